@@ -23,12 +23,94 @@
 #include "simulation_data.h"
 #include "patch.h"
 
+#include <map>
+#include <set>
+#include <vector>
+
+using ArrayCache = std::map<int, vtkSmartPointer<vtkUnsignedCharArray>>;
+
 struct MandelbrotDataAdaptor::DInternals
 {
   simulation_data *sim;
   sensei::MeshMetadataPtr metadata;
+
+  // the hierarchy is reused while the structure it was built from, the
+  // boxes, their owners and ids, and the geometry, is unchanged
+  vtkSmartPointer<vtkOverlappingAMR> Mesh;
+  std::vector<double> MeshStructure;
+
+  // arrays of the local blocks, keyed by patch id. they are pointed at
+  // the new simulation data each step. the ghost arrays of leaf patches
+  // own their buffers and are kept apart from those wrapping blanking data
+  ArrayCache Data;
+  ArrayCache Ghosts;
+  ArrayCache LeafGhosts;
 };
 
+namespace
+{
+// --------------------------------------------------------------------------
+// everything in the metadata that the hierarchy is built from
+void getStructure(const sensei::MeshMetadataPtr &md, std::vector<double> &st)
+{
+  st.clear();
+  st.push_back(md->NumLevels);
+  st.insert(st.end(), md->BlocksPerLevel.begin(), md->BlocksPerLevel.end());
+  st.insert(st.end(), md->Bounds.begin(), md->Bounds.end());
+  st.insert(st.end(), md->Extent.begin(), md->Extent.end());
+  for (int i = 0; i < md->NumBlocks; ++i)
+    {
+    st.push_back(md->BlockIds[i]);
+    st.push_back(md->BlockLevel[i]);
+    st.push_back(md->BlockOwner[i]);
+    st.insert(st.end(), md->BlockExtents[i].begin(), md->BlockExtents[i].end());
+    }
+}
+
+// --------------------------------------------------------------------------
+// get the cached array for the block, making a new one if there is none or
+// if it is referenced from elsewhere, by a copy of an earlier step's
+// hierarchy for instance, and must not be modified. the array is removed
+// from the block.
+vtkUnsignedCharArray *getArray(ArrayCache &cache, int gid,
+  vtkUniformGrid *block, const char *name)
+{
+  block->GetCellData()->RemoveArray(name);
+
+  vtkSmartPointer<vtkUnsignedCharArray> &arr = cache[gid];
+  if (!arr || (arr->GetReferenceCount() > 1))
+    {
+    arr = vtkSmartPointer<vtkUnsignedCharArray>::New();
+    arr->SetName(name);
+    }
+
+  return arr;
+}
+
+// --------------------------------------------------------------------------
+// drop the cached arrays of patches that no longer exist. patch ids are
+// reassigned each step.
+void pruneCache(ArrayCache &cache, const std::set<int> &ids)
+{
+  ArrayCache::iterator it = cache.begin();
+  while (it != cache.end())
+    {
+    if (ids.count(it->first))
+      ++it;
+    else
+      it = cache.erase(it);
+    }
+}
+
+// --------------------------------------------------------------------------
+// returns true if the hierarchy is referenced from elsewhere
+bool isShared(vtkOverlappingAMR *amr)
+{
+  return (amr->GetReferenceCount() > 1) ||
+    (amr->GetAMRInfo() && (amr->GetAMRInfo()->GetReferenceCount() > 1));
+}
+}
+
 //-----------------------------------------------------------------------------
 senseiNewMacro(MandelbrotDataAdaptor);
 
@@ -93,6 +175,19 @@ int MandelbrotDataAdaptor::GetMesh(const std::string &meshName,
 
   int rr = mmd->RefRatio[0][0];
 
+  // reuse the hierarchy made in an earlier step when it is unchanged. the
+  // arrays are replaced as they are added.
+  std::vector<double> structure;
+  getStructure(mmd, structure);
+
+  if (internals.Mesh && (structure == internals.MeshStructure) &&
+    !isShared(internals.Mesh))
+    {
+    mesh = internals.Mesh;
+    mesh->Register(0);
+    return 0;
+    }
+
   // create the VTK dataset
   vtkSmartPointer<vtkOverlappingAMR> amrMesh =
     vtkSmartPointer<vtkOverlappingAMR>::New();
@@ -159,6 +254,9 @@ int MandelbrotDataAdaptor::GetMesh(const std::string &meshName,
       }
     }
 
+  internals.Mesh = amrMesh;
+  internals.MeshStructure.swap(structure);
+
   mesh = amrMesh;
   mesh->Register(0);
 
@@ -188,6 +286,7 @@ int MandelbrotDataAdaptor::AddGhostCellsArray(vtkDataObject* mesh,
   vtkUniformGridAMRDataIterator *it =
     dynamic_cast<vtkUniformGridAMRDataIterator*>(amrMesh->NewIterator());
 
+  std::set<int> ids;
   for (it->InitTraversal(); !it->IsDoneWithTraversal(); it->GoToNextItem())
     {
     int level = it->GetCurrentLevel();
@@ -205,29 +304,37 @@ int MandelbrotDataAdaptor::AddGhostCellsArray(vtkDataObject* mesh,
       return -1;
       }
 
+    vtkUniformGrid *block =
+      dynamic_cast<vtkUniformGrid*>(it->GetCurrentDataObject());
+
     int nxy = patch->nx*patch->ny;
-    vtkUnsignedCharArray *arr = vtkUnsignedCharArray::New();
-    arr->SetName("vtkGhostType");
+    vtkUnsignedCharArray *arr = nullptr;
     if (patch->blank)
       {
+      this->Internals->LeafGhosts.erase(gid);
+      arr = getArray(this->Internals->Ghosts, gid, block, "vtkGhostType");
       arr->SetArray(patch->blank, nxy, 1);
       }
     else
       {
-      // leaf patches won't have a blank array.
+      // leaf patches won't have a blank array. the zeros go in a buffer the
+      // array owns, an array that wrapped freed blanking data is not reused
+      this->Internals->Ghosts.erase(gid);
+      arr = getArray(this->Internals->LeafGhosts, gid, block, "vtkGhostType");
       arr->SetNumberOfTuples(nxy);
       memset(arr->GetVoidPointer(0), 0, nxy*sizeof(unsigned char));
       }
 
-    vtkUniformGrid *block =
-      dynamic_cast<vtkUniformGrid*>(it->GetCurrentDataObject());
     block->GetCellData()->AddArray(arr);
-    arr->Delete();
+    ids.insert(gid);
     }
 
   it->Delete();
   patch_free_flat_array(patches);
 
+  pruneCache(this->Internals->Ghosts, ids);
+  pruneCache(this->Internals->LeafGhosts, ids);
+
   return 0;
 }
 
@@ -255,6 +362,7 @@ int MandelbrotDataAdaptor::AddArray(vtkDataObject* mesh, const std::string &mesh
   vtkUniformGridAMRDataIterator *it =
     dynamic_cast<vtkUniformGridAMRDataIterator*>(amrMesh->NewIterator());
 
+  std::set<int> ids;
   for (it->InitTraversal(); !it->IsDoneWithTraversal(); it->GoToNextItem())
     {
     int level = it->GetCurrentLevel();
@@ -274,17 +382,19 @@ int MandelbrotDataAdaptor::AddArray(vtkDataObject* mesh, const std::string &mesh
 
     // pass it into VTK
     vtkUniformGrid *block = dynamic_cast<vtkUniformGrid*>(it->GetCurrentDataObject());
-    vtkUnsignedCharArray *arr = vtkUnsignedCharArray::New();
-    arr->SetName("mandelbrot");
+    vtkUnsignedCharArray *arr =
+      getArray(this->Internals->Data, gid, block, "mandelbrot");
     arr->SetArray(patch->data, patch->nx*patch->ny, 1);
     block->GetCellData()->SetScalars(arr);
     block->GetCellData()->SetActiveScalars("mandelbrot");
-    arr->Delete();
+    ids.insert(gid);
     }
 
   it->Delete();
   patch_free_flat_array(patches);
 
+  pruneCache(this->Internals->Data, ids);
+
   return 0;
 }
 
@@ -413,5 +523,26 @@ int MandelbrotDataAdaptor::GetMeshMetadata(unsigned int id,
 int MandelbrotDataAdaptor::ReleaseData()
 {
   sensei::TimeEvent<64> event("MandelbrotDataAdaptor::ReleaseData");
+
+  // the simulation frees the patch data after each step. take the arrays
+  // off of the hierarchy kept for reuse so that they are not seen before
+  // they are pointed at the new data.
+  DInternals& internals = (*this->Internals);
+  if (internals.Mesh)
+    {
+    vtkUniformGridAMRDataIterator *it =
+      dynamic_cast<vtkUniformGridAMRDataIterator*>(internals.Mesh->NewIterator());
+
+    for (it->InitTraversal(); !it->IsDoneWithTraversal(); it->GoToNextItem())
+      {
+      vtkUniformGrid *block =
+        dynamic_cast<vtkUniformGrid*>(it->GetCurrentDataObject());
+      block->GetCellData()->RemoveArray("mandelbrot");
+      block->GetCellData()->RemoveArray("vtkGhostType");
+      }
+
+    it->Delete();
+    }
+
   return 0;
 }
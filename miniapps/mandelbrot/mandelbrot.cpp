@@ -6,6 +6,9 @@
 #include <sstream>
 #include <string>
 #include <iostream>
+#include <vector>
+#include <map>
+#include <algorithm>
 
 #include <mpi.h>
 
@@ -24,49 +27,74 @@
 // Code for calculating data values
 //*****************************************************************************
 
-class complex
-{
-public:
-    complex() : a(0.), b(0.) { }
-    complex(float A, float B) : a(A), b(B) { }
-    complex(const complex &obj) : a(obj.a), b(obj.b) { }
-    complex operator = (const complex &obj) { a = obj.a; b = obj.b; return *this;}
-    complex operator + (const complex &obj) const
-    {
-        return complex(a + obj.a,  b + obj.b);
-    }
-    complex operator * (const complex &obj) const
-    {
-        return complex(a * obj.a - b * obj.b, a * obj.b + b * obj.a);
-    }
-    float mag2() const
-    {
-        return a*a + b*b;
-    }
-    float mag() const
-    {
-        return sqrtf(a*a + b*b);
-    }
-private:
-    float a,b;
-};
-
 #define MAXIT 30
 
-inline unsigned char
-mandelbrot(const complex &C)
+// Number of pixels iterated together by the escape time kernel.
+#define NLANES 16
+
+// -----------------------------------------------------------------------------
+// @brief Computes the escape time of nx pixels along a row, returning the
+//        number of iterations done. The pixels are iterated NLANES at a time.
+//        Lanes that have escaped are masked out rather than branched on so
+//        that the compiler vectorizes the lane loop, and a group stops as
+//        soon as all of its lanes have escaped. A pixel's value is the
+//        iteration at which |z| exceeded 2 under z = z^2 + c, or 0 if it
+//        never did.
+//
+long long
+mandelbrot_row(float x0, float x1, float y, int nx, unsigned char *data)
 {
-    complex Z;
-    for(unsigned char zit = 0; zit < MAXIT; ++zit)
+    long long work = 0;
+    for(int i0 = 0; i0 < nx; i0 += NLANES)
     {
-        Z = (Z * Z) + C;
-        if(Z.mag2() > 4.f)
-            return zit+1;
+        int n = std::min(NLANES, nx - i0);
+
+        float cr[NLANES], zr[NLANES], zi[NLANES];
+        int it[NLANES];
+        for(int l = 0; l < NLANES; ++l)
+        {
+            float tx = (float)(i0 + l) / (float)(nx - 1);
+            cr[l] = x0 + tx * (x1 - x0);
+            zr[l] = 0.f;
+            zi[l] = 0.f;
+            // lanes past the end of the row start out escaped
+            it[l] = l < n ? 0 : -1;
+        }
+
+        for(int zit = 0; zit < MAXIT; ++zit)
+        {
+            int active = 0;
+            for(int l = 0; l < NLANES; ++l)
+            {
+                float a = zr[l];
+                float b = zi[l];
+                float za = a * a - b * b + cr[l];
+                float zb = a * b + b * a + y;
+                int run = it[l] == 0;
+                int escaped = run & (za * za + zb * zb > 4.f);
+                zr[l] = run ? za : a;
+                zi[l] = run ? zb : b;
+                it[l] = escaped ? zit + 1 : it[l];
+                active |= run & !escaped;
+            }
+            if(active == 0)
+                break;
+        }
+
+        for(int l = 0; l < n; ++l)
+        {
+            data[i0 + l] = (unsigned char)it[l];
+            work += it[l] ? it[l] : MAXIT;
+        }
     }
-    return 0;
+    return work;
 }
 
-void
+// -----------------------------------------------------------------------------
+// @brief Computes the data on a patch. Returns the number of escape time
+//        iterations done, the measure of work used for load balancing.
+//
+long long
 calculate_data(patch_t *patch)
 {
     unsigned char *data = patch->data;
@@ -78,18 +106,15 @@ calculate_data(patch_t *patch)
     float cellHeight = (patch->window[3] - patch->window[2]) / ((float)patch->ny);
     float y0 = patch->window[2] + cellHeight / 2.f;
     float y1 = patch->window[3] - cellHeight / 2.f;
+    long long work = 0;
     for(int j = 0; j < patch->ny; ++j)
     {
         float ty = (float)j / (float)(patch->ny - 1);
         float y = y0 + ty * (y1 - y0);
-        for(int i = 0; i < patch->nx; ++i)
-        {
-            float tx = (float)i / (float)(patch->nx - 1);
-            float x = x0 + tx * (x1 - x0);
-
-            *data++ = mandelbrot(complex(x, y));
-        }
+        work += mandelbrot_row(x0, x1, y, patch->nx, data);
+        data += patch->nx;
     }
+    return work;
 }
 
 //*****************************************************************************
@@ -164,99 +189,139 @@ log_patches(patch_t *patch, const char *msg)
 }
 #endif
 
-#if 1
-int
-count_local_patches(simulation_data *sim)
+// -----------------------------------------------------------------------------
+// @brief Estimates the work of computing each subpatch of a patch from the
+//        iterations its parent's pixels took. A parent pixel covers
+//        refinement_ratio^2 subpatch pixels, which take about as many
+//        iterations as it did.
+//
+void
+estimate_subpatch_work(simulation_data *sim, patch_t *patch,
+    std::vector<long long> &work)
 {
-    int np = 0;
-    patch_t **patches_this_rank = patch_flat_array(&sim->patch, &np);
-    int count = 0;
-    for(int i = 0; i < np; ++i)
+    int r = sim->refinement_ratio;
+    work.assign(patch->nsubpatches, 0);
+    for(int s = 0; s < patch->nsubpatches; ++s)
     {
-        if(patches_this_rank[i]->nowners > 1)
-        {
-            if(patches_this_rank[i]->owners[0] == sim->par_rank)
-                count++;
-        }
-        else
-            count++;
+        patch_t *sp = &patch->subpatches[s];
+        int i0 = sp->logical_extents[0] / r - patch->logical_extents[0];
+        int i1 = (sp->logical_extents[1] + 1) / r - patch->logical_extents[0];
+        int j0 = sp->logical_extents[2] / r - patch->logical_extents[2];
+        int j1 = (sp->logical_extents[3] + 1) / r - patch->logical_extents[2];
+        long long w = 0;
+        for(int j = j0; j < j1; ++j)
+            for(int i = i0; i < i1; ++i)
+            {
+                int it = patch->data[j*patch->nx + i];
+                w += it ? it : MAXIT;
+            }
+        work[s] = w * r * r;
     }
-    FREE(patches_this_rank);
-    return count;
 }
 
-int compare_workload(const void *a, const void *b)
+// -----------------------------------------------------------------------------
+// @brief Gathers the work done so far in this step by each of the owners of a
+//        patch, in owner list order. comm must hold exactly the owners.
+//
+void
+gather_owner_work(MPI_Comm comm, simulation_data *sim, patch_t *patch,
+    std::vector<long long> &load)
 {
-    const int *A = (const int *)a;
-    const int *B = (const int *)b;
-    if(A[1] < B[1])
-        return -1;
-    else if(A[1] == B[1])
-        return 0;
-    else
-        return 1;
+    long long local[2] = {sim->par_rank, sim->work};
+    std::vector<long long> all(2*patch->nowners);
+    MPI_Allgather(local, 2, MPI_LONG_LONG, all.data(), 2, MPI_LONG_LONG, comm);
+
+    std::map<int, long long> rank_load;
+    for(int i = 0; i < patch->nowners; ++i)
+        rank_load[(int)all[2*i]] = all[2*i+1];
+
+    load.resize(patch->nowners);
+    for(int i = 0; i < patch->nowners; ++i)
+        load[i] = rank_load[patch->owners[i]];
 }
 
 // -----------------------------------------------------------------------------
-// @brief This routine is called among the owners of a patch to decide who has
-//        the most work. The owner list is sorted so ranks with less work appear
-//        first in the list so they can get a little more work when we assign
-//        patches to ranks.
+// @brief Decides which of the owners of a patch own each of its subpatches
+//        using the measured work. When there are at least as many subpatches
+//        as owners each subpatch goes to one owner, largest first to the
+//        least loaded owner. Otherwise every owner gets one subpatch, and the
+//        owners are spread over the subpatches in proportion to their work,
+//        with the least loaded owners going to the largest subpatches. The
+//        result is the same on all owners.
 //
 void
-sort_owners_by_workload(MPI_Comm comm, simulation_data *sim, patch_t *patch)
+weighted_assignment(MPI_Comm comm, simulation_data *sim, patch_t *patch,
+    std::vector<std::vector<int> > &subpatch_owners)
 {
-    // How much work do we have?
-    int nlocal_patches = count_local_patches(sim);
-
-    // We need to among just the processors in the owner list for this patch.
-    // Let's do point 2 point.
-    int tag = 1000, tag2 = 1001;
-    int *counts = new int[patch->nowners];
-    if(sim->par_rank == patch->owners[0])
+    std::vector<long long> work;
+    estimate_subpatch_work(sim, patch, work);
+
+    std::vector<long long> load;
+    gather_owner_work(comm, sim, patch, load);
+
+    int nsub = patch->nsubpatches;
+    int nown = patch->nowners;
+
+    // subpatches from the most to the least work
+    std::vector<int> sub(nsub);
+    for(int i = 0; i < nsub; ++i)
+        sub[i] = i;
+    std::stable_sort(sub.begin(), sub.end(),
+        [&](int a, int b){ return work[a] > work[b]; });
+
+    // owners from the least to the most loaded
+    std::vector<int> own(nown);
+    for(int i = 0; i < nown; ++i)
+        own[i] = i;
+    std::stable_sort(own.begin(), own.end(),
+        [&](int a, int b){ return load[a] < load[b]; });
+
+    if(nsub >= nown)
     {
-        counts[0] = nlocal_patches;
-        // Gather to the first
-        MPI_Status status;
-        for(int i = 1; i < patch->nowners; ++i)
-            MPI_Recv(counts + i, 1, MPI_INT, patch->owners[i], tag, comm, &status);
-        // Send to the rest
-        for(int i = 1; i < patch->nowners; ++i)
-            MPI_Send(counts, patch->nowners, MPI_INT, patch->owners[i], tag2, comm);
+        for(int i = 0; i < nsub; ++i)
+        {
+            int o = own[0];
+            for(int j = 1; j < nown; ++j)
+                if(load[own[j]] < load[o])
+                    o = own[j];
+            subpatch_owners[sub[i]].push_back(patch->owners[o]);
+            load[o] += work[sub[i]];
+        }
     }
     else
     {
-        MPI_Send(&nlocal_patches, 1, MPI_INT, patch->owners[0], tag, comm);
-        MPI_Status status;
-        MPI_Recv(counts, patch->nowners, MPI_INT, patch->owners[0], tag2, comm, &status);
-    }
-
-    // Now we have counts on all ranks. Sort according to workload so the low
-    // work ranks are first where they are more likely to get assigned work
-    // due to the mod assignment.
-    int *s = new int[patch->nowners * 2];
-    for(int i = 0; i < patch->nowners; ++i)
-    {
-        s[2*i]   = patch->owners[i]; // owner
-        s[2*i+1] = counts[i]; // workload
+        // give each extra owner to the subpatch with the most work per owner
+        std::vector<int> count(nsub, 1);
+        for(int i = nsub; i < nown; ++i)
+        {
+            int s = 0;
+            for(int j = 1; j < nsub; ++j)
+                if((double)work[j] * count[s] > (double)work[s] * count[j])
+                    s = j;
+            count[s]++;
+        }
+        for(int i = 0, o = 0; i < nsub; ++i)
+            for(int j = 0; j < count[sub[i]]; ++j)
+                subpatch_owners[sub[i]].push_back(patch->owners[own[o++]]);
     }
-    qsort(s, patch->nowners, 2*sizeof(int), compare_workload);
-    delete [] counts;
-
-    // We've sorted based on the workload.
-    for(int i = 0; i < patch->nowners; ++i)
-        patch->owners[i] = s[2*i];
-    delete [] s;
 }
-#endif
 
 // -----------------------------------------------------------------------------
 // @brief Takes the input patch and doles out the subpatches it contains to the
-//        ranks that own the input patch.
+//        ranks that own the input patch. When balancing, comm holds the owners
+//        of the input patch, and a communicator holding the owners of the
+//        subpatch kept on this rank is returned in subcomm if that subpatch
+//        has more than one owner. A rank keeps at most one such subpatch.
 //
 void
-assign_patches(MPI_Comm comm, simulation_data *sim, patch_t *patch)
+assign_patches(MPI_Comm comm, simulation_data *sim, patch_t *patch,
+    MPI_Comm *subcomm)
 {
+    *subcomm = MPI_COMM_NULL;
+
+    if(patch->nsubpatches == 0)
+        return;
+
     // Decide how patches are assigned to processors.
     if(patch->nowners > 1)
     {
@@ -264,35 +329,53 @@ assign_patches(MPI_Comm comm, simulation_data *sim, patch_t *patch)
         fprintf(debuglog, "assign_patches: Current patch owned by %d ranks\n", patch->nowners);
         fprintf(debuglog, "assign_patches: Current patch refined into %d subpatches\n", patch->nsubpatches);
 #endif
-
-#if 1
-        // Sort the owner list by the total amount of work so the least loaded
-        // ranks are first in the list.
+        std::vector<std::vector<int> > subpatch_owners(patch->nsubpatches);
         if(sim->balance)
-            sort_owners_by_workload(comm, sim, patch);
-#endif
-        // The current patch exists on more than one rank. Divide the
-        // refined patch list among those ranks.
-        int n = std::max(patch->nowners, patch->nsubpatches);
-        std::vector<int> patches_owned_by_this_rank;
-        for(int i = 0; i < n; ++i)
         {
-            int owner = patch->owners[i % patch->nowners];
-            int subpatchIndex = i % patch->nsubpatches;
-            patch_add_owner(&patch->subpatches[subpatchIndex], owner);
+            // Weight the assignment by the work of the subpatches and the
+            // work already done by the owners.
+            weighted_assignment(comm, sim, patch, subpatch_owners);
+        }
+        else
+        {
+            // The current patch exists on more than one rank. Divide the
+            // refined patch list among those ranks.
+            int n = std::max(patch->nowners, patch->nsubpatches);
+            for(int i = 0; i < n; ++i)
+                subpatch_owners[i % patch->nsubpatches].push_back(
+                    patch->owners[i % patch->nowners]);
+        }
 
-            if(owner == sim->par_rank)
+        std::vector<int> patches_owned_by_this_rank;
+        for(int i = 0; i < patch->nsubpatches; ++i)
+        {
+            for(size_t j = 0; j < subpatch_owners[i].size(); ++j)
             {
-                patches_owned_by_this_rank.push_back(subpatchIndex);
+                int owner = subpatch_owners[i][j];
+                patch_add_owner(&patch->subpatches[i], owner);
+
+                if(owner == sim->par_rank)
+                {
+                    patches_owned_by_this_rank.push_back(i);
 #ifdef DO_LOG
-                fprintf(debuglog, "assign_patches: patches owned by this rank: %d\n", subpatchIndex);
+                    fprintf(debuglog, "assign_patches: patches owned by this rank: %d\n", i);
 #endif
+                }
             }
         }
 
+        // Group the owners of shared subpatches for balancing further down.
+        if(sim->balance)
+        {
+            int color = MPI_UNDEFINED;
+            for(size_t i = 0; i < patches_owned_by_this_rank.size(); ++i)
+                if(subpatch_owners[patches_owned_by_this_rank[i]].size() > 1)
+                    color = patches_owned_by_this_rank[i];
+            MPI_Comm_split(comm, color, sim->par_rank, subcomm);
+        }
+
         // Keep just the ones we want on this rank.
-        int *keep = ALLOC(patch->nsubpatches, int);
-        memset(keep, 0, patch->nsubpatches * sizeof(int));
+        std::vector<int> keep(patch->nsubpatches, 0);
         for(size_t i = 0; i < patches_owned_by_this_rank.size(); ++i)
             keep[patches_owned_by_this_rank[i]] = 1;
 
@@ -304,7 +387,6 @@ assign_patches(MPI_Comm comm, simulation_data *sim, patch_t *patch)
             else
                 patch_dtor(&patch->subpatches[i]);
         }
-        FREE(keep);
         FREE(patch->subpatches);
         patch->subpatches = subpatches;
         patch->nsubpatches = patches_owned_by_this_rank.size();
@@ -322,7 +404,8 @@ assign_patches(MPI_Comm comm, simulation_data *sim, patch_t *patch)
 // -----------------------------------------------------------------------------
 // @brief Compute data for a patch. Refine the patch if we're not beyond max levels.
 //        The subpatches are divided among ranks that own patch. Then we recurse to
-//        compute data for the subpatches.
+//        compute data for the subpatches. When balancing, comm holds the owners
+//        of a patch with more than one owner.
 //
 void
 calculate_amr_helper(MPI_Comm comm, simulation_data *sim, patch_t *patch, int level)
@@ -332,7 +415,7 @@ calculate_amr_helper(MPI_Comm comm, simulation_data *sim, patch_t *patch, int le
 
     // Calculate the data on this patch
     patch_alloc_data(patch, patch->nx, patch->ny);
-    calculate_data(patch);
+    sim->work += calculate_data(patch);
 
     if(level+1 > sim->max_levels)
         return;
@@ -346,7 +429,8 @@ calculate_amr_helper(MPI_Comm comm, simulation_data *sim, patch_t *patch, int le
 #endif
 
     // Assign the subpatches to MPI ranks.
-    assign_patches(comm, sim, patch);
+    MPI_Comm subcomm = MPI_COMM_NULL;
+    assign_patches(comm, sim, patch, &subcomm);
 #ifdef DO_LOG
     log_patches(patch, "AFTER assign_patches");
 #endif
@@ -356,8 +440,12 @@ calculate_amr_helper(MPI_Comm comm, simulation_data *sim, patch_t *patch, int le
     {
         patch_t *p = &patch->subpatches[i];
         //patch_alloc_data(p, p->nx, p->ny);
-        calculate_amr_helper(comm, sim, p, level+1);
+        calculate_amr_helper(p->nowners > 1 ? subcomm : MPI_COMM_NULL,
+            sim, p, level+1);
     }
+
+    if(subcomm != MPI_COMM_NULL)
+        MPI_Comm_free(&subcomm);
 }
 
 // -----------------------------------------------------------------------------
@@ -656,13 +744,24 @@ int main(int argc, char **argv)
 #ifdef ENABLE_SENSEI
         sensei::Profiler::StartEvent("mandelbrot::compute");
 #endif
+        sim.work = 0;
         calculate_amr(MPI_COMM_WORLD, &sim);
 
-        if(sim.log && sim.par_rank == 0)
+        if(sim.log)
         {
-            log << "# patches_per_rank" << sim.cycle << endl;
-            for(int i = 0; i < sim.par_size; ++i)
-                log << i << " " << sim.npatches_per_rank[i] << std::endl;
+            std::vector<long long> work_per_rank(sim.par_size);
+            MPI_Gather(&sim.work, 1, MPI_LONG_LONG, work_per_rank.data(),
+                1, MPI_LONG_LONG, 0, MPI_COMM_WORLD);
+
+            if(sim.par_rank == 0)
+            {
+                log << "# patches_per_rank" << sim.cycle << endl;
+                for(int i = 0; i < sim.par_size; ++i)
+                    log << i << " " << sim.npatches_per_rank[i] << std::endl;
+                log << "# iterations_per_rank" << sim.cycle << endl;
+                for(int i = 0; i < sim.par_size; ++i)
+                    log << i << " " << work_per_rank[i] << std::endl;
+            }
         }
 
 #ifdef ENABLE_SENSEI
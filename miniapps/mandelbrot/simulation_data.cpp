@@ -10,6 +10,7 @@ simulation_data::simulation_data()
     refinement_ratio = 2;
     balance = false;
     log = false;
+    work = 0;
     patch_ctor(&patch);
     npatches_per_rank = NULL;
     npatches_per_level = NULL;
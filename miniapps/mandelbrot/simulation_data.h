@@ -20,6 +20,7 @@ public:
     int     refinement_ratio;
     bool    balance;
     bool    log;
+    long long work;              // escape time iterations done this step
 
     patch_t patch;
 
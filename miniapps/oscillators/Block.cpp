@@ -1,7 +1,255 @@
 #include "Block.h"
 
+#include <ThreadPool.h>
+
+#include <algorithm>
+#include <cmath>
+
+// --------------------------------------------------------------------------
+void Block::initialize_gaussians()
+{
+    const Vertex &shape = grid.shape();
+    std::vector<float> *gauss[3] = {&gauss_x, &gauss_y, &gauss_z};
+    size_t nosc = oscillators.size();
+    for (int q = 0; q < 3; ++q)
+    {
+        int n = shape[q];
+        int i0 = bounds.min[q];
+        float dx = spacing[q];
+        float x0 = origin[q] + dx;
+
+        std::vector<float> &g = *gauss[q];
+        g.resize(nosc*n);
+
+        for (size_t o = 0; o < nosc; ++o)
+        {
+            float c = oscillators[o].center[q];
+            float r = oscillators[o].radius;
+            float *go = g.data() + o*n;
+            for (int i = 0; i < n; ++i)
+            {
+                float x = x0 + dx*(i0 + i);
+                float d = c - x;
+                go[i] = exp(-d*d/(2*r*r));
+            }
+        }
+    }
+}
+
 // --------------------------------------------------------------------------
 void Block::update_fields(float t)
+{
+    if (reference_kernels)
+    {
+        update_fields_reference(t);
+        return;
+    }
+
+    const Vertex &shape = grid.shape();
+    int ni = shape[0];
+    int nj = shape[1];
+    int nk = shape[2];
+    int nij = ni*nj;
+    size_t nosc = oscillators.size();
+
+    if (gauss_x.size() != nosc*ni)
+        initialize_gaussians();
+
+    // the time dependent part of each oscillator is the same everywhere
+    std::vector<float> amp(nosc);
+    for (size_t o = 0; o < nosc; ++o)
+        amp[o] = oscillators[o].amplitude(t);
+
+    // update the scalar oscillator field. with the Gaussian factored the
+    // inner loop is a multiply add over contiguous memory
+    const float *gx = gauss_x.data();
+    const float *gy = gauss_y.data();
+    const float *gz = gauss_z.data();
+    const float *pamp = amp.data();
+    float *pdata = grid.data();
+
+    sensei::ThreadPool::GetGlobalPool().ParallelFor(nk,
+        [=](int, long k)
+        {
+            float *pdk = pdata + k*nij;
+            for (int j = 0; j < nj; ++j)
+            {
+                float *pd = pdk + j*ni;
+
+                for (int i = 0; i < ni; ++i)
+                    pd[i] = 0.f;
+
+                for (size_t o = 0; o < nosc; ++o)
+                {
+                    float a = pamp[o] * gz[o*nk + k] * gy[o*nj + j];
+                    const float *gxo = gx + o*ni;
+                    for (int i = 0; i < ni; ++i)
+                        pd[i] += a * gxo[i];
+                }
+            }
+        });
+
+    // update the velocity field on the particle mesh. particles are
+    // processed in chunks, within a chunk the loop over particles is
+    // innermost
+    const long chunk = 512;
+    long np = particles.size();
+    long nChunks = (np + chunk - 1) / chunk;
+
+    const float *px = particles.x.data();
+    const float *py = particles.y.data();
+    const float *pz = particles.z.data();
+    float *pvx = particles.vx.data();
+    float *pvy = particles.vy.data();
+    float *pvz = particles.vz.data();
+    const Oscillator *posc = oscillators.data();
+    float vscale = velocity_scale;
+
+    sensei::ThreadPool::GetGlobalPool().ParallelFor(nChunks,
+        [=](int, long c)
+        {
+            long p0 = c*chunk;
+            long p1 = std::min(np, p0 + chunk);
+
+            for (long p = p0; p < p1; ++p)
+            {
+                pvx[p] = 0.f;
+                pvy[p] = 0.f;
+                pvz[p] = 0.f;
+            }
+
+            // see Oscillator::evaluateGradient
+            for (size_t o = 0; o < nosc; ++o)
+            {
+                float a = pamp[o];
+                float cx = posc[o].center[0];
+                float cy = posc[o].center[1];
+                float cz = posc[o].center[2];
+                float r2 = posc[o].radius * posc[o].radius;
+                for (long p = p0; p < p1; ++p)
+                {
+                    float dx = cx - px[p];
+                    float dy = cy - py[p];
+                    float dz = cz - pz[p];
+                    float dist2 = dx*dx + dy*dy + dz*dz;
+                    float f = a * exp(-dist2/(2*r2)) / r2;
+                    pvx[p] += f * dx;
+                    pvy[p] += f * dy;
+                    pvz[p] += f * dz;
+                }
+            }
+
+            // scale the gradient to get "units" right for velocity
+            for (long p = p0; p < p1; ++p)
+            {
+                pvx[p] *= vscale;
+                pvy[p] *= vscale;
+                pvz[p] *= vscale;
+            }
+        });
+}
+
+// --------------------------------------------------------------------------
+void Block::move_particles(float dt, const sdiy::Master::ProxyWithLink& cp)
+{
+    if (reference_kernels)
+    {
+        move_particles_reference(dt, cp);
+        return;
+    }
+
+    auto link = static_cast<sdiy::RegularGridLink*>(cp.link());
+
+    size_t np = particles.size();
+
+    // update particle positions and apply the periodic bci, one
+    // coordinate at a time
+    sdiy::Bounds<float> wsdom = world_space_bounds(domain, origin, spacing);
+
+    float *pos[3] = {particles.x.data(), particles.y.data(), particles.z.data()};
+    const float *vel[3] = {particles.vx.data(), particles.vy.data(), particles.vz.data()};
+
+    for (int q = 0; q < 3; ++q)
+    {
+        float *px = pos[q];
+        const float *pv = vel[q];
+
+        for (size_t i = 0; i < np; ++i)
+            px[i] += pv[i] * dt;
+
+        float dm = wsdom.min[q];
+        float dM = wsdom.max[q];
+        float dx = dM - dm;
+        bool planar = fabs(dx) < 1.0e-6f;
+
+        for (size_t i = 0; i < np; ++i)
+        {
+            if ((px[i] > dM) || (px[i] < dm))
+            {
+                if (planar)
+                {
+                    px[i] = dm;
+                }
+                else
+                {
+                    float dpdx = (px[i] - dm) / dx;
+                    px[i] = (dpdx - floor(dpdx))*dx + dm;
+                }
+            }
+        }
+    }
+
+    // send particles that have left this block to the neighbor that now
+    // contains them. block bounds have ghost zones, these are removed
+    sdiy::Bounds<float> wsblk = world_space_bounds(domain, bounds, origin, spacing, nghost);
+
+    size_t i = 0;
+    while (i < particles.size())
+    {
+        float x = particles.x[i];
+        float y = particles.y[i];
+        float z = particles.z[i];
+
+        if ((x >= wsblk.min[0]) && (x <= wsblk.max[0]) &&
+            (y >= wsblk.min[1]) && (y <= wsblk.max[1]) &&
+            (z >= wsblk.min[2]) && (z <= wsblk.max[2]))
+        {
+            ++i;
+            continue;
+        }
+
+        Particle particle = particles.get(i);
+
+        bool enqueued = false;
+
+        // search neighbor blocks for one that now conatins this particle
+        for (int j = 0; j < link->size(); ++j)
+        {
+            // link bounds do not have ghost zones
+            if (contains(link->bounds(j), origin, spacing, particle.position))
+            {
+                cp.enqueue(link->target(j), particle);
+
+                enqueued = true;
+                break;
+            }
+        }
+
+        if (!enqueued)
+        {
+            std::cerr << "Error: could not find appropriate neighbor for particle: "
+               << particle << std::endl;
+
+            abort();
+        }
+
+        // the last particle is moved into slot i and is tested next
+        particles.swap_remove(i);
+    }
+}
+
+// --------------------------------------------------------------------------
+void Block::update_fields_reference(float t)
 {
     // update the scalar oscillator field
     const Vertex &shape = grid.shape();
@@ -38,8 +286,10 @@ void Block::update_fields(float t)
     }
 
     // update the velocity field on the particle mesh
-    for (auto& particle : particles)
+    size_t np = particles.size();
+    for (size_t q = 0; q < np; ++q)
     {
+        Particle particle = particles.get(q);
         particle.velocity = { 0, 0, 0 };
         for (auto& o : oscillators)
         {
@@ -47,46 +297,52 @@ void Block::update_fields(float t)
         }
         // scale the gradient to get "units" right for velocity
         particle.velocity *= velocity_scale;
+
+        particles.vx[q] = particle.velocity[0];
+        particles.vy[q] = particle.velocity[1];
+        particles.vz[q] = particle.velocity[2];
     }
 }
 
 // --------------------------------------------------------------------------
-void Block::move_particles(float dt, const sdiy::Master::ProxyWithLink& cp)
+void Block::move_particles_reference(float dt, const sdiy::Master::ProxyWithLink& cp)
 {
     auto link = static_cast<sdiy::RegularGridLink*>(cp.link());
 
-    auto particle = particles.begin();
-    while (particle != particles.end())
+    size_t q = 0;
+    while (q < particles.size())
     {
+        Particle particle = particles.get(q);
+
         // update particle position
-        particle->position += particle->velocity * dt;
+        particle.position += particle.velocity * dt;
 
         // warp position if needed
         // applies periodic bci
         sdiy::Bounds<float> wsdom = world_space_bounds(domain, origin, spacing);
         for (int i = 0; i < 3; ++i)
         {
-            if ((particle->position[i] > wsdom.max[i]) ||
-              (particle->position[i] < wsdom.min[i]))
+            if ((particle.position[i] > wsdom.max[i]) ||
+              (particle.position[i] < wsdom.min[i]))
             {
                 float dm = wsdom.min[i];
                 float dx = wsdom.max[i] - dm;
                 if (fabs(dx) < 1.0e-6f)
                 {
-                  particle->position[i] = dm;
+                  particle.position[i] = dm;
                 }
                 else
                 {
-                  float dp = particle->position[i] - dm;
+                  float dp = particle.position[i] - dm;
                   float dpdx = dp / dx;
-                  particle->position[i] = (dpdx - floor(dpdx))*dx + dm;
+                  particle.position[i] = (dpdx - floor(dpdx))*dx + dm;
                 }
             }
         }
 
         // check if the particle has left this block
         // block bounds have ghost zones
-        if (!contains(domain, bounds, origin, spacing, nghost, particle->position))
+        if (!contains(domain, bounds, origin, spacing, nghost, particle.position))
         {
             bool enqueued = false;
 
@@ -94,12 +350,9 @@ void Block::move_particles(float dt, const sdiy::Master::ProxyWithLink& cp)
             for (int i = 0; i < link->size(); ++i)
             {
                 // link bounds do not have ghost zones
-                if (contains(link->bounds(i), origin, spacing, particle->position))
+                if (contains(link->bounds(i), origin, spacing, particle.position))
                 {
-                    /*std::cerr << "moving " << *particle << " from " << gid
-                      << " to " << link->target(i).gid << std::endl;*/
-
-                    cp.enqueue(link->target(i), *particle);
+                    cp.enqueue(link->target(i), particle);
 
                     enqueued = true;
                     break;
@@ -109,16 +362,19 @@ void Block::move_particles(float dt, const sdiy::Master::ProxyWithLink& cp)
             if (!enqueued)
             {
                 std::cerr << "Error: could not find appropriate neighbor for particle: "
-                   << *particle << std::endl;
+                   << particle << std::endl;
 
                 abort();
             }
 
-            particle = particles.erase(particle);
+            particles.erase(q);
         }
         else
         {
-            ++particle;
+            particles.x[q] = particle.position[0];
+            particles.y[q] = particle.position[1];
+            particles.z[q] = particle.position[2];
+            ++q;
         }
     }
 }
@@ -141,12 +397,8 @@ void Block::handle_incoming_particles(const sdiy::Master::ProxyWithLink& cp)
 
 std::ostream &operator<<(std::ostream &os, const Block &b)
 {
-    os << b.gid << ": " << b.bounds.min << " - " << b.bounds.max << std::endl;
-
-    auto it = b.particles.begin();
-    auto end = b.particles.end();
-    for (; it != end; ++it)
-        os << "    " << *it << std::endl;
+    os << b.gid << ": " << b.bounds.min << " - " << b.bounds.max << std::endl
+        << b.particles;
 
     return os;
 }
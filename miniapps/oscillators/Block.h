@@ -19,11 +19,12 @@ struct Block
 
      Block(int gid_, const sdiy::DiscreteBounds& bounds_, const sdiy::DiscreteBounds& domain_,
          const sdiy::Point<float,3> &origin_, const sdiy::Point<float,3> &spacing_,
-         int nghost_, const std::vector<Oscillator>& oscillators_, float velocity_scale_) :
+         int nghost_, const std::vector<Oscillator>& oscillators_, float velocity_scale_,
+         bool reference_kernels_ = false) :
                 gid(gid_), velocity_scale(velocity_scale_), bounds(bounds_),
                 domain(domain_), origin(origin_), spacing(spacing_), nghost(nghost_),
                 grid(Vertex(&bounds.max[0]) - Vertex(&bounds.min[0]) + Vertex::one()),
-                oscillators(oscillators_)
+                oscillators(oscillators_), reference_kernels(reference_kernels_)
     {}
 
     // update scalar and vector fields
@@ -32,6 +33,11 @@ struct Block
     // update pareticle positions
     void move_particles(float dt, const sdiy::Master::ProxyWithLink& cp);
 
+    // the original scalar implementations of the above, evaluating each
+    // oscillator at each point. these are used when reference_kernels is set
+    void update_fields_reference(float t);
+    void move_particles_reference(float dt, const sdiy::Master::ProxyWithLink& cp);
+
     // handle particle migration
     void handle_incoming_particles(const sdiy::Master::ProxyWithLink& cp);
 
@@ -47,12 +53,22 @@ struct Block
     sdiy::Point<float,3>             spacing; // mesh spacing
     int                             nghost; // number of ghost zones
     sdiy::Grid<float,3>              grid;   // container for the gridded data arrays
-    std::vector<Particle>           particles;
+    ParticleArrays                  particles;
     std::vector<Oscillator>         oscillators;
+    bool                            reference_kernels; // use the original unoptimized kernels
 
  private:
+    // the Gaussian factor of each oscillator is separable, g(x,y,z) = gx(x)*gy(y)*gz(z).
+    // the factors are a function of the grid only and are computed once, they
+    // are stored for each oscillator in i, j, and k order
+    void initialize_gaussians();
+
+    std::vector<float>              gauss_x;
+    std::vector<float>              gauss_y;
+    std::vector<float>              gauss_z;
+
     // for create; to let Master manage the blocks
-    Block() : gid(-1), velocity_scale(1.0f), nghost(0)
+    Block() : gid(-1), velocity_scale(1.0f), nghost(0), reference_kernels(false)
     {
         origin[0] = origin[1] = origin[2] = 0.0f;
         spacing[0] = spacing[1] = spacing[2] = 1.0f;
@@ -1,6 +1,7 @@
 #include "DataAdaptor.h"
 #include "MeshMetadata.h"
 #include "Error.h"
+#include "ArrayPool.h"
 
 #include <vtkCellArray.h>
 #include <vtkCellData.h>
@@ -19,6 +20,10 @@
 
 #include <sdiy/master.hpp>
 
+#include <algorithm>
+#include <array>
+#include <vector>
+
 
 static
 long getBlockNumCells(const sdiy::DiscreteBounds &ext)
@@ -58,6 +63,89 @@ void getBlockExtent(const sdiy::DiscreteBounds &db, int *ext)
   ext[5] = db.max[2];
 }
 
+// get the number of cells selected by the first and last selected cells
+// in each direction and the stride
+static
+long getNumSelectedCells(const int *cellExt, const std::array<int,3> &stride)
+{
+  return ((cellExt[1] - cellExt[0])/stride[0] + 1)*
+    ((cellExt[3] - cellExt[2])/stride[1] + 1)*
+    ((cellExt[5] - cellExt[4])/stride[2] + 1);
+}
+
+// copy the selected cells of a block. ext is the cell extent of the block
+// and cellExt the first and last selected cells in each direction.
+template <typename T>
+void gatherCells(const T *src, const sdiy::DiscreteBounds &ext,
+  const int *cellExt, const std::array<int,3> &stride, T *dest)
+{
+  long nx = ext.max[0] - ext.min[0] + 1;
+  long nxy = nx*(ext.max[1] - ext.min[1] + 1);
+
+  for (int k = cellExt[4]; k <= cellExt[5]; k += stride[2])
+    {
+    for (int j = cellExt[2]; j <= cellExt[3]; j += stride[1])
+      {
+      const T *row = src + (k - ext.min[2])*nxy + (j - ext.min[1])*nx;
+      for (int i = cellExt[0]; i <= cellExt[1]; i += stride[0])
+        *dest++ = row[i - ext.min[0]];
+      }
+    }
+}
+
+// arrays cached across time steps for a single block
+struct BlockCache
+{
+  // the unstructured mesh and ghost cells are static and are shared with
+  // every mesh handed out
+  vtkSmartPointer<vtkPoints> UgPoints;
+  vtkSmartPointer<vtkCellArray> UgCells;
+  vtkSmartPointer<vtkUnsignedCharArray> UgCellTypes;
+  vtkSmartPointer<vtkIdTypeArray> UgCellLocations;
+  vtkSmartPointer<vtkUnsignedCharArray> Ghosts;
+
+  // zero copy wrappers of simulation memory
+  vtkSmartPointer<vtkFloatArray> Data;
+
+  // particle data that must be copied or computed
+  vtkSmartPointer<vtkIntArray> ParticleIds;
+  vtkSmartPointer<vtkPoints> ParticlePoints;
+  vtkSmartPointer<vtkCellArray> ParticleVerts;
+  vtkSmartPointer<vtkFloatArray> Velocity;
+  vtkSmartPointer<vtkFloatArray> VelocityMagnitude;
+};
+
+// tracks the number and size of array allocations made during a step
+struct AllocationCounter
+{
+  AllocationCounter() : Count(0), Bytes(0) {}
+
+  void Add(vtkDataArray *da)
+  {
+    this->Count += 1;
+    this->Bytes += da->GetNumberOfTuples() *
+      da->GetNumberOfComponents() * da->GetDataTypeSize();
+  }
+
+  void Clear()
+  {
+    this->Count = 0;
+    this->Bytes = 0;
+  }
+
+  long long Count;
+  long long Bytes;
+};
+
+// returns true if the array can be overwritten in place. this is the case
+// when it has the right size and no one but the cache holds a reference
+static
+bool reusable(vtkDataArray *da, vtkIdType nTuples)
+{
+  return da && (da->GetReferenceCount() == 1) &&
+    (da->GetNumberOfTuples() == nTuples);
+}
+
 static
 vtkImageData *newCartesianBlock(double *origin,
   double *spacing, const sdiy::DiscreteBounds &cellExts,
@@ -80,11 +168,16 @@ vtkImageData *newCartesianBlock(double *origin,
 static
 vtkUnstructuredGrid *newUnstructuredBlock(const double *origin,
   const double *spacing, const sdiy::DiscreteBounds &cellExts,
-  bool structureOnly)
+  bool structureOnly, BlockCache &cache, AllocationCounter &allocs)
 {
   vtkUnstructuredGrid *ug = vtkUnstructuredGrid::New();
 
-  if (!structureOnly)
+  if (structureOnly)
+    return ug;
+
+  // the mesh is static, it's generated once and shared by the meshes
+  // handed out on subsequent steps
+  if (!cache.UgPoints)
     {
     // Add points.
     int nx = cellExts.max[0] - cellExts.min[0] + 1 + 1;
@@ -111,8 +204,8 @@ vtkUnstructuredGrid *newUnstructuredBlock(const double *origin,
         }
       }
 
-    ug->SetPoints(pts);
-    pts->Delete();
+    cache.UgPoints.TakeReference(pts);
+    allocs.Add(pts->GetData());
 
     // Add cells
     int ncx = nx - 1;
@@ -151,104 +244,171 @@ vtkUnstructuredGrid *newUnstructuredBlock(const double *origin,
       nl += 9;
       }
 
+    allocs.Add(nlist);
+    allocs.Add(cellTypes);
+    allocs.Add(cellLocations);
+
     vtkCellArray *cells = vtkCellArray::New();
     cells->SetCells(ncells, nlist);
     nlist->Delete();
-    ug->SetCells(cellTypes, cellLocations, cells);
-    cellTypes->Delete();
-    cellLocations->Delete();
-    cells->Delete();
-  }
+
+    cache.UgCells.TakeReference(cells);
+    cache.UgCellTypes.TakeReference(cellTypes);
+    cache.UgCellLocations.TakeReference(cellLocations);
+    }
+
+  ug->SetPoints(cache.UgPoints);
+  ug->SetCells(cache.UgCellTypes, cache.UgCellLocations, cache.UgCells);
 
   return ug;
 }
 
 static
-vtkPolyData *newParticleBlock(const std::vector<Particle> *particles,
-  bool structureOnly)
+vtkPolyData *newParticleBlock(const ParticleArrays *particles,
+  bool structureOnly, BlockCache &cache, AllocationCounter &allocs)
 {
   vtkPolyData *block = vtkPolyData::New();
 
-  if (structureOnly)
+  if (structureOnly || !particles)
     return block;
 
-  vtkNew<vtkPoints> points;
-  vtkNew<vtkCellArray> cells;
-  points->Allocate(particles->size());
-  cells->Allocate(particles->size());
+  vtkIdType np = particles->size();
+
+  // the positions change every step. the cached points are overwritten
+  // unless the count changed or a previous step's mesh is still alive
+  vtkPoints *points = cache.ParticlePoints;
+  if (!points || (points->GetReferenceCount() > 1) ||
+    !reusable(points->GetData(), np))
+    {
+    vtkDataArray *pts = sensei::ArrayPool::NewArray(VTK_FLOAT, np, 3);
+    points = vtkPoints::New();
+    points->SetData(pts);
+    pts->Delete();
+    cache.ParticlePoints.TakeReference(points);
+    allocs.Add(points->GetData());
+    }
+
+  float *pp = static_cast<vtkFloatArray*>(points->GetData())->GetPointer(0);
+  const float *px = particles->x.data();
+  const float *py = particles->y.data();
+  const float *pz = particles->z.data();
+  for (vtkIdType i = 0; i < np; ++i)
+    {
+    pp[3*i] = px[i];
+    pp[3*i+1] = py[i];
+    pp[3*i+2] = pz[i];
+    }
+  points->Modified();
 
-  vtkIdType pointId = 0;
-  for (const auto &p : *particles)
+  // the connectivity depends only on the number of particles. it is
+  // never modified and hence can be shared
+  if (!cache.ParticleVerts || (cache.ParticleVerts->GetNumberOfCells() != np))
     {
-    points->InsertNextPoint(p.position[0], p.position[1], p.position[2]);
-    cells->InsertNextCell(1, &pointId);
-    ++pointId;
+    vtkIdTypeArray *ids = vtkIdTypeArray::New();
+    ids->SetNumberOfValues(2*np);
+    vtkIdType *pids = ids->GetPointer(0);
+    for (vtkIdType i = 0; i < np; ++i)
+      {
+      pids[2*i] = 1;
+      pids[2*i+1] = i;
+      }
+
+    allocs.Add(ids);
+
+    vtkCellArray *verts = vtkCellArray::New();
+    verts->SetCells(np, ids);
+    ids->Delete();
+
+    cache.ParticleVerts.TakeReference(verts);
     }
-  block->SetPoints(points.Get());
-  block->SetVerts(cells.Get());
+
+  block->SetPoints(points);
+  block->SetVerts(cache.ParticleVerts);
 
   return block;
 }
 
 static
-int newParticleArray(const std::vector<Particle> &particles,
-  const std::string &arrayName, vtkFloatArray *&fa)
+int newParticleArray(const ParticleArrays &particles,
+  const std::string &arrayName, BlockCache &cache, AllocationCounter &allocs,
+  vtkDataArray *&da)
 {
-  enum {PID, VEL, VELMAG};
+  da = nullptr;
 
-  fa = vtkFloatArray::New();
+  vtkIdType np = particles.size();
 
-  int aid = PID;
-  if (arrayName == "pid")
+  if (arrayName == "id")
     {
-    aid = PID;
-    }
-  else if (arrayName == "velocity")
-    {
-    aid = VEL;
-    fa->SetNumberOfComponents(3);
-    }
-  else if (arrayName == "velocityMagnitude")
-    {
-    aid = VELMAG;
-    }
-  else
-    {
-    SENSEI_ERROR("Invalid array name \"" << arrayName << "\"")
-    return -1;
+    // the ids are copied, the vector reallocates and is reordered as
+    // particles move between blocks while consumers may hold the array
+    vtkIntArray *ia = cache.ParticleIds;
+    if (!reusable(ia, np))
+      {
+      ia = static_cast<vtkIntArray*>(
+        sensei::ArrayPool::NewArray(VTK_INT, np, 1, "id"));
+      cache.ParticleIds.TakeReference(ia);
+      allocs.Add(ia);
+      }
+
+    std::copy(particles.id.begin(), particles.id.end(), ia->GetPointer(0));
+    ia->Modified();
+
+    da = ia;
+    return 0;
     }
 
-  unsigned int np = particles.size();
+  const float *pvx = particles.vx.data();
+  const float *pvy = particles.vy.data();
+  const float *pvz = particles.vz.data();
+
+  if (arrayName == "velocity")
+    {
+    // the velocity is interleaved. the cached array is overwritten unless
+    // the count changed or a previous step's mesh is still alive
+    vtkFloatArray *fa = cache.Velocity;
+    if (!reusable(fa, np))
+      {
+      fa = static_cast<vtkFloatArray*>(
+        sensei::ArrayPool::NewArray(VTK_FLOAT, np, 3, "velocity"));
+      cache.Velocity.TakeReference(fa);
+      allocs.Add(fa);
+      }
 
-  fa->SetName(arrayName.c_str());
-  fa->SetNumberOfTuples(np);
+    float *pfa = fa->GetPointer(0);
+    for (vtkIdType i = 0; i < np; ++i)
+      {
+      pfa[3*i] = pvx[i];
+      pfa[3*i+1] = pvy[i];
+      pfa[3*i+2] = pvz[i];
+      }
+    fa->Modified();
 
-  float *pfa = fa->GetPointer(0);
+    da = fa;
+    return 0;
+    }
 
-  for (unsigned int i = 0; i < np; ++i)
+  if (arrayName == "velocityMagnitude")
     {
-    switch (aid)
+    vtkFloatArray *fa = cache.VelocityMagnitude;
+    if (!reusable(fa, np))
       {
-      case PID:
-        pfa[i] = particles[i].id;
-        break;
-      case VEL:
-        pfa[3*i] = particles[i].velocity[0];
-        pfa[3*i+1] = particles[i].velocity[1];
-        pfa[3*i+2] = particles[i].velocity[2];
-        break;
-      case VELMAG:
-        {
-        float vx = particles[i].velocity[0];
-        float vy = particles[i].velocity[1];
-        float vz = particles[i].velocity[2];
-        pfa[i] = sqrt(vx*vx + vy*vy + vz*vz);
-        }
-        break;
+      fa = static_cast<vtkFloatArray*>(
+        sensei::ArrayPool::NewArray(VTK_FLOAT, np, 1, "velocityMagnitude"));
+      cache.VelocityMagnitude.TakeReference(fa);
+      allocs.Add(fa);
       }
+
+    float *pfa = fa->GetPointer(0);
+    for (vtkIdType i = 0; i < np; ++i)
+      pfa[i] = sqrt(pvx[i]*pvx[i] + pvy[i]*pvy[i] + pvz[i]*pvz[i]);
+    fa->Modified();
+
+    da = fa;
+    return 0;
     }
 
-  return 0;
+  SENSEI_ERROR("Invalid array name \"" << arrayName << "\"")
+  return -1;
 }
 
 static
@@ -333,19 +493,22 @@ namespace oscillators
 struct DataAdaptor::InternalsType
 {
   InternalsType() : NumBlocks(0), Origin{},
-    Spacing{1,1,1}, Shape{}, NumGhostCells(0) {}
+    Spacing{1,1,1}, Shape{}, NumGhostCells(0), Verbose(0) {}
 
   long NumBlocks;                                   // total number of blocks on all ranks
   sdiy::DiscreteBounds DomainExtent;                 // global index space
   std::map<long, sdiy::DiscreteBounds> BlockExtents; // local block extents, indexed by global block id
   std::map<long, float*> BlockData;                 // local data array, indexed by block id
-  std::map<long, const std::vector<Particle>*> ParticleData;
+  std::map<long, const ParticleArrays*> ParticleData;
+  std::map<long, BlockCache> Cache;                 // arrays reused across steps, indexed by block id
+  AllocationCounter Allocations;                    // array allocations made this step
 
   double Origin[3];                                 // lower left corner of simulation domain
   double Spacing[3];                                // mesh spacing
 
   int Shape[3];
   int NumGhostCells;                                // number of ghost cells
+  int Verbose;                                      // report allocations each step
 };
 
 //-----------------------------------------------------------------------------
@@ -393,6 +556,18 @@ void DataAdaptor::Initialize(size_t nblocks, size_t n_local_blocks,
     }
 }
 
+//-----------------------------------------------------------------------------
+void DataAdaptor::SetVerbose(int val)
+{
+  this->Internals->Verbose = val;
+}
+
+//-----------------------------------------------------------------------------
+int DataAdaptor::GetVerbose()
+{
+  return this->Internals->Verbose;
+}
+
 //-----------------------------------------------------------------------------
 void DataAdaptor::SetBlockExtent(int gid, int xmin, int xmax, int ymin,
    int ymax, int zmin, int zmax)
@@ -426,7 +601,7 @@ void DataAdaptor::SetBlockData(int gid, float* data)
 }
 
 //-----------------------------------------------------------------------------
-void DataAdaptor::SetParticleData(int gid, const std::vector<Particle> &particles)
+void DataAdaptor::SetParticleData(int gid, const ParticleArrays &particles)
 {
   this->Internals->ParticleData[gid] = &particles;
 }
@@ -437,6 +612,54 @@ int DataAdaptor::GetMesh(const std::string &meshName, bool structureOnly,
 {
   mesh = nullptr;
 
+  vtkMultiBlockDataSet *mb = nullptr;
+  if (this->NewMesh(meshName, structureOnly, sensei::MeshSelection(), mb))
+    return -1;
+
+  mesh = mb;
+
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+int DataAdaptor::GetMesh(const std::string &meshName, bool structureOnly,
+    const std::vector<int> &blockIds, vtkCompositeDataSet *&mesh)
+{
+  mesh = nullptr;
+
+  sensei::MeshSelection sel;
+  sel.SetBlockIds(blockIds);
+
+  vtkMultiBlockDataSet *mb = nullptr;
+  if (this->NewMesh(meshName, structureOnly, sel, mb))
+    return -1;
+
+  mesh = mb;
+
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+int DataAdaptor::GetMesh(const std::string &meshName, bool structureOnly,
+    const sensei::MeshSelection &sel, vtkCompositeDataSet *&mesh)
+{
+  mesh = nullptr;
+
+  vtkMultiBlockDataSet *mb = nullptr;
+  if (this->NewMesh(meshName, structureOnly, sel, mb))
+    return -1;
+
+  mesh = mb;
+
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+int DataAdaptor::NewMesh(const std::string &meshName, bool structureOnly,
+    const sensei::MeshSelection &sel, vtkMultiBlockDataSet *&mb)
+{
+  mb = nullptr;
+
   if ((meshName != "mesh") && (meshName != "ucdmesh") && (meshName != "particles"))
     {
     SENSEI_ERROR("the miniapp provides meshes named \"mesh\", \"ucdmesh\","
@@ -447,18 +670,49 @@ int DataAdaptor::GetMesh(const std::string &meshName, bool structureOnly,
   int particleBlocks = meshName == "particles";
   int unstructuredBlocks = particleBlocks ? 0 : meshName == "ucdmesh";
 
-  vtkMultiBlockDataSet *mb = vtkMultiBlockDataSet::New();
+  // the cells of the Cartesian blocks may be subset, in which case the
+  // blocks are placed on the coarsened grid
+  bool subsetCells = (meshName == "mesh") && sel.CellsSelected();
+
+  double origin[3];
+  double spacing[3];
+  if (subsetCells)
+    sel.GetCoarseGeometry(this->Internals->Origin, this->Internals->Spacing,
+      origin, spacing);
+
+  mb = vtkMultiBlockDataSet::New();
   mb->SetNumberOfBlocks(this->Internals->NumBlocks);
 
   auto it = this->Internals->BlockExtents.begin();
   auto end = this->Internals->BlockExtents.end();
   for (; it != end; ++it)
     {
+    // blocks that were not selected are left empty
+    if (sel.BlocksSelected())
+      {
+      double bounds[6];
+      getBlockBounds(it->second, this->Internals->Origin,
+        this->Internals->Spacing, bounds);
+
+      if (!sel.SelectBlock(it->first, bounds))
+        continue;
+      }
+
+    int blockExt[6];
+    int cellExt[6];
+    if (subsetCells)
+      {
+      getBlockExtent(it->second, blockExt);
+      if (!sel.GetCellExtent(blockExt, cellExt))
+        continue;
+      }
+
     if (particleBlocks)
       {
       vtkPolyData *pd =
         newParticleBlock(this->Internals->ParticleData[it->first],
-        structureOnly);
+        structureOnly, this->Internals->Cache[it->first],
+        this->Internals->Allocations);
 
       mb->SetBlock(it->first, pd);
       pd->Delete();
@@ -466,11 +720,30 @@ int DataAdaptor::GetMesh(const std::string &meshName, bool structureOnly,
     else if (unstructuredBlocks)
       {
       vtkUnstructuredGrid *ug = newUnstructuredBlock(this->Internals->Origin,
-        this->Internals->Spacing, it->second, structureOnly);
+        this->Internals->Spacing, it->second, structureOnly,
+        this->Internals->Cache[it->first], this->Internals->Allocations);
 
       mb->SetBlock(it->first, ug);
       ug->Delete();
       }
+    else if (subsetCells)
+      {
+      int coarseExt[6];
+      sel.GetCoarseExtent(cellExt, coarseExt);
+
+      sdiy::DiscreteBounds ext = it->second;
+      for (int i = 0; i < 3; ++i)
+        {
+        ext.min[i] = coarseExt[2*i];
+        ext.max[i] = coarseExt[2*i+1];
+        }
+
+      vtkImageData *id = newCartesianBlock(origin, spacing, ext,
+        structureOnly);
+
+      mb->SetBlock(it->first, id);
+      id->Delete();
+      }
     else
       {
       vtkImageData *id = newCartesianBlock(this->Internals->Origin,
@@ -481,14 +754,21 @@ int DataAdaptor::GetMesh(const std::string &meshName, bool structureOnly,
       }
     }
 
-  mesh = mb;
-
   return 0;
 }
 
 //-----------------------------------------------------------------------------
 int DataAdaptor::AddArray(vtkDataObject* mesh, const std::string &meshName,
     int association, const std::string &arrayName)
+{
+  return this->AddArray(mesh, meshName, association, arrayName,
+    sensei::MeshSelection());
+}
+
+//-----------------------------------------------------------------------------
+int DataAdaptor::AddArray(vtkDataObject* mesh, const std::string &meshName,
+    int association, const std::string &arrayName,
+    const sensei::MeshSelection &sel)
 {
   vtkMultiBlockDataSet *mb = dynamic_cast<vtkMultiBlockDataSet*>(mesh);
   if (!mb)
@@ -531,6 +811,9 @@ int DataAdaptor::AddArray(vtkDataObject* mesh, const std::string &meshName,
     return -1;
     }
 
+  // the cells of the Cartesian blocks may be subset
+  bool subsetCells = (meshName == "mesh") && sel.CellsSelected();
+
   auto it = this->Internals->BlockData.begin();
   auto end = this->Internals->BlockData.end();
   for (; it != end; ++it)
@@ -539,33 +822,75 @@ int DataAdaptor::AddArray(vtkDataObject* mesh, const std::string &meshName,
     // because they both have the same number of cells and are in the
     // same order
     vtkDataObject *blk = mb->GetBlock(it->first);
+
+    // skip blocks left out by a request for a subset of the blocks
     if (!blk)
-      {
-      SENSEI_ERROR("encountered empty block at index " << it->first)
-      return -1;
-      }
+      continue;
+
+    BlockCache &cache = this->Internals->Cache[it->first];
 
-    vtkFloatArray *fa = nullptr;
+    vtkDataArray *da = nullptr;
     vtkDataSetAttributes *dsa = nullptr;
 
-    if (meshId == BLOCK)
+    if (subsetCells)
       {
       dsa = blk->GetAttributes(vtkDataObject::CELL);
-      vtkIdType nCells = getBlockNumCells(this->Internals->BlockExtents[it->first]);
+      const sdiy::DiscreteBounds &ext = this->Internals->BlockExtents[it->first];
 
-      // zero coopy the array
-      fa = vtkFloatArray::New();
+      int blockExt[6];
+      int cellExt[6];
+      getBlockExtent(ext, blockExt);
+      sel.GetCellExtent(blockExt, cellExt);
+
+      // copy the selected cells
+      vtkFloatArray *fa = vtkFloatArray::New();
       fa->SetName("data");
-      fa->SetArray(it->second, nCells, 1);
+      fa->SetNumberOfTuples(getNumSelectedCells(cellExt, sel.GetStride()));
+
+      gatherCells(it->second, ext, cellExt, sel.GetStride(),
+        fa->GetPointer(0));
+
+      this->Internals->Allocations.Add(fa);
+      dsa->AddArray(fa);
+      fa->Delete();
+
+      continue;
+      }
+    else if (meshId == BLOCK)
+      {
+      dsa = blk->GetAttributes(vtkDataObject::CELL);
+      vtkIdType nCells = getBlockNumCells(this->Internals->BlockExtents[it->first]);
+
+      // zero coopy the array. the simulation's buffer does not move so
+      // the wrapper is made once
+      vtkFloatArray *fa = cache.Data;
+      if (!fa || (fa->GetPointer(0) != it->second) ||
+        (fa->GetNumberOfTuples() != nCells))
+        {
+        fa = vtkFloatArray::New();
+        fa->SetName("data");
+        fa->SetArray(it->second, nCells, 1);
+        cache.Data.TakeReference(fa);
+        }
+      da = fa;
       }
     else
       {
       dsa = blk->GetAttributes(vtkDataObject::POINT);
-      newParticleArray(*this->Internals->ParticleData[it->first], arrayName, fa);
+
+      const ParticleArrays *particles = this->Internals->ParticleData[it->first];
+      if (!particles)
+        {
+        SENSEI_ERROR("No particles for block " << it->first)
+        return -1;
+        }
+
+      if (newParticleArray(*particles, arrayName, cache,
+        this->Internals->Allocations, da))
+        return -1;
       }
 
-    dsa->AddArray(fa);
-    fa->Delete();
+    dsa->AddArray(da);
     }
 
   return 0;
@@ -574,6 +899,13 @@ int DataAdaptor::AddArray(vtkDataObject* mesh, const std::string &meshName,
 
 //----------------------------------------------------------------------------
 int DataAdaptor::AddGhostCellsArray(vtkDataObject *mesh, const std::string &meshName)
+{
+  return this->AddGhostCellsArray(mesh, meshName, sensei::MeshSelection());
+}
+
+//----------------------------------------------------------------------------
+int DataAdaptor::AddGhostCellsArray(vtkDataObject *mesh,
+  const std::string &meshName, const sensei::MeshSelection &sel)
 {
   if ((meshName != "mesh") && (meshName != "ucdmesh"))
     {
@@ -589,6 +921,9 @@ int DataAdaptor::AddGhostCellsArray(vtkDataObject *mesh, const std::string &mesh
     return -1;
     }
 
+  // the cells of the Cartesian blocks may be subset
+  bool subsetCells = (meshName == "mesh") && sel.CellsSelected();
+
   auto it = this->Internals->BlockExtents.begin();
   auto end = this->Internals->BlockExtents.end();
   for (; it != end; ++it)
@@ -597,19 +932,47 @@ int DataAdaptor::AddGhostCellsArray(vtkDataObject *mesh, const std::string &mesh
     // because they both have the same number of cells and are in the
     // same order
     vtkDataObject *blk = mb->GetBlock(it->first);
+
+    // skip blocks left out by a request for a subset of the blocks
     if (!blk)
+      continue;
+
+    vtkDataSetAttributes *dsa = blk->GetAttributes(vtkDataObject::CELL);
+
+    // the ghost cells are static, they are generated once and shared
+    BlockCache &cache = this->Internals->Cache[it->first];
+    if (!cache.Ghosts)
       {
-      SENSEI_ERROR("encountered empty block at index " << it->first)
-      return -1;
+      vtkUnsignedCharArray *ga = newGhostCellsArray(this->Internals->Shape,
+        it->second, this->Internals->NumGhostCells);
+
+      cache.Ghosts.TakeReference(ga);
+      this->Internals->Allocations.Add(ga);
       }
 
-    vtkDataSetAttributes *dsa = blk->GetAttributes(vtkDataObject::CELL);
+    if (subsetCells)
+      {
+      int blockExt[6];
+      int cellExt[6];
+      getBlockExtent(it->second, blockExt);
+      sel.GetCellExtent(blockExt, cellExt);
+
+      // copy the selected cells
+      vtkUnsignedCharArray *ga = vtkUnsignedCharArray::New();
+      ga->SetName("vtkGhostType");
+      ga->SetNumberOfTuples(getNumSelectedCells(cellExt, sel.GetStride()));
+
+      gatherCells(cache.Ghosts->GetPointer(0), it->second, cellExt,
+        sel.GetStride(), ga->GetPointer(0));
 
-    vtkUnsignedCharArray *ga = newGhostCellsArray(this->Internals->Shape,
-      it->second, this->Internals->NumGhostCells);
+      this->Internals->Allocations.Add(ga);
+      dsa->AddArray(ga);
+      ga->Delete();
 
-    dsa->AddArray(ga);
-    ga->Delete();
+      continue;
+      }
+
+    dsa->AddArray(cache.Ghosts);
     }
 
   return 0;
@@ -754,6 +1117,25 @@ int DataAdaptor::GetMeshMetadata(unsigned int id, sensei::MeshMetadataPtr &metad
 //-----------------------------------------------------------------------------
 int DataAdaptor::ReleaseData()
 {
+  // report the array allocations made during this step. in the steady
+  // state only particle arrays whose size changed or that are still held
+  // by an analysis from a previous step are allocated
+  AllocationCounter &allocs = this->Internals->Allocations;
+
+  if (this->Internals->Verbose)
+    {
+    long long counts[2] = {allocs.Count, allocs.Bytes};
+    long long totals[2] = {0ll, 0ll};
+
+    MPI_Reduce(counts, totals, 2, MPI_LONG_LONG, MPI_SUM, 0,
+      this->GetCommunicator());
+
+    SENSEI_STATUS("oscillators::DataAdaptor step " << this->GetDataTimeStep()
+      << " array allocations " << totals[0] << " (" << totals[1] << " bytes)")
+    }
+
+  allocs.Clear();
+
   return 0;
 }
 
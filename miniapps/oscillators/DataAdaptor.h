@@ -5,7 +5,10 @@
 
 #include "Particles.h"
 
+#include <vector>
+
 class vtkDataArray;
+class vtkMultiBlockDataSet;
 
 namespace oscillators
 {
@@ -25,6 +28,11 @@ public:
     int domain_shape_z, int *gid, int *from_x, int *from_y, int *from_z,
     int *to_x, int *to_y, int *to_z, int *shape, int ghostLevels);
 
+  /// When set, the number and size of the arrays allocated on all ranks
+  /// are reported each step.
+  void SetVerbose(int val);
+  int GetVerbose();
+
   /// Set the extents for local blocks.
   void SetBlockExtent(int gid, int xmin, int xmax, int ymin,
     int ymax, int zmin, int zmax);
@@ -37,21 +45,43 @@ public:
   void SetBlockData(int gid, float* data);
 
   /// Set particles for a specific block
-  void SetParticleData(int gid, const std::vector<Particle> &particles);
+  void SetParticleData(int gid, const ParticleArrays &particles);
 
   // SENSEI API
   int GetNumberOfMeshes(unsigned int &numMeshes) override;
 
   int GetMeshMetadata(unsigned int id, sensei::MeshMetadataPtr &md) override;
 
+  using sensei::DataAdaptor::GetMesh;
+
   int GetMesh(const std::string &meshName, bool structureOnly,
     vtkDataObject *&mesh) override;
 
+  /// Only the listed blocks are generated, the others are left empty.
+  int GetMesh(const std::string &meshName, bool structureOnly,
+    const std::vector<int> &blockIds, vtkCompositeDataSet *&mesh) override;
+
+  /// Only the selected blocks are generated. The sub-extent and stride
+  /// are honored on the Cartesian mesh named "mesh".
+  int GetMesh(const std::string &meshName, bool structureOnly,
+    const sensei::MeshSelection &sel, vtkCompositeDataSet *&mesh) override;
+
+  using sensei::DataAdaptor::AddArray;
+
   int AddArray(vtkDataObject* mesh, const std::string &meshName,
     int association, const std::string &arrayName) override;
 
+  int AddArray(vtkDataObject* mesh, const std::string &meshName,
+    int association, const std::string &arrayName,
+    const sensei::MeshSelection &sel) override;
+
+  using sensei::DataAdaptor::AddGhostCellsArray;
+
   int AddGhostCellsArray(vtkDataObject* mesh, const std::string &meshName) override;
 
+  int AddGhostCellsArray(vtkDataObject* mesh, const std::string &meshName,
+    const sensei::MeshSelection &sel) override;
+
   int ReleaseData() override;
 
 protected:
@@ -62,6 +92,10 @@ protected:
 
   vtkDataObject* GetParticlesBlock(int gid, bool structureOnly);
 
+  /// Generate the selected part of the named mesh.
+  int NewMesh(const std::string &meshName, bool structureOnly,
+    const sensei::MeshSelection &sel, vtkMultiBlockDataSet *&mesh);
+
 private:
   DataAdaptor(const DataAdaptor&); // not implemented.
   void operator=(const DataAdaptor&); // not implemented.
@@ -11,35 +11,40 @@ struct Oscillator
 
     static constexpr float pi = 3.14159265358979323846;
 
-    float evaluate(const Vertex &v, float t) const
+    // the time dependent part of the oscillator, f(x, t) = a(t) * g(x)
+    float amplitude(float t) const
     {
         t *= 2*pi;
 
-        float dist2 = (center - v).norm();
-        float dist_damp = exp(-dist2/(2*radius*radius));
-
         if (type == damped)
         {
             float phi   = acos(zeta);
             float val   = 1. - exp(-zeta*omega0*t) * (sin(sqrt(1-zeta*zeta)*omega0*t + phi) / sin(phi));
-            return val * dist_damp;
+            return val;
         }
         else if (type == decaying)
         {
             t += 1. / omega0;
             float val = sin(t / omega0) / (omega0 * t);
-            return val * dist_damp;
+            return val;
         }
         else if (type == periodic)
         {
             t += 1. / omega0;
             float val = sin(t / omega0);
-            return val * dist_damp;
+            return val;
         }
 
         return 0.0f; // impossible
     }
 
+    float evaluate(const Vertex &v, float t) const
+    {
+        float dist2 = (center - v).norm();
+        float dist_damp = exp(-dist2/(2*radius*radius));
+        return amplitude(t) * dist_damp;
+    }
+
     Vertex evaluateGradient(const Vertex& x, float t) const
     {
         // let f(x, t) = this->evaluate(x,t) = o(t) * g(x)
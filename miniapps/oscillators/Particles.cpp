@@ -23,6 +23,87 @@ sdiy::DiscreteBounds remove_ghosts(const sdiy::DiscreteBounds &domain,
 }
 
 // --------------------------------------------------------------------------
+void ParticleArrays::reserve(size_t n)
+{
+    id.reserve(n);
+    x.reserve(n);
+    y.reserve(n);
+    z.reserve(n);
+    vx.reserve(n);
+    vy.reserve(n);
+    vz.reserve(n);
+}
+
+// --------------------------------------------------------------------------
+void ParticleArrays::clear()
+{
+    id.clear();
+    x.clear();
+    y.clear();
+    z.clear();
+    vx.clear();
+    vy.clear();
+    vz.clear();
+}
+
+// --------------------------------------------------------------------------
+void ParticleArrays::push_back(const Particle &p)
+{
+    id.push_back(p.id);
+    x.push_back(p.position[0]);
+    y.push_back(p.position[1]);
+    z.push_back(p.position[2]);
+    vx.push_back(p.velocity[0]);
+    vy.push_back(p.velocity[1]);
+    vz.push_back(p.velocity[2]);
+}
+
+// --------------------------------------------------------------------------
+Particle ParticleArrays::get(size_t i) const
+{
+    Particle p;
+    p.id = id[i];
+    p.position = { x[i], y[i], z[i] };
+    p.velocity = { vx[i], vy[i], vz[i] };
+    return p;
+}
+
+// --------------------------------------------------------------------------
+void ParticleArrays::swap_remove(size_t i)
+{
+    size_t last = size() - 1;
+    if (i != last)
+    {
+        id[i] = id[last];
+        x[i] = x[last];
+        y[i] = y[last];
+        z[i] = z[last];
+        vx[i] = vx[last];
+        vy[i] = vy[last];
+        vz[i] = vz[last];
+    }
+
+    id.pop_back();
+    x.pop_back();
+    y.pop_back();
+    z.pop_back();
+    vx.pop_back();
+    vy.pop_back();
+    vz.pop_back();
+}
+
+// --------------------------------------------------------------------------
+void ParticleArrays::erase(size_t i)
+{
+    id.erase(id.begin() + i);
+    x.erase(x.begin() + i);
+    y.erase(y.begin() + i);
+    z.erase(z.begin() + i);
+    vx.erase(vx.begin() + i);
+    vy.erase(vy.begin() + i);
+    vz.erase(vz.begin() + i);
+}
+
 // --------------------------------------------------------------------------
 std::ostream &operator<<(std::ostream &os, const Particle &particle)
 {
@@ -32,3 +113,12 @@ std::ostream &operator<<(std::ostream &os, const Particle &particle)
         << "))";
     return os;
 }
+
+// --------------------------------------------------------------------------
+std::ostream &operator<<(std::ostream &os, const ParticleArrays &particles)
+{
+    size_t n = particles.size();
+    for (size_t i = 0; i < n; ++i)
+        os << "    " << particles.get(i) << std::endl;
+    return os;
+}
@@ -6,6 +6,8 @@
 
 #include <random>
 #include <vector>
+#include <ostream>
+#include <cstddef>
 
 
 // container for a single particle
@@ -19,6 +21,37 @@ struct Particle
 // put the particle in the stream in human readable format
 std::ostream &operator<<(std::ostream &os, const Particle &particle);
 
+// container for a collection of particles stored as a structure of arrays
+// so that loops over a single quantity are contiguous and vectorize
+struct ParticleArrays
+{
+    size_t size() const { return id.size(); }
+    bool empty() const { return id.empty(); }
+
+    void reserve(size_t n);
+    void clear();
+
+    // append a particle
+    void push_back(const Particle &p);
+
+    // get a copy of the i'th particle
+    Particle get(size_t i) const;
+
+    // remove the i'th particle by moving the last particle into its slot.
+    // this is O(1) but does not preserve order
+    void swap_remove(size_t i);
+
+    // remove the i'th particle preserving the order of the rest
+    void erase(size_t i);
+
+    std::vector<int> id;
+    std::vector<float> x, y, z;
+    std::vector<float> vx, vy, vz;
+};
+
+// put the particles in the stream in human readable format
+std::ostream &operator<<(std::ostream &os, const ParticleArrays &particles);
+
 // strips the ghost zones from the block, returns a copy
 // with ghosts removed. ghost zones don't go outside of the
 // computational domain.
@@ -66,7 +99,7 @@ sdiy::Bounds<coord_type> world_space_bounds(const sdiy::DiscreteBounds &domain,
 
 // gerate count particles
 template<typename coord_type>
-std::vector<Particle> GenerateRandomParticles(std::default_random_engine& rng,
+ParticleArrays GenerateRandomParticles(std::default_random_engine& rng,
     const sdiy::DiscreteBounds &domain, const sdiy::DiscreteBounds &gbounds,
     const sdiy::Point<coord_type,3> &origin, const sdiy::Point<coord_type,3> &spacing,
     int nghost, int startId, int count)
@@ -78,7 +111,8 @@ std::vector<Particle> GenerateRandomParticles(std::default_random_engine& rng,
     std::uniform_real_distribution<coord_type> rgy(world_bounds.min[1], world_bounds.max[1]);
     std::uniform_real_distribution<coord_type> rgz(world_bounds.min[2], world_bounds.max[2]);
 
-    std::vector<Particle> particles;
+    ParticleArrays particles;
+    particles.reserve(count);
     for (int i = 0; i < count; ++i)
     {
         Particle p;
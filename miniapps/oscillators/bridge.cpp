@@ -19,7 +19,7 @@ int initialize(size_t nblocks, size_t n_local_blocks,
   float *origin, float *spacing, int domain_shape_x, int domain_shape_y,
   int domain_shape_z, int *gid, int *from_x, int *from_y, int *from_z,
   int *to_x, int *to_y, int *to_z, int *shape, int ghostLevels,
-  const std::string &config_file)
+  const std::string &config_file, int verbose)
 {
   sensei::TimeEvent<128> mark("oscillators::bridge::initialize");
 
@@ -29,6 +29,8 @@ int initialize(size_t nblocks, size_t n_local_blocks,
     domain_shape_x, domain_shape_y, domain_shape_z, gid, from_x, from_y,
     from_z, to_x, to_y, to_z, shape, ghostLevels);
 
+  DataAdaptor->SetVerbose(verbose);
+
   AnalysisAdaptor = vtkSmartPointer<sensei::ConfigurableAnalysis>::New();
   if (AnalysisAdaptor->Initialize(config_file))
     {
@@ -46,7 +48,7 @@ void set_data(int gid, float* data)
 }
 
 //-----------------------------------------------------------------------------
-void set_particles(int gid, const std::vector<Particle> &particles)
+void set_particles(int gid, const ParticleArrays &particles)
 {
   DataAdaptor->SetParticleData(gid, particles);
 }
@@ -88,6 +88,8 @@ int main(int argc, char** argv)
     ;
     bool sync = ops >> Present("sync", "synchronize after each time step");
     bool verbose = ops >> Present("verbose", "print debugging messages");
+    bool reference_kernels = ops >> Present("reference-kernels",
+        "use the original unoptimized field update and particle advection");
 
     std::string infn;
     if (  ops >> Present('h', "help", "show help") ||
@@ -210,7 +212,8 @@ int main(int argc, char** argv)
                        const sdiy::DiscreteBounds &domain, const Link& link)
                    {
                       Block *b = new Block(gid, bounds, domain, origin,
-                        spacing, ghostCells, oscillators, velocity_scale);
+                        spacing, ghostCells, oscillators, velocity_scale,
+                        reference_kernels);
 
                       // generate particles
                       int start = particlesPerBlock * gid;
@@ -249,7 +252,7 @@ int main(int argc, char** argv)
                        &from_x[0], &from_y[0], &from_z[0],
                        &to_x[0],   &to_y[0],   &to_z[0],
                        &shape[0], ghostCells,
-                       config_file);
+                       config_file, verbose);
 #else
     init_analysis(world, window, gids.size(),
                   domain.max[0] + 1, domain.max[1] + 1, domain.max[2] + 1,
@@ -266,13 +269,6 @@ int main(int argc, char** argv)
         if (verbose && (world.rank() == 0))
             std::cerr << "started step = " << t_count << " t = " << t << std::endl;
 
-        sensei::Profiler::StartEvent("oscillators::update_fields");
-        master.foreach([=](Block* b, const Proxy&)
-                              {
-                                b->update_fields(t);
-                              });
-        sensei::Profiler::EndEvent("oscillators::update_fields");
-
         sensei::Profiler::StartEvent("oscillators::move_particles");
         master.foreach([=](Block* b, const Proxy& p)
                               {
@@ -280,12 +276,22 @@ int main(int argc, char** argv)
                               });
         sensei::Profiler::EndEvent("oscillators::move_particles");
 
+        // particles move with their own velocity, so the fields are updated
+        // while the particles leaving each block are in flight
         sensei::Profiler::StartEvent("oscillators::master.exchange");
-        master.exchange();
+        auto exchange = master.start_exchange();
         sensei::Profiler::EndEvent("oscillators::master.exchange");
 
+        sensei::Profiler::StartEvent("oscillators::update_fields");
+        master.foreach([=](Block* b, const Proxy&)
+                              {
+                                b->update_fields(t);
+                              });
+        sensei::Profiler::EndEvent("oscillators::update_fields");
+
+        // blocks take their particles as soon as they have arrived
         sensei::Profiler::StartEvent("oscillators::handle_incoming_particles");
-        master.foreach([=](Block* b, const Proxy& p)
+        master.foreach_exchange(exchange, [=](Block* b, const Proxy& p)
                               {
                                 b->handle_incoming_particles(p);
                               });
@@ -338,6 +344,10 @@ int main(int argc, char** argv)
         if (sync)
             world.barrier();
 
+        // in summary mode the profiler periodically reduces and writes its
+        // statistics. every rank takes every step, so this is safe here
+        sensei::Profiler::EndStep();
+
         t += dt;
         ++t_count;
     }
@@ -0,0 +1,358 @@
+// checks the MeshSelection handling of the oscillator's data adaptor and
+// of the DataAdaptor defaults. the blocks of a Cartesian mesh hold a
+// function of the global cell index. meshes are requested by block ids,
+// bounds, sub-extent, and stride, and the blocks, their extents, the
+// number of cells, and the data and ghost values delivered are compared
+// against the cells picked out of the full mesh here.
+//
+// usage: testOscillatorSelection
+
+#include "../DataAdaptor.h"
+#include "MeshSelection.h"
+
+#include <vtkDataObject.h>
+#include <vtkImageData.h>
+#include <vtkMultiBlockDataSet.h>
+#include <vtkCompositeDataSet.h>
+#include <vtkCellData.h>
+#include <vtkFloatArray.h>
+#include <vtkUnsignedCharArray.h>
+
+#include <mpi.h>
+
+#include <algorithm>
+#include <array>
+#include <vector>
+#include <string>
+#include <iostream>
+
+using std::cerr;
+using std::endl;
+
+using Extent = std::array<int,6>;
+
+// the value at a global cell index
+float f(int i, int j, int k)
+{
+  return i + 100.0f*j + 10000.0f*k;
+}
+
+// the mesh, 2 by 2 blocks of 6 by 5 by 8 cells
+const int nBlocks = 4;
+const int domainShape[3] = {12, 10, 8};
+
+Extent blockExtent(int b)
+{
+  int ix = b % 2;
+  int iy = b / 2;
+  return {6*ix, 6*ix + 5, 5*iy, 5*iy + 4, 0, 7};
+}
+
+// --------------------------------------------------------------------------
+int checkMesh(const std::string &label, vtkCompositeDataSet *mesh,
+  const std::vector<int> &expectBlocks, const sensei::MeshSelection &sel,
+  vtkMultiBlockDataSet *full)
+{
+  vtkMultiBlockDataSet *mb = dynamic_cast<vtkMultiBlockDataSet*>(mesh);
+  if (!mb || (int(mb->GetNumberOfBlocks()) != nBlocks))
+    {
+    cerr << "ERROR: " << label << ": the mesh is not a multiblock with "
+      << nBlocks << " blocks" << endl;
+    return 1;
+    }
+
+  int nFailed = 0;
+  for (int b = 0; b < nBlocks; ++b)
+    {
+    bool expect = std::find(expectBlocks.begin(), expectBlocks.end(), b)
+      != expectBlocks.end();
+
+    vtkImageData *block = dynamic_cast<vtkImageData*>(mb->GetBlock(b));
+    if (!block != !expect)
+      {
+      cerr << "ERROR: " << label << ": block " << b << " is "
+        << (expect ? "missing" : "not expected") << endl;
+      ++nFailed;
+      continue;
+      }
+
+    if (!block)
+      continue;
+
+    // pick the selected cells out of the full block. the stride counts
+    // from the lower corner of the extent when there is one
+    const std::array<int,3> &stride = sel.GetStride();
+    Extent sub = blockExtent(b);
+    int base[3] = {0, 0, 0};
+    if (sel.ExtentSet())
+      {
+      const Extent &se = sel.GetExtent();
+      for (int q = 0; q < 3; ++q)
+        {
+        sub[2*q] = std::max(sub[2*q], se[2*q]);
+        sub[2*q+1] = std::min(sub[2*q+1], se[2*q+1]);
+        base[q] = se[2*q];
+        }
+      }
+
+    Extent fext = blockExtent(b);
+    long fnx = fext[1] - fext[0] + 1;
+    long fnxy = fnx*(fext[3] - fext[2] + 1);
+
+    vtkImageData *fullBlock = static_cast<vtkImageData*>(full->GetBlock(b));
+    vtkUnsignedCharArray *fullGhosts = dynamic_cast<vtkUnsignedCharArray*>(
+      fullBlock->GetCellData()->GetArray("vtkGhostType"));
+
+    std::vector<float> values;
+    std::vector<unsigned char> ghosts;
+    Extent cext = {1 << 30, -(1 << 30), 1 << 30, -(1 << 30), 1 << 30, -(1 << 30)};
+
+    for (int k = sub[4]; k <= sub[5]; ++k)
+      {
+      if ((k - base[2]) % stride[2])
+        continue;
+      for (int j = sub[2]; j <= sub[3]; ++j)
+        {
+        if ((j - base[1]) % stride[1])
+          continue;
+        for (int i = sub[0]; i <= sub[1]; ++i)
+          {
+          if ((i - base[0]) % stride[0])
+            continue;
+
+          values.push_back(f(i, j, k));
+
+          long q = (k - fext[4])*fnxy + (j - fext[2])*fnx + i - fext[0];
+          ghosts.push_back(fullGhosts->GetValue(q));
+
+          int idx[3] = {i, j, k};
+          for (int d = 0; d < 3; ++d)
+            {
+            int c = (idx[d] - base[d])/stride[d];
+            cext[2*d] = std::min(cext[2*d], c);
+            cext[2*d+1] = std::max(cext[2*d+1], c);
+            }
+          }
+        }
+      }
+
+    // cells are only subset when the selection asks for it
+    if (!sel.CellsSelected())
+      cext = fext;
+
+    int *ext = block->GetExtent();
+    for (int q = 0; q < 3; ++q)
+      {
+      if ((ext[2*q] != cext[2*q]) || (ext[2*q+1] != cext[2*q+1] + 1))
+        {
+        cerr << "ERROR: " << label << ": block " << b
+          << " has the wrong extent" << endl;
+        ++nFailed;
+        break;
+        }
+      }
+
+    long nCells = values.size();
+    if (block->GetNumberOfCells() != nCells)
+      {
+      cerr << "ERROR: " << label << ": block " << b << " has "
+        << block->GetNumberOfCells() << " cells expected " << nCells << endl;
+      ++nFailed;
+      continue;
+      }
+
+    vtkFloatArray *da = dynamic_cast<vtkFloatArray*>(
+      block->GetCellData()->GetArray("data"));
+
+    vtkUnsignedCharArray *ga = dynamic_cast<vtkUnsignedCharArray*>(
+      block->GetCellData()->GetArray("vtkGhostType"));
+
+    if (!da || !ga || (da->GetNumberOfTuples() != nCells) ||
+      (ga->GetNumberOfTuples() != nCells))
+      {
+      cerr << "ERROR: " << label << ": block " << b
+        << " is missing arrays or has the wrong number of values" << endl;
+      ++nFailed;
+      continue;
+      }
+
+    for (long q = 0; q < nCells; ++q)
+      {
+      if ((da->GetValue(q) != values[q]) || (ga->GetValue(q) != ghosts[q]))
+        {
+        cerr << "ERROR: " << label << ": block " << b << " cell " << q
+          << " has " << da->GetValue(q) << ", " << int(ga->GetValue(q))
+          << " expected " << values[q] << ", " << int(ghosts[q]) << endl;
+        ++nFailed;
+        break;
+        }
+      }
+    }
+
+  return nFailed;
+}
+
+// --------------------------------------------------------------------------
+int runCases(oscillators::DataAdaptor *da)
+{
+  int nFailed = 0;
+
+  // the full mesh, the reference
+  vtkDataObject *dobj = nullptr;
+  if (da->GetMesh("mesh", false, dobj) ||
+    da->AddArray(dobj, "mesh", vtkDataObject::CELL, "data") ||
+    da->AddGhostCellsArray(dobj, "mesh"))
+    {
+    cerr << "ERROR: failed to get the full mesh" << endl;
+    return 1;
+    }
+
+  vtkMultiBlockDataSet *full = static_cast<vtkMultiBlockDataSet*>(dobj);
+
+  nFailed += checkMesh("full", full, {0, 1, 2, 3},
+    sensei::MeshSelection(), full);
+
+  // a subset of the blocks by id
+  vtkCompositeDataSet *mesh = nullptr;
+  if (da->GetMesh("mesh", false, std::vector<int>({1, 2}), mesh) ||
+    da->AddArray(mesh, "mesh", vtkDataObject::CELL, "data") ||
+    da->AddGhostCellsArray(mesh, "mesh"))
+    {
+    cerr << "ERROR: failed to get blocks by id" << endl;
+    return 1;
+    }
+
+  nFailed += checkMesh("block ids", mesh, {1, 2}, sensei::MeshSelection(),
+    full);
+
+  mesh->Delete();
+
+  // selections handled by the adaptor
+  struct Case
+  {
+    std::string Label;
+    sensei::MeshSelection Sel;
+    std::vector<int> Blocks;
+  };
+
+  std::vector<Case> cases(5);
+
+  cases[0].Label = "bounds";
+  cases[0].Sel.SetBounds({0.5, 5.5, 0.5, 4.5, 0.0, 8.0});
+  cases[0].Blocks = {0};
+
+  cases[1].Label = "stride";
+  cases[1].Sel.SetStride({2, 3, 2});
+  cases[1].Blocks = {0, 1, 2, 3};
+
+  cases[2].Label = "extent and stride";
+  cases[2].Sel.SetExtent({3, 10, 2, 8, 1, 6});
+  cases[2].Sel.SetStride({2, 2, 3});
+  cases[2].Blocks = {0, 1, 2, 3};
+
+  cases[3].Label = "extent and ids";
+  cases[3].Sel.SetExtent({0, 4, 0, 3, 0, 7});
+  cases[3].Sel.SetBlockIds({0, 1});
+  cases[3].Blocks = {0};
+
+  cases[4].Label = "ids and stride";
+  cases[4].Sel.SetBlockIds({2, 3});
+  cases[4].Sel.SetStride({4, 4, 4});
+  cases[4].Blocks = {2, 3};
+
+  for (const Case &c : cases)
+    {
+    mesh = nullptr;
+    if (da->GetMesh("mesh", false, c.Sel, mesh) ||
+      da->AddArray(mesh, "mesh", vtkDataObject::CELL, "data", c.Sel) ||
+      da->AddGhostCellsArray(mesh, "mesh", c.Sel))
+      {
+      cerr << "ERROR: " << c.Label << ": failed to get the mesh" << endl;
+      return 1;
+      }
+
+    nFailed += checkMesh(c.Label, mesh, c.Blocks, c.Sel, full);
+
+    mesh->Delete();
+    }
+
+  // the default resolves bounds and extents to block ids using the
+  // metadata, and returns the selected blocks whole
+  for (int i = 0; i < 4; ++i)
+    {
+    if (!cases[i].Sel.BlocksSelected() && !cases[i].Sel.ExtentSet())
+      continue;
+
+    std::string label = cases[i].Label + " (default)";
+
+    mesh = nullptr;
+    if (da->sensei::DataAdaptor::GetMesh("mesh", false, cases[i].Sel, mesh) ||
+      da->AddArray(mesh, "mesh", vtkDataObject::CELL, "data") ||
+      da->AddGhostCellsArray(mesh, "mesh"))
+      {
+      cerr << "ERROR: " << label << ": failed to get the mesh" << endl;
+      return 1;
+      }
+
+    sensei::MeshSelection blocks;
+    blocks.SetBlockIds(cases[i].Blocks);
+
+    nFailed += checkMesh(label, mesh, cases[i].Blocks, blocks, full);
+
+    mesh->Delete();
+    }
+
+  full->Delete();
+
+  return nFailed;
+}
+
+// --------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+  MPI_Init(&argc, &argv);
+
+  float origin[3] = {0.0f, 0.0f, 0.0f};
+  float spacing[3] = {1.0f, 1.0f, 1.0f};
+  int shape[3] = {domainShape[0], domainShape[1], domainShape[2]};
+
+  int gid[nBlocks];
+  int from[3][nBlocks];
+  int to[3][nBlocks];
+  std::vector<std::vector<float>> data(nBlocks);
+
+  for (int b = 0; b < nBlocks; ++b)
+    {
+    Extent ext = blockExtent(b);
+    gid[b] = b;
+    for (int q = 0; q < 3; ++q)
+      {
+      from[q][b] = ext[2*q];
+      to[q][b] = ext[2*q+1];
+      }
+
+    for (int k = ext[4]; k <= ext[5]; ++k)
+      for (int j = ext[2]; j <= ext[3]; ++j)
+        for (int i = ext[0]; i <= ext[1]; ++i)
+          data[b].push_back(f(i, j, k));
+    }
+
+  oscillators::DataAdaptor *da = oscillators::DataAdaptor::New();
+  da->Initialize(nBlocks, nBlocks, origin, spacing, domainShape[0],
+    domainShape[1], domainShape[2], gid, from[0], from[1], from[2],
+    to[0], to[1], to[2], shape, 1);
+
+  for (int b = 0; b < nBlocks; ++b)
+    da->SetBlockData(b, data[b].data());
+
+  int nFailed = runCases(da);
+
+  da->ReleaseData();
+  da->Delete();
+
+  cerr << nFailed << " failed checks" << endl;
+
+  MPI_Finalize();
+
+  return nFailed ? -1 : 0;
+}
@@ -23,8 +23,15 @@
 #include "simulation_data.h"
 #include "patch.h"
 
+#include <map>
+#include <set>
+#include <vector>
+
 static const char *arrname = "vortex";
 
+template <typename array_t>
+using ArrayCache = std::map<int, vtkSmartPointer<array_t>>;
+
 struct VortexDataAdaptor::DInternals
 {
 #ifdef REPRESENT_VTK_AMR
@@ -33,8 +40,106 @@ struct VortexDataAdaptor::DInternals
   vtkSmartPointer<vtkMultiBlockDataSet> Mesh;
 #endif
   simulation_data *sim;
+
+  // the hierarchy is kept across steps and reused while the patches it
+  // was built from are unchanged. MeshValid is set once it has been
+  // checked this step.
+  std::vector<double> MeshStructure;
+  bool MeshValid;
+
+  // arrays of the local patches, keyed by patch id. they are pointed at
+  // the new simulation data each step. the ghost arrays of leaf patches
+  // own their buffers and are kept apart from those wrapping blanking data
+  ArrayCache<vtkFloatArray> Data;
+  ArrayCache<vtkUnsignedCharArray> Ghosts;
+  ArrayCache<vtkUnsignedCharArray> LeafGhosts;
+
+  DInternals() : sim(nullptr), MeshValid(false) {}
 };
 
+//-----------------------------------------------------------------------------
+// everything about the local patches that the hierarchy is built from
+static void getStructure(simulation_data *sim, std::vector<double> &st)
+{
+  st.clear();
+  st.push_back(sim->max_levels);
+  st.insert(st.end(), sim->npatches_per_level,
+    sim->npatches_per_level + sim->max_levels + 1);
+
+  int np = 0;
+  patch_t **patches_this_rank = patch_flat_array(&sim->patch, &np);
+  for(int i = 0; i < np; ++i)
+    {
+    patch_t *p = patches_this_rank[i];
+    st.push_back(p->id);
+    st.push_back(p->level);
+    st.push_back(p->owners[0]);
+    st.insert(st.end(), p->logical_extents, p->logical_extents + 6);
+    st.insert(st.end(), p->window, p->window + 6);
+    }
+  FREE(patches_this_rank);
+}
+
+//-----------------------------------------------------------------------------
+// get the cached array for the patch, a new one if it is shared elsewhere
+template <typename array_t>
+static array_t *getArray(ArrayCache<array_t> &cache, int id,
+  vtkDataSet *block, const char *name)
+{
+  block->GetCellData()->RemoveArray(name);
+
+  vtkSmartPointer<array_t> &arr = cache[id];
+  if (!arr || (arr->GetReferenceCount() > 1))
+    {
+    arr = vtkSmartPointer<array_t>::New();
+    arr->SetName(name);
+    }
+
+  return arr;
+}
+
+//-----------------------------------------------------------------------------
+// drop the cached arrays of patches that no longer exist
+template <typename array_t>
+static void pruneCache(ArrayCache<array_t> &cache, const std::set<int> &ids)
+{
+  typename ArrayCache<array_t>::iterator it = cache.begin();
+  while (it != cache.end())
+    {
+    if (ids.count(it->first))
+      ++it;
+    else
+      it = cache.erase(it);
+    }
+}
+
+//-----------------------------------------------------------------------------
+// If the patch has children, and blank data then expose that data as
+// vtkGhostType.
+static void setGhostArray(ArrayCache<vtkUnsignedCharArray> &ghosts,
+  ArrayCache<vtkUnsignedCharArray> &leafGhosts, patch_t *patch,
+  vtkDataSet *block)
+{
+  vtkUnsignedCharArray *arr = nullptr;
+  int sz = patch->nx*patch->ny*patch->nz;
+  if(patch->blank != nullptr)
+    {
+    leafGhosts.erase(patch->id);
+    arr = getArray(ghosts, patch->id, block, "vtkGhostType");
+    arr->SetArray(patch->blank, sz, 1);
+    }
+  else
+    {
+    // leaf patches won't have a blank array. the zeros go in a buffer the
+    // array owns, an array that wrapped freed blanking data is not reused
+    ghosts.erase(patch->id);
+    arr = getArray(leafGhosts, patch->id, block, "vtkGhostType");
+    arr->SetNumberOfTuples(sz);
+    memset(arr->GetVoidPointer(0), 0, sz * sizeof(unsigned char));
+    }
+  block->GetCellData()->AddArray(arr);
+}
+
 //-----------------------------------------------------------------------------
 senseiNewMacro(VortexDataAdaptor);
 
@@ -71,6 +176,44 @@ int VortexDataAdaptor::GetMesh(const std::string &meshName, bool /*structureOnly
     }
 
   DInternals& internals = (*this->Internals);
+
+  // reuse the hierarchy made in an earlier step when the patches are
+  // unchanged, only pointing the ghost arrays at the new blanking data.
+  // otherwise it is made again below.
+  if (internals.Mesh && !internals.MeshValid)
+    {
+    std::vector<double> structure;
+    getStructure(internals.sim, structure);
+
+    if ((structure == internals.MeshStructure) &&
+      (internals.Mesh->GetReferenceCount() == 1) &&
+      (internals.Mesh->GetAMRInfo()->GetReferenceCount() == 1))
+      {
+      int np = 0;
+      patch_t **patches_this_rank = patch_flat_array(&internals.sim->patch, &np);
+      for(int i = 0; i < np; ++i)
+        {
+        // Skip any duplicate patches not owned by this rank.
+        if((patches_this_rank[i]->nowners > 1) &&
+          (patches_this_rank[i]->owners[0] != internals.sim->par_rank))
+          continue;
+
+        unsigned int mylevel, mypatch;
+        internals.Mesh->GetLevelAndIndex(patches_this_rank[i]->id, mylevel, mypatch);
+
+        vtkDataSet *block = internals.Mesh->GetDataSet(mylevel, mypatch);
+        if(block)
+          setGhostArray(internals.Ghosts, internals.LeafGhosts,
+            patches_this_rank[i], block);
+        }
+      FREE(patches_this_rank);
+      }
+    else
+      {
+      internals.Mesh = nullptr;
+      }
+    }
+
   if (!internals.Mesh)
     {
 //#define DEBUG_GET_MESH
@@ -209,23 +352,8 @@ int VortexDataAdaptor::GetMesh(const std::string &meshName, bool /*structureOnly
                  );
         }
 #endif
-      // If the patch has children, and blank data then expose that data as
-      // vtkGhostType.
-      vtkUnsignedCharArray *arr = vtkUnsignedCharArray::New();
-      arr->SetName("vtkGhostType");
-      int sz = patches_this_rank[i]->nx*patches_this_rank[i]->ny*patches_this_rank[i]->nz;
-      if(patches_this_rank[i]->blank != nullptr)
-        {
-        arr->SetArray(patches_this_rank[i]->blank, sz, 1);
-        }
-      else
-        {
-        // leaf patches won't have a blank array.
-        arr->SetNumberOfTuples(sz);
-        memset(arr->GetVoidPointer(0), 0, sz * sizeof(unsigned char));
-        }
-      p->GetCellData()->AddArray(arr);
-      arr->FastDelete();
+      setGhostArray(internals.Ghosts, internals.LeafGhosts,
+        patches_this_rank[i], p);
 
       // Set the vtkUniformGrid into the AMR dataset.
       vtkAMRBox box(low, high);
@@ -251,10 +379,25 @@ int VortexDataAdaptor::GetMesh(const std::string &meshName, bool /*structureOnly
         fclose(f);
 #endif
     delete [] spacingSet;
+
+    // the patches changed, drop the arrays of those that are gone
+    std::set<int> ids;
+    for(int i = 0; i < np; ++i)
+      ids.insert(patches_this_rank[i]->id);
+
+    pruneCache(internals.Data, ids);
+    pruneCache(internals.Ghosts, ids);
+    pruneCache(internals.LeafGhosts, ids);
+
     FREE(patches_this_rank);
+
+    getStructure(internals.sim, internals.MeshStructure);
     }
 
+  internals.MeshValid = true;
+
   mesh = internals.Mesh;
+  mesh->Register(nullptr);
   return 0;
 }
 
@@ -301,14 +444,12 @@ int VortexDataAdaptor::AddArray(vtkDataObject* mesh, const std::string &meshName
       vtkDataArray *m = block->GetCellData()->GetArray(arrname);
       if(m == nullptr)
         {
-        vtkFloatArray *arr = vtkFloatArray::New();
-        arr->SetName(arrname);
+        vtkFloatArray *arr = getArray(internals.Data, domain, block, arrname);
         arr->SetArray(patches_this_rank[i]->data, 
                       patches_this_rank[i]->nx*patches_this_rank[i]->ny*patches_this_rank[i]->nz,
                       1);
         block->GetCellData()->SetScalars(arr);
         block->GetCellData()->SetActiveScalars(arrname);
-        arr->FastDelete();
         retVal = 0;
         }
       }
@@ -385,6 +526,28 @@ int VortexDataAdaptor::GetMeshMetadata(unsigned int id,
 int VortexDataAdaptor::ReleaseData()
 {
   DInternals& internals = (*this->Internals);
-  internals.Mesh = NULL;
+
+  // the simulation frees the patch data after each step. take the arrays
+  // off of the hierarchy kept for reuse so that they are not seen before
+  // they are pointed at the new data.
+  if (internals.Mesh)
+    {
+    unsigned int nLevels = internals.Mesh->GetNumberOfLevels();
+    for (unsigned int j = 0; j < nLevels; ++j)
+      {
+      unsigned int nBlocks = internals.Mesh->GetNumberOfDataSets(j);
+      for (unsigned int i = 0; i < nBlocks; ++i)
+        {
+        vtkDataSet *block = internals.Mesh->GetDataSet(j, i);
+        if (block)
+          {
+          block->GetCellData()->RemoveArray(arrname);
+          block->GetCellData()->RemoveArray("vtkGhostType");
+          }
+        }
+      }
+    }
+
+  internals.MeshValid = false;
   return 0;
 }
@@ -6,6 +6,7 @@
 #include "MPIUtils.h"
 #include "Error.h"
 #include "Profiler.h"
+#include "ArrayPool.h"
 
 #include <vtkCellTypes.h>
 #include <vtkCellData.h>
@@ -1144,10 +1145,8 @@ int ArraySchema::Read(MPI_Comm comm, AdiosHandle handles, const std::string &ons
         return -1;
         }
 
-      vtkDataArray *array = vtkDataArray::CreateDataArray(array_type);
-      array->SetNumberOfComponents(num_components);
-      array->SetNumberOfTuples(num_elem_local);
-      array->SetName(array_name.c_str());
+      vtkDataArray *array = sensei::ArrayPool::NewArray(array_type,
+        num_elem_local, num_components, array_name.c_str());
 
       // /data_object_<id>/data_array_<id>/data
       if (adios2_get(handles.engine, vinfo, array->GetVoidPointer(0),
@@ -1424,10 +1423,8 @@ int PointSchema::Read(MPI_Comm comm, AdiosHandle handles, const std::string &ons
           return -1;
           }
 
-        vtkDataArray *points = vtkDataArray::CreateDataArray(md->CoordinateType);
-        points->SetNumberOfComponents(3);
-        points->SetNumberOfTuples(num_local);
-        points->SetName("points");
+        vtkDataArray *points = sensei::ArrayPool::NewArray(md->CoordinateType,
+          num_local, 3, "points");
 
         adios2_error getErr = adios2_get(handles.engine,
           vinfo, points->GetVoidPointer(0), adios2_mode_sync);
@@ -3113,10 +3110,8 @@ int StretchedCartesianSchema::Read(MPI_Comm comm, AdiosHandle handles,
           return -1;
           }
 
-        vtkDataArray *x_coords = vtkDataArray::CreateDataArray(md->CoordinateType);
-        x_coords->SetNumberOfComponents(1);
-        x_coords->SetNumberOfTuples(nx_local);
-        x_coords->SetName("x_coords");
+        vtkDataArray *x_coords = sensei::ArrayPool::NewArray(md->CoordinateType,
+          nx_local, 1, "x_coords");
 
         if (adios2_get(handles.engine, xc_vinfo,
           x_coords->GetVoidPointer(0), adios2_mode_sync))
@@ -3144,10 +3139,8 @@ int StretchedCartesianSchema::Read(MPI_Comm comm, AdiosHandle handles,
           return -1;
           }
 
-        vtkDataArray *y_coords = vtkDataArray::CreateDataArray(md->CoordinateType);
-        y_coords->SetNumberOfComponents(1);
-        y_coords->SetNumberOfTuples(ny_local);
-        y_coords->SetName("y_coords");
+        vtkDataArray *y_coords = sensei::ArrayPool::NewArray(md->CoordinateType,
+          ny_local, 1, "y_coords");
 
         if (adios2_get(handles.engine, yc_vinfo,
           y_coords->GetVoidPointer(0), adios2_mode_sync))
@@ -3175,10 +3168,8 @@ int StretchedCartesianSchema::Read(MPI_Comm comm, AdiosHandle handles,
           return -1;
           }
 
-        vtkDataArray *z_coords = vtkDataArray::CreateDataArray(md->CoordinateType);
-        z_coords->SetNumberOfComponents(1);
-        z_coords->SetNumberOfTuples(nz_local);
-        z_coords->SetName("z_coords");
+        vtkDataArray *z_coords = sensei::ArrayPool::NewArray(md->CoordinateType,
+          nz_local, 1, "z_coords");
 
         if (adios2_get(handles.engine, zc_vinfo,
           z_coords->GetVoidPointer(0), adios2_mode_sync))
@@ -0,0 +1,376 @@
+#include "ArrayPool.h"
+#include "Profiler.h"
+#include "Error.h"
+
+#include <vtkDataArray.h>
+#include <vtkAbstractArray.h>
+#include <vtkVersionMacros.h>
+#if (VTK_MAJOR_VERSION > 8) || ((VTK_MAJOR_VERSION == 8) && (VTK_MINOR_VERSION >= 2))
+#define SENSEI_ARRAY_POOL_SUPPORTED
+#include <vtkAOSDataArrayTemplate.h>
+#endif
+
+#include <map>
+#include <unordered_map>
+#include <algorithm>
+#include <vector>
+#include <utility>
+#include <mutex>
+#include <cstdlib>
+
+namespace
+{
+// a buffer in the cache and the step on which it became idle
+struct IdleBuffer
+{
+  void *Data;
+  long Step;
+};
+
+// VTK type and number of values
+using KeyType = std::pair<int, size_t>;
+
+struct PoolState
+{
+  PoolState() : Step(0), MaxIdleBytes(1ll << 30), MaxIdleSteps(2),
+    Enabled(1), StepBytesAllocated(0), StepBytesReused(0), Stats{}
+  {
+    char *tmp = getenv("SENSEI_ARRAY_POOL");
+    if (tmp)
+      this->Enabled = atoi(tmp);
+  }
+
+  // release the buffer to the system. the caller must hold the lock.
+  void Release(void *buf, long long nBytes)
+  {
+    free(buf);
+    this->Stats.NumReleased += 1;
+    this->Stats.IdleBytes -= nBytes;
+  }
+
+  std::mutex Mutex;
+  std::map<KeyType, std::vector<IdleBuffer>> Idle;
+  std::unordered_map<void*, KeyType> Live;
+  long Step;
+  long long MaxIdleBytes;
+  int MaxIdleSteps;
+  int Enabled;
+  long long StepBytesAllocated;
+  long long StepBytesReused;
+  sensei::ArrayPool::Statistics Stats;
+};
+
+// arrays may be destroyed during static destruction, after a static
+// instance would have been destroyed. for that reason the state is
+// created on first use and never deleted.
+PoolState &GetState()
+{
+  static PoolState *state = new PoolState;
+  return *state;
+}
+
+// get the size in bytes of the given number of values
+long long GetNumBytes(int vtkType, size_t nValues)
+{
+  return nValues * vtkAbstractArray::GetDataTypeSize(vtkType);
+}
+}
+
+namespace sensei
+{
+
+// --------------------------------------------------------------------------
+vtkDataArray *ArrayPool::NewArray(int vtkType, vtkIdType nTuples,
+  int nComps, const char *name)
+{
+  vtkDataArray *da = vtkDataArray::CreateDataArray(vtkType);
+  if (!da)
+    {
+    SENSEI_ERROR("Failed to create an array of type " << vtkType)
+    return nullptr;
+    }
+
+  da->SetNumberOfComponents(nComps);
+
+  if (name)
+    da->SetName(name);
+
+#if defined(SENSEI_ARRAY_POOL_SUPPORTED)
+  if (ArrayPool::Enabled())
+    {
+    vtkIdType nValues = nTuples * nComps;
+    switch (vtkType)
+      {
+      vtkTemplateMacro(
+        vtkAOSDataArrayTemplate<VTK_TT> *aos =
+          dynamic_cast<vtkAOSDataArrayTemplate<VTK_TT>*>(da);
+        if (aos)
+          {
+          // the array does not own the buffer, when the array is done
+          // with it the buffer is returned to the pool
+          VTK_TT *buf = static_cast<VTK_TT*>(
+            ArrayPool::Allocate(vtkType, nValues));
+
+          aos->SetArray(buf, nValues, 0);
+          aos->SetArrayFreeFunction(ArrayPool::Free);
+
+          return da;
+          }
+        );
+      }
+    }
+#endif
+
+  da->SetNumberOfTuples(nTuples);
+
+  return da;
+}
+
+// --------------------------------------------------------------------------
+void *ArrayPool::Allocate(int vtkType, size_t nValues)
+{
+  PoolState &state = GetState();
+
+  KeyType key(vtkType, nValues);
+  long long nBytes = GetNumBytes(vtkType, nValues);
+
+  std::unique_lock<std::mutex> lock(state.Mutex);
+
+  if (state.Enabled)
+    {
+    std::map<KeyType, std::vector<IdleBuffer>>::iterator it =
+      state.Idle.find(key);
+
+    if ((it != state.Idle.end()) && !it->second.empty())
+      {
+      // the most recently freed buffer is the most likely to be in cache
+      void *buf = it->second.back().Data;
+      it->second.pop_back();
+
+      state.Live[buf] = key;
+
+      state.Stats.NumReused += 1;
+      state.Stats.BytesReused += nBytes;
+      state.Stats.IdleBytes -= nBytes;
+      state.StepBytesReused += nBytes;
+
+      return buf;
+      }
+    }
+
+  lock.unlock();
+
+  // malloc may return nullptr for 0 bytes, which would not be tracked
+  void *buf = malloc(nBytes > 0 ? nBytes : 1);
+  if (!buf)
+    {
+    SENSEI_ERROR("Failed to allocate " << nBytes << " bytes")
+    return nullptr;
+    }
+
+  lock.lock();
+
+  state.Live[buf] = key;
+
+  state.Stats.NumAllocated += 1;
+  state.Stats.BytesAllocated += nBytes;
+  state.StepBytesAllocated += nBytes;
+
+  return buf;
+}
+
+// --------------------------------------------------------------------------
+void ArrayPool::Free(void *buf)
+{
+  if (!buf)
+    return;
+
+  PoolState &state = GetState();
+
+  std::unique_lock<std::mutex> lock(state.Mutex);
+
+  std::unordered_map<void*, KeyType>::iterator it = state.Live.find(buf);
+  if (it == state.Live.end())
+    {
+    // not one of ours
+    lock.unlock();
+    free(buf);
+    return;
+    }
+
+  KeyType key = it->second;
+  state.Live.erase(it);
+
+  long long nBytes = GetNumBytes(key.first, key.second);
+
+  if (!state.Enabled || (state.MaxIdleSteps < 1) ||
+    (state.Stats.IdleBytes + nBytes > state.MaxIdleBytes))
+    {
+    lock.unlock();
+    free(buf);
+    lock.lock();
+    state.Stats.NumReleased += 1;
+    return;
+    }
+
+  state.Idle[key].push_back({buf, state.Step});
+
+  state.Stats.IdleBytes += nBytes;
+  state.Stats.MaxIdleBytes = std::max(state.Stats.MaxIdleBytes,
+    state.Stats.IdleBytes);
+}
+
+// --------------------------------------------------------------------------
+void ArrayPool::EndStep()
+{
+  PoolState &state = GetState();
+
+  std::unique_lock<std::mutex> lock(state.Mutex);
+
+  state.Step += 1;
+
+  // release buffers that have not been reused recently
+  std::map<KeyType, std::vector<IdleBuffer>>::iterator it = state.Idle.begin();
+  std::map<KeyType, std::vector<IdleBuffer>>::iterator end = state.Idle.end();
+  while (it != end)
+    {
+    long long nBytes = GetNumBytes(it->first.first, it->first.second);
+
+    std::vector<IdleBuffer> &bufs = it->second;
+
+    size_t nBufs = bufs.size();
+    size_t nKept = 0;
+    for (size_t i = 0; i < nBufs; ++i)
+      {
+      if (state.Step - bufs[i].Step > state.MaxIdleSteps)
+        state.Release(bufs[i].Data, nBytes);
+      else
+        bufs[nKept++] = bufs[i];
+      }
+    bufs.resize(nKept);
+
+    if (bufs.empty())
+      it = state.Idle.erase(it);
+    else
+      ++it;
+    }
+
+  long long bytesAllocated = state.StepBytesAllocated;
+  long long bytesReused = state.StepBytesReused;
+  long long idleBytes = state.Stats.IdleBytes;
+
+  state.StepBytesAllocated = 0;
+  state.StepBytesReused = 0;
+
+  lock.unlock();
+
+  if (Profiler::Enabled())
+    {
+    Profiler::StartEvent("ArrayPool::Allocated", bytesAllocated);
+    Profiler::EndEvent("ArrayPool::Allocated", bytesAllocated);
+
+    Profiler::StartEvent("ArrayPool::Reused", bytesReused);
+    Profiler::EndEvent("ArrayPool::Reused", bytesReused);
+
+    Profiler::StartEvent("ArrayPool::Idle", idleBytes);
+    Profiler::EndEvent("ArrayPool::Idle", idleBytes);
+    }
+}
+
+// --------------------------------------------------------------------------
+void ArrayPool::Clear()
+{
+  PoolState &state = GetState();
+
+  std::lock_guard<std::mutex> lock(state.Mutex);
+
+  std::map<KeyType, std::vector<IdleBuffer>>::iterator it = state.Idle.begin();
+  std::map<KeyType, std::vector<IdleBuffer>>::iterator end = state.Idle.end();
+  for (; it != end; ++it)
+    {
+    long long nBytes = GetNumBytes(it->first.first, it->first.second);
+
+    size_t nBufs = it->second.size();
+    for (size_t i = 0; i < nBufs; ++i)
+      state.Release(it->second[i].Data, nBytes);
+    }
+
+  state.Idle.clear();
+}
+
+// --------------------------------------------------------------------------
+void ArrayPool::SetMaxIdleBytes(long long nBytes)
+{
+  PoolState &state = GetState();
+  std::lock_guard<std::mutex> lock(state.Mutex);
+  state.MaxIdleBytes = nBytes;
+}
+
+// --------------------------------------------------------------------------
+long long ArrayPool::GetMaxIdleBytes()
+{
+  PoolState &state = GetState();
+  std::lock_guard<std::mutex> lock(state.Mutex);
+  return state.MaxIdleBytes;
+}
+
+// --------------------------------------------------------------------------
+void ArrayPool::SetMaxIdleSteps(int nSteps)
+{
+  PoolState &state = GetState();
+  std::lock_guard<std::mutex> lock(state.Mutex);
+  state.MaxIdleSteps = nSteps;
+}
+
+// --------------------------------------------------------------------------
+int ArrayPool::GetMaxIdleSteps()
+{
+  PoolState &state = GetState();
+  std::lock_guard<std::mutex> lock(state.Mutex);
+  return state.MaxIdleSteps;
+}
+
+// --------------------------------------------------------------------------
+void ArrayPool::Enable(bool val)
+{
+  PoolState &state = GetState();
+  std::lock_guard<std::mutex> lock(state.Mutex);
+
+  // the environment takes precedence
+  if (!getenv("SENSEI_ARRAY_POOL"))
+    state.Enabled = val;
+}
+
+// --------------------------------------------------------------------------
+bool ArrayPool::Enabled()
+{
+  PoolState &state = GetState();
+  std::lock_guard<std::mutex> lock(state.Mutex);
+  return state.Enabled;
+}
+
+// --------------------------------------------------------------------------
+void ArrayPool::GetStatistics(Statistics &stats)
+{
+  PoolState &state = GetState();
+  std::lock_guard<std::mutex> lock(state.Mutex);
+  stats = state.Stats;
+}
+
+// --------------------------------------------------------------------------
+void ArrayPool::PrintStatistics(std::ostream &os)
+{
+  Statistics stats;
+  ArrayPool::GetStatistics(stats);
+
+  long long numReq = stats.NumAllocated + stats.NumReused;
+
+  os << "ArrayPool: " << numReq << " requests, "
+    << stats.NumReused << " reused (" << stats.BytesReused << " bytes), "
+    << stats.NumAllocated << " allocated (" << stats.BytesAllocated
+    << " bytes), " << stats.NumReleased << " released, "
+    << stats.IdleBytes << " bytes idle, " << stats.MaxIdleBytes
+    << " bytes max idle" << std::endl;
+}
+
+}
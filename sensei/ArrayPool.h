@@ -0,0 +1,102 @@
+#ifndef sensei_ArrayPool_h
+#define sensei_ArrayPool_h
+
+#include "senseiConfig.h"
+
+#include <vtkType.h>
+
+#include <cstddef>
+#include <ostream>
+
+class vtkDataArray;
+
+namespace sensei
+{
+
+// ArrayPool - recycles the storage of VTK data arrays across time steps
+/**
+Data adaptors and in transit readers create a new set of arrays every
+time step which are then destroyed when the step's data is released.
+Over a long run this allocation churn fragments the heap. Arrays created
+through the pool get their storage from a process wide cache of idle
+buffers keyed by VTK type and length. When such an array is destroyed
+its buffer is returned to the cache, where it can be handed to an array
+of the same type and length on a later step.
+
+Idle buffers not reused within SetMaxIdleSteps steps, or that would push
+the cache past SetMaxIdleBytes, are released to the system. Steps are
+counted by calls to EndStep, which ConfigurableAnalysis makes at the end
+of each Execute.
+
+Pooling requires VTK 8.2 or newer. With older VTK, and when disabled by
+setting the environment variable SENSEI_ARRAY_POOL=0, NewArray returns
+ordinary arrays.
+
+When profiling is enabled EndStep logs the following events:
+
+  ArrayPool::Allocated  -- bytes are the bytes allocated this step
+  ArrayPool::Reused     -- bytes are the bytes reused this step
+  ArrayPool::Idle       -- bytes are the bytes held by idle buffers
+*/
+class ArrayPool
+{
+public:
+  // cumulative statistics
+  struct Statistics
+  {
+    long long NumAllocated;   // buffers allocated from the system
+    long long NumReused;      // buffers served from the cache
+    long long NumReleased;    // idle buffers returned to the system
+    long long BytesAllocated;
+    long long BytesReused;
+    long long IdleBytes;      // bytes currently held in the cache
+    long long MaxIdleBytes;   // high water mark of the above
+  };
+
+  // Create a new array of the given VTK type, number of tuples and
+  // components whose storage comes from the pool. The caller owns the
+  // returned reference. Returns nullptr if the type is not a supported
+  // POD type.
+  static vtkDataArray *NewArray(int vtkType, vtkIdType nTuples,
+    int nComps = 1, const char *name = nullptr);
+
+  // Get a buffer of nValues values of the given VTK type. It must be
+  // returned with Free.
+  static void *Allocate(int vtkType, size_t nValues);
+
+  // Return a buffer to the pool. Buffers not allocated by the pool are
+  // passed to free.
+  static void Free(void *buf);
+
+  // Mark the end of a time step. Idle buffers that have not been reused
+  // within the last MaxIdleSteps steps are released.
+  static void EndStep();
+
+  // Release all idle buffers
+  static void Clear();
+
+  // Set/get the maximum number of bytes held by idle buffers.
+  // default value: 1 GiB
+  static void SetMaxIdleBytes(long long nBytes);
+  static long long GetMaxIdleBytes();
+
+  // Set/get the number of steps an idle buffer is kept.
+  // default value: 2
+  static void SetMaxIdleSteps(int nSteps);
+  static int GetMaxIdleSteps();
+
+  // Enable or disable pooling. Overriden by the SENSEI_ARRAY_POOL
+  // environment variable.
+  static void Enable(bool val = true);
+  static bool Enabled();
+
+  // get the cumulative statistics
+  static void GetStatistics(Statistics &stats);
+
+  // send the cumulative statistics to the stream in human readable form
+  static void PrintStatistics(std::ostream &os);
+};
+
+}
+
+#endif
@@ -9,6 +9,7 @@
 #include <conduit_blueprint.hpp>
 
 #include <vtkObjectFactory.h>
+#include <vtkSmartPointer.h>
 #include <vtkCellArray.h>
 #include <vtkDataObject.h>
 #include <vtkDataArray.h>
@@ -27,12 +28,22 @@
 #include <vtkSOADataArrayTemplate.h>
 #include <vtkDataArrayTemplate.h>
 #include <vtkUnsignedCharArray.h>
+#include <vtkVersionMacros.h>
+
+#include <type_traits>
+#include <map>
 
 namespace
 {
 // --------------------------------------------------------------------------
 template<typename n_t> struct conduit_tt {};
 
+using conduit_long = std::conditional<sizeof(long) == 8,
+  conduit::int64, conduit::int32>::type;
+
+using conduit_ulong = std::conditional<sizeof(long) == 8,
+  conduit::uint64, conduit::uint32>::type;
+
 #define declare_conduit_tt(cpp_t, conduit_t) \
 template<> struct conduit_tt<cpp_t>          \
 {                                            \
@@ -46,8 +57,8 @@ declare_conduit_tt(short, conduit::int16);
 declare_conduit_tt(unsigned short, conduit::uint16);
 declare_conduit_tt(int, conduit::int32);
 declare_conduit_tt(unsigned int, conduit::uint32);
-declare_conduit_tt(long, conduit::int32);
-declare_conduit_tt(unsigned long, conduit::uint32);
+declare_conduit_tt(long, conduit_long);
+declare_conduit_tt(unsigned long, conduit_ulong);
 declare_conduit_tt(long long, conduit::int64);
 declare_conduit_tt(unsigned long long, conduit::uint64);
 declare_conduit_tt(float, conduit::float32);
@@ -254,6 +265,79 @@ int PassFields(int bid, vtkDataSet *ds, conduit::Node &node)
 }
 */
 
+// **************************************************************************
+// pass a VTK array to conduit without a copy. a single component is placed
+// in values directly, otherwise the first nOut components are placed in
+// children with the given names. the components of AOS arrays become
+// strided views of the VTK memory. returns 1 if the array's layout can not
+// be passed without a copy.
+template<typename T>
+int PassArrayExternal(vtkDataArray *da, const char *const *compNames,
+  int nOut, conduit::Node &values)
+{
+  using conduit_t = typename conduit_tt<T>::conduit_type;
+
+  conduit::index_t nElem = da->GetNumberOfTuples();
+  conduit::index_t nComps = da->GetNumberOfComponents();
+  conduit::index_t elemBytes = sizeof(T);
+
+  if (vtkAOSDataArrayTemplate<T> *aos =
+    dynamic_cast<vtkAOSDataArrayTemplate<T>*>(da))
+  {
+    conduit_t *ptr = (conduit_t*)aos->GetPointer(0);
+    for (int j = 0; j < nOut; ++j)
+    {
+      conduit::Node &comp = compNames ? values[compNames[j]] : values;
+      comp.set_external(ptr, nElem, j*elemBytes, nComps*elemBytes,
+        elemBytes, conduit::Endianness::DEFAULT_ID);
+    }
+    return 0;
+  }
+
+  if (vtkSOADataArrayTemplate<T> *soa =
+    dynamic_cast<vtkSOADataArrayTemplate<T>*>(da))
+  {
+    for (int j = 0; j < nOut; ++j)
+    {
+      conduit_t *ptr = (conduit_t*)soa->GetComponentArrayPointer(j);
+      conduit::Node &comp = compNames ? values[compNames[j]] : values;
+      comp.set_external(ptr, nElem, 0, elemBytes, elemBytes,
+        conduit::Endianness::DEFAULT_ID);
+    }
+    return 0;
+  }
+
+  return 1;
+}
+
+// **************************************************************************
+// pass a VTK array to conduit. see PassArrayExternal. arrays with other
+// layouts are copied to float64.
+void PassArray(vtkDataArray *da, const char *const *compNames,
+  int nOut, conduit::Node &values)
+{
+  int copy = 1;
+  switch (da->GetDataType())
+  {
+    vtkTemplateMacro(
+      copy = PassArrayExternal<VTK_TT>(da, compNames, nOut, values);
+      );
+  }
+
+  if (!copy)
+    return;
+
+  vtkIdType nElem = da->GetNumberOfTuples();
+  for (int j = 0; j < nOut; ++j)
+  {
+    conduit::Node &comp = compNames ? values[compNames[j]] : values;
+    comp.set(conduit::DataType::float64(nElem));
+    conduit::float64 *pComp = comp.as_float64_ptr();
+    for (vtkIdType i = 0; i < nElem; ++i)
+      pComp[i] = da->GetComponent(i, j);
+  }
+}
+
 // **************************************************************************
 int PassFields(vtkDataSet* ds, conduit::Node& node,
   const std::string &arrayName, int arrayCen)
@@ -279,18 +363,6 @@ int PassFields(vtkDataSet* ds, conduit::Node& node,
   std::string valPath = ss.str();
   ss.str(std::string());
 
-  ss << "fields/" << arrayName << "/values/u";
-  std::string uValPath = ss.str();
-  ss.str(std::string());
-
-  ss << "fields/" << arrayName << "/values/v";
-  std::string vValPath = ss.str();
-  ss.str(std::string());
-
-  ss << "fields/" << arrayName << "/values/w";
-  std::string wValPath = ss.str();
-  ss.str(std::string());
-
   //ss << "fields/" << arrayName << "/grid_function";
   //std::string gridPath = ss.str();
   //ss.str(std::string());
@@ -307,6 +379,12 @@ int PassFields(vtkDataSet* ds, conduit::Node& node,
   // tell ascent the centering
   vtkDataSetAttributes *atts = ds->GetAttributes(arrayCen);
   vtkDataArray *da = atts->GetArray(arrayName.c_str());
+  if (!da)
+  {
+    SENSEI_ERROR("No array named \"" << arrayName << "\"")
+    return -1;
+  }
+
   std::string cenType;
   if (arrayCen == vtkDataObject::POINT)
   {
@@ -323,61 +401,22 @@ int PassFields(vtkDataSet* ds, conduit::Node& node,
   }
   node[assocPath] = cenType;
 
-  // FIXME -- zero coopy transfer the data
   int components = da->GetNumberOfComponents();
-  int tuples = da->GetNumberOfTuples();
-
-  if(components == 1)
+  if ((components < 1) || (components > 3))
   {
-    node[typePath] = "scalar";
-
-    // FIXME -- get the type from VTK
-    std::vector<conduit::float64> vals(tuples, 0.0);
-
-    for(int i = 0; i < tuples; ++i)
-    {
-      vals[i] = da->GetComponent(i, 0);
-    }
-    node[valPath].set(vals);
+    SENSEI_ERROR("Invalid number of components (" << components
+      << ") associated with " << arrayName);
+    return -1;
   }
-  else if(components == 2)
-  {
-    node[typePath] = "vector";
 
-    std::vector<conduit::float64> uVals(tuples, 0.0);
-    std::vector<conduit::float64> vVals(tuples, 0.0);
+  // pass the values without a copy where the layout allows. vectors are
+  // passed as u, v, w components
+  static const char *compNames[] = {"u", "v", "w"};
 
-    for(int i = 0; i < tuples; ++i)
-    {
-      uVals[i] = da->GetComponent(i, 0);
-      vVals[i] = da->GetComponent(i, 1);
-    }
-    node[uValPath].set(uVals);
-    node[vValPath].set(vVals);
-  }
-  else if(components == 3)
-  {
-    node[typePath] = "vector";
+  node[typePath] = components == 1 ? "scalar" : "vector";
 
-    std::vector<conduit::float64> uVals(tuples, 0.0);
-    std::vector<conduit::float64> vVals(tuples, 0.0);
-    std::vector<conduit::float64> wVals(tuples, 0.0);
-
-    for(int i = 0; i < tuples; ++i)
-    {
-      uVals[i] = da->GetComponent(i, 0);
-      vVals[i] = da->GetComponent(i, 1);
-      wVals[i] = da->GetComponent(i, 2);
-    }
-    node[uValPath].set(uVals);
-    node[vValPath].set(vVals);
-    node[wValPath].set(wVals);
-  }
-  else
-  {
-    SENSEI_ERROR("Too many components (" << components << ") associated with " << arrayName);
-    return -1;
-  }
+  PassArray(da, components == 1 ? nullptr : compNames,
+    components, node[valPath]);
 
   // tell ascent which topology the array belongs to
   node[topoPath] = "mesh";
@@ -445,29 +484,39 @@ int PassTopology(vtkDataSet* ds, conduit::Node& node)
     node["topologies/mesh/coordset"] = "coords";
 
     vtkCellArray* cellarray = unstructured->GetCells();
-    vtkIdType *ptr = cellarray->GetPointer();
+    vtkIdType ncells = cellarray->GetNumberOfCells();
+    if (ncells < 1)
+    {
+      SENSEI_ERROR("Unstructured mesh has no cells");
+      return( -1 );
+    }
 
-    std::string shape;
-    GetShape(shape, ptr[0]);
-    node["topologies/mesh/elements/shape"] = shape;
+    conduit::Node &conn = node["topologies/mesh/elements/connectivity"];
 
-    int ncells = unstructured->GetNumberOfCells();
-    int connections = ncells*(ptr[0] + 1);
-    std::vector<int> data(ncells*ptr[0], 0);
+#if VTK_MAJOR_VERSION >= 9
+    int cellSize = cellarray->GetCellSize(0);
 
-    int count = 0;
-    for(int i = 0; i < connections; ++i)
+    // the connectivity is stored without the cell sizes and is passed
+    // without a copy
+    PassArray(cellarray->GetConnectivityArray(), nullptr, 1, conn);
+#else
+    vtkIdType *ptr = cellarray->GetPointer();
+    int cellSize = ptr[0];
+
+    // skip the cell sizes interleaved with the point ids
+    conn.set(conduit::DataType::int32(ncells*cellSize));
+    conduit::int32 *pConn = conn.as_int32_ptr();
+    for (vtkIdType i = 0; i < ncells; ++i)
     {
-      int offset = ptr[0] + 1;
-      if(i%offset == 0)
-        continue;
-      else
-      {
-        data[count] = ptr[i];
-        count++;
-      }
+      const vtkIdType *pCell = ptr + i*(cellSize + 1) + 1;
+      for (int j = 0; j < cellSize; ++j)
+        pConn[i*cellSize + j] = pCell[j];
     }
-    node["topologies/mesh/elements/connectivity"].set(data);
+#endif
+
+    std::string shape;
+    GetShape(shape, cellSize);
+    node["topologies/mesh/elements/shape"] = shape;
   }
   else
   {
@@ -541,36 +590,10 @@ int PassCoordsets(vtkDataSet* ds, conduit::Node& node)
       return( -1 );
     }
 
-    switch (x->GetDataType())
-    {
-      vtkTemplateMacro(
-        // x
-        vtkAOSDataArrayTemplate<VTK_TT> *tx =
-           dynamic_cast<vtkAOSDataArrayTemplate<VTK_TT>*>(x);
-        VTK_TT *ptr = tx->GetPointer(0);
-        long nElem = tx->GetNumberOfTuples();
-        node["coordsets/coords/values/x"].set_external((conduit_tt<VTK_TT>::conduit_type*)ptr, nElem, 0,
-          sizeof(VTK_TT), sizeof(VTK_TT), conduit::Endianness::DEFAULT_ID);
-        // y
-        vtkAOSDataArrayTemplate<VTK_TT> *ty =
-           dynamic_cast<vtkAOSDataArrayTemplate<VTK_TT>*>(y);
-        ptr = ty->GetPointer(0);
-        nElem = ty->GetNumberOfTuples();
-        node["coordsets/coords/values/y"].set_external((conduit_tt<VTK_TT>::conduit_type*)ptr, nElem, 0,
-          sizeof(VTK_TT), sizeof(VTK_TT), conduit::Endianness::DEFAULT_ID);
-        // z
-        vtkAOSDataArrayTemplate<VTK_TT> *tz =
-           dynamic_cast<vtkAOSDataArrayTemplate<VTK_TT>*>(z);
-        ptr = tz->GetPointer(0);
-        nElem = tz->GetNumberOfTuples();
-        if( nElem > 1 )
-            node["coordsets/coords/values/z"].set_external((conduit_tt<VTK_TT>::conduit_type*)ptr, nElem, 0,
-                sizeof(VTK_TT), sizeof(VTK_TT), conduit::Endianness::DEFAULT_ID);
-        );
-      default:
-        SENSEI_ERROR("Invlaid data type for recilinear grid coordinates");
-        return( -1 );
-    }
+    PassArray(x, nullptr, 1, node["coordsets/coords/values/x"]);
+    PassArray(y, nullptr, 1, node["coordsets/coords/values/y"]);
+    if (z->GetNumberOfTuples() > 1)
+      PassArray(z, nullptr, 1, node["coordsets/coords/values/z"]);
   }
   else if(structured != nullptr)
   {
@@ -579,44 +602,21 @@ int PassCoordsets(vtkDataSet* ds, conduit::Node& node)
     int dims[3] = {0, 0, 0};
     structured->GetDimensions(dims);
 
-    int numPoints = structured->GetPoints()->GetNumberOfPoints();
-    double point[3] = {0, 0, 0};
-    std::vector<conduit::float64> x(numPoints, 0.0);
-    std::vector<conduit::float64> y(numPoints, 0.0);
-    std::vector<conduit::float64> z(numPoints, 0.0);
+    // pass the points as strided x, y, z components without a copy
+    static const char *compNames[] = {"x", "y", "z"};
+    int nOut = (dims[2] != 0 && dims[2] != 1) ? 3 : 2;
 
-    for(int i = 0; i < numPoints; ++i)
-    {
-      structured->GetPoints()->GetPoint(i, point);
-      x[i] = point[0];
-      y[i] = point[1];
-      z[i] = point[2];
-    }
-    node["coordsets/coords/values/x"].set(x);
-    node["coordsets/coords/values/y"].set(y);
-    if(dims[2] != 0 && dims[2] != 1)
-      node["coordsets/coords/values/z"].set(z);
+    PassArray(structured->GetPoints()->GetData(), compNames, nOut,
+      node["coordsets/coords/values"]);
   }
   else if(unstructured != nullptr)
   {
     node["coordsets/coords/type"] = "explicit";
 
-    int numPoints = unstructured->GetPoints()->GetNumberOfPoints();
-    double point[3] = {0, 0, 0};
-    std::vector<conduit::float64> x(numPoints, 0.0);
-    std::vector<conduit::float64> y(numPoints, 0.0);
-    std::vector<conduit::float64> z(numPoints, 0.0);
+    static const char *compNames[] = {"x", "y", "z"};
 
-    for(int i = 0; i < numPoints; ++i)
-    {
-      unstructured->GetPoints()->GetPoint(i, point);
-      x[i] = point[0];
-      y[i] = point[1];
-      z[i] = point[2];
-    }
-    node["coordsets/coords/values/x"].set(x);
-    node["coordsets/coords/values/y"].set(y);
-    node["coordsets/coords/values/z"].set(z);
+    PassArray(unstructured->GetPoints()->GetData(), compNames, 3,
+      node["coordsets/coords/values"]);
   }
   else
   {
@@ -649,14 +649,59 @@ void NodeIter(const conduit::Node& node, std::set<std::string>& fields)
   }
 }
 
+// **************************************************************************
+// the coordsets and topology of a block of a static mesh. the copy of the
+// block's structure keeps the VTK memory that the node references alive.
+struct StaticMeshEntry
+{
+  vtkSmartPointer<vtkDataSet> Structure;
+  conduit::Node Node;
+};
+
+// **************************************************************************
+int PassMesh(vtkDataSet* ds, conduit::Node& node, StaticMeshEntry *cache)
+{
+  if (!cache)
+  {
+    if (PassCoordsets(ds, node) || PassTopology(ds, node))
+      return -1;
+    return 0;
+  }
+
+  // build the nodes on first use, or if the structure changed in spite of
+  // the mesh being declared static
+  vtkDataSet *structure = cache->Structure;
+  if (!structure || (structure->GetDataObjectType() != ds->GetDataObjectType()) ||
+    (structure->GetNumberOfPoints() != ds->GetNumberOfPoints()) ||
+    (structure->GetNumberOfCells() != ds->GetNumberOfCells()))
+  {
+    structure = ds->NewInstance();
+    structure->CopyStructure(ds);
+    cache->Structure.TakeReference(structure);
+    cache->Node.reset();
+
+    if (PassCoordsets(structure, cache->Node) ||
+      PassTopology(structure, cache->Node))
+    {
+      cache->Structure = nullptr;
+      return -1;
+    }
+  }
+
+  node["coordsets"].set_external(cache->Node["coordsets"]);
+  node["topologies"].set_external(cache->Node["topologies"]);
+
+  return 0;
+}
+
 // **************************************************************************
 int PassData(vtkDataSet* ds, conduit::Node& node,
-  const std::string &arrayName, int arrayCen, sensei::DataAdaptor *dataAdaptor)
+  const std::string &arrayName, int arrayCen, sensei::DataAdaptor *dataAdaptor,
+  StaticMeshEntry *cache)
 {
     // FIXME -- do error checking on all these and report any errors
     PassState(ds, node, dataAdaptor);
-    PassCoordsets(ds, node);
-    PassTopology(ds, node);
+    PassMesh(ds, node, cache);
     PassFields(ds, node, arrayName, arrayCen);
     PassGhostsZones(ds, node);
     return 0;
@@ -686,17 +731,26 @@ int LoadConfig(const std::string &file_name, conduit::Node& node)
 
 namespace sensei
 {
+//------------------------------------------------------------------------------
+struct AscentAnalysisAdaptor::MeshCacheType
+{
+  // indexed by the block's flat index
+  std::map<unsigned int, StaticMeshEntry> Blocks;
+};
+
 //------------------------------------------------------------------------------
 senseiNewMacro(AscentAnalysisAdaptor);
 
 //------------------------------------------------------------------------------
 AscentAnalysisAdaptor::AscentAnalysisAdaptor()
 {
+  this->MeshCache = new MeshCacheType;
 }
 
 //------------------------------------------------------------------------------
 AscentAnalysisAdaptor::~AscentAnalysisAdaptor()
 {
+  delete this->MeshCache;
 }
 
 //-----------------------------------------------------------------------------
@@ -810,12 +864,17 @@ bool AscentAnalysisAdaptor::Execute(DataAdaptor* dataAdaptor)
     return( false );
   }
 
+  // release the mesh on every return. the conduit node only references
+  // its memory
+  vtkSmartPointer<vtkDataObject> objPtr;
+  objPtr.TakeReference(obj);
+
   if (dataAdaptor->AddArray(obj, meshName, arrayCen, arrayName))
   {
     SENSEI_ERROR("Failed to add "
       << " data array \"" << arrayName << "\" to mesh \""
       << meshName << "\"");
-    return( -1 );
+    return( false );
   }
 
   // get metadata for the requested mesh
@@ -842,6 +901,13 @@ bool AscentAnalysisAdaptor::Execute(DataAdaptor* dataAdaptor)
       return( false );
   }
 
+  // when the mesh is static the coordsets and topologies are built once
+  if (!metadata->StaticMesh)
+    this->MeshCache->Blocks.clear();
+
+  std::map<unsigned int, StaticMeshEntry> &meshCache = this->MeshCache->Blocks;
+  bool staticMesh = metadata->StaticMesh;
+
   int domainNum = 0;
   if (vtkCompositeDataSet *cds = dynamic_cast<vtkCompositeDataSet*>(obj))
   {
@@ -860,6 +926,9 @@ bool AscentAnalysisAdaptor::Execute(DataAdaptor* dataAdaptor)
     {
       if (vtkDataSet *ds = dynamic_cast<vtkDataSet*>(cds->GetDataSet(itr)))
       {
+        StaticMeshEntry *cache = staticMesh ?
+          &meshCache[itr->GetCurrentFlatIndex()] : nullptr;
+
         char domain[20] = "";
         if( numBlocks > 1 )
         {
@@ -868,13 +937,13 @@ bool AscentAnalysisAdaptor::Execute(DataAdaptor* dataAdaptor)
           conduit::Node &temp_node = root[domain];
 
           // FIXME -- check retuirn for error
-          ::PassData(ds, temp_node, arrayName, arrayCen, dataAdaptor);
+          ::PassData(ds, temp_node, arrayName, arrayCen, dataAdaptor, cache);
         }
         else
         {
           conduit::Node &temp_node = root;
           // FIXME -- check retuirn for error
-          ::PassData(ds, temp_node, arrayName, arrayCen, dataAdaptor);
+          ::PassData(ds, temp_node, arrayName, arrayCen, dataAdaptor, cache);
         }
       }
       itr->GoToNextItem();
@@ -883,15 +952,16 @@ bool AscentAnalysisAdaptor::Execute(DataAdaptor* dataAdaptor)
   else if (vtkDataSet *ds = vtkDataSet::SafeDownCast(obj))
   {
     conduit::Node &temp_node = root;
+    StaticMeshEntry *cache = staticMesh ? &meshCache[0] : nullptr;
 
     // FIXME -- check retuirn for error
-    ::PassData(ds, temp_node, arrayName, arrayCen, dataAdaptor);
+    ::PassData(ds, temp_node, arrayName, arrayCen, dataAdaptor, cache);
   }
   else
   {
     SENSEI_ERROR("Data object " << obj->GetClassName()
       << " is not supported.");
-    return( -1 );
+    return( false );
   }
 
 #ifdef DEBUG_SAVE_DATA
@@ -918,6 +988,7 @@ int AscentAnalysisAdaptor::Finalize()
 {
   this->_ascent.close();
   this->Fields.clear();
+  this->MeshCache->Blocks.clear();
 
   return( 0 );
 }
@@ -51,6 +51,10 @@ private:
   void GetFieldsFromActions();
   std::set<std::string> Fields;
 
+  // coordsets and topologies of static meshes, reused across steps
+  struct MeshCacheType;
+  MeshCacheType *MeshCache;
+
   DataRequirements Requirements;
 };
 
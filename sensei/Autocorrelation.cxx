@@ -1,5 +1,6 @@
 #include "Autocorrelation.h"
 
+#include "BlockParallel.h"
 #include "DataAdaptor.h"
 #include "MeshMetadata.h"
 #include "MeshMetadataMap.h"
@@ -21,8 +22,12 @@
 
 #include <memory>
 #include <vector>
+#include <map>
+#include <utility>
 
 #include <sdiy/master.hpp>
+#include <sdiy/storage.hpp>
+#include <sdiy/mmap-storage.hpp>
 #include <sdiy/reduce.hpp>
 #include <sdiy/partners/merge.hpp>
 #include <sdiy/io/numpy.hpp>
@@ -80,6 +85,25 @@ struct AutocorrelationImpl
 
   static void* create()            { return new AutocorrelationImpl; }
   static void destroy(void* b)    { delete static_cast<AutocorrelationImpl*>(b); }
+
+  // out-of-core support. the grids are written with one copy each.
+  static void save(const void* b_, sdiy::BinaryBuffer& bb)
+    {
+    const AutocorrelationImpl* b = static_cast<const AutocorrelationImpl*>(b_);
+    sdiy::save(bb, b->window, b->gid, b->from, b->to, b->shape, b->offset, b->count);
+    bb.save_binary(reinterpret_cast<const char*>(b->values.data()), b->values.size()*sizeof(float));
+    bb.save_binary(reinterpret_cast<const char*>(b->corr.data()), b->corr.size()*sizeof(float));
+    }
+
+  static void load(void* b_, sdiy::BinaryBuffer& bb)
+    {
+    AutocorrelationImpl* b = static_cast<AutocorrelationImpl*>(b_);
+    sdiy::load(bb, b->window, b->gid, b->from, b->to, b->shape, b->offset, b->count);
+    b->values = Grid(b->shape.lift(3, b->window));
+    b->corr = Grid(b->shape.lift(3, b->window));
+    bb.load_binary(reinterpret_cast<char*>(b->values.data()), b->values.size()*sizeof(float));
+    bb.load_binary(reinterpret_cast<char*>(b->corr.data()), b->corr.size()*sizeof(float));
+    }
   void process(float* data, unsigned char *ghostArray)
     {
     GridRef g(data, shape);
@@ -141,13 +165,14 @@ struct AutocorrelationImpl
   size_t          count  = 0;
 
 private:
-  AutocorrelationImpl() {}        // here just for create; to let Master manage the blocks (+ if we choose to add OOC later)
+  AutocorrelationImpl() {}        // here just for create; to let Master manage the blocks
 };
 
 //-----------------------------------------------------------------------------
 class Autocorrelation::AInternals
 {
 public:
+  std::unique_ptr<sdiy::ExternalStorage> Storage;
   std::unique_ptr<sdiy::Master> Master;
   size_t KMax;
   std::string MeshName;
@@ -156,9 +181,16 @@ public:
   size_t Window;
   bool BlocksInitialized;
   size_t NumberOfBlocks;
+  int NumberOfThreads;
+  int BlocksInMemory;
+  int StorageType;
+  std::string StorageTemplate;
 
   AInternals() : KMax(3), Association(vtkDataObject::POINT),
-    Window(10), BlocksInitialized(false), NumberOfBlocks(0) {}
+    Window(10), BlocksInitialized(false), NumberOfBlocks(0),
+    NumberOfThreads(-1), BlocksInMemory(-1),
+    StorageType(Autocorrelation::STORAGE_MMAP),
+    StorageTemplate("/tmp/sensei-autocorrelation.XXXXXX") {}
 
   void InitializeBlocks(vtkDataObject* dobj)
     {
@@ -243,8 +275,33 @@ void Autocorrelation::Initialize(size_t window, const std::string &meshName,
 
   AInternals& internals = (*this->Internals);
 
-  internals.Master = make_unique<sdiy::Master>(this->GetCommunicator(),
-    numThreads, -1, &AutocorrelationImpl::create, &AutocorrelationImpl::destroy);
+  internals.NumberOfThreads = numThreads;
+
+  if (internals.BlocksInMemory > 0)
+    {
+    // blocks beyond the limit are kept in files. the storage must outlive
+    // the master, which does not take ownership of it. sdiy's threads
+    // process the blocks so that they are loaded in turn.
+    internals.Master.reset();
+
+    if (internals.StorageType == STORAGE_MMAP)
+      internals.Storage = make_unique<sdiy::MmapStorage>(internals.StorageTemplate);
+    else
+      internals.Storage = make_unique<sdiy::FileStorage>(internals.StorageTemplate);
+
+    internals.Master = make_unique<sdiy::Master>(this->GetCommunicator(),
+      BlockParallel::GetNumberOfThreads(numThreads), internals.BlocksInMemory,
+      &AutocorrelationImpl::create, &AutocorrelationImpl::destroy,
+      internals.Storage.get(), &AutocorrelationImpl::save,
+      &AutocorrelationImpl::load);
+    }
+  else
+    {
+    // the blocks are processed on the global thread pool, the master only
+    // needs a thread of its own for the final reduction
+    internals.Master = make_unique<sdiy::Master>(this->GetCommunicator(),
+      1, -1, &AutocorrelationImpl::create, &AutocorrelationImpl::destroy);
+    }
 
   internals.MeshName = meshName;
   internals.Association = association;
@@ -253,6 +310,25 @@ void Autocorrelation::Initialize(size_t window, const std::string &meshName,
   internals.KMax = kmax;
 }
 
+//-----------------------------------------------------------------------------
+int Autocorrelation::SetOutOfCore(int blocksInMemory, int storageType,
+  const std::string &fileTemplate)
+{
+  if ((storageType != STORAGE_MMAP) && (storageType != STORAGE_FILE))
+    {
+    SENSEI_ERROR("Invalid storage type " << storageType)
+    return -1;
+    }
+
+  AInternals& internals = (*this->Internals);
+
+  internals.BlocksInMemory = blocksInMemory;
+  internals.StorageType = storageType;
+  internals.StorageTemplate = fileTemplate;
+
+  return 0;
+}
+
 //-----------------------------------------------------------------------------
 bool Autocorrelation::Execute(DataAdaptor* dataAdaptor)
 {
@@ -311,6 +387,11 @@ bool Autocorrelation::Execute(DataAdaptor* dataAdaptor)
   const int association = internals.Association;
   internals.InitializeBlocks(mesh);
 
+  // the arrays for each block. the blocks are processed through the master
+  // so that those that are out of core are loaded in turn
+  using ArrayPair = std::pair<float*, unsigned char*>;
+  std::map<int, ArrayPair> arrays;
+
   if (vtkCompositeDataSet* cd = vtkCompositeDataSet::SafeDownCast(mesh))
     {
     vtkSmartPointer<vtkCompositeDataIterator> iter;
@@ -322,15 +403,13 @@ bool Autocorrelation::Execute(DataAdaptor* dataAdaptor)
       {
       if (vtkDataSet* dataObj = vtkDataSet::SafeDownCast(iter->GetCurrentDataObject()))
         {
-        int lid = internals.Master->lid(static_cast<int>(bid));
-        AutocorrelationImpl* corr = internals.Master->block<AutocorrelationImpl>(lid);
         vtkFloatArray* fa = vtkFloatArray::SafeDownCast(
           dataObj->GetAttributesAsFieldData(association)->GetArray(internals.ArrayName.c_str()));
         vtkUnsignedCharArray *gc = vtkUnsignedCharArray::SafeDownCast(
           dataObj->GetCellData()->GetArray("vtkGhostType"));
         if (fa)
           {
-          corr->process(fa->GetPointer(0), gc ? gc->GetPointer(0) : nullptr);
+          arrays[bid] = ArrayPair(fa->GetPointer(0), gc ? gc->GetPointer(0) : nullptr);
           }
         else
           {
@@ -343,15 +422,13 @@ bool Autocorrelation::Execute(DataAdaptor* dataAdaptor)
   else if (vtkDataSet* ds = vtkDataSet::SafeDownCast(mesh))
     {
     int bid = internals.Master->communicator().rank();
-    int lid = internals.Master->lid(static_cast<int>(bid));
-    AutocorrelationImpl* corr = internals.Master->block<AutocorrelationImpl>(lid);
     vtkFloatArray* fa = vtkFloatArray::SafeDownCast(
       ds->GetAttributesAsFieldData(association)->GetArray(internals.ArrayName.c_str()));
     vtkUnsignedCharArray *gc = vtkUnsignedCharArray::SafeDownCast(
       ds->GetCellData()->GetArray("vtkGhostType"));
     if (fa)
       {
-      corr->process(fa->GetPointer(0), gc ? gc->GetPointer(0) : nullptr);
+      arrays[bid] = ArrayPair(fa->GetPointer(0), gc ? gc->GetPointer(0) : nullptr);
       }
     else
       {
@@ -360,6 +437,30 @@ bool Autocorrelation::Execute(DataAdaptor* dataAdaptor)
       }
     }
 
+  if (internals.BlocksInMemory > 0)
+    {
+    internals.Master->foreach(
+      [&arrays](AutocorrelationImpl* corr, const sdiy::Master::ProxyWithLink& cp)
+      {
+      std::map<int, ArrayPair>::const_iterator it = arrays.find(cp.gid());
+      if (it != arrays.end())
+        corr->process(it->second.first, it->second.second);
+      });
+    }
+  else
+    {
+    // all blocks are in memory, process them in parallel
+    sdiy::Master &master = *internals.Master;
+    BlockParallel::ForEach(master.size(), internals.NumberOfThreads,
+      [&](int, long lid)
+      {
+      std::map<int, ArrayPair>::const_iterator it = arrays.find(master.gid(lid));
+      if (it != arrays.end())
+        master.block<AutocorrelationImpl>(lid)->process(it->second.first,
+          it->second.second);
+      });
+    }
+
   mesh->Delete();
 
   return true;
@@ -30,10 +30,29 @@ public:
   /// @param arrayname together with \c association, identifies the array to
   ///         compute autocorrelation for.
   /// @param kMax number of strongest autocorrelations to report
-  /// @param numThreads number of threads in sdiy's thread pool
+  /// @param numThreads number of threads processing the blocks, all of the
+  ///        global ThreadPool's when less than 1. When blocks are kept out
+  ///        of core, the number of threads in sdiy's thread pool.
   void Initialize(size_t window, const std::string &meshName,
     int association, const std::string &arrayname, size_t kMax,
-    int numThreads = 1);
+    int numThreads = -1);
+
+  /// storage for out-of-core blocks
+  enum {STORAGE_MMAP = 0, STORAGE_FILE = 1};
+
+  /// @brief Keep some of the blocks out of core.
+  ///
+  /// Each block keeps \c window copies of its data, which for long windows
+  /// may not fit in memory. With this set at most \c blocksInMemory blocks
+  /// are kept in memory and the others are stored in files created from
+  /// \c fileTemplate. STORAGE_MMAP pages blocks through a single memory
+  /// mapped file and reads the next block ahead, STORAGE_FILE writes a file
+  /// per block. A limit of -1, the default, keeps all blocks in memory.
+  /// Must be called before Initialize.
+  ///
+  /// @returns zero if successful.
+  int SetOutOfCore(int blocksInMemory, int storageType = STORAGE_MMAP,
+    const std::string &fileTemplate = "/tmp/sensei-autocorrelation.XXXXXX");
 
   bool Execute(DataAdaptor* data) override;
 
@@ -0,0 +1,114 @@
+#include "BlockParallel.h"
+
+#include <vtkCompositeDataIterator.h>
+#include <vtkCompositeDataSet.h>
+#include <vtkDataObject.h>
+#include <vtkSmartPointer.h>
+
+#include <cmath>
+
+namespace
+{
+// pieces smaller than this are not worth handing to a thread
+const long minPieceSize = 4096;
+
+// a piece of a block
+struct Piece
+{
+  long Block;
+  long First;
+  long Last;
+};
+}
+
+namespace sensei
+{
+namespace BlockParallel
+{
+
+// --------------------------------------------------------------------------
+int GetNumberOfThreads(int nThreads)
+{
+  int nPool = ThreadPool::GetGlobalPool().GetNumberOfThreads();
+  return nThreads < 1 ? nPool : std::min(nThreads, nPool);
+}
+
+// --------------------------------------------------------------------------
+void GetBlocks(vtkDataObject *mesh, std::vector<vtkDataObject*> &blocks,
+  std::vector<long> *ids)
+{
+  blocks.clear();
+  if (ids)
+    ids->clear();
+
+  if (!mesh)
+    return;
+
+  vtkCompositeDataSet *cd = dynamic_cast<vtkCompositeDataSet*>(mesh);
+  if (!cd)
+    {
+    blocks.push_back(mesh);
+    if (ids)
+      ids->push_back(0);
+    return;
+    }
+
+  vtkSmartPointer<vtkCompositeDataIterator> it;
+  it.TakeReference(cd->NewIterator());
+  it->SetSkipEmptyNodes(1);
+
+  for (it->InitTraversal(); !it->IsDoneWithTraversal(); it->GoToNextItem())
+    {
+    blocks.push_back(it->GetCurrentDataObject());
+    if (ids)
+      ids->push_back(it->GetCurrentFlatIndex() - 1);
+    }
+}
+
+// --------------------------------------------------------------------------
+void ForEach(long nBlocks, int nThreads, const ThreadPool::LoopBody &body)
+{
+  ThreadPool::GetGlobalPool().ParallelFor(nBlocks, body,
+    GetNumberOfThreads(nThreads));
+}
+
+// --------------------------------------------------------------------------
+void ForEachPiece(const std::vector<long> &sizes, int nThreads,
+  const PieceBody &body)
+{
+  nThreads = GetNumberOfThreads(nThreads);
+
+  long nBlocks = sizes.size();
+
+  double total = 0.0;
+  for (long i = 0; i < nBlocks; ++i)
+    total += sizes[i];
+
+  // a few pieces per thread, in proportion to the size of the blocks
+  long nTarget = 4*nThreads;
+
+  std::vector<Piece> pieces;
+  for (long i = 0; i < nBlocks; ++i)
+    {
+    long n = sizes[i];
+    if (n < 1)
+      continue;
+
+    long nPieces = nThreads < 2 ? 1 : std::max(1L, std::min(
+      long(std::ceil(nTarget*(n/total))), n/minPieceSize));
+
+    for (long j = 0; j < nPieces; ++j)
+      pieces.push_back({i, n*j/nPieces, n*(j + 1)/nPieces});
+    }
+
+  ThreadPool::GetGlobalPool().ParallelFor(pieces.size(),
+    [&](int thread, long p)
+    {
+    const Piece &piece = pieces[p];
+    body(thread, piece.Block, piece.First, piece.Last);
+    },
+    nThreads);
+}
+
+}
+}
@@ -0,0 +1,82 @@
+#ifndef sensei_BlockParallel_h
+#define sensei_BlockParallel_h
+
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+class vtkDataObject;
+
+namespace sensei
+{
+
+/// Helpers for executing the per-block work of an analysis on the global
+/// ThreadPool. An analysis gathers the local blocks of its mesh with
+/// GetBlocks and processes them with ForEach, or with ForEachPiece when the
+/// blocks are large and few enough that they need to be split to keep all
+/// of the threads busy. Partial results, such as ranges and histograms, are
+/// accumulated per thread in a ThreadLocal and merged before the MPI
+/// reduction, so that the threads never contend. The number of threads is
+/// the analysis' n-threads setting, where a value less than 1 uses all of
+/// the pool's threads.
+namespace BlockParallel
+{
+
+/// Get the number of threads that will be used for the given n-threads
+/// setting.
+int GetNumberOfThreads(int nThreads);
+
+/// Get the non-empty leaves of a composite dataset, or the dataset itself
+/// when it is not composite. When ids is given it receives the id of each
+/// block, its flat index less one, or 0 for a dataset that is not
+/// composite.
+void GetBlocks(vtkDataObject *mesh, std::vector<vtkDataObject*> &blocks,
+  std::vector<long> *ids = nullptr);
+
+/// Execute body(threadId, i) for each of the nBlocks blocks.
+void ForEach(long nBlocks, int nThreads, const ThreadPool::LoopBody &body);
+
+/// The body of ForEachPiece is passed the id of the thread, the index of
+/// the block, and the range [first, last) of its elements to process.
+using PieceBody =
+  std::function<void(int threadId, long block, long first, long last)>;
+
+/// Split the blocks, of sizes[i] elements each, into pieces such that each
+/// thread has a few of them and execute body on each piece.
+void ForEachPiece(const std::vector<long> &sizes, int nThreads,
+  const PieceBody &body);
+
+/// Per-thread storage for the partial results of ForEach and ForEachPiece.
+/// The loop body accumulates into the value of the thread executing it.
+template <typename T>
+class ThreadLocal
+{
+public:
+  /// allocate a value, copied from init, for each of the threads that the
+  /// given n-threads setting uses
+  explicit ThreadLocal(int nThreads, const T &init = T()) :
+    Values(GetNumberOfThreads(nThreads), init) {}
+
+  T &operator[](int threadId) { return this->Values[threadId]; }
+
+  /// merge the values of the threads into the first, using
+  /// op(T &a, const T &b) to merge b into a, and return it.
+  template <typename Op>
+  T &Merge(const Op &op)
+  {
+    size_t n = this->Values.size();
+    for (size_t i = 1; i < n; ++i)
+      op(this->Values[0], this->Values[i]);
+    return this->Values[0];
+  }
+
+private:
+  std::vector<T> Values;
+};
+
+}
+}
+
+#endif
@@ -0,0 +1,756 @@
+#include "CartesianExtract.h"
+#include "ThreadPool.h"
+#include "BlockParallel.h"
+#include "Profiler.h"
+#include "Error.h"
+
+#include <vtkDataObject.h>
+#include <vtkCompositeDataSet.h>
+#include <vtkCompositeDataIterator.h>
+#include <vtkUniformGridAMRDataIterator.h>
+#include <vtkImageData.h>
+#include <vtkPolyData.h>
+#include <vtkPoints.h>
+#include <vtkCellArray.h>
+#include <vtkPointData.h>
+#include <vtkCellData.h>
+#include <vtkFieldData.h>
+#include <vtkDataArray.h>
+#include <vtkDoubleArray.h>
+#include <vtkFloatArray.h>
+#include <vtkIdTypeArray.h>
+#include <vtkUnsignedCharArray.h>
+#include <vtkMarchingCubesTriangleCases.h>
+
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+// marching cubes cell edges as pairs of corners, the lower corner first,
+// the axis each edge is parallel to, and the offset of each corner. the
+// corners are ordered as in vtkMarchingCubes, which the case table expects
+const int mcEdges[12][2] = {{0,1}, {1,2}, {3,2}, {0,3}, {4,5}, {5,6},
+  {7,6}, {4,7}, {0,4}, {1,5}, {3,7}, {2,6}};
+
+const int mcEdgeAxis[12] = {0, 1, 0, 1, 0, 1, 0, 1, 2, 2, 2, 2};
+
+const int mcCorners[8][3] = {{0,0,0}, {1,0,0}, {1,1,0}, {0,1,0},
+  {0,0,1}, {1,0,1}, {1,1,1}, {0,1,1}};
+
+// a Cartesian block and the field to contour
+struct Block
+{
+  Block() : Image(nullptr), Id(-1), Dims{0,0,0}, X0{0.,0.,0.},
+    Dx{1.,1.,1.}, Ghosts(nullptr), Array(nullptr), Skip(false) {}
+
+  vtkImageData *Image;
+  long Id;
+  int Dims[3];
+  double X0[3];
+  double Dx[3];
+  const unsigned char *Ghosts;
+  vtkDataArray *Array;          // the point data array to contour, or
+  std::vector<double> Field;    // the values to contour
+  bool Skip;
+};
+
+// a slab of cells of a block and the triangles extracted from it
+struct Piece
+{
+  long BlockIndex;
+  int K0;
+  int K1;
+  std::vector<float> Points;        // 3 coordinates per point
+  std::vector<vtkIdType> Edges;     // the 2 input points of each point
+  std::vector<float> Weights;       // the weight of the 2nd input point
+  std::vector<double> Scalars;      // the contour value at each point
+  std::vector<vtkIdType> Tris;      // 3 points per triangle
+  std::vector<vtkIdType> Cells;     // the input cell of each triangle
+};
+
+// --------------------------------------------------------------------------
+template <typename T>
+void Contour(const T *s, int stride, const Block &block,
+  const std::vector<double> &vals, Piece &piece)
+{
+  vtkMarchingCubesTriangleCases *cases =
+    vtkMarchingCubesTriangleCases::GetCases();
+
+  vtkIdType nx = block.Dims[0];
+  vtkIdType nxy = nx*block.Dims[1];
+  int ncx = block.Dims[0] - 1;
+  int ncy = block.Dims[1] - 1;
+
+  vtkIdType offs[8];
+  for (int m = 0; m < 8; ++m)
+    offs[m] = mcCorners[m][0] + mcCorners[m][1]*nx + mcCorners[m][2]*nxy;
+
+  // output points are shared by the cells around an edge. an edge is
+  // identified by its lower point and axis
+  std::unordered_map<vtkIdType, vtkIdType> edgeIds;
+
+  size_t nVals = vals.size();
+  for (size_t q = 0; q < nVals; ++q)
+    {
+    double v = vals[q];
+    edgeIds.clear();
+
+    for (int k = piece.K0; k < piece.K1; ++k)
+      {
+      for (int j = 0; j < ncy; ++j)
+        {
+        vtkIdType cid = (vtkIdType(k)*ncy + j)*ncx;
+        vtkIdType pid = k*nxy + j*nx;
+        for (int i = 0; i < ncx; ++i, ++cid, ++pid)
+          {
+          if (block.Ghosts && block.Ghosts[cid])
+            continue;
+
+          double c[8];
+          int index = 0;
+          for (int m = 0; m < 8; ++m)
+            {
+            c[m] = s[(pid + offs[m])*stride];
+            index |= (c[m] >= v) << m;
+            }
+
+          if ((index == 0) || (index == 255))
+            continue;
+
+          const int *edge = cases[index].edges;
+          for (; edge[0] > -1; edge += 3)
+            {
+            vtkIdType tri[3];
+            for (int e = 0; e < 3; ++e)
+              {
+              int a = mcEdges[edge[e]][0];
+              int b = mcEdges[edge[e]][1];
+              int axis = mcEdgeAxis[edge[e]];
+
+              vtkIdType pa = pid + offs[a];
+              vtkIdType key = 3*pa + axis;
+
+              std::pair<std::unordered_map<vtkIdType, vtkIdType>::iterator, bool>
+                ins = edgeIds.emplace(key, vtkIdType(piece.Weights.size()));
+
+              if (ins.second)
+                {
+                double w = (v - c[a])/(c[b] - c[a]);
+
+                double ijk[3] = {double(i + mcCorners[a][0]),
+                  double(j + mcCorners[a][1]), double(k + mcCorners[a][2])};
+                ijk[axis] += w;
+
+                for (int d = 0; d < 3; ++d)
+                  piece.Points.push_back(block.X0[d] + block.Dx[d]*ijk[d]);
+
+                piece.Edges.push_back(pa);
+                piece.Edges.push_back(pid + offs[b]);
+                piece.Weights.push_back(w);
+                piece.Scalars.push_back(v);
+                }
+
+              tri[e] = ins.first->second;
+              }
+
+            if ((tri[0] != tri[1]) && (tri[1] != tri[2]) && (tri[0] != tri[2]))
+              {
+              piece.Tris.insert(piece.Tris.end(), tri, tri + 3);
+              piece.Cells.push_back(cid);
+              }
+            }
+          }
+        }
+      }
+    }
+}
+
+// --------------------------------------------------------------------------
+template <typename T>
+void CellToPoint(const T *cd, int stride, const Block &block,
+  std::vector<double> &pd)
+{
+  int nx = block.Dims[0];
+  int ny = block.Dims[1];
+  int nz = block.Dims[2];
+  int ncx = nx - 1;
+  int ncy = ny - 1;
+
+  pd.resize(vtkIdType(nx)*ny*nz);
+
+  // average the cells around each point, ignoring ghost cells unless
+  // there is nothing else
+  vtkIdType pid = 0;
+  for (int k = 0; k < nz; ++k)
+    {
+    int k0 = std::max(k - 1, 0);
+    int k1 = std::min(k, nz - 2);
+    for (int j = 0; j < ny; ++j)
+      {
+      int j0 = std::max(j - 1, 0);
+      int j1 = std::min(j, ny - 2);
+      for (int i = 0; i < nx; ++i, ++pid)
+        {
+        int i0 = std::max(i - 1, 0);
+        int i1 = std::min(i, nx - 2);
+
+        double sum = 0.0;
+        int n = 0;
+        double gsum = 0.0;
+        int gn = 0;
+        for (int kk = k0; kk <= k1; ++kk)
+          {
+          for (int jj = j0; jj <= j1; ++jj)
+            {
+            for (int ii = i0; ii <= i1; ++ii)
+              {
+              vtkIdType cid = (vtkIdType(kk)*ncy + jj)*ncx + ii;
+              double val = cd[cid*stride];
+              if (block.Ghosts && block.Ghosts[cid])
+                {
+                gsum += val;
+                gn += 1;
+                }
+              else
+                {
+                sum += val;
+                n += 1;
+                }
+              }
+            }
+          }
+
+        pd[pid] = n ? sum/n : gsum/gn;
+        }
+      }
+    }
+}
+
+// --------------------------------------------------------------------------
+template <typename T>
+void Interpolate(const T *in, int nComps, const vtkIdType *edges,
+  const float *weights, vtkIdType n, T *out)
+{
+  for (vtkIdType i = 0; i < n; ++i)
+    {
+    const T *a = in + edges[2*i]*nComps;
+    const T *b = in + edges[2*i+1]*nComps;
+    double w = weights[i];
+    for (int c = 0; c < nComps; ++c)
+      out[i*nComps + c] = static_cast<T>(a[c] + w*(double(b[c]) - a[c]));
+    }
+}
+
+// --------------------------------------------------------------------------
+template <typename T>
+void Gather(const T *in, int nComps, const vtkIdType *ids, vtkIdType n,
+  T *out)
+{
+  for (vtkIdType i = 0; i < n; ++i)
+    {
+    const T *a = in + ids[i]*nComps;
+    for (int c = 0; c < nComps; ++c)
+      out[i*nComps + c] = a[c];
+    }
+}
+
+// --------------------------------------------------------------------------
+int GetBlocks(vtkCompositeDataSet *input, std::vector<Block> &blocks)
+{
+  vtkCompositeDataIterator *it = input->NewIterator();
+  it->SetSkipEmptyNodes(1);
+
+  // AMR block ids do not match the metadata
+  bool amr = dynamic_cast<vtkUniformGridAMRDataIterator*>(it);
+
+  for (it->InitTraversal(); !it->IsDoneWithTraversal(); it->GoToNextItem())
+    {
+    vtkImageData *im = dynamic_cast<vtkImageData*>(it->GetCurrentDataObject());
+    if (!im)
+      {
+      it->Delete();
+      return -1;
+      }
+
+    Block block;
+    block.Image = im;
+    block.Id = amr ? -1 : long(it->GetCurrentFlatIndex()) - 1;
+
+    im->GetDimensions(block.Dims);
+    if ((block.Dims[0] < 2) || (block.Dims[1] < 2) || (block.Dims[2] < 2))
+      {
+      it->Delete();
+      return -1;
+      }
+
+    int ext[6];
+    im->GetExtent(ext);
+    im->GetSpacing(block.Dx);
+    im->GetOrigin(block.X0);
+    for (int d = 0; d < 3; ++d)
+      block.X0[d] += ext[2*d]*block.Dx[d];
+
+    vtkUnsignedCharArray *ghosts = dynamic_cast<vtkUnsignedCharArray*>(
+      im->GetCellData()->GetArray("vtkGhostType"));
+
+    block.Ghosts = ghosts ? ghosts->GetPointer(0) : nullptr;
+
+    blocks.push_back(std::move(block));
+    }
+
+  it->Delete();
+
+  return 0;
+}
+
+// --------------------------------------------------------------------------
+// an array copied to the output, and where to find it in each block
+struct OutputArray
+{
+  std::string Name;
+  int Centering;
+  vtkDataArray *Out;
+  std::vector<void*> In;
+};
+
+// --------------------------------------------------------------------------
+void GetOutputArrays(const std::vector<Block> &blocks, int centering,
+  vtkIdType nOut, std::vector<OutputArray> &arrays)
+{
+  long nBlocks = blocks.size();
+
+  long ref = 0;
+  while ((ref < nBlocks) && blocks[ref].Skip)
+    ++ref;
+
+  if (ref == nBlocks)
+    return;
+
+  vtkFieldData *refAtts = centering == vtkDataObject::POINT ?
+    static_cast<vtkFieldData*>(blocks[ref].Image->GetPointData()) :
+    static_cast<vtkFieldData*>(blocks[ref].Image->GetCellData());
+
+  int nArrays = refAtts->GetNumberOfArrays();
+  for (int j = 0; j < nArrays; ++j)
+    {
+    vtkDataArray *refDa = refAtts->GetArray(j);
+    if (!refDa || !refDa->GetName() ||
+      (strcmp(refDa->GetName(), "vtkGhostType") == 0))
+      continue;
+
+    // the array is passed only if every block has it
+    OutputArray oa;
+    oa.Name = refDa->GetName();
+    oa.Centering = centering;
+    oa.In.resize(nBlocks, nullptr);
+
+    bool ok = true;
+    for (long i = 0; ok && (i < nBlocks); ++i)
+      {
+      if (blocks[i].Skip)
+        continue;
+
+      vtkFieldData *atts = centering == vtkDataObject::POINT ?
+        static_cast<vtkFieldData*>(blocks[i].Image->GetPointData()) :
+        static_cast<vtkFieldData*>(blocks[i].Image->GetCellData());
+
+      vtkDataArray *da = atts->GetArray(oa.Name.c_str());
+
+      ok = da && (da->GetDataType() == refDa->GetDataType()) &&
+        (da->GetNumberOfComponents() == refDa->GetNumberOfComponents());
+
+      // get the pointer now, it may not be safe to do so from the
+      // worker threads
+      if (ok)
+        oa.In[i] = da->GetVoidPointer(0);
+      }
+
+    if (!ok)
+      continue;
+
+    oa.Out = vtkDataArray::CreateDataArray(refDa->GetDataType());
+    oa.Out->SetName(oa.Name.c_str());
+    oa.Out->SetNumberOfComponents(refDa->GetNumberOfComponents());
+    oa.Out->SetNumberOfTuples(nOut);
+
+    arrays.push_back(std::move(oa));
+    }
+}
+
+// --------------------------------------------------------------------------
+// contour the blocks' fields at the given values and merge the results
+// into a single polydata. when scalarName is given the contour values are
+// passed in a point data array of that name
+int Extract(std::vector<Block> &blocks, const std::vector<double> &vals,
+  const char *scalarName, int nThreads, vtkPolyData *&output)
+{
+  sensei::ThreadPool &pool = sensei::ThreadPool::GetGlobalPool();
+  nThreads = sensei::BlockParallel::GetNumberOfThreads(nThreads);
+
+  // split the blocks into slabs, such that there are a few per thread, to
+  // balance the load when there are fewer blocks than threads
+  long nBlocks = blocks.size();
+
+  double nCells = 0.0;
+  for (long i = 0; i < nBlocks; ++i)
+    {
+    if (!blocks[i].Skip)
+      nCells += double(blocks[i].Dims[0] - 1)*(blocks[i].Dims[1] - 1)*
+        (blocks[i].Dims[2] - 1);
+    }
+
+  int nTarget = 4*nThreads;
+
+  std::vector<Piece> pieces;
+  for (long i = 0; i < nBlocks; ++i)
+    {
+    if (blocks[i].Skip)
+      continue;
+
+    int ncz = blocks[i].Dims[2] - 1;
+    double blockCells = double(blocks[i].Dims[0] - 1)*
+      (blocks[i].Dims[1] - 1)*ncz;
+
+    int nSlabs = std::max(1, std::min(ncz,
+      int(std::ceil(nTarget*blockCells/nCells))));
+
+    for (int j = 0; j < nSlabs; ++j)
+      {
+      Piece piece;
+      piece.BlockIndex = i;
+      piece.K0 = ncz*j/nSlabs;
+      piece.K1 = ncz*(j + 1)/nSlabs;
+      pieces.push_back(std::move(piece));
+      }
+    }
+
+  long nPieces = pieces.size();
+
+  {
+  sensei::TimeEvent<128> mark("CartesianExtract::Contour");
+  pool.ParallelFor(nPieces,
+    [&](int, long p)
+    {
+    Piece &piece = pieces[p];
+    const Block &block = blocks[piece.BlockIndex];
+    if (block.Array)
+      {
+      int stride = block.Array->GetNumberOfComponents();
+      switch (block.Array->GetDataType())
+        {
+        vtkTemplateMacro(
+          const VTK_TT *s = static_cast<const VTK_TT*>(
+            block.Array->GetVoidPointer(0));
+          Contour(s, stride, block, vals, piece);
+          );
+        }
+      }
+    else
+      {
+      Contour(block.Field.data(), 1, block, vals, piece);
+      }
+    },
+    nThreads);
+  }
+
+  sensei::TimeEvent<128> mark("CartesianExtract::Merge");
+
+  // where each piece goes in the output
+  std::vector<vtkIdType> ptOffs(nPieces + 1, 0);
+  std::vector<vtkIdType> triOffs(nPieces + 1, 0);
+  for (long p = 0; p < nPieces; ++p)
+    {
+    ptOffs[p + 1] = ptOffs[p] + pieces[p].Weights.size();
+    triOffs[p + 1] = triOffs[p] + pieces[p].Cells.size();
+    }
+
+  vtkIdType nPts = ptOffs[nPieces];
+  vtkIdType nTris = triOffs[nPieces];
+
+  vtkFloatArray *x = vtkFloatArray::New();
+  x->SetNumberOfComponents(3);
+  x->SetNumberOfTuples(nPts);
+  float *px = x->GetPointer(0);
+
+  vtkIdTypeArray *conn = vtkIdTypeArray::New();
+  conn->SetNumberOfTuples(4*nTris);
+  vtkIdType *pconn = conn->GetPointer(0);
+
+  vtkDoubleArray *scalars = nullptr;
+  double *pscalars = nullptr;
+  if (scalarName)
+    {
+    scalars = vtkDoubleArray::New();
+    scalars->SetName(scalarName);
+    scalars->SetNumberOfTuples(nPts);
+    pscalars = scalars->GetPointer(0);
+    }
+
+  std::vector<OutputArray> arrays;
+  GetOutputArrays(blocks, vtkDataObject::POINT, nPts, arrays);
+  GetOutputArrays(blocks, vtkDataObject::CELL, nTris, arrays);
+
+  size_t nArrays = arrays.size();
+
+  pool.ParallelFor(nPieces,
+    [&](int, long p)
+    {
+    const Piece &piece = pieces[p];
+    long bi = piece.BlockIndex;
+    vtkIdType ptOff = ptOffs[p];
+    vtkIdType triOff = triOffs[p];
+    vtkIdType np = piece.Weights.size();
+    vtkIdType nt = piece.Cells.size();
+
+    std::copy(piece.Points.begin(), piece.Points.end(), px + 3*ptOff);
+
+    vtkIdType *pc = pconn + 4*triOff;
+    for (vtkIdType i = 0; i < nt; ++i)
+      {
+      pc[4*i] = 3;
+      pc[4*i+1] = piece.Tris[3*i] + ptOff;
+      pc[4*i+2] = piece.Tris[3*i+1] + ptOff;
+      pc[4*i+3] = piece.Tris[3*i+2] + ptOff;
+      }
+
+    if (pscalars)
+      std::copy(piece.Scalars.begin(), piece.Scalars.end(), pscalars + ptOff);
+
+    for (size_t j = 0; j < nArrays; ++j)
+      {
+      const OutputArray &oa = arrays[j];
+      int nComps = oa.Out->GetNumberOfComponents();
+      switch (oa.Out->GetDataType())
+        {
+        vtkTemplateMacro(
+          const VTK_TT *in = static_cast<const VTK_TT*>(oa.In[bi]);
+          VTK_TT *out = static_cast<VTK_TT*>(oa.Out->GetVoidPointer(0));
+          if (oa.Centering == vtkDataObject::POINT)
+            Interpolate(in, nComps, piece.Edges.data(),
+              piece.Weights.data(), np, out + ptOff*nComps);
+          else
+            Gather(in, nComps, piece.Cells.data(), nt, out + triOff*nComps);
+          );
+        }
+      }
+    },
+    nThreads);
+
+  vtkPoints *points = vtkPoints::New();
+  points->SetData(x);
+  x->Delete();
+
+  vtkCellArray *polys = vtkCellArray::New();
+  polys->SetCells(nTris, conn);
+  conn->Delete();
+
+  vtkPolyData *pd = vtkPolyData::New();
+  pd->SetPoints(points);
+  pd->SetPolys(polys);
+  points->Delete();
+  polys->Delete();
+
+  if (scalars)
+    {
+    pd->GetPointData()->AddArray(scalars);
+    scalars->Delete();
+    }
+
+  for (size_t j = 0; j < nArrays; ++j)
+    {
+    if (arrays[j].Centering == vtkDataObject::POINT)
+      pd->GetPointData()->AddArray(arrays[j].Out);
+    else
+      pd->GetCellData()->AddArray(arrays[j].Out);
+    arrays[j].Out->Delete();
+    }
+
+  output = pd;
+
+  return 0;
+}
+}
+
+namespace sensei
+{
+namespace CartesianExtract
+{
+
+// --------------------------------------------------------------------------
+bool Supported(vtkCompositeDataSet *input)
+{
+  std::vector<Block> blocks;
+  return GetBlocks(input, blocks) == 0;
+}
+
+// --------------------------------------------------------------------------
+int IsoSurface(vtkCompositeDataSet *input, const std::string &arrayName,
+  int arrayCen, const std::vector<double> &vals,
+  const std::map<long, std::array<double,2>> &blockRanges,
+  vtkPolyData *&output, int nThreads)
+{
+  TimeEvent<128> mark("CartesianExtract::IsoSurface");
+
+  std::vector<Block> blocks;
+  if (GetBlocks(input, blocks))
+    {
+    SENSEI_ERROR("Only 3D vtkImageData blocks are supported")
+    return -1;
+    }
+
+  long nBlocks = blocks.size();
+
+  // skip blocks that the surfaces do not pass through. a value at or
+  // below the minimum puts all of the points inside
+  for (long i = 0; i < nBlocks; ++i)
+    {
+    std::map<long, std::array<double,2>>::const_iterator it =
+      blockRanges.find(blocks[i].Id);
+
+    if ((blocks[i].Id < 0) || (it == blockRanges.end()))
+      continue;
+
+    const std::array<double,2> &rng = it->second;
+
+    bool skip = true;
+    size_t nVals = vals.size();
+    for (size_t q = 0; skip && (q < nVals); ++q)
+      skip = (vals[q] <= rng[0]) || (vals[q] > rng[1]);
+
+    blocks[i].Skip = skip;
+    }
+
+  // get the field to contour
+  std::vector<int> errors(nBlocks, 0);
+  ThreadPool::GetGlobalPool().ParallelFor(nBlocks,
+    [&](int, long i)
+    {
+    Block &block = blocks[i];
+    if (block.Skip)
+      return;
+
+    vtkDataArray *da = arrayCen == vtkDataObject::POINT ?
+      block.Image->GetPointData()->GetArray(arrayName.c_str()) :
+      block.Image->GetCellData()->GetArray(arrayName.c_str());
+
+    if (!da)
+      {
+      errors[i] = 1;
+      return;
+      }
+
+    // only the contoured array is converted
+    if (arrayCen == vtkDataObject::CELL)
+      {
+      int stride = da->GetNumberOfComponents();
+      switch (da->GetDataType())
+        {
+        vtkTemplateMacro(
+          const VTK_TT *cd = static_cast<const VTK_TT*>(da->GetVoidPointer(0));
+          CellToPoint(cd, stride, block, block.Field);
+          );
+        default:
+          errors[i] = 1;
+        }
+      }
+    else
+      {
+      block.Array = da;
+      }
+    },
+    nThreads);
+
+  for (long i = 0; i < nBlocks; ++i)
+    {
+    if (errors[i])
+      {
+      SENSEI_ERROR("Failed to get " << (arrayCen == vtkDataObject::POINT ?
+        "point" : "cell") << " data array \"" << arrayName
+        << "\" from block " << blocks[i].Id)
+      return -1;
+      }
+    }
+
+  // the point data of the surfaces includes the contoured array. for
+  // cell data it is not otherwise there
+  const char *scalarName =
+    arrayCen == vtkDataObject::CELL ? arrayName.c_str() : nullptr;
+
+  return Extract(blocks, vals, scalarName, nThreads, output);
+}
+
+// --------------------------------------------------------------------------
+int Slice(vtkCompositeDataSet *input, const std::array<double,3> &point,
+  const std::array<double,3> &normal, vtkPolyData *&output, int nThreads)
+{
+  TimeEvent<128> mark("CartesianExtract::Slice");
+
+  std::vector<Block> blocks;
+  if (GetBlocks(input, blocks))
+    {
+    SENSEI_ERROR("Only 3D vtkImageData blocks are supported")
+    return -1;
+    }
+
+  // the slice is the zero contour of the signed distance to the plane
+  long nBlocks = blocks.size();
+  ThreadPool::GetGlobalPool().ParallelFor(nBlocks,
+    [&](int, long i)
+    {
+    Block &block = blocks[i];
+
+    double d0 = 0.0;
+    double dd[3];
+    for (int d = 0; d < 3; ++d)
+      {
+      d0 += normal[d]*(block.X0[d] - point[d]);
+      dd[d] = normal[d]*block.Dx[d];
+      }
+
+    // skip blocks that the plane does not pass through. the distance is
+    // linear, its extremes are at the corners
+    int nInside = 0;
+    for (int m = 0; m < 8; ++m)
+      {
+      double dist = d0;
+      for (int d = 0; d < 3; ++d)
+        dist += dd[d]*(block.Dims[d] - 1)*mcCorners[m][d];
+      nInside += dist >= 0.0;
+      }
+
+    if ((nInside == 0) || (nInside == 8))
+      {
+      block.Skip = true;
+      return;
+      }
+
+    int nx = block.Dims[0];
+    int ny = block.Dims[1];
+    int nz = block.Dims[2];
+
+    block.Field.resize(vtkIdType(nx)*ny*nz);
+    double *f = block.Field.data();
+
+    for (int k = 0; k < nz; ++k)
+      {
+      for (int j = 0; j < ny; ++j)
+        {
+        double dkj = d0 + dd[2]*k + dd[1]*j;
+        for (int ii = 0; ii < nx; ++ii, ++f)
+          *f = dkj + dd[0]*ii;
+        }
+      }
+    },
+    nThreads);
+
+  std::vector<double> vals(1, 0.0);
+  return Extract(blocks, vals, nullptr, nThreads, output);
+}
+
+}
+}
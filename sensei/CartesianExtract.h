@@ -0,0 +1,53 @@
+#ifndef CartesianExtract_h
+#define CartesianExtract_h
+
+class vtkCompositeDataSet;
+class vtkPolyData;
+
+#include <vector>
+#include <array>
+#include <map>
+#include <string>
+
+namespace sensei
+{
+
+/// Iso-surface and planar slice extraction on Cartesian meshes. Unlike the
+/// VTK filters, all of the vtkImageData blocks of a rank are processed at
+/// once, in parallel using the global ThreadPool, and the result is a
+/// single vtkPolyData of triangles. Blocks are split into slabs so that
+/// ranks with only a few large blocks use all of their threads. Cells
+/// flagged in the vtkGhostType cell array are skipped. Point data arrays
+/// are interpolated onto the output points and cell data arrays are copied
+/// to the triangles. Points are merged within a slab, not across slabs or
+/// blocks.
+namespace CartesianExtract
+{
+
+/// Returns true if every non-empty leaf of the input is a 3D vtkImageData,
+/// the case handled here.
+bool Supported(vtkCompositeDataSet *input);
+
+/// Extract the iso-surfaces of the named array at the given values using
+/// marching cubes. The first component of the array is used. A cell
+/// centered array is first converted to point data by averaging the
+/// non-ghost cells around each point, no other arrays are converted, and
+/// the converted values are passed as a point data array of the same name.
+/// When block ranges are given, keyed by block id, blocks whose range
+/// excludes all of the values are skipped without being touched. Block ids
+/// are flat indices, and ranges are ignored for AMR. At most nThreads
+/// threads are used, all of the pool's when it is less than 1.
+int IsoSurface(vtkCompositeDataSet *input, const std::string &arrayName,
+  int arrayCen, const std::vector<double> &vals,
+  const std::map<long, std::array<double,2>> &blockRanges,
+  vtkPolyData *&output, int nThreads = -1);
+
+/// Extract the slice through the given point with the given normal.
+int Slice(vtkCompositeDataSet *input, const std::array<double,3> &point,
+  const std::array<double,3> &normal, vtkPolyData *&output,
+  int nThreads = -1);
+
+}
+}
+
+#endif
@@ -1,5 +1,6 @@
 #include "CinemaHelper.h"
 #include "Profiler.h"
+#include "ThreadPool.h"
 
 #include <vector>
 #include <map>
@@ -203,38 +204,155 @@ void convertToDoubles(std::vector<std::string> &input, double* output)
     }
 }
 
+#ifdef ENABLE_CATALYST
 // --------------------------------------------------------------------------
-// Helper Struct for pixel sorting
+// Helpers for sorted composite data
 // --------------------------------------------------------------------------
 
-struct Pixel
-{
-  unsigned char Index;
-  float Depth;
+// number of pixels ordered at once. the sorting network is applied to all
+// the pixels of a tile together, which the compiler vectorizes.
+static const size_t SORT_TILE = 64;
 
-  Pixel() : Index(0), Depth(0.0) {}
-  ~Pixel() {}
-  Pixel(const Pixel& other)
-  {
-    this->Index = other.Index;
-    this->Depth = other.Depth;
-  }
-  void operator=(const Pixel& other)
-  {
-    this->Index = other.Index;
-    this->Depth = other.Depth;
-  }
-  // void operator<(const Pixel& other)
-  // {
-  //   return this->Depth < other.Depth;
-  // }
+// the per layer image planes of a sorted composite. kept across camera
+// positions so that the memory is allocated only once.
+struct CompositeBuffers
+{
+  std::vector<std::vector<float>> Depths;             // depth plane per layer
+  std::vector<std::vector<unsigned char>> Luminances; // luminance plane per layer
+  std::vector<unsigned char> Order;      // layer ids, nearest first plane
+  std::vector<unsigned char> Intensity;  // luminance of Order
+  std::vector<std::vector<float>> TileDepths; // per thread network scratch
+  std::vector<std::vector<int>> TileIds;
 };
 
-bool pixelComp(Pixel& a, Pixel& b)
+// --------------------------------------------------------------------------
+// order the nLayers rows of SORT_TILE lanes front to back with an odd-even
+// transposition network. lanes are independent and every compare-exchange
+// is branch free so the inner loop is vectorized. equal depths keep layer
+// order.
+static void sortTile(size_t nLayers, float *depth, int *ids)
 {
-  return a.Depth < b.Depth;
+  for (size_t pass = 0; pass < nLayers; ++pass)
+    {
+    for (size_t i = pass % 2; i + 1 < nLayers; i += 2)
+      {
+      float *d0 = depth + i*SORT_TILE;
+      float *d1 = d0 + SORT_TILE;
+      int *id0 = ids + i*SORT_TILE;
+      int *id1 = id0 + SORT_TILE;
+      for (size_t j = 0; j < SORT_TILE; ++j)
+        {
+        float a = d0[j];
+        float b = d1[j];
+        int ia = id0[j];
+        int ib = id1[j];
+        bool swap = b < a;
+        d0[j] = swap ? b : a;
+        d1[j] = swap ? a : b;
+        id0[j] = swap ? ib : ia;
+        id1[j] = swap ? ia : ib;
+        }
+      }
+    }
 }
 
+// --------------------------------------------------------------------------
+// compute the order and intensity planes from the captured depth and
+// luminance planes. a layer where nothing was rendered (depth 1) at a
+// pixel is ordered last, with id 255 and intensity 0. image rows are
+// processed in parallel.
+static void sortComposite(CompositeBuffers &buf, size_t nLayers,
+  size_t linearSize, size_t rowSize)
+{
+  size_t stackSize = nLayers*linearSize;
+  buf.Order.resize(stackSize);
+  buf.Intensity.resize(stackSize);
+
+  if (!nLayers || !linearSize)
+    return;
+
+  rowSize = rowSize ? std::min(rowSize, linearSize) : linearSize;
+  size_t nRows = linearSize/rowSize + (linearSize % rowSize ? 1 : 0);
+
+  ThreadPool &pool = ThreadPool::GetGlobalPool();
+  size_t nThreads = pool.GetNumberOfThreads();
+  buf.TileDepths.resize(nThreads);
+  buf.TileIds.resize(nThreads);
+
+  pool.ParallelFor(nRows, [&](int thread, long row)
+    {
+    std::vector<float> &tileDepths = buf.TileDepths[thread];
+    std::vector<int> &tileIds = buf.TileIds[thread];
+    tileDepths.resize(nLayers*SORT_TILE);
+    tileIds.resize(nLayers*SORT_TILE);
+    float *depth = tileDepths.data();
+    int *ids = tileIds.data();
+
+    size_t rowStart = row*rowSize;
+    size_t rowEnd = std::min(rowStart + rowSize, linearSize);
+
+    for (size_t tileStart = rowStart; tileStart < rowEnd; tileStart += SORT_TILE)
+      {
+      size_t n = std::min(SORT_TILE, rowEnd - tileStart);
+
+      // load the tile. unused lanes are background
+      for (size_t i = 0; i < nLayers; ++i)
+        {
+        const float *src = buf.Depths[i].data() + tileStart;
+        float *d = depth + i*SORT_TILE;
+        int *id = ids + i*SORT_TILE;
+        for (size_t j = 0; j < n; ++j)
+          {
+          bool bg = !(src[j] < 1.0f);
+          d[j] = bg ? 1.0f : src[j];
+          id[j] = bg ? 255 : int(i);
+          }
+        for (size_t j = n; j < SORT_TILE; ++j)
+          {
+          d[j] = 1.0f;
+          id[j] = 255;
+          }
+        }
+
+      sortTile(nLayers, depth, ids);
+
+      // store the order and look up the intensity
+      for (size_t i = 0; i < nLayers; ++i)
+        {
+        const int *id = ids + i*SORT_TILE;
+        unsigned char *order = buf.Order.data() + i*linearSize + tileStart;
+        unsigned char *intensity = buf.Intensity.data() + i*linearSize + tileStart;
+        for (size_t j = 0; j < n; ++j)
+          {
+          order[j] = id[j];
+          intensity[j] = id[j] < 255 ?
+            buf.Luminances[id[j]][tileStart + j] : 0;
+          }
+        }
+      }
+    });
+}
+
+// --------------------------------------------------------------------------
+// write a plane stack of the sorted composite
+static void writeComposite(const std::string &fileName,
+  const std::vector<unsigned char> &data)
+{
+  std::ofstream fp(fileName.c_str(), ios::out | ios::binary);
+
+  if (fp.fail())
+    {
+    std::cout << "Unable to open file: "<< fileName.c_str() << std::endl;
+    }
+  else
+    {
+    fp.write((const char*)data.data(), data.size());
+    fp.flush();
+    fp.close();
+    }
+}
+#endif
+
 // --------------------------------------------------------------------------
 // Internals
 // --------------------------------------------------------------------------
@@ -254,6 +372,7 @@ struct CinemaHelper::Internals
   int CurrentCameraPosition;
 #ifdef ENABLE_CATALYST
   std::vector<vtkSmartPointer<vtkSMRepresentationProxy>> Representations;
+  CompositeBuffers Composite;
 #endif
   std::vector<vtkSmartPointer<vtkActor>> Actors;
   std::string CaptureMethod;
@@ -981,10 +1100,14 @@ void CinemaHelper::CaptureSortedCompositeData(vtkSMRenderViewProxy* view)
 
   // Show only active Representation
   // Extract images for each fields
-  std::vector<vtkSmartPointer<vtkFloatArray>> zBuffers;
-  std::vector<vtkSmartPointer<vtkUnsignedCharArray>> luminances;
+  CompositeBuffers &buf = this->Data->Composite;
   size_t compositeSize = this->Data->Representations.size();
-  int linearSize = 0;
+  size_t linearSize = 0;
+  if (this->Data->IsRoot)
+    {
+    buf.Depths.resize(compositeSize);
+    buf.Luminances.resize(compositeSize);
+    }
   for (size_t compositeIdx = 0; compositeIdx < compositeSize; compositeIdx++)
     {
     vtkSMRepresentationProxy* rep = this->Data->Representations[compositeIdx];
@@ -1001,12 +1124,16 @@ void CinemaHelper::CaptureSortedCompositeData(vtkSMRenderViewProxy* view)
     vtkSMPropertyHelper(rep, "Visibility").Set(1);
     rep->UpdateVTKObjects();
 
-    // capture Z
+    // capture Z. the view owns the buffer and reuses it on the next
+    // capture, copy it into the layer's plane
     view->StillRender();
-    vtkSmartPointer<vtkFloatArray> zBuffer = vtkSmartPointer<vtkFloatArray>::New();
-    zBuffer->DeepCopy(view->CaptureDepthBuffer());
-    // vtkSmartPointer<vtkFloatArray> zBuffer = view->CaptureDepthBuffer(); // FIXME test
-    zBuffers.push_back(zBuffer);
+    vtkFloatArray* zBuffer = view->CaptureDepthBuffer();
+    if (this->Data->IsRoot)
+      {
+      size_t nz = zBuffer->GetNumberOfTuples();
+      const float* pz = zBuffer->GetPointer(0);
+      buf.Depths[compositeIdx].assign(pz, pz + nz);
+      }
 
     // Prevent color interference to handle light (intensity)
     double white[3] = {1, 1, 1};
@@ -1018,18 +1145,21 @@ void CinemaHelper::CaptureSortedCompositeData(vtkSMRenderViewProxy* view)
     vtkUnsignedCharArray* imagescalars = vtkUnsignedCharArray::SafeDownCast(view->CaptureWindow(1)->GetPointData()->GetScalars());
 
     // Extract specular information
-    int specularOffset = 1; // [diffuse, specular, ?]
-    linearSize = imagescalars->GetNumberOfTuples();
-    vtkSmartPointer<vtkUnsignedCharArray> specularComponent = vtkSmartPointer<vtkUnsignedCharArray>::New();
-    specularComponent->SetNumberOfComponents(1);
-    specularComponent->SetNumberOfTuples(linearSize);
-
-    for (int idx = 0; idx < linearSize; idx++)
+    if (this->Data->IsRoot)
       {
-      specularComponent->SetValue(idx, imagescalars->GetValue(idx * 3 + specularOffset));
+      int specularOffset = 1; // [diffuse, specular, ?]
+      linearSize = imagescalars->GetNumberOfTuples();
+      std::vector<unsigned char> &specularComponent = buf.Luminances[compositeIdx];
+      specularComponent.resize(linearSize);
+
+      const unsigned char* pScalars = imagescalars->GetPointer(0) + specularOffset;
+      unsigned char* pSpecular = specularComponent.data();
+      for (size_t idx = 0; idx < linearSize; idx++)
+        {
+        pSpecular[idx] = pScalars[idx * 3];
+        }
       }
 
-    luminances.push_back(specularComponent);
     view->InvokeCommand("StopCaptureLuminance");
     }
 
@@ -1040,91 +1170,23 @@ void CinemaHelper::CaptureSortedCompositeData(vtkSMRenderViewProxy* view)
     return;
     }
 
-  int stackSize = linearSize * compositeSize;
-  vtkNew<vtkUnsignedCharArray> orderArray;
-  orderArray->SetNumberOfComponents(1);
-  orderArray->SetNumberOfTuples(stackSize);
-  std::vector<Pixel> pixelSorter;
-  while (pixelSorter.size() < compositeSize)
+  for (size_t layerIdx = 0; layerIdx < compositeSize; layerIdx++)
     {
-    pixelSorter.push_back(Pixel());
-    }
-
-  for (int pixelId = 0; pixelId < linearSize; pixelId++)
-    {
-    // Fill pixelSorter
-    for (size_t layerIdx = 0; layerIdx < compositeSize; layerIdx++)
+    if (buf.Depths[layerIdx].size() != linearSize)
       {
-      float depth = zBuffers[layerIdx]->GetValue(pixelId);
-      if (depth < 1.0)
-        {
-        pixelSorter[layerIdx].Index = (unsigned char)layerIdx;
-        pixelSorter[layerIdx].Depth = depth;
-        }
-      else
-        {
-        pixelSorter[layerIdx].Index = 255;
-        pixelSorter[layerIdx].Depth = 1.0;
-        }
-      }
-
-    // Sort pixels
-    std::sort(pixelSorter.begin(), pixelSorter.end(), pixelComp);
-
-    // Fill sortedOrder array
-    for (size_t layerIdx = 0; layerIdx < compositeSize; layerIdx++)
-      {
-      orderArray->SetValue(layerIdx * linearSize + pixelId, pixelSorter[layerIdx].Index);
+      std::cout << "Depth and luminance buffers differ in size" << std::endl;
+      return;
       }
     }
 
-  // Write order file
-  std::string orderFileName = this->Data->getDataAbsoluteFilePath("order.uint8", true);
-  std::ofstream fp(orderFileName.c_str(), ios::out | ios::binary);
+  // Sort the layers of each pixel and look up their intensity
+  sortComposite(buf, compositeSize, linearSize, size_t(this->Data->ImageSize[0]));
 
-  if (fp.fail())
-    {
-    std::cout << "Unable to open file: "<< orderFileName.c_str() << std::endl;
-    }
-  else
-    {
-    fp.write((char*)orderArray->GetPointer(0), stackSize);
-    fp.flush();
-    fp.close();
-    }
-
-  // Compute intensity data
-  vtkNew<vtkUnsignedCharArray> intensityArray;
-  intensityArray->SetNumberOfComponents(1);
-  intensityArray->SetNumberOfTuples(stackSize);
-  for (int idx = 0; idx < stackSize; idx++)
-    {
-    int layerIdx = orderArray->GetValue(idx);
-    if (layerIdx < 255)
-      {
-      intensityArray->SetValue(idx, luminances[layerIdx]->GetValue(idx % linearSize));
-      }
-    else
-      {
-      intensityArray->SetValue(idx, 0);
-      }
-
-    }
+  // Write order file
+  writeComposite(this->Data->getDataAbsoluteFilePath("order.uint8", true), buf.Order);
 
   // Write light intensity file
-  std::string intensityFileName = this->Data->getDataAbsoluteFilePath("intensity.uint8", true);
-  std::ofstream fpItensity(intensityFileName.c_str(), ios::out | ios::binary);
-
-  if (fpItensity.fail())
-    {
-    std::cout << "Unable to open file: "<< intensityFileName.c_str() << std::endl;
-    }
-  else
-    {
-    fpItensity.write((char*)intensityArray->GetPointer(0), stackSize);
-    fpItensity.flush();
-    fpItensity.close();
-    }
+  writeComposite(this->Data->getDataAbsoluteFilePath("intensity.uint8", true), buf.Intensity);
 }
 #endif // ENABLE_CATALYST
 
@@ -1211,10 +1273,14 @@ void CinemaHelper::CaptureSortedCompositeData(vtkRenderWindow* renderWindow, vtk
 
   // Show only active Representation
   // Extract images for each fields
-  std::vector<vtkSmartPointer<vtkFloatArray>> zBuffers;
-  std::vector<vtkSmartPointer<vtkUnsignedCharArray>> luminances;
+  CompositeBuffers &buf = this->Data->Composite;
   size_t compositeSize = this->Data->Actors.size();
   size_t linearSize = 0;
+  if (this->Data->IsRoot)
+    {
+    buf.Depths.resize(compositeSize);
+    buf.Luminances.resize(compositeSize);
+    }
   for (size_t compositeIdx = 0; compositeIdx < compositeSize; compositeIdx++)
     {
     vtkActor* actor = this->Data->Actors[compositeIdx];
@@ -1235,15 +1301,12 @@ void CinemaHelper::CaptureSortedCompositeData(vtkRenderWindow* renderWindow, vtk
 
     if (this->Data->IsRoot)
       {
-      vtkSmartPointer<vtkFloatArray> zBuffer = vtkSmartPointer<vtkFloatArray>::New();
-
-      zBuffer->DeepCopy(compositePass->GetLastRenderedDepths());
-      // cout << "PID(" << controller->GetLocalProcessId()
-      //     << "): Size " << zBuffer->GetNumberOfTuples()
-      //     << " Range " << zBuffer->GetRange()[0] << ", " << zBuffer->GetRange()[1] << endl;
-      zBuffers.push_back(zBuffer);
-
+      // the pass owns the depths and reuses them on the next render, copy
+      // them into the layer's plane
+      vtkFloatArray* zBuffer = compositePass->GetLastRenderedDepths();
       linearSize = zBuffer->GetNumberOfTuples();
+      const float* pz = zBuffer->GetPointer(0);
+      buf.Depths[compositeIdx].assign(pz, pz + linearSize);
 
       // ------------------------------------------------------------------------
       // Capture Luminance
@@ -1251,15 +1314,15 @@ void CinemaHelper::CaptureSortedCompositeData(vtkRenderWindow* renderWindow, vtk
       compositePass->GetLastRenderedTile(image);
       vtkUnsignedCharArray* imagescalars = image.GetRawPtr();
       size_t step = imagescalars->GetNumberOfComponents();
-      vtkSmartPointer<vtkUnsignedCharArray> specularComponent = vtkSmartPointer<vtkUnsignedCharArray>::New();
-      specularComponent->SetNumberOfComponents(1);
-      specularComponent->SetNumberOfTuples(linearSize);
+      std::vector<unsigned char> &specularComponent = buf.Luminances[compositeIdx];
+      specularComponent.resize(linearSize);
+
+      const unsigned char* pScalars = imagescalars->GetPointer(0);
+      unsigned char* pSpecular = specularComponent.data();
       for (size_t idx = 0; idx < linearSize; idx++)
         {
-        specularComponent->SetValue(idx, imagescalars->GetValue(idx * step));
+        pSpecular[idx] = pScalars[idx * step];
         }
-
-      luminances.push_back(specularComponent);
       }
     }
 
@@ -1270,91 +1333,14 @@ void CinemaHelper::CaptureSortedCompositeData(vtkRenderWindow* renderWindow, vtk
     return;
     }
 
-  size_t stackSize = linearSize * compositeSize;
-  vtkNew<vtkUnsignedCharArray> orderArray;
-  orderArray->SetNumberOfComponents(1);
-  orderArray->SetNumberOfTuples(stackSize);
-  std::vector<Pixel> pixelSorter;
-  while (pixelSorter.size() < compositeSize)
-    {
-    pixelSorter.push_back(Pixel());
-    }
-
-  for (size_t pixelId = 0; pixelId < linearSize; pixelId++)
-    {
-    // Fill pixelSorter
-    for (size_t layerIdx = 0; layerIdx < compositeSize; layerIdx++)
-      {
-      float depth = zBuffers[layerIdx]->GetValue(pixelId);
-      if (depth < 1.0)
-        {
-        pixelSorter[layerIdx].Index = (unsigned char)layerIdx;
-        pixelSorter[layerIdx].Depth = depth;
-        }
-      else
-        {
-        pixelSorter[layerIdx].Index = 255;
-        pixelSorter[layerIdx].Depth = 1.0;
-        }
-      }
-
-    // Sort pixels
-    std::sort(pixelSorter.begin(), pixelSorter.end(), pixelComp);
-
-    // Fill sortedOrder array
-    for (size_t layerIdx = 0; layerIdx < compositeSize; layerIdx++)
-      {
-      orderArray->SetValue(layerIdx * linearSize + pixelId, pixelSorter[layerIdx].Index);
-      }
-    }
+  // Sort the layers of each pixel and look up their intensity
+  sortComposite(buf, compositeSize, linearSize, size_t(this->Data->ImageSize[0]));
 
   // Write order file
-  std::string orderFileName = this->Data->getDataAbsoluteFilePath("order.uint8", true);
-  std::ofstream fp(orderFileName.c_str(), ios::out | ios::binary);
-
-  if (fp.fail())
-    {
-    std::cout << "Unable to open file: "<< orderFileName.c_str() << std::endl;
-    }
-  else
-    {
-    fp.write((char*)orderArray->GetPointer(0), stackSize);
-    fp.flush();
-    fp.close();
-    }
-
-  // Compute intensity data
-  vtkNew<vtkUnsignedCharArray> intensityArray;
-  intensityArray->SetNumberOfComponents(1);
-  intensityArray->SetNumberOfTuples(stackSize);
-  for (size_t idx = 0; idx < stackSize; idx++)
-    {
-    size_t layerIdx = orderArray->GetValue(idx);
-    if (layerIdx < 255)
-      {
-      intensityArray->SetValue(idx, luminances[layerIdx]->GetValue(idx % linearSize));
-      }
-    else
-      {
-      intensityArray->SetValue(idx, 0);
-      }
-
-    }
+  writeComposite(this->Data->getDataAbsoluteFilePath("order.uint8", true), buf.Order);
 
   // Write light intensity file
-  std::string intensityFileName = this->Data->getDataAbsoluteFilePath("intensity.uint8", true);
-  std::ofstream fpItensity(intensityFileName.c_str(), ios::out | ios::binary);
-
-  if (fpItensity.fail())
-    {
-    std::cout << "Unable to open file: "<< intensityFileName.c_str() << std::endl;
-    }
-  else
-    {
-    fpItensity.write((char*)intensityArray->GetPointer(0), stackSize);
-    fpItensity.flush();
-    fpItensity.close();
-    }
+  writeComposite(this->Data->getDataAbsoluteFilePath("intensity.uint8", true), buf.Intensity);
 }
 
 // --------------------------------------------------------------------------
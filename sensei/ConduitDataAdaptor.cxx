@@ -1,5 +1,7 @@
 #include <cassert>
 #include <sstream>
+#include <algorithm>
+#include <cstring>
 
 #include <conduit_blueprint.hpp>
 
@@ -15,6 +17,14 @@
 #include <vtkUnsignedLongLongArray.h>
 #include <vtkFloatArray.h>
 #include <vtkDoubleArray.h>
+#include <vtkVersionMacros.h>
+#if (VTK_MAJOR_VERSION > 7) || ((VTK_MAJOR_VERSION == 7) && (VTK_MINOR_VERSION >= 1))
+#include <vtkSOADataArrayTemplate.h>
+#endif
+#if VTK_MAJOR_VERSION >= 9
+#include <vtkTypeInt32Array.h>
+#include <vtkTypeInt64Array.h>
+#endif
 
 #include <vtkDataSetAttributes.h>
 #include <vtkImageData.h>
@@ -35,6 +45,7 @@
 #include <vtkUnstructuredGrid.h>
 
 #include "ConduitDataAdaptor.h"
+#include "ArrayPool.h"
 #include "Error.h"
 #include "Timer.h"
 
@@ -45,7 +56,7 @@ namespace sensei
 senseiNewMacro(ConduitDataAdaptor);
 
 //-----------------------------------------------------------------------------
-ConduitDataAdaptor::ConduitDataAdaptor()
+ConduitDataAdaptor::ConduitDataAdaptor() : BlockStart(0), Node(NULL)
 {
 }
 
@@ -82,58 +93,66 @@ static inline int VTKCellTypeSize( int cell_type )
 }
 
 //-----------------------------------------------------------------------------
-template<typename T> void Blueprint_MultiCompArray_To_VTKDataArray( const conduit::Node &n, int ncomps, int ntuples, vtkDataArray *darray )
+// get the VTK type equivalent to the conduit type, or -1 if there is none
+static int ConduitTypeToVTKType( const conduit::DataType &dt )
 {
-  // vtk reqs us to set number of comps before number of tuples
-  if( ncomps == 2 ) // we need 3 comps for vectors
-    darray->SetNumberOfComponents( 3 );
-  else
-    darray->SetNumberOfComponents( ncomps );
- 
-  // set number of tuples
-  darray->SetNumberOfTuples( ntuples );
-        
-  if( n.number_of_children() > 0 )
+  if( dt.is_unsigned_char() )  return VTK_UNSIGNED_CHAR;
+  if( dt.is_unsigned_short() ) return VTK_UNSIGNED_SHORT;
+  if( dt.is_unsigned_int() )   return VTK_UNSIGNED_INT;
+  if( dt.is_unsigned_long() )  return VTK_UNSIGNED_LONG;
+  if( dt.is_char() )           return VTK_CHAR;
+  if( dt.is_short() )          return VTK_SHORT;
+  if( dt.is_int() )            return VTK_INT;
+  if( dt.is_long() )           return VTK_LONG;
+  if( dt.is_float() )          return VTK_FLOAT;
+  if( dt.is_double() )         return VTK_DOUBLE;
+
+  return -1;
+}
+
+//-----------------------------------------------------------------------------
+// copy one component of a conduit array into an interleaved buffer
+// with ncomps components. contiguous sources are copied by a plain loop
+// that the compiler can vectorize.
+template<typename T>
+void CopyComponent( const conduit::Node &n, vtkIdType ntuples, int comp, int ncomps, T *dest )
+{
+  const char *src = static_cast<const char*>( n.element_ptr(0) );
+  conduit::index_t stride = n.dtype().stride();
+
+  if( stride == sizeof(T) )
   {
-    // handle multi-component case
-    for(vtkIdType c=0; c < ncomps ;++c)
+    const T *psrc = reinterpret_cast<const T*>( src );
+    if( ncomps == 1 )
     {
-      conduit::DataArray<T> vals_array = n[c].value();
-
+      memcpy( dest, psrc, ntuples*sizeof(T) );
+    }
+    else
+    {
+      T *pdest = dest + comp;
       for(vtkIdType i = 0; i < ntuples ;++i)
-      {
-        darray->SetComponent( i, c, (double)vals_array[i] );
-
-        if( ncomps == 2 )
-        {
-          darray->SetComponent( i, 2, 0.0 );
-        }
-      }
+        pdest[i*ncomps] = psrc[i];
     }
   }
   else
   {
-    // single array case
-    conduit::DataArray<T> vals_array = n.value();
-
     for(vtkIdType i = 0; i < ntuples ;++i)
-    {
-      darray->SetComponent( i, 0, (double)vals_array[i] );
-    }
+      memcpy( dest + i*ncomps + comp, src + i*stride, sizeof(T) );
   }
 }
 
 //-----------------------------------------------------------------------------
-vtkDataArray * ConduitArrayToVTKDataArray( const conduit::Node &n )
+// convert a conduit array or mcarray to a VTK array with ncompsOut
+// components. when ncompsOut is larger than the number of components in
+// the node the extra components are zero filled. When the layout allows,
+// that is a contiguous array, an interleaved mcarray, or an mcarray with
+// contiguous components, the node's memory is used directly and the VTK
+// array is valid only as long as the node's data is. Otherwise the values
+// are copied.
+vtkDataArray * ConduitArrayToVTKDataArray( const conduit::Node &n, int ncompsOut )
 {
-  vtkDataArray *retval = NULL;
-  
   int nchildren = n.number_of_children();
-  int ntuples = 0;
-  int ncomps  = 1;
-
-
-  conduit::DataType vals_dtype;
+  int ncomps = 1;
 
   if( nchildren > 0 ) // n is a mcarray w/ children that hold the vals
   {
@@ -142,180 +161,221 @@ vtkDataArray * ConduitArrayToVTKDataArray( const conduit::Node &n )
     {
       SENSEI_ERROR( "Node is not a mcarray " << v_info.to_json() );
     }
-        
+
     // in this case, each child is a component of the array
     ncomps = nchildren;
-    // This assumes all children have the same leaf type
-    vals_dtype = n[0].dtype();
-  }
-  else // n is an array, holds the vals
-  {
-    vals_dtype = n.dtype();
-  }
-    
-  // get the number of tuples
-  ntuples = (int) vals_dtype.number_of_elements();
-    
-  if( vals_dtype.is_unsigned_char() )
-  {
-    retval = vtkUnsignedCharArray::New();
-    Blueprint_MultiCompArray_To_VTKDataArray<CONDUIT_NATIVE_UNSIGNED_CHAR>( n, ncomps, ntuples, retval );
-  }
-  else if( vals_dtype.is_unsigned_short() )
-  {
-    retval = vtkUnsignedShortArray::New();
-    Blueprint_MultiCompArray_To_VTKDataArray<CONDUIT_NATIVE_UNSIGNED_SHORT>( n, ncomps, ntuples, retval );
-  }
-  else if( vals_dtype.is_unsigned_int() )
-  {
-    retval = vtkUnsignedIntArray::New();
-    Blueprint_MultiCompArray_To_VTKDataArray<CONDUIT_NATIVE_UNSIGNED_INT>( n, ncomps, ntuples, retval );
-  }
-  else if( vals_dtype.is_char() )
-  {
-    retval = vtkCharArray::New();
-    Blueprint_MultiCompArray_To_VTKDataArray<CONDUIT_NATIVE_CHAR>( n, ncomps, ntuples, retval );
-  }
-  else if( vals_dtype.is_short() )
-  {
-    retval = vtkShortArray::New();
-    Blueprint_MultiCompArray_To_VTKDataArray<CONDUIT_NATIVE_SHORT>( n, ncomps, ntuples, retval );
-  }
-  else if( vals_dtype.is_int() )
-  {
-    retval = vtkIntArray::New();
-    Blueprint_MultiCompArray_To_VTKDataArray<CONDUIT_NATIVE_INT>( n, ncomps, ntuples, retval );
-  }
-  else if( vals_dtype.is_long() )
-  {
-    retval = vtkLongArray::New();
-    Blueprint_MultiCompArray_To_VTKDataArray<CONDUIT_NATIVE_LONG>( n, ncomps, ntuples, retval );
   }
-  else if( vals_dtype.is_float() )
+
+  const conduit::Node &n0 = nchildren > 0 ? n.child(0) : n;
+  conduit::DataType vals_dtype = n0.dtype();
+
+  int vtk_type = ConduitTypeToVTKType( vals_dtype );
+  if( vtk_type < 0 )
   {
-    retval = vtkFloatArray::New();
-    Blueprint_MultiCompArray_To_VTKDataArray<CONDUIT_NATIVE_FLOAT>( n, ncomps, ntuples, retval );
+    SENSEI_ERROR( "Conduit Array to VTK Data Array:  unsupported data type: " << vals_dtype.name() );
+    return( NULL );
   }
-  else if( vals_dtype.is_double() )
+
+  vtkIdType ntuples = vals_dtype.number_of_elements();
+
+  for(int c = 1; c < nchildren ;++c)
   {
-    retval = vtkDoubleArray::New();
-    Blueprint_MultiCompArray_To_VTKDataArray<CONDUIT_NATIVE_DOUBLE>( n, ncomps, ntuples, retval );
+    const conduit::DataType &dt = n.child(c).dtype();
+    if( (dt.id() != vals_dtype.id()) || (dt.number_of_elements() != ntuples) )
+    {
+      SENSEI_ERROR( "Conduit Array to VTK Data Array: mcarray components differ in type or length" );
+      return( NULL );
+    }
   }
-  else
+
+  if( (ncompsOut == ncomps) && (ntuples > 0) && vals_dtype.endianness_matches_machine() )
   {
-    SENSEI_ERROR( "Conduit Array to VTK Data Array:  unsupported data type: " << n.dtype().name() );
-  }
-  return( retval );
-}
+    // array of structures. a single contiguous array or an interleaved
+    // mcarray
+    size_t esize = vals_dtype.element_bytes();
+    const char *p0 = static_cast<const char*>( n0.element_ptr(0) );
 
-//-----------------------------------------------------------------------------
-vtkCellArray * HomogeneousShapeTopologyToVTKCellArray( const conduit::Node &n_topo, int /*npts*/ )
-{
-  vtkCellArray *ca = vtkCellArray::New();
-  vtkIdTypeArray *ida = vtkIdTypeArray::New();
+    bool aos = true;
+    for(int c = 0; aos && (c < ncomps) ;++c)
+    {
+      const conduit::Node &nc = nchildren > 0 ? n.child(c) : n;
+      aos = (nc.dtype().stride() == (conduit::index_t)(ncomps*esize)) &&
+        (static_cast<const char*>(nc.element_ptr(0)) == p0 + c*esize);
+    }
 
-  int ctype = ElementShapeNameToVTKCellType(n_topo["elements/shape"].as_string());
-  int csize = VTKCellTypeSize(ctype);
-  int ncells = n_topo["elements/connectivity"].dtype().number_of_elements() / csize;
+    if( aos )
+    {
+      vtkDataArray *darray = vtkDataArray::CreateDataArray( vtk_type );
+      darray->SetNumberOfComponents( ncomps );
+      darray->SetVoidArray( const_cast<char*>(p0), ntuples*ncomps, 1 );
+      return( darray );
+    }
 
-    conduit::int_array topo_conn;
-    ida->SetNumberOfTuples(ncells * (csize + 1));
-    for (int i=0; i < ncells ;++i)
+#if (VTK_MAJOR_VERSION > 7) || ((VTK_MAJOR_VERSION == 7) && (VTK_MINOR_VERSION >= 1))
+    // structure of arrays. an mcarray with contiguous components
+    bool soa = nchildren > 0;
+    for(int c = 0; soa && (c < ncomps) ;++c)
+      soa = n.child(c).dtype().is_compact();
+
+    if( soa )
     {
-      conduit::Node n_tmp;
-      if(n_topo["elements/connectivity"].dtype().is_int())
-      {
-        topo_conn = n_topo["elements/connectivity"].as_int_array();
-      }
-      else
+      switch( vtk_type )
       {
-        n_topo["elements/connectivity"].to_int_array(n_tmp);
-        topo_conn = n_tmp.as_int_array();
-      }
-            
-      ida->SetComponent((csize+1)*i, 0, csize);
-      for (int j=0; j < csize ;++j)
-      {
-        ida->SetComponent((csize+1)*i+j+1, 0,topo_conn[i*csize+j]);
+        vtkTemplateMacro(
+          vtkSOADataArrayTemplate<VTK_TT> *darray = vtkSOADataArrayTemplate<VTK_TT>::New();
+          darray->SetNumberOfComponents( ncomps );
+          for(int c = 0; c < ncomps ;++c)
+          {
+            VTK_TT *pc = static_cast<VTK_TT*>( const_cast<void*>(n.child(c).element_ptr(0)) );
+            darray->SetArray( c, pc, ntuples, true, true );
+          }
+          return( darray );
+          );
       }
+    }
+#endif
   }
-  ca->SetCells(ncells, ida);
-  ida->Delete();
-  return ca;
+
+  // the layout or the number of components forces a copy
+  vtkDataArray *darray = ArrayPool::NewArray( vtk_type, ntuples, ncompsOut );
+  if( !darray || (ntuples < 1) )
+    return( darray );
+
+  switch( vtk_type )
+  {
+    vtkTemplateMacro(
+      VTK_TT *pda = static_cast<VTK_TT*>( darray->GetVoidPointer(0) );
+
+      for(int c = 0; c < ncomps ;++c)
+        CopyComponent( nchildren > 0 ? n.child(c) : n, ntuples, c, ncompsOut, pda );
+
+      for(int c = ncomps; c < ncompsOut ;++c)
+        for(vtkIdType i = 0; i < ntuples ;++i)
+          pda[i*ncompsOut + c] = VTK_TT(0);
+      );
+  }
+
+  return( darray );
 }
 
 //-----------------------------------------------------------------------------
-vtkPoints * ExplicitCoordsToVTKPoints( const conduit::Node &coords )
+vtkDataArray * ConduitArrayToVTKDataArray( const conduit::Node &n )
 {
-  vtkPoints *points = vtkPoints::New();
+  // 2 component vectors are padded, VTK expects 3
+  int ncomps = std::max( 1, (int)n.number_of_children() );
+  return( ConduitArrayToVTKDataArray(n, ncomps == 2 ? 3 : ncomps) );
+}
 
-  const conduit::Node &vals = coords["values"];
+#if VTK_MAJOR_VERSION >= 9
+//-----------------------------------------------------------------------------
+// pass contiguous connectivity of a fixed cell size to VTK without a copy.
+// only the offsets are generated.
+template<typename array_t>
+void ConnectivityToVTKCellArray( const conduit::Node &conn, vtkIdType ncells, int csize, vtkCellArray *ca )
+{
+  using value_t = typename array_t::ValueType;
 
-  // We always use doubles
-  int npts = (int) vals["x"].dtype().number_of_elements();
+  array_t *conn_array = array_t::New();
+  value_t *pconn = static_cast<value_t*>( const_cast<void*>(conn.element_ptr(0)) );
+  conn_array->SetArray( pconn, ncells*csize, 1 );
 
-  conduit::double_array x_vals;
-  conduit::double_array y_vals;
-  conduit::double_array z_vals;
+  array_t *offs_array = array_t::New();
+  offs_array->SetNumberOfTuples( ncells + 1 );
+  value_t *poffs = offs_array->GetPointer(0);
+  for(vtkIdType i = 0; i <= ncells ;++i)
+    poffs[i] = i*csize;
 
-  bool have_y = false;
-  bool have_z = false;
+  ca->SetData( offs_array, conn_array );
 
-  conduit::Node vals_double;
+  offs_array->Delete();
+  conn_array->Delete();
+}
+#endif
 
-  if( !vals["x"].dtype().is_double() )
-  {
-    vals["x"].to_double_array( vals_double["x"] );
-    x_vals = vals_double["x"].value();
-  }
-  else
-  {
-    x_vals = vals["x"].value();
-  }
+//-----------------------------------------------------------------------------
+vtkCellArray * HomogeneousShapeTopologyToVTKCellArray( const conduit::Node &n_topo, int /*npts*/ )
+{
+  int ctype = ElementShapeNameToVTKCellType(n_topo["elements/shape"].as_string());
+  int csize = VTKCellTypeSize(ctype);
+  if( csize < 1 )
+    return( NULL );
+
+  const conduit::Node &conn = n_topo["elements/connectivity"];
+  conduit::DataType conn_dtype = conn.dtype();
+  vtkIdType ncells = conn_dtype.number_of_elements() / csize;
+
+  vtkCellArray *ca = vtkCellArray::New();
 
-  if( vals.has_child("y") )
+#if VTK_MAJOR_VERSION >= 9
+  // VTK stores the connectivity and offsets separately, 32 and 64 bit
+  // contiguous connectivity is used in place
+  if( (ncells > 0) && conn_dtype.is_compact() && conn_dtype.endianness_matches_machine() )
   {
-    have_y = true;
-        
-    if( !vals["y"].dtype().is_double() )
+    if( conn_dtype.is_int32() )
     {
-      vals["y"].to_double_array( vals_double["y"] );
-      y_vals = vals_double["y"].value();
+      ConnectivityToVTKCellArray<vtkTypeInt32Array>( conn, ncells, csize, ca );
+      return( ca );
     }
-    else
+    else if( conn_dtype.is_int64() )
     {
-      y_vals = vals["y"].value();
+      ConnectivityToVTKCellArray<vtkTypeInt64Array>( conn, ncells, csize, ca );
+      return( ca );
     }
   }
+#endif
+
+  // copy into the VTK legacy layout, the number of points followed by
+  // the point ids for each cell
+  vtkIdTypeArray *ida = vtkIdTypeArray::New();
+  ida->SetNumberOfTuples( ncells*(csize + 1) );
 
-  if( vals.has_child("z") )
+  if( ncells > 0 )
   {
-    have_z = true;
+    vtkIdType *pida = ida->GetPointer(0);
+    const char *src = static_cast<const char*>( conn.element_ptr(0) );
+    conduit::index_t stride = conn_dtype.stride();
 
-    if( !vals["z"].dtype().is_double() )
+    switch( ConduitTypeToVTKType(conn_dtype) )
     {
-      vals["z"].to_double_array(vals_double["z"]);
-      z_vals = vals_double["z"].value();
-    }
-    else
-    {
-      z_vals = vals["z"].value();
+      vtkTemplateMacro(
+        for(vtkIdType i = 0; i < ncells ;++i)
+        {
+          vtkIdType *pcell = pida + i*(csize + 1);
+          const char *psrc = src + i*csize*stride;
+          pcell[0] = csize;
+          for(int j = 0; j < csize ;++j)
+          {
+            VTK_TT id;
+            memcpy( &id, psrc + j*stride, sizeof(VTK_TT) );
+            pcell[j+1] = static_cast<vtkIdType>( id );
+          }
+        }
+        );
+      default:
+        SENSEI_ERROR( "Unsupported connectivity type: " << conn_dtype.name() );
+        ida->Delete();
+        ca->Delete();
+        return( NULL );
     }
   }
 
-  points->SetDataTypeToDouble();
-  points->SetNumberOfPoints(npts);
+  ca->SetCells( ncells, ida );
+  ida->Delete();
+  return ca;
+}
 
-  //TODO: we could describe the VTK data array via 
-  // and push the conversion directly into its memory. 
+//-----------------------------------------------------------------------------
+vtkPoints * ExplicitCoordsToVTKPoints( const conduit::Node &coords )
+{
+  // 3D coordinates are used in place when the layout allows, 1D and 2D
+  // coordinates are copied and zero padded
+  vtkDataArray *da = ConduitArrayToVTKDataArray( coords["values"], 3 );
+  if( !da )
+    return( NULL );
 
-  for(vtkIdType i = 0; i < npts ;++i)
-  {
-    double x = x_vals[i];
-    double y = have_y ? y_vals[i] : 0;
-    double z = have_z ? z_vals[i] : 0;
-    points->SetPoint(i, x, y, z);
-  }
+  vtkPoints *points = vtkPoints::New();
+  points->SetData( da );
+  da->Delete();
 
   return( points );
 }
@@ -335,6 +395,11 @@ vtkDataSet* StructuredMesh( const conduit::Node* node )
   sgrid->SetDimensions( dims );
 
   vtkPoints *points = ExplicitCoordsToVTKPoints(coords);
+  if( !points )
+  {
+    sgrid->Delete();
+    return( NULL );
+  }
   sgrid->SetPoints( points );
   points->Delete();
 
@@ -348,6 +413,8 @@ vtkDataSet* UnstructuredMesh( const conduit::Node* node )
   const conduit::Node &topo   = (*node)["topologies"][0];
 
   vtkPoints *points = ExplicitCoordsToVTKPoints( coords );
+  if( !points )
+    return( NULL );
 
   vtkUnstructuredGrid *ugrid = vtkUnstructuredGrid::New();
   ugrid->SetPoints( points );
@@ -357,6 +424,11 @@ vtkDataSet* UnstructuredMesh( const conduit::Node* node )
   // Now, add explicit topology
   //
   vtkCellArray *ca = HomogeneousShapeTopologyToVTKCellArray( topo, points->GetNumberOfPoints() );
+  if( !ca )
+  {
+    ugrid->Delete();
+    return( NULL );
+  }
   ugrid->SetCells( ElementShapeNameToVTKCellType(topo["elements/shape"].as_string()), ca );
   ca->Delete();
     
@@ -641,8 +713,7 @@ int ConduitDataAdaptor::GetMesh( const std::string &meshName, bool /*structureOn
     local_blocks[rank] = this->Node->number_of_children();
     MPI_Allreduce( &local_blocks, &global_blocks, size, MPI_INT, MPI_SUM, this->GetCommunicator() ); 
 
-    this->GlobalBlockDistribution = (int *)malloc( (sizeof(int) * size) );
-    memcpy( this->GlobalBlockDistribution, global_blocks, (sizeof(int) * size) );
+    this->GlobalBlockDistribution.assign( global_blocks, global_blocks + size );
         
     for(int i = 0; i < size ;++i)
     {
@@ -651,6 +722,9 @@ int ConduitDataAdaptor::GetMesh( const std::string &meshName, bool /*structureOn
         start += global_blocks[i];
     }
 
+    // AddArray needs this for every array
+    this->BlockStart = start;
+
 
     mb_mesh->SetNumberOfBlocks( total_blocks );
     int domain = 0;
@@ -691,8 +765,7 @@ int ConduitDataAdaptor::GetMesh( const std::string &meshName, bool /*structureOn
     local_blocks[rank] = 1;
     MPI_Allreduce( &local_blocks, &global_blocks, size, MPI_INT, MPI_SUM, this->GetCommunicator() );
         
-    this->GlobalBlockDistribution = (int*)malloc( (sizeof(int) * size) );
-    memcpy( this->GlobalBlockDistribution, global_blocks, (sizeof(int) * size) );
+    this->GlobalBlockDistribution.assign( global_blocks, global_blocks + size );
    
     for(int i = 0; i < size ;++i)
     {
@@ -701,6 +774,8 @@ int ConduitDataAdaptor::GetMesh( const std::string &meshName, bool /*structureOn
         start += global_blocks[i];
     }
 
+    this->BlockStart = start;
+
     mb_mesh->SetNumberOfBlocks( total_blocks );
 
     int block = start;
@@ -776,11 +851,8 @@ int ConduitDataAdaptor::AddArray( vtkDataObject* mesh, const std::string &meshNa
     return( -1 );
   }
 
-  int rank, start = 0;
-  MPI_Comm_rank( this->GetCommunicator(), &rank );
-  
-  for(int i = 0; i < rank ;++i)
-    start += this->GlobalBlockDistribution[i];
+  // the first block on this rank, computed in GetMesh
+  int start = this->BlockStart;
 
   vtkMultiBlockDataSet *mb = dynamic_cast<vtkMultiBlockDataSet*>( mesh );
 
@@ -800,7 +872,13 @@ int ConduitDataAdaptor::AddArray( vtkDataObject* mesh, const std::string &meshNa
       const conduit::Node& field  = fields[arrayname];
       const conduit::Node& values = field["values"];
             
-      vtkSmartPointer<vtkDataArray> array = ConduitArrayToVTKDataArray( values );
+      vtkSmartPointer<vtkDataArray> array;
+      array.TakeReference( ConduitArrayToVTKDataArray( values ) );
+      if( !array )
+      {
+        SENSEI_ERROR( "Failed to convert array \"" << arrayname << "\"" );
+        return( -1 );
+      }
       array->SetName( arrayname.c_str() );
        
       vtkDataObject *block = mb->GetBlock( start + domain );
@@ -853,7 +931,13 @@ int ConduitDataAdaptor::AddArray( vtkDataObject* mesh, const std::string &meshNa
     const conduit::Node& fields  = (*this->Node)["fields"];
     const conduit::Node& field   = fields[arrayname];
     const conduit::Node& values  = field["values"];
-    vtkSmartPointer<vtkDataArray> array = ConduitArrayToVTKDataArray( values );
+    vtkSmartPointer<vtkDataArray> array;
+    array.TakeReference( ConduitArrayToVTKDataArray( values ) );
+    if( !array )
+    {
+      SENSEI_ERROR( "Failed to convert array \"" << arrayname << "\"" );
+      return( -1 );
+    }
     array->SetName( arrayname.c_str() );
 
     vtkDataObject *block = mb->GetBlock( start );
@@ -908,7 +992,8 @@ int ConduitDataAdaptor::ReleaseData()
 {
   this->Node = NULL;
   this->FieldNames.clear();
-  free( this->GlobalBlockDistribution );
+  this->GlobalBlockDistribution.clear();
+  this->BlockStart = 0;
 
   return( 0 );
 }
@@ -11,6 +11,10 @@
 namespace sensei
 {
 
+// Presents a Conduit Blueprint mesh to SENSEI. Arrays, coordinates, and
+// connectivity are passed to VTK without a copy when their layout allows,
+// hence the VTK objects reference the node's memory and are valid only
+// until the simulation modifies or frees it.
 class ConduitDataAdaptor : public sensei::DataAdaptor
 {
 public:
@@ -41,7 +45,8 @@ protected:
 
   typedef std::map<std::string, std::vector<std::string>> Fields;
   Fields FieldNames;
-  int *GlobalBlockDistribution;
+  std::vector<int> GlobalBlockDistribution;
+  int BlockStart;
 
 private:
   ConduitDataAdaptor(const ConduitDataAdaptor&) = delete; // not implemented.
@@ -13,10 +13,14 @@
 #include "senseiConfig.h"
 #include "Error.h"
 #include "Profiler.h"
+#include "ArrayPool.h"
 #include "VTKUtils.h"
 #include "XMLUtils.h"
 #include "STLUtils.h"
 #include "DataRequirements.h"
+#include "ReductionDataAdaptor.h"
+#include "GhostDataAdaptor.h"
+#include "BlockParallel.h"
 
 #include "Autocorrelation.h"
 #include "Histogram.h"
@@ -105,11 +109,27 @@ struct ConfigurableAnalysis::InternalsType
   int AddPythonAnalysis(pugi::xml_node node);
   int AddSliceExtract(pugi::xml_node node);
 
+  // creates and initializes from xml a reduction stage in front of the
+  // analyses added since the given index
+  int AddReduction(pugi::xml_node node, unsigned long firstAnalysis);
+
+  // creates and initializes from xml a ghost zone stage in front of the
+  // analyses added since the given index
+  int AddGhosts(pugi::xml_node node, unsigned long firstAnalysis);
+
 public:
   // list of all analyses. api calls are forwareded to each
   // analysis in the list
   AnalysisAdaptorVector Analyses;
 
+  // optional reduction stages, one per analysis. when set the analysis
+  // is passed the reduced data
+  std::vector<vtkSmartPointer<ReductionDataAdaptor>> Reductions;
+
+  // optional ghost zone stages, one per analysis. when set the analysis
+  // is passed data with ghost zones. applied after the reduction.
+  std::vector<vtkSmartPointer<GhostDataAdaptor>> Ghosts;
+
   // special analyses. these apear in the above list, however
   // they require special treatment which is simplified by
   // storing an additional pointer.
@@ -181,6 +201,7 @@ int ConfigurableAnalysis::InternalsType::AddHistogram(pugi::xml_node node)
   std::string array = node.attribute("array").value();
   int bins = node.attribute("bins").as_int(10);
   std::string fileName = node.attribute("file").value();
+  int numThreads = node.attribute("n-threads").as_int(-1);
 
   auto histogram = vtkSmartPointer<Histogram>::New();
 
@@ -188,15 +209,17 @@ int ConfigurableAnalysis::InternalsType::AddHistogram(pugi::xml_node node)
     histogram->SetCommunicator(this->Comm);
 
   this->TimeInitialization(histogram, [&]() {
-      histogram->Initialize(bins, mesh, association, array, fileName);
+      histogram->Initialize(bins, mesh, association, array, fileName,
+        numThreads);
       return 0;
     });
   this->Analyses.push_back(histogram.GetPointer());
 
   SENSEI_STATUS("Configured histogram with " << bins
     << " bins on " << assocStr << " data array \"" << array
-    << "\" on mesh \"" << mesh << "\" writing output to "
-    << (fileName.empty() ? "cout" : "file"))
+    << "\" on mesh \"" << mesh << "\" using "
+    << BlockParallel::GetNumberOfThreads(numThreads)
+    << " threads writing output to " << (fileName.empty() ? "cout" : "file"))
 
   return 0;
 }
@@ -222,18 +245,27 @@ int ConfigurableAnalysis::InternalsType::AddVTKmContour(pugi::xml_node node)
   double value = node.attribute("value").as_double(0.0);
   bool writeOutput = node.attribute("write_output").as_bool(false);
 
+  int device = VTKmUtils::DEVICE_ANY;
+  if (VTKmUtils::GetDevice(node.attribute("device").as_string("any"), device))
+    {
+    SENSEI_ERROR("Failed to initialize VTKmContourAnalysis");
+    return -1;
+    }
+
   auto contour = vtkSmartPointer<VTKmContourAnalysis>::New();
 
   if (this->Comm != MPI_COMM_NULL)
     contour->SetCommunicator(this->Comm);
 
   this->TimeInitialization(contour, [&]() {
-    contour->Initialize(mesh.value(), array.value(), value, writeOutput);
+    contour->Initialize(mesh.value(), array.value(), value, writeOutput,
+      device);
     return 0;
     });
   this->Analyses.push_back(contour.GetPointer());
 
-  SENSEI_STATUS("Configured VTKmContourAnalysis " << array.value())
+  SENSEI_STATUS("Configured VTKmContourAnalysis " << array.value()
+    << " on the " << VTKmUtils::GetDeviceName(device) << " device")
 
   return 0;
 #endif
@@ -261,14 +293,23 @@ int ConfigurableAnalysis::InternalsType::AddVTKmVolumeReduction(pugi::xml_node n
 
   std::string workDir = node.attribute("working-directory").as_string(".");
 
+  int device = VTKmUtils::DEVICE_ANY;
+  if (VTKmUtils::GetDevice(node.attribute("device").as_string("any"), device))
+    {
+    SENSEI_ERROR("Failed to initialize VTKmVolumeReductionAnalysis");
+    return -1;
+    }
+
   auto reducer = vtkSmartPointer<VTKmVolumeReductionAnalysis>::New();
   this->TimeInitialization(reducer, [&]() {
-    reducer->Initialize(mesh, field, assoc, workDir, reduction, this->Comm);
+    reducer->Initialize(mesh, field, assoc, workDir, reduction, this->Comm,
+      device);
     return 0;
   });
   this->Analyses.push_back(reducer.GetPointer());
 
-  SENSEI_STATUS("Configured VTKmVolumeReductionAnalysis " << mesh << "/" << field)
+  SENSEI_STATUS("Configured VTKmVolumeReductionAnalysis " << mesh << "/" << field
+    << " on the " << VTKmUtils::GetDeviceName(device) << " device")
 
   return 0;
 #endif
@@ -852,15 +893,39 @@ int ConfigurableAnalysis::InternalsType::AddAutoCorrelation(pugi::xml_node node)
 
   int window = node.attribute("window").as_int(10);
   int kMax = node.attribute("k-max").as_int(3);
-  int numThreads = node.attribute("n-threads").as_int(1);
+  int numThreads = node.attribute("n-threads").as_int(-1);
+
+  // out-of-core blocks
+  int blocksInMemory = node.attribute("blocks-in-memory").as_int(-1);
+  std::string storageStr = node.attribute("storage").as_string("mmap");
+  std::string storageTemplate = node.attribute("storage-template").as_string(
+    "/tmp/sensei-autocorrelation.XXXXXX");
+
+  int storage = Autocorrelation::STORAGE_MMAP;
+  if (storageStr == "file")
+    {
+    storage = Autocorrelation::STORAGE_FILE;
+    }
+  else if (storageStr != "mmap")
+    {
+    SENSEI_ERROR("Invalid storage \"" << storageStr
+      << "\" for Autocorrelation. Use mmap or file.")
+    return -1;
+    }
 
   auto adaptor = vtkSmartPointer<Autocorrelation>::New();
 
   if (this->Comm != MPI_COMM_NULL)
     adaptor->SetCommunicator(this->Comm);
 
+  if (adaptor->SetOutOfCore(blocksInMemory, storage, storageTemplate))
+    {
+    SENSEI_ERROR("Failed to initialize Autocorrelation");
+    return -1;
+    }
+
   this->TimeInitialization(adaptor, [&]() {
-    adaptor->Initialize(window, meshName, assoc, arrayName, kMax);
+    adaptor->Initialize(window, meshName, assoc, arrayName, kMax, numThreads);
     return 0;
   });
 
@@ -869,7 +934,9 @@ int ConfigurableAnalysis::InternalsType::AddAutoCorrelation(pugi::xml_node node)
   SENSEI_STATUS("Configured Autocorrelation " << assocStr
     << " data array \"" << arrayName << "\" on mesh \"" << meshName
     << "\" window " << window << " k-max " << kMax
-    << " n-threads " << numThreads)
+    << " n-threads " << numThreads << (blocksInMemory > 0 ?
+    " blocks-in-memory " + std::to_string(blocksInMemory) + " storage " +
+    storageStr : std::string()))
 
   return 0;
 }
@@ -895,6 +962,9 @@ int ConfigurableAnalysis::InternalsType::AddPosthocIO(pugi::xml_node node)
   std::string writer = node.attribute("writer").as_string("xml");
   std::string ghostArrayName = node.attribute("ghost_array_name").as_string("");
   int verbose = node.attribute("verbose").as_int(0);
+  int writeBehind = node.attribute("write_behind").as_int(0);
+  int deepCopy = node.attribute("write_behind_deep_copy").as_int(1);
+  double budgetMiB = node.attribute("write_behind_budget").as_double(1024.0);
 
   auto adaptor = vtkSmartPointer<VTKPosthocIO>::New();
 
@@ -903,6 +973,9 @@ int ConfigurableAnalysis::InternalsType::AddPosthocIO(pugi::xml_node node)
 
   adaptor->SetGhostArrayName(ghostArrayName);
   adaptor->SetVerbose(verbose);
+  adaptor->SetWriteBehind(writeBehind);
+  adaptor->SetWriteBehindDeepCopy(deepCopy);
+  adaptor->SetMaxBytesInFlight(budgetMiB*1024.0*1024.0);
 
   if (adaptor->SetOutputDir(outputDir) || adaptor->SetMode(mode) ||
     adaptor->SetWriter(writer) || adaptor->SetDataRequirements(req))
@@ -939,12 +1012,19 @@ int ConfigurableAnalysis::InternalsType::AddVTKAmrWriter(pugi::xml_node node)
   std::string outputDir = node.attribute("output_dir").as_string("./");
   std::string fileName = node.attribute("file_name").as_string("data");
   std::string mode = node.attribute("mode").as_string("visit");
+  int writeBehind = node.attribute("write_behind").as_int(0);
+  int deepCopy = node.attribute("write_behind_deep_copy").as_int(1);
+  double budgetMiB = node.attribute("write_behind_budget").as_double(1024.0);
 
   auto adapter = vtkSmartPointer<VTKAmrWriter>::New();
 
   if (this->Comm != MPI_COMM_NULL)
     adapter->SetCommunicator(this->Comm);
 
+  adapter->SetWriteBehind(writeBehind);
+  adapter->SetWriteBehindDeepCopy(deepCopy);
+  adapter->SetMaxBytesInFlight(budgetMiB*1024.0*1024.0);
+
   if (adapter->SetOutputDir(outputDir) || adapter->SetMode(mode) ||
     adapter->SetDataRequirements(req) ||
     this->TimeInitialization(adapter, [&]() { return adapter->Initialize(); }))
@@ -1130,6 +1210,14 @@ int ConfigurableAnalysis::InternalsType::AddSliceExtract(pugi::xml_node node)
   adaptor->EnablePartitioner(enablePart);
   oss << " enable_partitioner=" <<  enablePart;
 
+  int enableCartesian = node.attribute("enable_cartesian").as_int(1);
+  adaptor->EnableCartesianExtract(enableCartesian);
+  oss << " enable_cartesian=" <<  enableCartesian;
+
+  int numThreads = node.attribute("n-threads").as_int(-1);
+  adaptor->SetNumberOfThreads(numThreads);
+  oss << " n-threads=" << numThreads;
+
   int verbose = node.attribute("verbose").as_int(0);
   adaptor->SetVerbose(verbose);
   oss << " verbose=" << verbose;
@@ -1147,6 +1235,66 @@ int ConfigurableAnalysis::InternalsType::AddSliceExtract(pugi::xml_node node)
 
 
 
+// --------------------------------------------------------------------------
+int ConfigurableAnalysis::InternalsType::AddReduction(pugi::xml_node node,
+  unsigned long firstAnalysis)
+{
+  unsigned long nAnalyses = this->Analyses.size();
+  this->Reductions.resize(nAnalyses);
+
+  for (unsigned long i = firstAnalysis; i < nAnalyses; ++i)
+    {
+    auto reduction = vtkSmartPointer<ReductionDataAdaptor>::New();
+
+    if (this->Comm != MPI_COMM_NULL)
+      reduction->SetCommunicator(this->Comm);
+
+    if (reduction->Initialize(node))
+      {
+      SENSEI_ERROR("Failed to initialize the reduction")
+      return -1;
+      }
+
+    this->Reductions[i] = reduction;
+    }
+
+  SENSEI_STATUS("Configured ReductionDataAdaptor stride="
+    << node.attribute("stride").as_int(1) << " filter="
+    << node.attribute("filter").as_string("sample") << " precision="
+    << node.attribute("precision").as_string("native"))
+
+  return 0;
+}
+
+// --------------------------------------------------------------------------
+int ConfigurableAnalysis::InternalsType::AddGhosts(pugi::xml_node node,
+  unsigned long firstAnalysis)
+{
+  unsigned long nAnalyses = this->Analyses.size();
+  this->Ghosts.resize(nAnalyses);
+
+  for (unsigned long i = firstAnalysis; i < nAnalyses; ++i)
+    {
+    auto ghosts = vtkSmartPointer<GhostDataAdaptor>::New();
+
+    if (this->Comm != MPI_COMM_NULL)
+      ghosts->SetCommunicator(this->Comm);
+
+    if (ghosts->Initialize(node))
+      {
+      SENSEI_ERROR("Failed to initialize the ghost zones")
+      return -1;
+      }
+
+    this->Ghosts[i] = ghosts;
+    }
+
+  SENSEI_STATUS("Configured GhostDataAdaptor layers="
+    << node.attribute("layers").as_int(1))
+
+  return 0;
+}
+
 //----------------------------------------------------------------------------
 senseiNewMacro(ConfigurableAnalysis);
 
@@ -1212,6 +1360,8 @@ int ConfigurableAnalysis::Initialize(const pugi::xml_node &root)
     if (!node.attribute("enabled").as_int(0))
       continue;
 
+    unsigned long firstAnalysis = this->Internals->Analyses.size();
+
     std::string type = node.attribute("type").value();
     if (!(((type == "histogram") && !this->Internals->AddHistogram(node))
       || ((type == "autocorrelation") && !this->Internals->AddAutoCorrelation(node))
@@ -1232,6 +1382,24 @@ int ConfigurableAnalysis::Initialize(const pugi::xml_node &root)
       SENSEI_ERROR("Failed to add \"" << type << "\" analysis")
       MPI_Abort(this->GetCommunicator(), -1);
       }
+
+    // optionally deliver reduced data to the analysis
+    pugi::xml_node reduce = node.child("reduce");
+    if (reduce && this->Internals->AddReduction(reduce, firstAnalysis))
+      {
+      SENSEI_ERROR("Failed to add the reduction to the \"" << type
+        << "\" analysis")
+      MPI_Abort(this->GetCommunicator(), -1);
+      }
+
+    // optionally deliver data with ghost zones to the analysis
+    pugi::xml_node ghosts = node.child("ghosts");
+    if (ghosts && this->Internals->AddGhosts(ghosts, firstAnalysis))
+      {
+      SENSEI_ERROR("Failed to add the ghost zones to the \"" << type
+        << "\" analysis")
+      MPI_Abort(this->GetCommunicator(), -1);
+      }
     }
 
   // create and configure transport analysis adaptors
@@ -1272,16 +1440,49 @@ bool ConfigurableAnalysis::Execute(DataAdaptor* data)
       Profiler::StartEvent(analysisName);
       }
 
-    if (!(*iter)->Execute(data))
+    // pass the data through the analysis' reduction stage
+    DataAdaptor *analysisData = data;
+    ReductionDataAdaptor *reduction =
+      ai < static_cast<int>(this->Internals->Reductions.size()) ?
+      this->Internals->Reductions[ai].GetPointer() : nullptr;
+
+    if (reduction)
+      {
+      reduction->SetDataAdaptor(data);
+      analysisData = reduction;
+      }
+
+    // then through its ghost zone stage
+    GhostDataAdaptor *ghosts =
+      ai < static_cast<int>(this->Internals->Ghosts.size()) ?
+      this->Internals->Ghosts[ai].GetPointer() : nullptr;
+
+    if (ghosts)
+      {
+      ghosts->SetDataAdaptor(analysisData);
+      analysisData = ghosts;
+      }
+
+    if (!(*iter)->Execute(analysisData))
       {
       SENSEI_ERROR("Failed to execute " << (*iter)->GetClassName())
       MPI_Abort(this->GetCommunicator(), -1);
       }
 
+    if (ghosts)
+      ghosts->SetDataAdaptor(nullptr);
+
+    if (reduction)
+      reduction->SetDataAdaptor(nullptr);
+
     if (logEnabled)
       Profiler::EndEvent(analysisName);
     }
 
+  // buffers released by the analyses this step become available to
+  // the next
+  ArrayPool::EndStep();
+
   return true;
 }
 
@@ -0,0 +1,548 @@
+#include "DIYUtils.h"
+#include "VTKUtils.h"
+#include "Profiler.h"
+#include "Error.h"
+
+#include <vtkDataObject.h>
+#include <vtkDataSet.h>
+#include <vtkPointSet.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkCellArray.h>
+#include <vtkIdTypeArray.h>
+#include <vtkFloatArray.h>
+#include <vtkDataArray.h>
+#include <vtkUnsignedCharArray.h>
+#include <vtkFieldData.h>
+#include <vtkPointData.h>
+#include <vtkMultiBlockDataSet.h>
+
+#include <sdiy/master.hpp>
+#include <sdiy/assigner.hpp>
+#include <sdiy/link.hpp>
+#include <sdiy/algorithms.hpp>
+#include <sdiy/serialization.hpp>
+
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <functional>
+#include <cfloat>
+
+namespace
+{
+// a block for the sample sort
+struct SortBlock
+{
+  std::vector<double> Values;
+  std::vector<double> Samples;
+};
+
+// a particle for the kd-tree, its position and the values of the
+// redistributed arrays
+struct KDPoint
+{
+  float operator[](int i) const { return this->X[i]; }
+
+  float X[3];
+  std::vector<double> Values;
+};
+
+// a block for the kd-tree
+struct KDBlock
+{
+  std::vector<KDPoint> Points;
+};
+
+// --------------------------------------------------------------------------
+// returns non-zero on all ranks if err is non-zero on any of them. used to
+// agree on local failures before entering a collective.
+int anyError(MPI_Comm comm, int err)
+{
+  err = err ? 1 : 0;
+  MPI_Allreduce(MPI_IN_PLACE, &err, 1, MPI_INT, MPI_MAX, comm);
+  return err;
+}
+
+// --------------------------------------------------------------------------
+template <typename T>
+void AppendComponent(const T *pda, vtkIdType nTups, int nComps, int comp,
+  const unsigned char *pGhosts, std::vector<double> &values)
+{
+  for (vtkIdType i = 0; i < nTups; ++i)
+    {
+    if (pGhosts && pGhosts[i])
+      continue;
+    values.push_back(pda[i*nComps + comp]);
+    }
+}
+
+// --------------------------------------------------------------------------
+template <typename T>
+void GetPositions(const T *ppts, vtkIdType nPts, KDPoint *pts)
+{
+  for (vtkIdType i = 0; i < nPts; ++i)
+    {
+    pts[i].X[0] = ppts[3*i];
+    pts[i].X[1] = ppts[3*i+1];
+    pts[i].X[2] = ppts[3*i+2];
+    }
+}
+
+// --------------------------------------------------------------------------
+template <typename T>
+void GetValues(const T *pda, vtkIdType nTups, int nComps, size_t first,
+  KDPoint *pts)
+{
+  for (vtkIdType i = 0; i < nTups; ++i)
+    {
+    const T *src = pda + i*nComps;
+    double *dest = pts[i].Values.data() + first;
+    for (int j = 0; j < nComps; ++j)
+      dest[j] = src[j];
+    }
+}
+
+// --------------------------------------------------------------------------
+template <typename T>
+void SetValues(const KDPoint *pts, vtkIdType nTups, int nComps, size_t first,
+  T *pda)
+{
+  for (vtkIdType i = 0; i < nTups; ++i)
+    {
+    const double *src = pts[i].Values.data() + first;
+    T *dest = pda + i*nComps;
+    for (int j = 0; j < nComps; ++j)
+      dest[j] = static_cast<T>(src[j]);
+    }
+}
+
+// --------------------------------------------------------------------------
+vtkPolyData *NewParticleBlock(const std::vector<KDPoint> &pts,
+  const std::vector<std::string> &arrays, const std::vector<int> &types,
+  const std::vector<int> &comps)
+{
+  vtkIdType nPts = pts.size();
+
+  vtkFloatArray *x = vtkFloatArray::New();
+  x->SetNumberOfComponents(3);
+  x->SetNumberOfTuples(nPts);
+  float *px = x->GetPointer(0);
+  for (vtkIdType i = 0; i < nPts; ++i)
+    {
+    px[3*i] = pts[i].X[0];
+    px[3*i+1] = pts[i].X[1];
+    px[3*i+2] = pts[i].X[2];
+    }
+
+  vtkPoints *points = vtkPoints::New();
+  points->SetData(x);
+  x->Delete();
+
+  vtkIdTypeArray *ids = vtkIdTypeArray::New();
+  ids->SetNumberOfValues(2*nPts);
+  vtkIdType *pids = ids->GetPointer(0);
+  for (vtkIdType i = 0; i < nPts; ++i)
+    {
+    pids[2*i] = 1;
+    pids[2*i+1] = i;
+    }
+
+  vtkCellArray *verts = vtkCellArray::New();
+  verts->SetCells(nPts, ids);
+  ids->Delete();
+
+  vtkPolyData *pd = vtkPolyData::New();
+  pd->SetPoints(points);
+  pd->SetVerts(verts);
+  points->Delete();
+  verts->Delete();
+
+  size_t first = 0;
+  size_t nArrays = arrays.size();
+  for (size_t j = 0; j < nArrays; ++j)
+    {
+    // no rank had particles, and hence the array
+    if (types[j] < 0)
+      continue;
+
+    vtkDataArray *da = vtkDataArray::CreateDataArray(types[j]);
+    da->SetName(arrays[j].c_str());
+    da->SetNumberOfComponents(comps[j]);
+    da->SetNumberOfTuples(nPts);
+
+    switch (types[j])
+      {
+      vtkTemplateMacro(
+        VTK_TT *pda = static_cast<VTK_TT*>(da->GetVoidPointer(0));
+        SetValues(pts.data(), nPts, comps[j], first, pda);
+        );
+      }
+
+    pd->GetPointData()->AddArray(da);
+    da->Delete();
+
+    first += comps[j];
+    }
+
+  return pd;
+}
+}
+
+namespace sdiy
+{
+template <>
+struct Serialization<KDPoint>
+{
+  static void save(BinaryBuffer &bb, const KDPoint &p)
+  {
+    sdiy::save(bb, p.X);
+    sdiy::save(bb, p.Values);
+  }
+
+  static void load(BinaryBuffer &bb, KDPoint &p)
+  {
+    sdiy::load(bb, p.X);
+    sdiy::load(bb, p.Values);
+  }
+};
+}
+
+namespace sensei
+{
+namespace DIYUtils
+{
+
+// --------------------------------------------------------------------------
+int Sort(MPI_Comm comm, vtkDataObject *mesh, int association,
+  const std::string &arrayName, int component, std::vector<double> &sorted,
+  long long &offset, long long &total)
+{
+  TimeEvent<128> mark("DIYUtils::Sort");
+
+  int rank = 0;
+  int nRanks = 1;
+  MPI_Comm_rank(comm, &rank);
+  MPI_Comm_size(comm, &nRanks);
+
+  SortBlock block;
+
+  // gather the local values
+  int err = 0;
+  if (mesh)
+    {
+    VTKUtils::DatasetFunction func = [&](vtkDataSet *ds) -> int
+      {
+      vtkFieldData *atts = VTKUtils::GetAttributes(ds, association);
+      if (!atts)
+        return -1;
+
+      vtkDataArray *da = atts->GetArray(arrayName.c_str());
+      if (!da)
+        return 0;
+
+      int nComps = da->GetNumberOfComponents();
+      if ((component < 0) || (component >= nComps))
+        {
+        SENSEI_ERROR("Invalid component " << component << " of array \""
+          << arrayName << "\" with " << nComps << " components")
+        return -1;
+        }
+
+      vtkUnsignedCharArray *ghosts = dynamic_cast<vtkUnsignedCharArray*>(
+        atts->GetArray("vtkGhostType"));
+
+      const unsigned char *pGhosts = ghosts ? ghosts->GetPointer(0) : nullptr;
+
+      vtkIdType nTups = da->GetNumberOfTuples();
+
+      switch (da->GetDataType())
+        {
+        vtkTemplateMacro(
+          const VTK_TT *pda = static_cast<const VTK_TT*>(da->GetVoidPointer(0));
+          AppendComponent(pda, nTups, nComps, component, pGhosts, block.Values);
+          );
+        default:
+          SENSEI_ERROR("Unsupported array type " << da->GetClassName())
+          return -1;
+        }
+
+      return 0;
+      };
+
+    if (VTKUtils::Apply(mesh, func) < 0)
+      {
+      SENSEI_ERROR("Failed to get the values of array \"" << arrayName << "\"")
+      err = 1;
+      }
+    }
+
+  // all ranks enter the sort or none do
+  if (anyError(comm, err))
+    return -1;
+
+  // sort across ranks, one block per rank. the samples determine the
+  // balance of the result, oversample a little as the rank count grows
+  size_t nSamples = std::min(1024, std::max(64, 4*nRanks));
+
+  sdiy::Master master(comm, 1, -1);
+  sdiy::ContiguousAssigner assigner(nRanks, nRanks);
+  master.add(rank, &block, new sdiy::Link);
+
+  sdiy::sort(master, assigner, &SortBlock::Values, &SortBlock::Samples,
+    nSamples, std::less<double>());
+
+  sorted.swap(block.Values);
+
+  long long nLocal = sorted.size();
+
+  offset = 0;
+  MPI_Exscan(&nLocal, &offset, 1, MPI_LONG_LONG, MPI_SUM, comm);
+  if (rank == 0)
+    offset = 0;
+
+  total = 0;
+  MPI_Allreduce(&nLocal, &total, 1, MPI_LONG_LONG, MPI_SUM, comm);
+
+  return 0;
+}
+
+// --------------------------------------------------------------------------
+int Select(MPI_Comm comm, const std::vector<double> &sorted,
+  long long offset, long long total, const std::vector<long long> &ids,
+  std::vector<double> &values)
+{
+  long long nLocal = sorted.size();
+  size_t nIds = ids.size();
+
+  // each value is contributed by the rank that holds it, and zero by
+  // all others
+  values.assign(nIds, 0.0);
+  for (size_t i = 0; i < nIds; ++i)
+    {
+    long long id = ids[i];
+    if ((id < 0) || (id >= total))
+      {
+      SENSEI_ERROR("Index " << id << " is out of bounds [0, " << total << ")")
+      return -1;
+      }
+
+    long long lid = id - offset;
+    if ((lid >= 0) && (lid < nLocal))
+      values[i] = sorted[lid];
+    }
+
+  MPI_Allreduce(MPI_IN_PLACE, values.data(), nIds, MPI_DOUBLE, MPI_SUM, comm);
+
+  return 0;
+}
+
+// --------------------------------------------------------------------------
+int Quantiles(MPI_Comm comm, const std::vector<double> &sorted,
+  long long offset, long long total, int nQuantiles,
+  std::vector<double> &quantiles)
+{
+  if (nQuantiles < 2)
+    {
+    SENSEI_ERROR("At least 2 quantiles are required, " << nQuantiles
+      << " were requested")
+    return -1;
+    }
+
+  if (total < 1)
+    {
+    SENSEI_ERROR("Quantiles of an empty set are undefined")
+    return -1;
+    }
+
+  // the nearest rank of each fraction
+  std::vector<long long> ids(nQuantiles);
+  for (int i = 0; i < nQuantiles; ++i)
+    ids[i] = ((total - 1)*i + (nQuantiles - 1)/2)/(nQuantiles - 1);
+
+  return Select(comm, sorted, offset, total, ids, quantiles);
+}
+
+// --------------------------------------------------------------------------
+int KDTreeRedistribute(MPI_Comm comm, vtkDataObject *mesh,
+  const std::vector<std::string> &arrays, int nBlocks,
+  vtkMultiBlockDataSet *&result)
+{
+  TimeEvent<128> mark("DIYUtils::KDTreeRedistribute");
+
+  result = nullptr;
+
+  int rank = 0;
+  int nRanks = 1;
+  MPI_Comm_rank(comm, &rank);
+  MPI_Comm_size(comm, &nRanks);
+
+  if (nBlocks < 1)
+    {
+    nBlocks = 1;
+    while (nBlocks < nRanks)
+      nBlocks *= 2;
+    }
+
+  if ((nBlocks & (nBlocks - 1)) || (nBlocks < nRanks))
+    {
+    SENSEI_ERROR("The number of blocks must be a power of 2 not less than the"
+      " number of ranks " << nRanks << ", got " << nBlocks)
+    return -1;
+    }
+
+  size_t nArrays = arrays.size();
+
+  // find the type and components of each array. ranks without particles
+  // learn them from the others
+  std::vector<int> types(nArrays, -1);
+  std::vector<int> comps(nArrays, 0);
+
+  std::vector<KDPoint> pts;
+  float bounds[6] = {FLT_MAX, FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX, -FLT_MAX};
+
+  int err = 0;
+  if (mesh)
+    {
+    VTKUtils::DatasetFunction func = [&](vtkDataSet *ds) -> int
+      {
+      vtkPointSet *ps = dynamic_cast<vtkPointSet*>(ds);
+      if (!ps)
+        {
+        SENSEI_ERROR("Particles must be stored in a vtkPointSet, not a "
+          << ds->GetClassName())
+        return -1;
+        }
+
+      vtkIdType nPts = ps->GetNumberOfPoints();
+      if (nPts < 1)
+        return 0;
+
+      size_t first = pts.size();
+      pts.resize(first + nPts);
+      KDPoint *ppts = pts.data() + first;
+
+      vtkDataArray *x = ps->GetPoints()->GetData();
+      switch (x->GetDataType())
+        {
+        vtkTemplateMacro(
+          const VTK_TT *px = static_cast<const VTK_TT*>(x->GetVoidPointer(0));
+          GetPositions(px, nPts, ppts);
+          );
+        default:
+          SENSEI_ERROR("Unsupported point type " << x->GetClassName())
+          return -1;
+        }
+
+      std::vector<vtkDataArray*> das(nArrays);
+      size_t nValues = 0;
+      for (size_t j = 0; j < nArrays; ++j)
+        {
+        das[j] = ps->GetPointData()->GetArray(arrays[j].c_str());
+        if (!das[j])
+          {
+          SENSEI_ERROR("No point data array named \"" << arrays[j] << "\"")
+          return -1;
+          }
+        types[j] = das[j]->GetDataType();
+        comps[j] = das[j]->GetNumberOfComponents();
+        nValues += comps[j];
+        }
+
+      for (vtkIdType i = 0; i < nPts; ++i)
+        ppts[i].Values.resize(nValues);
+
+      size_t firstValue = 0;
+      for (size_t j = 0; j < nArrays; ++j)
+        {
+        switch (types[j])
+          {
+          vtkTemplateMacro(
+            const VTK_TT *pda = static_cast<const VTK_TT*>(das[j]->GetVoidPointer(0));
+            GetValues(pda, nPts, comps[j], firstValue, ppts);
+            );
+          default:
+            SENSEI_ERROR("Unsupported array type " << das[j]->GetClassName())
+            return -1;
+          }
+        firstValue += comps[j];
+        }
+
+      return 0;
+      };
+
+    if (VTKUtils::Apply(mesh, func) < 0)
+      {
+      SENSEI_ERROR("Failed to get the particles")
+      err = 1;
+      }
+    }
+
+  // all ranks enter the redistribution or none do
+  if (anyError(comm, err))
+    return -1;
+
+  size_t nPts = pts.size();
+  for (size_t i = 0; i < nPts; ++i)
+    {
+    for (int j = 0; j < 3; ++j)
+      {
+      bounds[j] = std::min(bounds[j], pts[i].X[j]);
+      bounds[j+3] = std::max(bounds[j+3], pts[i].X[j]);
+      }
+    }
+
+  // the domain is the global bounds of the particles
+  float gbounds[6];
+  MPI_Allreduce(bounds, gbounds, 3, MPI_FLOAT, MPI_MIN, comm);
+  MPI_Allreduce(bounds + 3, gbounds + 3, 3, MPI_FLOAT, MPI_MAX, comm);
+
+  MPI_Allreduce(MPI_IN_PLACE, types.data(), nArrays, MPI_INT, MPI_MAX, comm);
+  MPI_Allreduce(MPI_IN_PLACE, comps.data(), nArrays, MPI_INT, MPI_MAX, comm);
+
+  sdiy::ContiguousAssigner assigner(nRanks, nBlocks);
+
+  std::vector<int> gids;
+  assigner.local_gids(rank, gids);
+
+  int nLocal = gids.size();
+  std::vector<KDBlock> blocks(nLocal);
+
+  bool empty = gbounds[0] > gbounds[3];
+  if (!empty)
+    {
+    sdiy::ContinuousBounds domain;
+    for (int j = 0; j < 3; ++j)
+      {
+      domain.min[j] = gbounds[j];
+      domain.max[j] = gbounds[j+3];
+      }
+
+    // all of the local particles start in the first local block
+    blocks[0].Points.swap(pts);
+
+    sdiy::Master master(comm, 1, -1);
+    for (int i = 0; i < nLocal; ++i)
+      master.add(gids[i], &blocks[i],
+        new sdiy::RegularContinuousLink(3, domain, domain));
+
+    sdiy::kdtree_sampling(master, assigner, 3, domain, &KDBlock::Points, 512);
+    }
+
+  vtkMultiBlockDataSet *mb = vtkMultiBlockDataSet::New();
+  mb->SetNumberOfBlocks(nBlocks);
+
+  for (int i = 0; i < nLocal; ++i)
+    {
+    vtkPolyData *pd = NewParticleBlock(blocks[i].Points, arrays, types, comps);
+    mb->SetBlock(gids[i], pd);
+    pd->Delete();
+    }
+
+  result = mb;
+
+  return 0;
+}
+
+}
+}
@@ -0,0 +1,61 @@
+#ifndef DIYUtils_h
+#define DIYUtils_h
+
+class vtkDataObject;
+class vtkMultiBlockDataSet;
+
+#include <vector>
+#include <string>
+#include <mpi.h>
+
+namespace sensei
+{
+
+/// Distributed algorithms on VTK data built on DIY's parallel sample sort
+/// and kd-tree decomposition
+namespace DIYUtils
+{
+
+/// Sort the values of one component of the named array of every leaf
+/// dataset of the mesh across the communicator. On return each rank holds
+/// a contiguous slice of the globally sorted values, the slices are in rank
+/// order, offset is the global index of the first local value and total
+/// the number of values on all ranks. Values flagged by the ghost array
+/// are skipped. Ranks without the array contribute no values. When the
+/// values can not be gathered on one rank, all ranks return an error.
+int Sort(MPI_Comm comm, vtkDataObject *mesh, int association,
+  const std::string &arrayName, int component, std::vector<double> &sorted,
+  long long &offset, long long &total);
+
+/// Given the slices produced by Sort, get the values at the given global
+/// indices, the order statistics. Every rank receives all of the values.
+int Select(MPI_Comm comm, const std::vector<double> &sorted,
+  long long offset, long long total, const std::vector<long long> &ids,
+  std::vector<double> &values);
+
+/// Given the slices produced by Sort, compute nQuantiles >= 2 exact
+/// quantiles at evenly spaced fractions from 0 (the minimum) to 1 (the
+/// maximum). The nearest rank is used, no interpolation is done. Every
+/// rank receives all of the quantiles.
+int Quantiles(MPI_Comm comm, const std::vector<double> &sorted,
+  long long offset, long long total, int nQuantiles,
+  std::vector<double> &quantiles);
+
+/// Redistribute the points of a particle mesh, the leaves of which must
+/// be vtkPointSets, and the named point data arrays into a kd-tree
+/// decomposition of nBlocks blocks, such that each block has about the
+/// same number of particles. nBlocks must be a power of 2 not less than the
+/// number of ranks, when 0 the smallest such power of 2 is used. Blocks are
+/// assigned to ranks contiguously. The result is a multiblock with nBlocks
+/// vtkPolyData blocks, local blocks have a vertex per particle and remote
+/// blocks are null. Array types and components are preserved. The caller
+/// takes ownership of the result. When the particles can not be gathered
+/// on one rank, all ranks return an error.
+int KDTreeRedistribute(MPI_Comm comm, vtkDataObject *mesh,
+  const std::vector<std::string> &arrays, int nBlocks,
+  vtkMultiBlockDataSet *&result);
+
+}
+}
+
+#endif
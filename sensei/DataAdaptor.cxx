@@ -1,5 +1,7 @@
 #include "DataAdaptor.h"
 #include "MeshMetadata.h"
+#include "MeshMetadataMap.h"
+#include "MeshSelection.h"
 #include "VTKUtils.h"
 #include "Error.h"
 
@@ -95,6 +97,65 @@ int DataAdaptor::GetMesh(const std::string &meshName, bool structureOnly,
   return 0;
 }
 
+//----------------------------------------------------------------------------
+int DataAdaptor::GetMesh(const std::string &meshName, bool structureOnly,
+  const std::vector<int> &blockIds, vtkCompositeDataSet *&mesh)
+{
+  // by default all blocks are returned
+  (void)blockIds;
+  return this->GetMesh(meshName, structureOnly, mesh);
+}
+
+//----------------------------------------------------------------------------
+int DataAdaptor::GetMesh(const std::string &meshName, bool structureOnly,
+  const MeshSelection &selection, vtkCompositeDataSet *&mesh)
+{
+  // nothing selects blocks, return all of them
+  if (!selection.BlocksSelected() && !selection.ExtentSet())
+    return this->GetMesh(meshName, structureOnly, mesh);
+
+  // only ids select blocks, no need for metadata
+  if (!selection.BoundsSet() && !selection.ExtentSet())
+    return this->GetMesh(meshName, structureOnly,
+      selection.GetBlockIds(), mesh);
+
+  // use the block bounds and extents to find the selected blocks
+  MeshMetadataFlags flags;
+  flags.SetBlockDecomp();
+
+  if (selection.BoundsSet())
+    flags.SetBlockBounds();
+
+  if (selection.ExtentSet())
+    flags.SetBlockExtents();
+
+  MeshMetadataMap mdm;
+  MeshMetadataPtr md;
+  if (mdm.Initialize(this, flags) || mdm.GetMeshMetadata(meshName, md))
+    {
+    SENSEI_ERROR("Failed to get metadata for mesh \"" << meshName << "\"")
+    return -1;
+    }
+
+  std::vector<int> blockIds;
+  if (selection.GetSelectedBlocks(md, blockIds))
+    {
+    SENSEI_ERROR("Failed to resolve the selection on mesh \""
+      << meshName << "\"")
+    return -1;
+    }
+
+  return this->GetMesh(meshName, structureOnly, blockIds, mesh);
+}
+
+//----------------------------------------------------------------------------
+int DataAdaptor::AddArray(vtkDataObject* mesh, const std::string &meshName,
+  int association, const std::string &arrayName, const MeshSelection &)
+{
+  // by default the array is added to all blocks present
+  return this->AddArray(mesh, meshName, association, arrayName);
+}
+
 //----------------------------------------------------------------------------
 int DataAdaptor::AddArrays(vtkDataObject* mesh, const std::string &meshName,
     int association, const std::vector<std::string> &arrayNames)
@@ -125,6 +186,20 @@ int DataAdaptor::AddGhostCellsArray(vtkDataObject*, const std::string &)
   return 0;
 }
 
+//----------------------------------------------------------------------------
+int DataAdaptor::AddGhostNodesArray(vtkDataObject* mesh,
+  const std::string &meshName, const MeshSelection &)
+{
+  return this->AddGhostNodesArray(mesh, meshName);
+}
+
+//----------------------------------------------------------------------------
+int DataAdaptor::AddGhostCellsArray(vtkDataObject* mesh,
+  const std::string &meshName, const MeshSelection &)
+{
+  return this->AddGhostCellsArray(mesh, meshName);
+}
+
 //----------------------------------------------------------------------------
 void DataAdaptor::PrintSelf(ostream& os, vtkIndent indent)
 {
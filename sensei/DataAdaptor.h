@@ -3,6 +3,7 @@
 
 #include "senseiConfig.h"
 #include "MeshMetadata.h"
+#include "MeshSelection.h"
 
 #include <vtkObjectBase.h>
 
@@ -88,6 +89,47 @@ public:
   virtual int GetMesh(const std::string &meshName, bool structureOnly,
     vtkCompositeDataSet *&mesh);
 
+  /// @brief Return a composite object holding only the listed blocks
+  ///
+  /// Analyses that need only some of the local blocks, for instance those
+  /// that a slice passes through, use this to avoid generating, moving, and
+  /// converting the others. Blocks are identified by the ids reported in
+  /// MeshMetadata::BlockIds. Adaptors that can produce a subset override
+  /// this, leaving the blocks that were not listed empty, and skip empty
+  /// blocks in AddArray and the ghost array methods. The default returns
+  /// all of the blocks, thus callers must be prepared to receive blocks
+  /// that they did not ask for.
+  ///
+  /// @param[in] meshName the name of the mesh to access (see GetMeshMetadata)
+  /// @param[in] structureOnly When set to true the returned mesh
+  ///            may not have any geometry or topology information.
+  /// @param[in] blockIds the ids of the local blocks that are needed
+  /// @param[out] mesh a reference to a pointer where a new VTK object is stored
+  /// @returns zero if successful, non zero if an error occurred
+  virtual int GetMesh(const std::string &meshName, bool structureOnly,
+    const std::vector<int> &blockIds, vtkCompositeDataSet *&mesh);
+
+  /// @brief Return a composite object holding only the selected part of
+  ///        the mesh
+  ///
+  /// The selection names blocks by id and/or by bounding box, and for
+  /// Cartesian meshes a sub-extent and stride for the cells of the selected
+  /// blocks (see MeshSelection). Adaptors that can generate or read less
+  /// data override this along with the AddArray, AddGhostCellsArray and
+  /// AddGhostNodesArray overloads taking a selection, which are passed the
+  /// same selection. The default honors the block selection, using block
+  /// bounds from the metadata to resolve a bounding box, and passes the
+  /// block ids to the overload above. Cells are not subset by default.
+  ///
+  /// @param[in] meshName the name of the mesh to access (see GetMeshMetadata)
+  /// @param[in] structureOnly When set to true the returned mesh
+  ///            may not have any geometry or topology information.
+  /// @param[in] selection describes the part of the mesh that is needed
+  /// @param[out] mesh a reference to a pointer where a new VTK object is stored
+  /// @returns zero if successful, non zero if an error occurred
+  virtual int GetMesh(const std::string &meshName, bool structureOnly,
+    const MeshSelection &selection, vtkCompositeDataSet *&mesh);
+
   /// @brief Adds ghost nodes on the specified mesh. The array name must be set
   ///        to "vtkGhostType".
   ///
@@ -96,6 +138,11 @@ public:
   /// @returns zero if successful, non zero if an error occurred
   virtual int AddGhostNodesArray(vtkDataObject* mesh, const std::string &meshName);
 
+  /// @brief Adds ghost nodes on a mesh returned by the GetMesh overload
+  ///        taking a selection. The default ignores the selection.
+  virtual int AddGhostNodesArray(vtkDataObject* mesh,
+    const std::string &meshName, const MeshSelection &selection);
+
   /// @brief Adds ghost cells on the specified mesh. The array name must be set
   ///        to "vtkGhostType".
   ///
@@ -104,6 +151,11 @@ public:
   /// @returns zero if successful, non zero if an error occurred
   virtual int AddGhostCellsArray(vtkDataObject* mesh, const std::string &meshName);
 
+  /// @brief Adds ghost cells on a mesh returned by the GetMesh overload
+  ///        taking a selection. The default ignores the selection.
+  virtual int AddGhostCellsArray(vtkDataObject* mesh,
+    const std::string &meshName, const MeshSelection &selection);
+
   /// @brief Adds the specified field array to the mesh.
   ///
   /// This method will add the requested array to the mesh, if available. If the
@@ -119,6 +171,23 @@ public:
   virtual int AddArray(vtkDataObject* mesh, const std::string &meshName,
     int association, const std::string &arrayName) = 0;
 
+  /// @brief Adds the specified field array to a mesh returned by the
+  ///        GetMesh overload taking a selection.
+  ///
+  /// Only the selected part of the array is needed. The default ignores
+  /// the selection.
+  ///
+  /// @param[in] mesh the VTK object returned from GetMesh
+  /// @param[in] meshName the name of the mesh on which the array is stored
+  /// @param[in] association field association; one of
+  ///            vtkDataObject::FieldAssociations or vtkDataObject::AttributeTypes.
+  /// @param[in] arrayName name of the array
+  /// @param[in] selection the selection passed to GetMesh
+  /// @returns zero if successful, non zero if an error occurred
+  virtual int AddArray(vtkDataObject* mesh, const std::string &meshName,
+    int association, const std::string &arrayName,
+    const MeshSelection &selection);
+
   /// @brief Adds the vector of field arrays to the mesh.
   ///
   /// This method will add the requested array to the mesh, if available. If the
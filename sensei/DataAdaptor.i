@@ -1,6 +1,7 @@
 %{
 #include "senseiConfig.h"
 #include "MeshMetadata.h"
+#include "MeshSelection.h"
 #include "DataAdaptor.h"
 #include "InTransitDataAdaptor.h"
 #include "ConfigurableInTransitDataAdaptor.h"
@@ -132,6 +133,20 @@ VTK_DERIVED(DA)
 }
 %include "MeshMetadata.h"
 
+/****************************************************************************
+ * MeshSelection
+ ***************************************************************************/
+%extend sensei::MeshSelection
+{
+  PyObject *__str__()
+    {
+    std::ostringstream oss;
+    self->ToStream(oss);
+    return C_STRING_TO_PY_STRING(oss.str().c_str());
+    }
+}
+%include "MeshSelection.h"
+
 /****************************************************************************
  * DataAdaptor
  ***************************************************************************/
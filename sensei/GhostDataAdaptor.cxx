@@ -0,0 +1,961 @@
+#include "GhostDataAdaptor.h"
+#include "MeshMetadata.h"
+#include "ThreadPool.h"
+#include "VTKUtils.h"
+#include "Profiler.h"
+#include "Error.h"
+
+#include <vtkObjectFactory.h>
+#include <vtkSmartPointer.h>
+#include <vtkCompositeDataIterator.h>
+#include <vtkMultiBlockDataSet.h>
+#include <vtkImageData.h>
+#include <vtkDataSetAttributes.h>
+#include <vtkFieldData.h>
+#include <vtkAbstractArray.h>
+#include <vtkDataArray.h>
+#include <vtkUnsignedCharArray.h>
+
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <cstring>
+#include <map>
+#include <vector>
+
+using vtkDataArrayPtr = vtkSmartPointer<vtkDataArray>;
+using vtkImageDataPtr = vtkSmartPointer<vtkImageData>;
+using vtkDataObjectPtr = vtkSmartPointer<vtkDataObject>;
+using vtkCompositeDataIteratorPtr = vtkSmartPointer<vtkCompositeDataIterator>;
+
+namespace
+{
+// a region of the cell index space copied from one block into the ghost
+// zone of another
+struct Region
+{
+  int Src;     // id of the block owning the region
+  int Dest;    // id of the block receiving the region
+  int Ext[6];  // cell extent of the region
+
+  // the order in which regions are packed into a message
+  bool operator<(const Region &other) const
+  {
+    return (this->Dest < other.Dest) ||
+      ((this->Dest == other.Dest) && (this->Src < other.Src));
+  }
+};
+
+// the ghost zone exchange of a mesh. it is computed from the global
+// metadata and reused for as long as the decomposition does not change.
+struct GhostLinks
+{
+  std::vector<int> Signature;               // layers, and block ids, owners, and extents
+  std::vector<int> BlockIds;                // ids of the local blocks
+  std::vector<std::array<int,6>> Extents;   // cell extents of the local blocks
+  std::vector<std::array<int,6>> GhostExtents; // cell extents grown by the ghost layers
+  std::map<int, int> LocalIds;              // local index of each local block id
+  std::vector<Region> Local;                // regions copied between local blocks
+  std::map<int, std::vector<Region>> Sends; // regions sent to each rank
+  std::map<int, std::vector<Region>> Recvs; // regions received from each rank
+};
+
+// a mesh and its ghosted counterpart
+struct GhostedMesh
+{
+  GhostedMesh() : Links(nullptr) {}
+
+  vtkDataObjectPtr Source;
+  vtkDataObjectPtr Ghosted;   // held so that the key is not reused
+  std::vector<vtkImageDataPtr> SourceBlocks;  // by local index
+  std::vector<vtkImageDataPtr> Blocks;        // by local index
+  const GhostLinks *Links;
+};
+
+// get the intersection of two cell extents. returns false if it is empty.
+bool intersect(const int *a, const int *b, int *c)
+{
+  for (int i = 0; i < 3; ++i)
+    {
+    c[2*i] = std::max(a[2*i], b[2*i]);
+    c[2*i+1] = std::min(a[2*i+1], b[2*i+1]);
+    if (c[2*i] > c[2*i+1])
+      return false;
+    }
+  return true;
+}
+
+// grow a cell extent by n layers, clamped to the whole extent
+void grow(const int *ext, int n, const int *whole, int *gext)
+{
+  for (int i = 0; i < 3; ++i)
+    {
+    gext[2*i] = std::max(ext[2*i] - n, whole[2*i]);
+    gext[2*i+1] = std::min(ext[2*i+1] + n, whole[2*i+1]);
+    }
+}
+
+// get the extent of the cells, or of the points, of a cell extent
+void getExtent(const int *cellExt, bool point, int *ext)
+{
+  for (int i = 0; i < 3; ++i)
+    {
+    ext[2*i] = cellExt[2*i];
+    ext[2*i+1] = cellExt[2*i+1] + (point ? 1 : 0);
+    }
+}
+
+long getSize(const int *ext)
+{
+  return long(ext[1] - ext[0] + 1)*long(ext[3] - ext[2] + 1)*
+    long(ext[5] - ext[4] + 1);
+}
+
+// copy the values in ext from an array laid out over srcExt into an array
+// laid out over destExt. when keep is given the destination's values
+// inside of it are left as they are.
+template <typename T>
+void copyRegion(const T *src, const int *srcExt, T *dest, const int *destExt,
+  const int *ext, int nComps, const int *keep)
+{
+  long snx = srcExt[1] - srcExt[0] + 1;
+  long snxy = snx*(srcExt[3] - srcExt[2] + 1);
+  long dnx = destExt[1] - destExt[0] + 1;
+  long dnxy = dnx*(destExt[3] - destExt[2] + 1);
+
+  for (long k = ext[4]; k <= ext[5]; ++k)
+    {
+    for (long j = ext[2]; j <= ext[3]; ++j)
+      {
+      const T *pSrc = src + ((k - srcExt[4])*snxy + (j - srcExt[2])*snx)*nComps;
+      T *pDest = dest + ((k - destExt[4])*dnxy + (j - destExt[2])*dnx)*nComps;
+
+      long i0 = ext[0];
+      long i1 = ext[1];
+
+      // split the row around the values that are kept
+      if (keep && (j >= keep[2]) && (j <= keep[3]) &&
+        (k >= keep[4]) && (k <= keep[5]))
+        {
+        long m = std::min<long>(i1, keep[0] - 1);
+        if (i0 <= m)
+          std::copy(pSrc + (i0 - srcExt[0])*nComps,
+            pSrc + (m + 1 - srcExt[0])*nComps,
+            pDest + (i0 - destExt[0])*nComps);
+
+        i0 = std::max<long>(i0, keep[1] + 1);
+        }
+
+      if (i0 <= i1)
+        std::copy(pSrc + (i0 - srcExt[0])*nComps,
+          pSrc + (i1 + 1 - srcExt[0])*nComps,
+          pDest + (i0 - destExt[0])*nComps);
+      }
+    }
+}
+
+// returns true if ghost zones can be added to the mesh. the blocks must be
+// 3D vtkImageData with extents and owners given in the metadata.
+bool canGhost(const sensei::MeshMetadataPtr &md, int layers)
+{
+  unsigned int nBlocks = md->BlockIds.size();
+
+  if ((layers < 1) || (md->MeshType != VTK_MULTIBLOCK_DATA_SET) ||
+    (md->BlockType != VTK_IMAGE_DATA) || (md->NumGhostCells > 0) ||
+    (md->BlockExtents.size() != nBlocks) || (md->BlockOwner.size() != nBlocks))
+    return false;
+
+  for (unsigned int i = 0; i < nBlocks; ++i)
+    {
+    const std::array<int,6> &ext = md->BlockExtents[i];
+    if ((ext[0] > ext[1]) || (ext[2] > ext[3]) || (ext[4] > ext[5]))
+      return false;
+    }
+
+  return true;
+}
+
+// find the regions each local block exchanges with its neighbors. blocks
+// are neighbors when one's ghost zone overlaps the other. the exchange is
+// left as is when the layers and the decomposition have not changed.
+void buildLinks(const sensei::MeshMetadataPtr &md, int layers, int rank,
+  GhostLinks &links)
+{
+  unsigned int nBlocks = md->BlockIds.size();
+
+  std::vector<int> sig;
+  sig.reserve(8*nBlocks + 7);
+  sig.push_back(layers);
+  sig.insert(sig.end(), md->Extent.begin(), md->Extent.end());
+  for (unsigned int i = 0; i < nBlocks; ++i)
+    {
+    sig.push_back(md->BlockIds[i]);
+    sig.push_back(md->BlockOwner[i]);
+    sig.insert(sig.end(), md->BlockExtents[i].begin(),
+      md->BlockExtents[i].end());
+    }
+
+  if (sig == links.Signature)
+    return;
+
+  links = GhostLinks();
+  links.Signature.swap(sig);
+
+  std::vector<std::array<int,6>> ghostExts(nBlocks);
+  for (unsigned int i = 0; i < nBlocks; ++i)
+    grow(md->BlockExtents[i].data(), layers, md->Extent.data(),
+      ghostExts[i].data());
+
+  for (unsigned int i = 0; i < nBlocks; ++i)
+    {
+    if (md->BlockOwner[i] != rank)
+      continue;
+
+    int bid = md->BlockIds[i];
+
+    links.LocalIds[bid] = links.BlockIds.size();
+    links.BlockIds.push_back(bid);
+    links.Extents.push_back(md->BlockExtents[i]);
+    links.GhostExtents.push_back(ghostExts[i]);
+
+    for (unsigned int j = 0; j < nBlocks; ++j)
+      {
+      if (j == i)
+        continue;
+
+      int nid = md->BlockIds[j];
+      int owner = md->BlockOwner[j];
+
+      Region recv;
+      recv.Src = nid;
+      recv.Dest = bid;
+      bool haveRecv = intersect(ghostExts[i].data(),
+        md->BlockExtents[j].data(), recv.Ext);
+
+      Region send;
+      send.Src = bid;
+      send.Dest = nid;
+      bool haveSend = intersect(ghostExts[j].data(),
+        md->BlockExtents[i].data(), send.Ext);
+
+      if (!haveRecv && !haveSend)
+        continue;
+
+      // blocks on this rank are copied directly. the send is the
+      // other block's receive.
+      if (owner == rank)
+        {
+        if (haveRecv)
+          links.Local.push_back(recv);
+        continue;
+        }
+
+      if (haveRecv)
+        links.Recvs[owner].push_back(recv);
+
+      if (haveSend)
+        links.Sends[owner].push_back(send);
+      }
+    }
+
+  // both ends of a message order the regions the same way
+  for (auto &peer : links.Recvs)
+    std::sort(peer.second.begin(), peer.second.end());
+
+  for (auto &peer : links.Sends)
+    std::sort(peer.second.begin(), peer.second.end());
+}
+
+// returns non-zero on all ranks if err is non-zero on any of them. errors
+// are agreed on before messages are posted so that no rank waits for a
+// peer that gave up.
+int anyError(MPI_Comm comm, int err)
+{
+  err = err ? 1 : 0;
+  MPI_Allreduce(MPI_IN_PLACE, &err, 1, MPI_INT, MPI_MAX, comm);
+  return err;
+}
+
+// fill the ghosted arrays. each block's own values are copied, then the
+// ghost zones from the neighbors. there is one message per pair of ranks.
+template <typename T>
+void exchangeGhosts(MPI_Comm comm, const GhostLinks &links, bool point,
+  int nComps, const std::vector<const T*> &src, const std::vector<T*> &dest)
+{
+  const int tag = 7031;
+
+  size_t nRecvs = links.Recvs.size();
+  size_t nSends = links.Sends.size();
+
+  std::vector<MPI_Request> reqs(nRecvs + nSends);
+  std::vector<std::vector<T>> recvBufs(nRecvs);
+  std::vector<std::vector<T>> sendBufs(nSends);
+
+  int ext[6];
+  int srcExt[6];
+  int destExt[6];
+  int keep[6];
+
+  // post the receives
+  size_t q = 0;
+  for (auto &peer : links.Recvs)
+    {
+    long n = 0;
+    for (const Region &r : peer.second)
+      {
+      getExtent(r.Ext, point, ext);
+      n += getSize(ext);
+      }
+
+    recvBufs[q].resize(n*nComps);
+
+    MPI_Irecv(recvBufs[q].data(), int(n*nComps*sizeof(T)), MPI_BYTE,
+      peer.first, tag, comm, &reqs[q]);
+
+    ++q;
+    }
+
+  // pack and send
+  q = 0;
+  for (auto &peer : links.Sends)
+    {
+    long n = 0;
+    for (const Region &r : peer.second)
+      {
+      getExtent(r.Ext, point, ext);
+      n += getSize(ext);
+      }
+
+    std::vector<T> &buf = sendBufs[q];
+    buf.resize(n*nComps);
+
+    T *pBuf = buf.data();
+    for (const Region &r : peer.second)
+      {
+      int li = links.LocalIds.at(r.Src);
+      getExtent(links.Extents[li].data(), point, srcExt);
+      getExtent(r.Ext, point, ext);
+
+      copyRegion(src[li], srcExt, pBuf, ext, ext, nComps, nullptr);
+
+      pBuf += getSize(ext)*nComps;
+      }
+
+    MPI_Isend(buf.data(), int(n*nComps*sizeof(T)), MPI_BYTE, peer.first,
+      tag, comm, &reqs[nRecvs + q]);
+
+    ++q;
+    }
+
+  // while the messages are in flight copy the blocks' own values
+  long nBlocks = links.BlockIds.size();
+  ThreadPool::GetGlobalPool().ParallelFor(nBlocks,
+    [&](int, long i)
+    {
+    int own[6];
+    int ghost[6];
+    getExtent(links.Extents[i].data(), point, own);
+    getExtent(links.GhostExtents[i].data(), point, ghost);
+    copyRegion(src[i], own, dest[i], ghost, own, nComps, nullptr);
+    });
+
+  // and the ghost zones that come from blocks on this rank. points on
+  // the surface of a block are its own and are kept.
+  for (const Region &r : links.Local)
+    {
+    int si = links.LocalIds.at(r.Src);
+    int di = links.LocalIds.at(r.Dest);
+
+    getExtent(links.Extents[si].data(), point, srcExt);
+    getExtent(links.GhostExtents[di].data(), point, destExt);
+    getExtent(links.Extents[di].data(), point, keep);
+    getExtent(r.Ext, point, ext);
+
+    copyRegion(src[si], srcExt, dest[di], destExt, ext, nComps,
+      point ? keep : nullptr);
+    }
+
+  // unpack the ghost zones that come from other ranks
+  MPI_Waitall(nRecvs, reqs.data(), MPI_STATUSES_IGNORE);
+
+  q = 0;
+  for (auto &peer : links.Recvs)
+    {
+    const T *pBuf = recvBufs[q].data();
+    for (const Region &r : peer.second)
+      {
+      int di = links.LocalIds.at(r.Dest);
+
+      getExtent(links.GhostExtents[di].data(), point, destExt);
+      getExtent(links.Extents[di].data(), point, keep);
+      getExtent(r.Ext, point, ext);
+
+      copyRegion(pBuf, ext, dest[di], destExt, ext, nComps,
+        point ? keep : nullptr);
+
+      pBuf += getSize(ext)*nComps;
+      }
+    ++q;
+    }
+
+  MPI_Waitall(nSends, reqs.data() + nRecvs, MPI_STATUSES_IGNORE);
+}
+}
+
+namespace sensei
+{
+
+struct GhostDataAdaptor::InternalsType
+{
+  InternalsType() : Layers(1) {}
+
+  // get the global view of the named mesh's metadata including the block
+  // decomposition and extents
+  int GetMeshMetadata(MPI_Comm comm, const std::string &meshName,
+    MeshMetadataPtr &md);
+
+  vtkSmartPointer<DataAdaptor> Source;
+  int Layers;
+
+  // the exchange of each mesh, kept across time steps
+  std::map<std::string, GhostLinks> Links;
+
+  // the meshes handed out this step indexed by the ghosted mesh
+  std::map<vtkDataObject*, GhostedMesh> Meshes;
+};
+
+//----------------------------------------------------------------------------
+int GhostDataAdaptor::InternalsType::GetMeshMetadata(MPI_Comm comm,
+  const std::string &meshName, MeshMetadataPtr &md)
+{
+  unsigned int nMeshes = 0;
+  if (this->Source->GetNumberOfMeshes(nMeshes))
+    return -1;
+
+  for (unsigned int i = 0; i < nMeshes; ++i)
+    {
+    MeshMetadataFlags flags;
+    flags.SetBlockDecomp();
+    flags.SetBlockExtents();
+
+    md = MeshMetadata::New(flags);
+
+    if (this->Source->GetMeshMetadata(i, md))
+      return -1;
+
+    if (md->MeshName == meshName)
+      return md->GlobalView ? 0 : md->GlobalizeView(comm);
+    }
+
+  SENSEI_ERROR("No mesh named \"" << meshName << "\"")
+  return -1;
+}
+
+//----------------------------------------------------------------------------
+senseiNewMacro(GhostDataAdaptor);
+
+//----------------------------------------------------------------------------
+GhostDataAdaptor::GhostDataAdaptor() :
+  Internals(new GhostDataAdaptor::InternalsType)
+{
+}
+
+//----------------------------------------------------------------------------
+GhostDataAdaptor::~GhostDataAdaptor()
+{
+  delete this->Internals;
+}
+
+//----------------------------------------------------------------------------
+void GhostDataAdaptor::SetDataAdaptor(DataAdaptor *source)
+{
+  this->Internals->Meshes.clear();
+  this->Internals->Source = source;
+}
+
+//----------------------------------------------------------------------------
+void GhostDataAdaptor::SetNumberOfGhostLayers(int layers)
+{
+  this->Internals->Layers = std::max(0, layers);
+}
+
+//----------------------------------------------------------------------------
+int GhostDataAdaptor::Initialize(pugi::xml_node &node)
+{
+  this->SetNumberOfGhostLayers(node.attribute("layers").as_int(1));
+  return 0;
+}
+
+//----------------------------------------------------------------------------
+int GhostDataAdaptor::GetNumberOfMeshes(unsigned int &numMeshes)
+{
+  numMeshes = 0;
+
+  if (!this->Internals->Source)
+    {
+    SENSEI_ERROR("No data adaptor was set")
+    return -1;
+    }
+
+  return this->Internals->Source->GetNumberOfMeshes(numMeshes);
+}
+
+//----------------------------------------------------------------------------
+int GhostDataAdaptor::GetMeshMetadata(unsigned int id, MeshMetadataPtr &md)
+{
+  if (!this->Internals->Source)
+    {
+    SENSEI_ERROR("No data adaptor was set")
+    return -1;
+    }
+
+  // the extents and owners tell if ghost zones will be added
+  md->Flags.SetBlockDecomp();
+  md->Flags.SetBlockExtents();
+
+  if (this->Internals->Source->GetMeshMetadata(id, md))
+    return -1;
+
+  int layers = this->Internals->Layers;
+  if (!canGhost(md, layers))
+    return 0;
+
+  // describe the ghosted blocks
+  unsigned int nBlocks = md->BlockExtents.size();
+  for (unsigned int i = 0; i < nBlocks; ++i)
+    {
+    std::array<int,6> &ext = md->BlockExtents[i];
+    grow(ext.data(), layers, md->Extent.data(), ext.data());
+
+    long nx = ext[1] - ext[0] + 1;
+    long ny = ext[3] - ext[2] + 1;
+    long nz = ext[5] - ext[4] + 1;
+
+    if (md->BlockNumCells.size() == nBlocks)
+      md->BlockNumCells[i] = nx*ny*nz;
+
+    if (md->BlockNumPoints.size() == nBlocks)
+      md->BlockNumPoints[i] = (nx + 1)*(ny + 1)*(nz + 1);
+    }
+
+  md->NumGhostCells = layers;
+  md->NumGhostNodes = layers;
+
+  return 0;
+}
+
+//----------------------------------------------------------------------------
+int GhostDataAdaptor::GetMesh(const std::string &meshName,
+  bool structureOnly, vtkDataObject *&mesh)
+{
+  TimeEvent<128> mark("GhostDataAdaptor::GetMesh");
+
+  mesh = nullptr;
+
+  if (!this->Internals->Source)
+    {
+    SENSEI_ERROR("No data adaptor was set")
+    return -1;
+    }
+
+  MPI_Comm comm = this->GetCommunicator();
+
+  MeshMetadataPtr md;
+  if (this->Internals->GetMeshMetadata(comm, meshName, md))
+    {
+    SENSEI_ERROR("Failed to get metadata for mesh \"" << meshName << "\"")
+    return -1;
+    }
+
+  vtkDataObject *dobj = nullptr;
+  if (this->Internals->Source->GetMesh(meshName, structureOnly, dobj))
+    {
+    SENSEI_ERROR("Failed to get mesh \"" << meshName << "\"")
+    return -1;
+    }
+
+  // the metadata is global so all ranks agree on this
+  if (!canGhost(md, this->Internals->Layers))
+    {
+    mesh = dobj;
+    return 0;
+    }
+
+  vtkMultiBlockDataSet *mb = dynamic_cast<vtkMultiBlockDataSet*>(dobj);
+  if (!mb)
+    {
+    SENSEI_ERROR("Mesh \"" << meshName << "\" is not a multiblock")
+    anyError(comm, 1);
+    if (dobj)
+      dobj->Delete();
+    return -1;
+    }
+
+  int rank = 0;
+  MPI_Comm_rank(comm, &rank);
+
+  GhostLinks &links = this->Internals->Links[meshName];
+  buildLinks(md, this->Internals->Layers, rank, links);
+
+  unsigned int nLocal = links.BlockIds.size();
+
+  GhostedMesh gm;
+  gm.Source.TakeReference(dobj);
+  gm.SourceBlocks.resize(nLocal);
+  gm.Blocks.resize(nLocal);
+  gm.Links = &links;
+
+  vtkMultiBlockDataSet *ghosted = vtkMultiBlockDataSet::New();
+  ghosted->CopyStructure(mb);
+
+  int err = 0;
+
+  vtkCompositeDataIteratorPtr it;
+  it.TakeReference(mb->NewIterator());
+  it->SetSkipEmptyNodes(1);
+  for (it->InitTraversal(); !it->IsDoneWithTraversal(); it->GoToNextItem())
+    {
+    vtkDataObject *leaf = it->GetCurrentDataObject();
+    int bid = it->GetCurrentFlatIndex() - 1;
+
+    // blocks not in the metadata are passed through
+    std::map<int, int>::const_iterator lit = links.LocalIds.find(bid);
+    if (lit == links.LocalIds.end())
+      {
+      ghosted->SetDataSet(it, leaf);
+      continue;
+      }
+
+    int li = lit->second;
+
+    // the block must be where the metadata says it is
+    int ext[6];
+    getExtent(links.Extents[li].data(), true, ext);
+
+    vtkImageData *block = dynamic_cast<vtkImageData*>(leaf);
+    if (!block || !std::equal(ext, ext + 6, block->GetExtent()))
+      {
+      SENSEI_ERROR("Block " << bid << " of mesh \"" << meshName
+        << "\" does not match the metadata")
+      err = 1;
+      break;
+      }
+
+    int ghostExt[6];
+    getExtent(links.GhostExtents[li].data(), true, ghostExt);
+
+    vtkImageData *ghostBlock = vtkImageData::New();
+    ghostBlock->SetOrigin(block->GetOrigin());
+    ghostBlock->SetSpacing(block->GetSpacing());
+    ghostBlock->SetExtent(ghostExt);
+
+    // pass field data through
+    ghostBlock->GetFieldData()->ShallowCopy(block->GetFieldData());
+
+    ghosted->SetDataSet(it, ghostBlock);
+
+    gm.SourceBlocks[li] = block;
+    gm.Blocks[li].TakeReference(ghostBlock);
+    }
+
+  for (unsigned int i = 0; !err && (i < nLocal); ++i)
+    {
+    if (!gm.Blocks[i])
+      {
+      SENSEI_ERROR("Block " << links.BlockIds[i] << " of mesh \""
+        << meshName << "\" is missing")
+      err = 1;
+      }
+    }
+
+  // the arrays of a mesh are exchanged collectively, so the mesh is
+  // handed out on all ranks or on none
+  if (anyError(comm, err))
+    {
+    ghosted->Delete();
+    return -1;
+    }
+
+  gm.Ghosted = ghosted;
+  this->Internals->Meshes[ghosted] = gm;
+
+  // the caller takes a reference
+  mesh = ghosted;
+
+  return 0;
+}
+
+//----------------------------------------------------------------------------
+int GhostDataAdaptor::ExchangeArray(vtkDataObject *mesh, int association,
+  const std::string &arrayName, int failed)
+{
+  TimeEvent<128> mark("GhostDataAdaptor::ExchangeArray");
+
+  MPI_Comm comm = this->GetCommunicator();
+
+  std::map<vtkDataObject*, GhostedMesh>::iterator it =
+    this->Internals->Meshes.find(mesh);
+
+  if (it == this->Internals->Meshes.end())
+    {
+    SENSEI_ERROR("The mesh was not made by this adaptor")
+    anyError(comm, 1);
+    return -1;
+    }
+
+  GhostedMesh &gm = it->second;
+  const GhostLinks &links = *gm.Links;
+
+  bool point = association == vtkDataObject::POINT;
+
+  // check the source arrays
+  long nBlocks = gm.Blocks.size();
+  std::vector<vtkDataArray*> srcArrays(nBlocks);
+
+  int err = failed;
+  for (long i = 0; !err && (i < nBlocks); ++i)
+    {
+    vtkDataArray *sa =
+      gm.SourceBlocks[i]->GetAttributes(association)->GetArray(arrayName.c_str());
+
+    if (!sa)
+      {
+      SENSEI_ERROR("Block is missing "
+        << VTKUtils::GetAttributesName(association) << " data array \""
+        << arrayName << "\"")
+      err = 1;
+      }
+    else if (i && ((sa->GetDataType() != srcArrays[0]->GetDataType()) ||
+      (sa->GetNumberOfComponents() != srcArrays[0]->GetNumberOfComponents())))
+      {
+      SENSEI_ERROR("The blocks have different types of "
+        << VTKUtils::GetAttributesName(association) << " data array \""
+        << arrayName << "\"")
+      err = 1;
+      }
+
+    srcArrays[i] = sa;
+    }
+
+  // all ranks must succeed and agree on the type and the number of
+  // components before any messages are posted. ranks without blocks take
+  // no part in the comparison.
+  int vals[5] = {err, INT_MIN, INT_MIN, INT_MIN, INT_MIN};
+  if (!err && nBlocks)
+    {
+    int type = srcArrays[0]->GetDataType();
+    int nComps = srcArrays[0]->GetNumberOfComponents();
+    vals[1] = type;
+    vals[2] = -type;
+    vals[3] = nComps;
+    vals[4] = -nComps;
+    }
+
+  MPI_Allreduce(MPI_IN_PLACE, vals, 5, MPI_INT, MPI_MAX, comm);
+
+  if (vals[0])
+    return -1;
+
+  if ((vals[1] != -vals[2]) || (vals[3] != -vals[4]))
+    {
+    SENSEI_ERROR("The ranks have different types of "
+      << VTKUtils::GetAttributesName(association) << " data array \""
+      << arrayName << "\"")
+    return -1;
+    }
+
+  if (nBlocks < 1)
+    return 0;
+
+  // allocate the ghosted arrays. ghost zones that no block covers are
+  // left zero.
+  std::vector<vtkDataArrayPtr> destArrays(nBlocks);
+  for (long i = 0; i < nBlocks; ++i)
+    {
+    vtkDataArray *sa = srcArrays[i];
+    vtkImageData *gb = gm.Blocks[i];
+
+    vtkDataArray *da = sa->NewInstance();
+    da->SetName(sa->GetName());
+    da->SetNumberOfComponents(sa->GetNumberOfComponents());
+    da->SetNumberOfTuples(point ? gb->GetNumberOfPoints() :
+      gb->GetNumberOfCells());
+
+    memset(da->GetVoidPointer(0), 0, da->GetNumberOfTuples()*
+      da->GetNumberOfComponents()*da->GetDataTypeSize());
+
+    destArrays[i].TakeReference(da);
+    }
+
+  int nComps = srcArrays[0]->GetNumberOfComponents();
+
+  switch (srcArrays[0]->GetDataType())
+    {
+    vtkTemplateMacro(
+      std::vector<const VTK_TT*> pSrc(nBlocks);
+      std::vector<VTK_TT*> pDest(nBlocks);
+      for (long i = 0; i < nBlocks; ++i)
+        {
+        pSrc[i] = static_cast<const VTK_TT*>(srcArrays[i]->GetVoidPointer(0));
+        pDest[i] = static_cast<VTK_TT*>(destArrays[i]->GetVoidPointer(0));
+        }
+      exchangeGhosts(comm, links, point, nComps, pSrc, pDest);
+      );
+    default:
+      SENSEI_ERROR("Failed to exchange " << srcArrays[0]->GetClassName()
+        << " \"" << arrayName << "\"")
+      return -1;
+    }
+
+  for (long i = 0; i < nBlocks; ++i)
+    gm.Blocks[i]->GetAttributes(association)->AddArray(destArrays[i]);
+
+  return 0;
+}
+
+//----------------------------------------------------------------------------
+int GhostDataAdaptor::AddGhostArray(vtkDataObject *mesh, int association)
+{
+  GhostedMesh &gm = this->Internals->Meshes.find(mesh)->second;
+  const GhostLinks &links = *gm.Links;
+
+  bool point = association == vtkDataObject::POINT;
+
+  unsigned char flag = point ? vtkDataSetAttributes::DUPLICATEPOINT :
+    vtkDataSetAttributes::DUPLICATECELL;
+
+  unsigned int nBlocks = gm.Blocks.size();
+  for (unsigned int i = 0; i < nBlocks; ++i)
+    {
+    int ext[6];
+    int ghostExt[6];
+    getExtent(links.Extents[i].data(), point, ext);
+    getExtent(links.GhostExtents[i].data(), point, ghostExt);
+
+    vtkUnsignedCharArray *ga = vtkUnsignedCharArray::New();
+    ga->SetName(vtkDataSetAttributes::GhostArrayName());
+    ga->SetNumberOfTuples(getSize(ghostExt));
+
+    unsigned char *pGa = ga->GetPointer(0);
+    for (int k = ghostExt[4]; k <= ghostExt[5]; ++k)
+      {
+      for (int j = ghostExt[2]; j <= ghostExt[3]; ++j)
+        {
+        bool own = (j >= ext[2]) && (j <= ext[3]) &&
+          (k >= ext[4]) && (k <= ext[5]);
+
+        for (int q = ghostExt[0]; q <= ghostExt[1]; ++q)
+          *pGa++ = (own && (q >= ext[0]) && (q <= ext[1])) ? 0 : flag;
+        }
+      }
+
+    gm.Blocks[i]->GetAttributes(association)->AddArray(ga);
+    ga->Delete();
+    }
+
+  return 0;
+}
+
+//----------------------------------------------------------------------------
+int GhostDataAdaptor::AddArray(vtkDataObject* mesh,
+  const std::string &meshName, int association, const std::string &arrayName)
+{
+  if (!this->Internals->Source)
+    {
+    SENSEI_ERROR("No data adaptor was set")
+    return -1;
+    }
+
+  // meshes that were passed through
+  std::map<vtkDataObject*, GhostedMesh>::iterator it =
+    this->Internals->Meshes.find(mesh);
+
+  if (it == this->Internals->Meshes.end())
+    return this->Internals->Source->AddArray(mesh, meshName,
+      association, arrayName);
+
+  // add the array to the source blocks, then exchange
+  GhostedMesh &gm = it->second;
+  int failed = this->Internals->Source->AddArray(gm.Source, meshName,
+    association, arrayName) ? 1 : 0;
+
+  if (association == vtkDataObject::FIELD)
+    {
+    if (failed)
+      return -1;
+
+    unsigned int nBlocks = gm.Blocks.size();
+    for (unsigned int i = 0; i < nBlocks; ++i)
+      {
+      vtkAbstractArray *fa = gm.SourceBlocks[i]->GetFieldData()->
+        GetAbstractArray(arrayName.c_str());
+      if (fa)
+        gm.Blocks[i]->GetFieldData()->AddArray(fa);
+      }
+    return 0;
+    }
+
+  // a failure is passed on so that the other ranks do not wait for this
+  // one's messages
+  return this->ExchangeArray(mesh, association, arrayName, failed);
+}
+
+//----------------------------------------------------------------------------
+int GhostDataAdaptor::AddGhostNodesArray(vtkDataObject* mesh,
+  const std::string &meshName)
+{
+  if (!this->Internals->Source)
+    {
+    SENSEI_ERROR("No data adaptor was set")
+    return -1;
+    }
+
+  if (!this->Internals->Meshes.count(mesh))
+    return this->Internals->Source->AddGhostNodesArray(mesh, meshName);
+
+  return this->AddGhostArray(mesh, vtkDataObject::POINT);
+}
+
+//----------------------------------------------------------------------------
+int GhostDataAdaptor::AddGhostCellsArray(vtkDataObject* mesh,
+  const std::string &meshName)
+{
+  if (!this->Internals->Source)
+    {
+    SENSEI_ERROR("No data adaptor was set")
+    return -1;
+    }
+
+  if (!this->Internals->Meshes.count(mesh))
+    return this->Internals->Source->AddGhostCellsArray(mesh, meshName);
+
+  return this->AddGhostArray(mesh, vtkDataObject::CELL);
+}
+
+//----------------------------------------------------------------------------
+int GhostDataAdaptor::ReleaseData()
+{
+  this->Internals->Meshes.clear();
+
+  if (this->Internals->Source)
+    return this->Internals->Source->ReleaseData();
+
+  return 0;
+}
+
+//----------------------------------------------------------------------------
+double GhostDataAdaptor::GetDataTime()
+{
+  return this->Internals->Source ?
+    this->Internals->Source->GetDataTime() : this->DataAdaptor::GetDataTime();
+}
+
+//----------------------------------------------------------------------------
+long GhostDataAdaptor::GetDataTimeStep()
+{
+  return this->Internals->Source ?
+    this->Internals->Source->GetDataTimeStep() :
+    this->DataAdaptor::GetDataTimeStep();
+}
+
+}
@@ -0,0 +1,98 @@
+#ifndef sensei_GhostDataAdaptor_h
+#define sensei_GhostDataAdaptor_h
+
+#include "DataAdaptor.h"
+
+#include <pugixml.hpp>
+#include <string>
+
+namespace sensei
+{
+/// @brief A DataAdaptor that adds layers of ghost cells to another
+///        adaptor's Cartesian meshes.
+///
+/// Placed in front of an analysis that needs data from the neighboring
+/// blocks, for instance contouring or other stencil operations, on data from
+/// a simulation that does not provide ghost zones. The 3D vtkImageData
+/// blocks of multiblock meshes are grown by the requested number of layers,
+/// clamped to the global extent, and the values of the ghost cells and
+/// points are copied from the blocks that own them. The neighbors are found
+/// from the block extents and owners in the mesh metadata. They are cached
+/// and reused for as long as the decomposition does not change. Arrays are
+/// exchanged as they are added, with one nonblocking message per pair of
+/// ranks. A vtkGhostType array marks the ghost cells and points. Meshes
+/// that already have ghost cells, or that are not described by the
+/// metadata, are passed through unchanged.
+class GhostDataAdaptor : public DataAdaptor
+{
+public:
+  static GhostDataAdaptor *New();
+  senseiTypeMacro(GhostDataAdaptor, DataAdaptor);
+
+  /// @brief Set the adaptor providing the data. This releases the data
+  /// cached from the previous adaptor.
+  void SetDataAdaptor(DataAdaptor *source);
+
+  /// @brief Set the number of layers of ghost cells to add. The default
+  /// is 1.
+  void SetNumberOfGhostLayers(int layers);
+
+  /// @brief Configure from the layers attribute of an XML element.
+  int Initialize(pugi::xml_node &node);
+
+  // SENSEI API
+  int GetNumberOfMeshes(unsigned int &numMeshes) override;
+
+  int GetMeshMetadata(unsigned int id, MeshMetadataPtr &metadata) override;
+
+  int GetMesh(const std::string &meshName, bool structureOnly,
+    vtkDataObject *&mesh) override;
+
+  using DataAdaptor::GetMesh;
+
+  int AddArray(vtkDataObject* mesh, const std::string &meshName,
+    int association, const std::string &arrayName) override;
+
+  using DataAdaptor::AddArray;
+
+  int AddGhostNodesArray(vtkDataObject* mesh,
+    const std::string &meshName) override;
+
+  using DataAdaptor::AddGhostNodesArray;
+
+  int AddGhostCellsArray(vtkDataObject* mesh,
+    const std::string &meshName) override;
+
+  using DataAdaptor::AddGhostCellsArray;
+
+  int ReleaseData() override;
+
+  double GetDataTime() override;
+
+  long GetDataTimeStep() override;
+
+protected:
+  GhostDataAdaptor();
+  ~GhostDataAdaptor();
+
+  GhostDataAdaptor(const GhostDataAdaptor&) = delete;
+  void operator=(const GhostDataAdaptor&) = delete;
+
+  // copy the named array from the source blocks onto the ghosted blocks
+  // and fill in the ghost zones from the neighboring blocks. this is
+  // collective, failed tells the other ranks that this one could not get
+  // the array and all of them return an error.
+  int ExchangeArray(vtkDataObject *mesh, int association,
+    const std::string &arrayName, int failed);
+
+  // add the vtkGhostType array marking the ghost zones
+  int AddGhostArray(vtkDataObject *mesh, int association);
+
+private:
+  struct InternalsType;
+  InternalsType *Internals;
+};
+
+}
+
+#endif
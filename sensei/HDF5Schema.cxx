@@ -1,6 +1,7 @@
 #include "HDF5Schema.h"
 #include "Profiler.h"
 #include "VTKUtils.h"
+#include "ArrayPool.h"
 
 #include <vtkCellArray.h>
 #include <vtkCellData.h>
@@ -1334,10 +1335,8 @@ bool ArrayFlow::load(unsigned int block_id,
   uint64_t count = num_elem_local;
   ;
 
-  vtkDataArray *array = vtkDataArray::CreateDataArray(GetArrayType());
-  array->SetNumberOfComponents(m_NumArrayComponent);
-  array->SetName(GetArrayName().c_str());
-  array->SetNumberOfTuples(num_elem_local);
+  vtkDataArray *array = sensei::ArrayPool::NewArray(GetArrayType(),
+    num_elem_local, m_NumArrayComponent, GetArrayName().c_str());
 
   if(!reader->ReadVar1D(m_ArrayPath, start, count, array->GetVoidPointer(0)))
     return false;
@@ -1874,10 +1873,8 @@ bool PointFlow::load(unsigned int block_id,
   uint64_t count = 3 * m_Metadata->BlockNumPoints[block_id];
 
   vtkDataArray *points =
-    vtkDataArray::CreateDataArray(m_Metadata->CoordinateType);
-  points->SetNumberOfComponents(3);
-  points->SetNumberOfTuples(m_Metadata->BlockNumPoints[block_id]);
-  points->SetName("points");
+    sensei::ArrayPool::NewArray(m_Metadata->CoordinateType,
+      m_Metadata->BlockNumPoints[block_id], 3, "points");
 
   // std::string path = ons + "points";
   // std::string path;
@@ -2173,22 +2170,16 @@ bool StretchedCartesianFlow::load(unsigned int block_id,
     }
 
   vtkDataArray *x_coords =
-    vtkDataArray::CreateDataArray(m_Metadata->CoordinateType);
-  x_coords->SetNumberOfComponents(1);
-  x_coords->SetNumberOfTuples(local[0]);
-  x_coords->SetName("x_coords");
+    sensei::ArrayPool::NewArray(m_Metadata->CoordinateType,
+      local[0], 1, "x_coords");
 
   vtkDataArray *y_coords =
-    vtkDataArray::CreateDataArray(m_Metadata->CoordinateType);
-  y_coords->SetNumberOfComponents(1);
-  y_coords->SetNumberOfTuples(local[1]);
-  y_coords->SetName("y_coords");
+    sensei::ArrayPool::NewArray(m_Metadata->CoordinateType,
+      local[1], 1, "y_coords");
 
   vtkDataArray *z_coords =
-    vtkDataArray::CreateDataArray(m_Metadata->CoordinateType);
-  z_coords->SetNumberOfComponents(1);
-  z_coords->SetNumberOfTuples(local[2]);
-  z_coords->SetName("z_coords");
+    sensei::ArrayPool::NewArray(m_Metadata->CoordinateType,
+      local[2], 1, "z_coords");
 
   if(!reader->ReadVar1D(
         m_XPath, m_BlockOffset[0], local[0], x_coords->GetVoidPointer(0)))
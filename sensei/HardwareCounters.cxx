@@ -0,0 +1,307 @@
+#include "HardwareCounters.h"
+#include "Error.h"
+
+#include <vector>
+#include <string>
+#include <sstream>
+#include <mutex>
+#include <atomic>
+#include <cstring>
+#include <cstdint>
+
+#if defined(__linux)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+// a counter's name and its perf event type and config
+struct CounterSpec
+{
+  const char *Name;
+  uint32_t Type;
+  uint64_t Config;
+};
+
+#if defined(__linux)
+#define HW_CACHE_EVENT(cache, op, result) \
+  (PERF_COUNT_HW_CACHE_ ## cache | (PERF_COUNT_HW_CACHE_OP_ ## op << 8) | \
+  (PERF_COUNT_HW_CACHE_RESULT_ ## result << 16))
+
+const CounterSpec counterSpecs[] = {
+  {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+  {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+  {"ref-cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_REF_CPU_CYCLES},
+  {"cache-references", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_REFERENCES},
+  {"cache-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+  {"branches", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_INSTRUCTIONS},
+  {"branch-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+  {"stalled-cycles-frontend", PERF_TYPE_HARDWARE,
+    PERF_COUNT_HW_STALLED_CYCLES_FRONTEND},
+  {"stalled-cycles-backend", PERF_TYPE_HARDWARE,
+    PERF_COUNT_HW_STALLED_CYCLES_BACKEND},
+  {"l1d-loads", PERF_TYPE_HW_CACHE, HW_CACHE_EVENT(L1D, READ, ACCESS)},
+  {"l1d-load-misses", PERF_TYPE_HW_CACHE, HW_CACHE_EVENT(L1D, READ, MISS)},
+  {"llc-loads", PERF_TYPE_HW_CACHE, HW_CACHE_EVENT(LL, READ, ACCESS)},
+  {"llc-load-misses", PERF_TYPE_HW_CACHE, HW_CACHE_EVENT(LL, READ, MISS)},
+  {"llc-stores", PERF_TYPE_HW_CACHE, HW_CACHE_EVENT(LL, WRITE, ACCESS)},
+  {"llc-store-misses", PERF_TYPE_HW_CACHE, HW_CACHE_EVENT(LL, WRITE, MISS)},
+  {"dtlb-load-misses", PERF_TYPE_HW_CACHE, HW_CACHE_EVENT(DTLB, READ, MISS)},
+  {"page-faults", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS},
+  {"context-switches", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES},
+  {"cpu-migrations", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CPU_MIGRATIONS},
+  {"task-clock", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK},
+  {nullptr, 0, 0}};
+#else
+// the names are known so that configurations are portable, but the
+// counters always read as -1
+const CounterSpec counterSpecs[] = {
+  {"cycles", 0, 0}, {"instructions", 0, 0}, {"ref-cycles", 0, 0},
+  {"cache-references", 0, 0}, {"cache-misses", 0, 0}, {"branches", 0, 0},
+  {"branch-misses", 0, 0}, {"stalled-cycles-frontend", 0, 0},
+  {"stalled-cycles-backend", 0, 0}, {"l1d-loads", 0, 0},
+  {"l1d-load-misses", 0, 0}, {"llc-loads", 0, 0}, {"llc-load-misses", 0, 0},
+  {"llc-stores", 0, 0}, {"llc-store-misses", 0, 0},
+  {"dtlb-load-misses", 0, 0}, {"page-faults", 0, 0},
+  {"context-switches", 0, 0}, {"cpu-migrations", 0, 0},
+  {"task-clock", 0, 0}, {nullptr, 0, 0}};
+#endif
+
+// the process wide counter configuration
+struct CounterConfig
+{
+  CounterConfig() : Generation(1)
+  {
+    // cycles, instructions, cache-references, cache-misses
+    this->Counters = {0, 1, 3, 4};
+  }
+
+  std::mutex Mutex;
+  std::vector<int> Counters;
+  std::atomic<unsigned long> Generation;
+};
+
+CounterConfig &GetConfig()
+{
+  static CounterConfig config;
+  return config;
+}
+
+// the calling thread's open counters
+struct ThreadCounters
+{
+  ThreadCounters() : Generation(0), Leader(-1), NumOpen(0) {}
+  ~ThreadCounters() { this->Close(); }
+
+  // open the configured counters as a group
+  void Open();
+
+  // close any open counters
+  void Close();
+
+  // read the counters, the values of unavailable counters are -1
+  int Read(long long *values);
+
+  unsigned long Generation;
+  int Leader;
+  int NumOpen;
+  std::vector<int> Fds;
+  std::vector<int> Slot;
+};
+
+thread_local ThreadCounters threadCounters;
+
+// --------------------------------------------------------------------------
+void ThreadCounters::Open()
+{
+  this->Close();
+
+  CounterConfig &config = GetConfig();
+
+  std::vector<int> counters;
+  {
+  std::lock_guard<std::mutex> lock(config.Mutex);
+  counters = config.Counters;
+  this->Generation = config.Generation;
+  }
+
+  int nCounters = counters.size();
+  this->Fds.assign(nCounters, -1);
+  this->Slot.assign(nCounters, -1);
+
+#if defined(__linux)
+  for (int i = 0; i < nCounters; ++i)
+    {
+    const CounterSpec &spec = counterSpecs[counters[i]];
+
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = spec.Type;
+    attr.config = spec.Config;
+    attr.read_format = PERF_FORMAT_GROUP |
+      PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    // user space only, this is permitted at perf_event_paranoid 2
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+
+    // this thread on any cpu. the first counter opened leads the group
+    int fd = syscall(__NR_perf_event_open, &attr, 0, -1,
+      this->Leader, PERF_FLAG_FD_CLOEXEC);
+
+    if (fd < 0)
+      continue;
+
+    if (this->Leader < 0)
+      this->Leader = fd;
+
+    this->Fds[i] = fd;
+    this->Slot[i] = this->NumOpen;
+    this->NumOpen += 1;
+    }
+#endif
+}
+
+// --------------------------------------------------------------------------
+void ThreadCounters::Close()
+{
+#if defined(__linux)
+  int nCounters = this->Fds.size();
+  for (int i = 0; i < nCounters; ++i)
+    {
+    if (this->Fds[i] >= 0)
+      close(this->Fds[i]);
+    }
+#endif
+
+  this->Fds.clear();
+  this->Slot.clear();
+  this->Leader = -1;
+  this->NumOpen = 0;
+}
+
+// --------------------------------------------------------------------------
+int ThreadCounters::Read(long long *values)
+{
+  if (this->Generation != GetConfig().Generation)
+    this->Open();
+
+  int nCounters = this->Fds.size();
+
+#if defined(__linux)
+  if (this->Leader >= 0)
+    {
+    // number of values, time enabled, time running, values
+    uint64_t buf[3 + sensei::HardwareCounters::MaxCounters];
+
+    ssize_t nRead = read(this->Leader, buf, sizeof(buf));
+    if (nRead >= ssize_t((3 + this->NumOpen)*sizeof(uint64_t)))
+      {
+      // scale for the time the counters were not scheduled when the
+      // kernel multiplexes them
+      double scale = 1.0;
+      if ((buf[2] > 0) && (buf[2] < buf[1]))
+        scale = double(buf[1])/double(buf[2]);
+
+      for (int i = 0; i < nCounters; ++i)
+        {
+        int slot = this->Slot[i];
+        values[i] = slot < 0 ? -1ll :
+          (scale == 1.0 ? (long long)buf[3 + slot] :
+          (long long)(buf[3 + slot]*scale));
+        }
+
+      return this->NumOpen == nCounters ? 0 : -1;
+      }
+    }
+#endif
+
+  for (int i = 0; i < nCounters; ++i)
+    values[i] = -1ll;
+
+  return -1;
+}
+}
+
+namespace sensei
+{
+
+// --------------------------------------------------------------------------
+int HardwareCounters::SetCounters(const std::string &names)
+{
+  std::vector<int> counters;
+
+  std::istringstream iss(names);
+  std::string name;
+  while (std::getline(iss, name, ','))
+    {
+    // trim white space
+    size_t first = name.find_first_not_of(" \t");
+    if (first == std::string::npos)
+      continue;
+    size_t last = name.find_last_not_of(" \t");
+    name = name.substr(first, last - first + 1);
+
+    int id = 0;
+    while (counterSpecs[id].Name && (name != counterSpecs[id].Name))
+      ++id;
+
+    if (!counterSpecs[id].Name)
+      {
+      SENSEI_ERROR("Unknown hardware counter \"" << name << "\"")
+      return -1;
+      }
+
+    counters.push_back(id);
+    }
+
+  if (counters.size() > MaxCounters)
+    {
+    SENSEI_ERROR("At most " << MaxCounters << " hardware counters can be"
+      " read at once, " << counters.size() << " were requested")
+    return -1;
+    }
+
+  CounterConfig &config = GetConfig();
+  std::lock_guard<std::mutex> lock(config.Mutex);
+  config.Counters.swap(counters);
+  config.Generation += 1;
+
+  return 0;
+}
+
+// --------------------------------------------------------------------------
+int HardwareCounters::GetNumberOfCounters()
+{
+  CounterConfig &config = GetConfig();
+  std::lock_guard<std::mutex> lock(config.Mutex);
+  return config.Counters.size();
+}
+
+// --------------------------------------------------------------------------
+const char *HardwareCounters::GetCounterName(int i)
+{
+  CounterConfig &config = GetConfig();
+  std::lock_guard<std::mutex> lock(config.Mutex);
+  return counterSpecs[config.Counters[i]].Name;
+}
+
+// --------------------------------------------------------------------------
+int HardwareCounters::Read(long long *values)
+{
+  return threadCounters.Read(values);
+}
+
+// --------------------------------------------------------------------------
+int HardwareCounters::GetNumberOfAvailableCounters()
+{
+  if (threadCounters.Generation != GetConfig().Generation)
+    threadCounters.Open();
+
+  return threadCounters.NumOpen;
+}
+
+}
@@ -0,0 +1,65 @@
+#ifndef sensei_HardwareCounters_h
+#define sensei_HardwareCounters_h
+
+#include "senseiConfig.h"
+
+#include <string>
+
+namespace sensei
+{
+
+// HardwareCounters - per thread hardware performance counters
+/**
+Reads CPU performance counters, such as cycles, instructions and last
+level cache misses, for the calling thread using Linux perf events. The
+Profiler uses this to attribute counts to events.
+
+The set of counters is process wide and is given by a comma separated
+list of names. The counters are opened lazily, on a thread's first call
+to Read, as a single group so that all values are read with one system
+call. When the kernel multiplexes the counters the values are scaled to
+the time the group was enabled.
+
+perf events are often restricted, for instance in containers or by the
+kernel.perf_event_paranoid setting. Counters are opened user space only,
+which is permitted at paranoid level 2, and counters that can not be
+opened read as -1. On systems without perf events all counters read as -1.
+
+The following counters are known:
+
+  cycles, instructions, ref-cycles, cache-references, cache-misses,
+  branches, branch-misses, stalled-cycles-frontend, stalled-cycles-backend,
+  l1d-loads, l1d-load-misses, llc-loads, llc-load-misses, llc-stores,
+  llc-store-misses, dtlb-load-misses, page-faults, context-switches,
+  cpu-migrations, task-clock
+*/
+class HardwareCounters
+{
+public:
+  // the most counters that can be read at once
+  enum { MaxCounters = 8 };
+
+  // Set the counters to read from a comma separated list of names.
+  // Unknown names are an error. Threads reopen their counters on their
+  // next call to Read.
+  // default value: "cycles,instructions,cache-references,cache-misses"
+  static int SetCounters(const std::string &names);
+
+  // get the number and names of the configured counters
+  static int GetNumberOfCounters();
+  static const char *GetCounterName(int i);
+
+  // Read the current value of each configured counter for the calling
+  // thread into values, which must have room for GetNumberOfCounters
+  // values. Values for counters that are not available are -1. Returns 0
+  // if all of the counters were read.
+  static int Read(long long *values);
+
+  // Open the calling thread's counters and return the number of the
+  // configured counters that are available
+  static int GetNumberOfAvailableCounters();
+};
+
+}
+
+#endif
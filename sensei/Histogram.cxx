@@ -1,4 +1,5 @@
 #include "Histogram.h"
+#include "BlockParallel.h"
 #include "DataAdaptor.h"
 #include "MeshMetadata.h"
 #include "MeshMetadataMap.h"
@@ -7,12 +8,9 @@
 #include "VTKUtils.h"
 #include "Error.h"
 
-#include <vtkCompositeDataIterator.h>
-#include <vtkCompositeDataSet.h>
 #include <vtkDataObject.h>
 #include <vtkDataSetAttributes.h>
 #include <vtkObjectFactory.h>
-#include <vtkSmartPointer.h>
 #include <vtkUnsignedCharArray.h>
 
 #include <algorithm>
@@ -26,7 +24,8 @@ senseiNewMacro(Histogram);
 
 //-----------------------------------------------------------------------------
 Histogram::Histogram() : Bins(0),
-  Association(vtkDataObject::FIELD_ASSOCIATION_POINTS), Internals(nullptr)
+  Association(vtkDataObject::FIELD_ASSOCIATION_POINTS), NumberOfThreads(-1),
+  Internals(nullptr)
 {
 }
 
@@ -38,13 +37,15 @@ Histogram::~Histogram()
 
 //-----------------------------------------------------------------------------
 void Histogram::Initialize(int bins, const std::string &meshName,
-  int association, const std::string& arrayName, const std::string &fileName)
+  int association, const std::string& arrayName, const std::string &fileName,
+  int numThreads)
 {
   this->Bins = bins;
   this->MeshName = meshName;
   this->ArrayName = arrayName;
   this->Association = association;
   this->FileName = fileName;
+  this->NumberOfThreads = numThreads;
 }
 
 //-----------------------------------------------------------------------------
@@ -136,91 +137,47 @@ bool Histogram::Execute(DataAdaptor* data)
     return false;
     }
 
-  if (vtkCompositeDataSet* cd = dynamic_cast<vtkCompositeDataSet*>(mesh))
-    {
-    vtkSmartPointer<vtkCompositeDataIterator> iter;
-    iter.TakeReference(cd->NewIterator());
-
-    for (iter->InitTraversal(); !iter->IsDoneWithTraversal(); iter->GoToNextItem())
-      {
-      // get the local mesh
-      vtkDataObject *curObj = iter->GetCurrentDataObject();
-
-      // get the array to compute histogram for
-      vtkDataArray* array = this->GetArray(curObj, this->ArrayName);
-      if (!array)
-        {
-        SENSEI_WARNING("Dataset " << iter->GetCurrentFlatIndex()
-          << " has no array named \"" << this->ArrayName << "\"")
-        continue;
-        }
-
-      // and get the ghost cell array
-      vtkUnsignedCharArray *ghostArray = dynamic_cast<vtkUnsignedCharArray*>(
-        this->GetArray(curObj, this->GetGhostArrayName()));
-
-      // compute local histogram range
-      this->Internals->AddRange(array, ghostArray);
-      }
-
-    // compute global histogram range
-    this->Internals->PreCompute(this->GetCommunicator(), this->Bins);
+  // gather the arrays of the local blocks
+  std::vector<vtkDataObject*> blocks;
+  std::vector<long> blockIds;
+  BlockParallel::GetBlocks(mesh, blocks, &blockIds);
 
-    for (iter->InitTraversal(); !iter->IsDoneWithTraversal(); iter->GoToNextItem())
-      {
-      // get the local mesh
-      vtkDataObject *curObj = iter->GetCurrentDataObject();
-      // get the array to compute histogram for
-      vtkDataArray* array = this->GetArray(curObj, this->ArrayName);
-      if (!array)
-        {
-        SENSEI_WARNING("Dataset " << iter->GetCurrentFlatIndex()
-          << " has no array named \"" << this->ArrayName << "\"")
-        continue;
-        }
-
-      // and get the ghost cell array
-      vtkUnsignedCharArray *ghostArray = dynamic_cast<vtkUnsignedCharArray*>(
-        this->GetArray(curObj, this->GetGhostArrayName()));
-
-      // compute local histogram
-      this->Internals->Compute(array, ghostArray);
-      }
+  std::vector<vtkDataArray*> arrays;
+  std::vector<vtkUnsignedCharArray*> ghostArrays;
 
-    // compute the global histogram
-    this->Internals->PostCompute(this->GetCommunicator(), this->Bins,
-      step, time, this->MeshName, this->ArrayName, this->FileName);
-    }
-  else
+  unsigned int nBlocks = blocks.size();
+  for (unsigned int i = 0; i < nBlocks; ++i)
     {
-    vtkDataArray* array = this->GetArray(mesh, this->ArrayName);
+    // get the array to compute histogram for
+    vtkDataArray* array = this->GetArray(blocks[i], this->ArrayName);
     if (!array)
       {
-      int rank = 0;
-      MPI_Comm_rank(this->GetCommunicator(), &rank);
-
-      SENSEI_WARNING("Dataset " << rank << " has no array named \""
+      SENSEI_WARNING("Block " << blockIds[i] << " has no array named \""
         << this->ArrayName << "\"")
-
-      this->Internals->PreCompute(this->GetCommunicator(), this->Bins);
-
-      this->Internals->PostCompute(this->GetCommunicator(), this->Bins,
-        step, time, this->MeshName, this->ArrayName, this->FileName);
+      continue;
       }
-    else
-      {
-      vtkUnsignedCharArray *ghostArray = dynamic_cast<vtkUnsignedCharArray*>(
-        this->GetArray(mesh, this->GetGhostArrayName()));
 
-      this->Internals->AddRange(array, ghostArray);
-      this->Internals->PreCompute(this->GetCommunicator(), this->Bins);
-      this->Internals->Compute(array, ghostArray);
+    // and get the ghost cell array
+    vtkUnsignedCharArray *ghostArray = dynamic_cast<vtkUnsignedCharArray*>(
+      this->GetArray(blocks[i], this->GetGhostArrayName()));
 
-      this->Internals->PostCompute(this->GetCommunicator(), this->Bins,
-        step, time, this->MeshName, this->ArrayName, this->FileName);
-      }
+    arrays.push_back(array);
+    ghostArrays.push_back(ghostArray);
     }
 
+  // compute local histogram range
+  this->Internals->AddRange(arrays, ghostArrays, this->NumberOfThreads);
+
+  // compute global histogram range
+  this->Internals->PreCompute(this->GetCommunicator(), this->Bins);
+
+  // compute local histogram
+  this->Internals->Compute(arrays, ghostArrays, this->NumberOfThreads);
+
+  // compute the global histogram
+  this->Internals->PostCompute(this->GetCommunicator(), this->Bins,
+    step, time, this->MeshName, this->ArrayName, this->FileName);
+
   mesh->Delete();
   return true;
 }
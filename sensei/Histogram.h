@@ -15,6 +15,10 @@ class VTKHistogram;
 
 /// @class Histogram
 /// @brief Computes a parallel histogram
+///
+/// The local blocks are processed on numThreads threads of the global
+/// ThreadPool, all of them when numThreads is less than 1, before the
+/// results of the ranks are reduced.
 class Histogram : public AnalysisAdaptor
 {
 public:
@@ -23,7 +27,7 @@ public:
 
   void Initialize(int bins, const std::string &meshName,
     int association, const std::string& arrayName,
-    const std::string &fileName);
+    const std::string &fileName, int numThreads = -1);
 
   bool Execute(DataAdaptor* data) override;
 
@@ -48,6 +52,7 @@ protected:
   std::string ArrayName;
   int Association;
   std::string FileName;
+  int NumberOfThreads;
 
   VTKHistogram *Internals;
 
@@ -52,43 +52,70 @@ int IsoSurfacePartitioner::GetIsoValues(std::string &meshName,
 }
 
 // --------------------------------------------------------------------------
-int IsoSurfacePartitioner::GetPartition(MPI_Comm comm,
-  const MeshMetadataPtr &mdIn, MeshMetadataPtr &mdOut)
+int IsoSurfacePartitioner::GetActiveBlocks(const MeshMetadataPtr &md,
+  const std::string &arrayName, const std::vector<double> &vals,
+  std::vector<int> &activeBlocks)
 {
-  TimeEvent<128> mark("IsoSurfacePartitioner::GetPartition");
+  int nBlocks = md->BlockArrayRange.size();
 
-  // find the set of arrays and values for this mesh
-  if (this->MeshName != mdIn->MeshName)
+  // require block array ranges. the metadata describes all blocks, or in
+  // a local view only this rank's blocks
+  int nExpected = md->GlobalView ? md->NumBlocks :
+    (md->NumBlocksLocal.empty() ? -1 : md->NumBlocksLocal[0]);
+
+  if (nBlocks != nExpected)
     {
-    SENSEI_ERROR("No iso values set for mesh \"" << mdIn->MeshName << "\"")
+    SENSEI_ERROR("Block array ranges are required")
     return -1;
     }
 
-  // locate the active blocks
-  std::set<int> activeBlocks;
-  for (int i = 0; i < mdIn->NumArrays; ++i)
+  std::set<int> active;
+  for (int i = 0; i < md->NumArrays; ++i)
     {
     // see if this array is being used, if not skip it
-    const std::string &array = mdIn->ArrayName[i];
-    if (this->ArrayName != array)
+    const std::string &array = md->ArrayName[i];
+    if (arrayName != array)
       continue;
 
     // walk blocks and see if any of them are needed
-    const std::vector<double> &vals = this->IsoValues;
     int nvals = vals.size();
-    for (int j = 0; j < mdIn->NumBlocks; ++j)
+    for (int j = 0; j < nBlocks; ++j)
       {
-      std::array<double,2> &rng = mdIn->BlockArrayRange[j][i];
+      const std::array<double,2> &rng = md->BlockArrayRange[j][i];
       for (int k = 0; k < nvals; ++k)
         {
         // if the value is in the range then this block is needed
         double val = vals[k];
         if ((val >= rng[0]) && (val <= rng[1]))
-          activeBlocks.insert(j);
+          active.insert(j);
         }
       }
     }
 
+  activeBlocks.assign(active.begin(), active.end());
+
+  return 0;
+}
+
+// --------------------------------------------------------------------------
+int IsoSurfacePartitioner::GetPartition(MPI_Comm comm,
+  const MeshMetadataPtr &mdIn, MeshMetadataPtr &mdOut)
+{
+  TimeEvent<128> mark("IsoSurfacePartitioner::GetPartition");
+
+  // find the set of arrays and values for this mesh
+  if (this->MeshName != mdIn->MeshName)
+    {
+    SENSEI_ERROR("No iso values set for mesh \"" << mdIn->MeshName << "\"")
+    return -1;
+    }
+
+  // locate the active blocks
+  std::vector<int> activeBlocks;
+  if (IsoSurfacePartitioner::GetActiveBlocks(mdIn, this->ArrayName,
+    this->IsoValues, activeBlocks))
+    return -1;
+
   // partition the needed blocks to ranks equally
   int nRanks = 1;
   MPI_Comm_size(comm, &nRanks);
@@ -122,9 +149,8 @@ int IsoSurfacePartitioner::GetPartition(MPI_Comm comm,
     mdOut->BlockOwner[i] = -1;
 
   // assign the active blocks to the correct rank
-  std::set<int>::iterator bit = activeBlocks.begin();
-  for (int i = 0; i < numActiveBlocks; ++i, ++bit)
-    mdOut->BlockOwner[*bit] = activeBlockOwner[i];
+  for (int i = 0; i < numActiveBlocks; ++i)
+    mdOut->BlockOwner[activeBlocks[i]] = activeBlockOwner[i];
 
   // report the decomp
   int rank = 0;
@@ -42,6 +42,13 @@ public:
   int GetPartition(MPI_Comm comm, const sensei::MeshMetadataPtr &in,
     sensei::MeshMetadataPtr &out) override;
 
+  // get the indices, into the metadata's block arrays, of the blocks whose
+  // range of the named array includes one or more of the values.
+  // BlockArrayRange is required.
+  static int GetActiveBlocks(const sensei::MeshMetadataPtr &md,
+    const std::string &arrayName, const std::vector<double> &vals,
+    std::vector<int> &activeBlocks);
+
 protected:
   IsoSurfacePartitioner() = default;
   IsoSurfacePartitioner(const IsoSurfacePartitioner &) = default;
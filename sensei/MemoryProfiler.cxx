@@ -42,7 +42,7 @@
 #include <string.h>
 
 #include <vector>
-#include <deque>
+#include <algorithm>
 #include <sstream>
 #include <sys/time.h>
 #include <cstring>
@@ -191,11 +191,20 @@ int GetFieldsFromCommand(const char* command, const char** field_names,
 namespace sensei
 {
 
+// a time stamped memory use sample
+struct MemorySample
+{
+  double Time;
+  long long Mem;
+};
+
 // intrernal data used by the memory profiler
 struct MemoryProfiler::InternalsType
 {
   InternalsType() : Comm(MPI_COMM_WORLD), Filename("mem_prof.csv"),
-    Interval(60.0), DataMutex(PTHREAD_MUTEX_INITIALIZER),
+    Interval(60.0), BufferSize(65536), NextSample(0), NumSamples(0),
+    NumDropped(0), Stop(false), DataMutex(PTHREAD_MUTEX_INITIALIZER),
+    StopCond(PTHREAD_COND_INITIALIZER),
     TotalVirtualMemory(0), AvailableVirtualMemory(0),
     TotalPhysicalMemory(0), AvailablePhysicalMemory(0)
       {}
@@ -237,17 +246,21 @@ struct MemoryProfiler::InternalsType
     const char* host_limit_env_var_name,
     const char* proc_limit_env_var_name);
 
-  // Get system RAM used by the process associated with the given
-  // process id in units of KiB.
-  long long GetProcMemoryUsed();
+  // allocate the sample buffer and reset the counters
+  void InitializeSamples();
 
   MPI_Comm Comm;
   std::string Filename;
   double Interval;
-  std::deque<long long> MemUse;
-  std::deque<double> TimePt;
+  std::vector<MemorySample> Samples;
+  long BufferSize;
+  long NextSample;
+  long NumSamples;
+  long long NumDropped;
+  bool Stop;
   pthread_t Thread;
   pthread_mutex_t DataMutex;
+  pthread_cond_t StopCond;
   long long TotalVirtualMemory;
   long long AvailableVirtualMemory;
   long long TotalPhysicalMemory;
@@ -269,6 +282,8 @@ MemoryProfiler::~MemoryProfiler()
 // --------------------------------------------------------------------------
 int MemoryProfiler::Initialize()
 {
+  this->Internals->InitializeSamples();
+
   if (pthread_create(&this->Internals->Thread,
     nullptr, profile, this->Internals))
     {
@@ -296,10 +311,14 @@ int MemoryProfiler::Finalize()
     MPI_Comm_size(this->Internals->Comm, &n_ranks);
     }
 
+  // tell the thread to quit, waking it if it is between samples, and wait
+  // for it to finish before the buffer is touched
   pthread_mutex_lock(&this->Internals->DataMutex);
+  this->Internals->Stop = true;
+  pthread_cond_signal(&this->Internals->StopCond);
+  pthread_mutex_unlock(&this->Internals->DataMutex);
 
-  // tell the thread to quit
-  this->Internals->Interval = -1;
+  pthread_join(this->Internals->Thread, nullptr);
 
   // create the ascii buffer
   // use ascii in the file as a convenince
@@ -310,21 +329,28 @@ int MemoryProfiler::Finalize()
   if (rank == 0)
     oss << "# rank, time, memory kiB" << std::endl;
 
-  long n_elem = this->Internals->MemUse.size();
+  // the ring buffer is written oldest sample first
+  long n_elem = this->Internals->NumSamples;
+  long n_buf = this->Internals->Samples.size();
+  long first = this->Internals->NextSample - n_elem + n_buf;
   for (long i = 0; i < n_elem; ++i)
     {
-    oss << rank << ", " << this->Internals->TimePt[i]
-      << ", " << this->Internals->MemUse[i] << std::endl;
+    const MemorySample &sample = this->Internals->Samples[(first + i) % n_buf];
+    oss << rank << ", " << sample.Time << ", " << sample.Mem << std::endl;
     }
 
+  long long n_dropped = this->Internals->NumDropped;
+
   // free resources
-  this->Internals->TimePt.clear();
-  this->Internals->MemUse.clear();
+  this->Internals->Samples = std::vector<MemorySample>();
+  this->Internals->NumSamples = 0;
+  this->Internals->NextSample = 0;
 
-  pthread_mutex_unlock(&this->Internals->DataMutex);
 
-  // cancle the profiler thread
-  pthread_cancel(this->Internals->Thread);
+  if (n_dropped)
+    SENSEI_WARNING("The memory profiler buffer overflowed, the oldest "
+      << n_dropped << " samples were overwritten. Increase the buffer size"
+      " or the sampling interval to keep them")
 
   // compute the file offset
   long n_bytes = oss.str().size();
@@ -382,12 +408,103 @@ int MemoryProfiler::Finalize()
     fclose(fh);
     }
 
-  // wait for the proiler thread to finish
-  pthread_join(this->Internals->Thread, nullptr);
-
   return 0;
 }
 
+// --------------------------------------------------------------------------
+void MemoryProfiler::SetBufferSize(long nSamples)
+{
+  pthread_mutex_lock(&this->Internals->DataMutex);
+  this->Internals->BufferSize = std::max(1l, nSamples);
+  pthread_mutex_unlock(&this->Internals->DataMutex);
+}
+
+// --------------------------------------------------------------------------
+long MemoryProfiler::GetBufferSize() const
+{
+  return this->Internals->BufferSize;
+}
+
+// --------------------------------------------------------------------------
+long long MemoryProfiler::GetPeakMemoryUsed(double t0, double t1)
+{
+  long long peak = -1;
+
+  pthread_mutex_lock(&this->Internals->DataMutex);
+
+  // walk back from the newest sample. samples are in time order so the
+  // walk stops at the first sample taken before t0
+  long n_elem = this->Internals->NumSamples;
+  long n_buf = this->Internals->Samples.size();
+  long last = this->Internals->NextSample - 1 + n_buf;
+  for (long i = 0; i < n_elem; ++i)
+    {
+    const MemorySample &sample = this->Internals->Samples[(last - i) % n_buf];
+
+    if (sample.Time < t0)
+      break;
+
+    if (sample.Time <= t1)
+      peak = std::max(peak, sample.Mem);
+    }
+
+  pthread_mutex_unlock(&this->Internals->DataMutex);
+
+  return peak;
+}
+
+// --------------------------------------------------------------------------
+long long MemoryProfiler::GetCurrentMemoryUsed()
+{
+#if defined(__linux)
+  // the second field of statm is the resident set size in pages. the file
+  // is opened once and re-read in place, this is a single system call and
+  // avoids the stdio and string handling needed to parse /proc/self/status
+  static const int fd = open("/proc/self/statm", O_RDONLY);
+  static const long long page_kib = sysconf(_SC_PAGESIZE) / 1024;
+
+  char buf[128];
+  ssize_t n_read = -1;
+  if ((fd >= 0) && ((n_read = pread(fd, buf, sizeof(buf) - 1, 0)) > 0))
+    {
+    buf[n_read] = '\0';
+    char *p = buf;
+    strtoll(p, &p, 10);
+    long long n_pages = strtoll(p, nullptr, 10);
+    return n_pages * page_kib;
+    }
+#elif defined(__APPLE__)
+  mach_task_basic_info_data_t info;
+  mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+  if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO,
+    (task_info_t)&info, &count) == KERN_SUCCESS)
+    return info.resident_size / 1024;
+#endif
+#if !defined(_WIN32)
+  // the high water mark is the best that is available here
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) == 0)
+#if defined(__APPLE__)
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+#endif
+  return -1;
+}
+
+// --------------------------------------------------------------------------
+void MemoryProfiler::InternalsType::InitializeSamples()
+{
+  pthread_mutex_lock(&this->DataMutex);
+  this->Samples.resize(this->BufferSize);
+  this->NextSample = 0;
+  this->NumSamples = 0;
+  this->NumDropped = 0;
+  this->Stop = false;
+  pthread_mutex_unlock(&this->DataMutex);
+}
+
 // --------------------------------------------------------------------------
 double MemoryProfiler::GetInterval() const
 {
@@ -618,68 +735,6 @@ long long MemoryProfiler::InternalsType::GetHostMemoryUsed()
 #endif
 }
 
-// --------------------------------------------------------------------------
-long long MemoryProfiler::InternalsType::GetProcMemoryUsed()
-{
-#if defined(_WIN32) && defined(KWSYS_SYS_HAS_PSAPI)
-  long pid = get_current_process_id();
-  HANDLE h_proc;
-  h_proc = open_process(PROCESS_QUERY_INFORMATION | PROCESS_VM_READ, false, pid);
-  if (h_proc == 0)
-    {
-    return -1;
-    }
-  PROCESS_MEMORY_COUNTERS pmc;
-  int ok = get_process_memory_info(h_proc, &pmc, sizeof(pmc));
-  close_handle(h_proc);
-  if (!ok)
-    {
-    return -2;
-    }
-  return pmc.working_set_size / 1024;
-#elif defined(__linux)
-  long long mem_used = 0;
-  int ierr = getFieldFromFile("/proc/self/status", "VmRSS:", mem_used);
-  if (ierr)
-    return -1;
-  return mem_used;
-#elif defined(__APPLE__)
-  long long mem_used = 0;
-  pid_t pid = getpid();
-  std::ostringstream oss;
-  oss << "ps -o rss= -p " << pid;
-  FILE* file = popen(oss.str().c_str(), "r");
-  if (file == 0)
-    {
-    return -1;
-    }
-  oss.str("");
-  while (!feof(file) && !ferror(file))
-    {
-    char buf[256] = { '\0' };
-    errno = 0;
-    long long n_read = fread(buf, 1, 256, file);
-
-    if (ferror(file) && (errno == EINTR))
-      clearerr(file);
-
-    if (n_read)
-      oss << buf;
-    }
-  int ierr = ferror(file);
-  pclose(file);
-  if (ierr)
-    return -2;
-
-  std::istringstream iss(oss.str());
-  iss >> mem_used;
-
-  return mem_used;
-#else
-  return 0;
-#endif
-}
-
 // --------------------------------------------------------------------------
 int MemoryProfiler::InternalsType::InitializeWindowsMemory()
 {
@@ -934,37 +989,57 @@ extern "C" void *profile(void *argp)
     gettimeofday(&tv, nullptr);
 
     double cur_time = tv.tv_sec + tv.tv_usec/1.0e6;
-    long long cur_mem = internals->GetProcMemoryUsed();
+    long long cur_mem = sensei::MemoryProfiler::GetCurrentMemoryUsed();
 
     pthread_mutex_lock(&internals->DataMutex);
 
-    // log time and mem use
-    internals->TimePt.push_back(cur_time);
-    internals->MemUse.push_back(cur_mem);
+    // check for shut down, the buffer is released after the thread exits
+    long n_buf = internals->Samples.size();
+    if (internals->Stop || (n_buf == 0))
+      {
+      pthread_mutex_unlock(&internals->DataMutex);
+      break;
+      }
+
+    // log time and mem use. when the buffer is full the oldest sample
+    // is overwritten
+    long next = internals->NextSample;
 
-    // get next interval
-    double interval = internals->Interval;
+    internals->Samples[next].Time = cur_time;
+    internals->Samples[next].Mem = cur_mem;
 
-    pthread_mutex_unlock(&internals->DataMutex);
+    internals->NextSample = (next + 1) % n_buf;
 
-    // check for shut down code
-    if (interval < 0)
-      pthread_exit(nullptr);
+    if (internals->NumSamples < n_buf)
+      internals->NumSamples += 1;
+    else
+      internals->NumDropped += 1;
+
+    // suspend the thread for the requested interval, or until Finalize
+    // wakes it
+    double interval = std::max(0.0, internals->Interval);
+    double wake = cur_time + interval;
 
-    // suspend the thread for the requested interval
-    long long secs = floor(interval);
-    long nsecs = (interval - secs)*1e9;
-    struct timespec sleep_time = {secs, nsecs};
+    struct timespec wake_time;
+    wake_time.tv_sec = floor(wake);
+    wake_time.tv_nsec = (wake - wake_time.tv_sec)*1e9;
 
     int ierr = 0;
-    int tries = 0;
-    while ((ierr = nanosleep(&sleep_time, &sleep_time)) && (errno == EINTR) && (++tries < 1000));
-    if (ierr)
+    while (!internals->Stop && (ierr != ETIMEDOUT))
       {
-      const char *estr = strerror(errno);
-      SENSEI_ERROR("Error: nanosleep had an error \"" << estr << "\"")
-      abort();
+      ierr = pthread_cond_timedwait(&internals->StopCond,
+        &internals->DataMutex, &wake_time);
+
+      if (ierr && (ierr != ETIMEDOUT))
+        {
+        const char *estr = strerror(ierr);
+        SENSEI_ERROR("Error: pthread_cond_timedwait had an error \""
+          << estr << "\"")
+        abort();
+        }
       }
+
+    pthread_mutex_unlock(&internals->DataMutex);
     }
 
   return nullptr;
@@ -17,6 +17,10 @@ given in seconds. For each sample the time is aquired. Calling
 Initialize starts profiling, and Finalize ends it. During
 Finaliziation the buffers are written using MPI-I/O to the
 file name provided
+
+Samples are stored in a fixed size ring buffer allocated by Initialize,
+so that sampling does not allocate. When the buffer fills the oldest
+samples are overwritten and a warning is issued during Finalize.
 */
 class MemoryProfiler
 {
@@ -36,6 +40,21 @@ public:
   void SetInterval(double interval);
   double GetInterval() const;
 
+  // Set the number of samples kept. Takes effect at Initialize.
+  // default value: 65536
+  void SetBufferSize(long nSamples);
+  long GetBufferSize() const;
+
+  // Get the largest memory use in KiB sampled in the time interval
+  // [t0, t1], or -1 if there are no samples in the interval. Times are
+  // seconds since the epoch.
+  long long GetPeakMemoryUsed(double t0, double t1);
+
+  // Get the resident set size of the calling process in KiB. This is
+  // cheap enough to call at the start and end of profiled events. Where
+  // the current value is not available the high water mark is returned.
+  static long long GetCurrentMemoryUsed();
+
   // Set the comunicator for parallel I/O
   void SetCommunicator(MPI_Comm comm);
 
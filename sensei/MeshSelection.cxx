@@ -0,0 +1,168 @@
+#include "MeshSelection.h"
+#include "STLUtils.h"
+#include "Error.h"
+
+#include <algorithm>
+
+namespace
+{
+// integer division rounding toward negative and positive infinity
+int floorDiv(int a, int b)
+{
+  return a/b - ((a % b) && ((a < 0) != (b < 0)));
+}
+
+int ceilDiv(int a, int b)
+{
+  return a/b + ((a % b) && ((a < 0) == (b < 0)));
+}
+}
+
+namespace sensei
+{
+// for various operator<< overloads
+using namespace STLUtils;
+
+// --------------------------------------------------------------------------
+void MeshSelection::SetBlockIds(const std::vector<int> &ids)
+{
+  this->Flags |= BLOCKS;
+  this->BlockIds = ids;
+
+  // sorted for fast look up
+  std::sort(this->BlockIds.begin(), this->BlockIds.end());
+}
+
+// --------------------------------------------------------------------------
+void MeshSelection::SetStride(const std::array<int,3> &stride)
+{
+  this->Flags |= STRIDE;
+  for (int i = 0; i < 3; ++i)
+    this->Stride[i] = std::max(1, stride[i]);
+}
+
+// --------------------------------------------------------------------------
+bool MeshSelection::SelectBlock(int blockId, const double *blockBounds) const
+{
+  if ((this->Flags & BLOCKS) && !std::binary_search(this->BlockIds.begin(),
+    this->BlockIds.end(), blockId))
+    return false;
+
+  if ((this->Flags & BOUNDS) && blockBounds)
+    {
+    for (int i = 0; i < 3; ++i)
+      {
+      if ((blockBounds[2*i] > this->Bounds[2*i+1]) ||
+        (blockBounds[2*i+1] < this->Bounds[2*i]))
+        return false;
+      }
+    }
+
+  return true;
+}
+
+// --------------------------------------------------------------------------
+int MeshSelection::GetSelectedBlocks(const sensei::MeshMetadataPtr &md,
+  std::vector<int> &ids) const
+{
+  ids.clear();
+
+  unsigned int nBlocks = md->BlockIds.size();
+  if (!nBlocks && (md->GlobalView ? md->NumBlocks :
+    (md->NumBlocksLocal.empty() ? 0 : md->NumBlocksLocal[0])))
+    {
+    SENSEI_ERROR("Block ids are required")
+    return -1;
+    }
+
+  bool haveBounds = md->BlockBounds.size() == nBlocks;
+  bool haveExtents = md->BlockExtents.size() == nBlocks;
+
+  for (unsigned int i = 0; i < nBlocks; ++i)
+    {
+    if (!this->SelectBlock(md->BlockIds[i],
+      haveBounds ? md->BlockBounds[i].data() : nullptr))
+      continue;
+
+    int cellExt[6];
+    if ((this->Flags & EXTENT) && haveExtents &&
+      !this->GetCellExtent(md->BlockExtents[i].data(), cellExt))
+      continue;
+
+    ids.push_back(md->BlockIds[i]);
+    }
+
+  return 0;
+}
+
+// --------------------------------------------------------------------------
+bool MeshSelection::GetCellExtent(const int *blockExt, int *cellExt) const
+{
+  for (int i = 0; i < 3; ++i)
+    {
+    int lo = blockExt[2*i];
+    int hi = blockExt[2*i+1];
+
+    if (this->Flags & EXTENT)
+      {
+      lo = std::max(lo, this->Extent[2*i]);
+      hi = std::min(hi, this->Extent[2*i+1]);
+      }
+
+    // snap to the lattice of strided cells
+    int s = this->Stride[i];
+    int b = this->GetStrideBase(i);
+
+    lo = b + s*ceilDiv(lo - b, s);
+    hi = b + s*floorDiv(hi - b, s);
+
+    if (lo > hi)
+      return false;
+
+    cellExt[2*i] = lo;
+    cellExt[2*i+1] = hi;
+    }
+
+  return true;
+}
+
+// --------------------------------------------------------------------------
+void MeshSelection::GetCoarseExtent(const int *cellExt, int *coarseExt) const
+{
+  for (int i = 0; i < 3; ++i)
+    {
+    int s = this->Stride[i];
+    int b = this->GetStrideBase(i);
+    coarseExt[2*i] = floorDiv(cellExt[2*i] - b, s);
+    coarseExt[2*i+1] = floorDiv(cellExt[2*i+1] - b, s);
+    }
+}
+
+// --------------------------------------------------------------------------
+void MeshSelection::GetCoarseGeometry(const double *origin,
+  const double *spacing, double *coarseOrigin, double *coarseSpacing) const
+{
+  for (int i = 0; i < 3; ++i)
+    {
+    coarseOrigin[i] = origin[i] + spacing[i]*this->GetStrideBase(i);
+    coarseSpacing[i] = spacing[i]*this->Stride[i];
+    }
+}
+
+// --------------------------------------------------------------------------
+int MeshSelection::ToStream(ostream &str) const
+{
+  str << "{";
+  if (this->Flags & BLOCKS)
+    str << "BlockIds = " << this->BlockIds << std::endl;
+  if (this->Flags & BOUNDS)
+    str << "Bounds = " << this->Bounds << std::endl;
+  if (this->Flags & EXTENT)
+    str << "Extent = " << this->Extent << std::endl;
+  if (this->Flags & STRIDE)
+    str << "Stride = " << this->Stride << std::endl;
+  str << "}";
+  return 0;
+}
+
+}
@@ -0,0 +1,118 @@
+#ifndef MeshSelection_h
+#define MeshSelection_h
+
+#include "MeshMetadata.h"
+
+#include <ostream>
+#include <vector>
+#include <array>
+
+namespace sensei
+{
+/// Describes the part of a mesh that an analysis needs. Passed to the
+/// DataAdaptor::GetMesh and DataAdaptor::AddArray overloads that take a
+/// selection so that adaptors can avoid generating, reading, or moving data
+/// no one will look at. A default constructed selection selects the entire
+/// mesh. Blocks are selected by id and/or by a bounding box, a block is
+/// selected when it passes all of the tests that are set. For Cartesian
+/// meshes the cells of the selected blocks may be further restricted to a
+/// sub-extent of the global cell index space and/or sampled with a stride.
+///
+/// Honoring a selection is optional. Adaptors may return more than was
+/// selected, and analyses must be prepared to receive it.
+class MeshSelection
+{
+public:
+  MeshSelection() : Flags(0), BlockIds(), Bounds{}, Extent{},
+    Stride{1,1,1} {}
+
+  // set, clear, or get the ids of the selected blocks. ids are those
+  // reported in MeshMetadata::BlockIds.
+  void SetBlockIds(const std::vector<int> &ids);
+  void ClearBlockIds(){ Flags &= ~BLOCKS; BlockIds.clear(); }
+  bool BlockIdsSet() const { return Flags & BLOCKS; }
+  const std::vector<int> &GetBlockIds() const { return BlockIds; }
+
+  // set, clear, or get an axis aligned box [x0,x1, y0,y1, z0,z1]. the
+  // blocks that intersect it are selected.
+  void SetBounds(const std::array<double,6> &bounds)
+  { Flags |= BOUNDS; Bounds = bounds; }
+  void ClearBounds(){ Flags &= ~BOUNDS; }
+  bool BoundsSet() const { return Flags & BOUNDS; }
+  const std::array<double,6> &GetBounds() const { return Bounds; }
+
+  // set, clear, or get a sub-extent [i0,i1, j0,j1, k0,k1] of the global
+  // cell index space (Cartesian). the blocks that intersect it are
+  // selected, and only the cells inside of it are needed.
+  void SetExtent(const std::array<int,6> &ext)
+  { Flags |= EXTENT; Extent = ext; }
+  void ClearExtent(){ Flags &= ~EXTENT; }
+  bool ExtentSet() const { return Flags & EXTENT; }
+  const std::array<int,6> &GetExtent() const { return Extent; }
+
+  // set, clear, or get the stride (Cartesian). only every stride'th cell
+  // in each direction, counting from the lower corner of the extent or
+  // the origin of the index space, is needed.
+  void SetStride(const std::array<int,3> &stride);
+  void ClearStride(){ Flags &= ~STRIDE; Stride = {1,1,1}; }
+  bool StrideSet() const { return Flags & STRIDE; }
+  const std::array<int,3> &GetStride() const { return Stride; }
+
+  // clear the selection, selecting the entire mesh
+  void Clear(){ *this = MeshSelection(); }
+
+  // returns true if the entire mesh is selected
+  bool Empty() const { return Flags == 0; }
+
+  // returns true if blocks are selected by id or by bounds
+  bool BlocksSelected() const { return Flags & (BLOCKS|BOUNDS); }
+
+  // returns true if the cells of Cartesian blocks are selected by extent
+  // or by stride
+  bool CellsSelected() const { return Flags & (EXTENT|STRIDE); }
+
+  // returns true if the block passes the id and bounds tests. bounds may
+  // be null in which case the bounds test is skipped.
+  bool SelectBlock(int blockId, const double *blockBounds) const;
+
+  // resolve the block selection into the ids of the selected blocks in the
+  // metadata. the metadata must have block ids, and when bounds or an
+  // extent are set, block bounds or block extents respectively. when the
+  // latter are not available the corresponding test is skipped.
+  int GetSelectedBlocks(const sensei::MeshMetadataPtr &md,
+    std::vector<int> &ids) const;
+
+  // given the cell extent of a Cartesian block, get the first and last
+  // selected cells in each direction. returns false if no cell of the
+  // block is selected.
+  bool GetCellExtent(const int *blockExt, int *cellExt) const;
+
+  // given the first and last selected cells, as computed by GetCellExtent,
+  // get the cell extent in the coarsened index space, where cell n is
+  // selected cell n*stride. together with the coarsened origin and spacing
+  // this places the blocks of a strided mesh consistently.
+  void GetCoarseExtent(const int *cellExt, int *coarseExt) const;
+
+  void GetCoarseGeometry(const double *origin, const double *spacing,
+    double *coarseOrigin, double *coarseSpacing) const;
+
+  int ToStream(ostream &str) const;
+
+private:
+  // lower corner of the lattice of cells selected by the stride
+  int GetStrideBase(int i) const
+  { return (Flags & EXTENT) ? Extent[2*i] : 0; }
+
+  long long Flags;
+  std::vector<int> BlockIds;      // sorted ids of the selected blocks
+  std::array<double,6> Bounds;    // box selecting blocks
+  std::array<int,6> Extent;       // global cell index space sub-extent
+  std::array<int,3> Stride;       // cell stride in each direction
+
+  // flag values
+  enum { BLOCKS = 0x1, BOUNDS = 0x2, EXTENT = 0x4, STRIDE = 0x8 };
+};
+
+}
+
+#endif
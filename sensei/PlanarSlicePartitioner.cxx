@@ -36,26 +36,29 @@ int PlanarSlicePartitioner::Initialize(pugi::xml_node &node)
 }
 
 // --------------------------------------------------------------------------
-int PlanarSlicePartitioner::GetPartition(MPI_Comm comm,
-  const MeshMetadataPtr &mdIn, MeshMetadataPtr &mdOut)
+int PlanarSlicePartitioner::GetActiveBlocks(const MeshMetadataPtr &md,
+  const std::array<double,3> &point, const std::array<double,3> &normal,
+  std::vector<int> &activeBlocks)
 {
-  TimeEvent<128>("PlanarSlicePartitioner::GetPartition");
+  int nBlocks = md->BlockBounds.size();
 
-  // require block bounds
-  if (mdIn->BlockBounds.size() != static_cast<unsigned int>(mdIn->NumBlocks))
+  // require block bounds. the metadata describes all blocks, or in
+  // a local view only this rank's blocks
+  int nExpected = md->GlobalView ? md->NumBlocks :
+    (md->NumBlocksLocal.empty() ? -1 : md->NumBlocksLocal[0]);
+
+  if (nBlocks != nExpected)
     {
     SENSEI_ERROR("Block bounds are required")
     return -1;
     }
 
-  // build the list of active blocks
-  std::vector<int> activeBlocks;
-  for (int i = 0; i < mdIn->NumBlocks; ++i)
+  for (int i = 0; i < nBlocks; ++i)
     {
     // compute the distance from  each corner of the block bounding box
     // to the plane. if the block intersects the plane, at least one
     // corner will have a different sign.
-    const std::array<double,6> &bounds = mdIn->BlockBounds[i];
+    const std::array<double,6> &bounds = md->BlockBounds[i];
 
     // triplets defining corner points
     int pt_ids[] = {0,2,4, 0,3,4, 1,3,4, 1,2,4,
@@ -68,7 +71,7 @@ int PlanarSlicePartitioner::GetPartition(MPI_Comm comm,
       {
       double d = 0.0;
       for (int j = 0; j < 3; ++j)
-        d += this->Normal[j] * (bounds[pt_ids[q*3 + j]] - this->Point[j]);
+        d += normal[j] * (bounds[pt_ids[q*3 + j]] - point[j]);
 
       min_d = std::min(min_d, d);
       max_d = std::max(max_d, d);
@@ -81,6 +84,21 @@ int PlanarSlicePartitioner::GetPartition(MPI_Comm comm,
       }
     }
 
+  return 0;
+}
+
+// --------------------------------------------------------------------------
+int PlanarSlicePartitioner::GetPartition(MPI_Comm comm,
+  const MeshMetadataPtr &mdIn, MeshMetadataPtr &mdOut)
+{
+  TimeEvent<128>("PlanarSlicePartitioner::GetPartition");
+
+  // build the list of active blocks
+  std::vector<int> activeBlocks;
+  if (PlanarSlicePartitioner::GetActiveBlocks(mdIn, this->Point,
+    this->Normal, activeBlocks))
+    return -1;
+
   // partition the remaining blocks to ranks equally
   int nRanks = 1;
   MPI_Comm_size(comm, &nRanks);
@@ -3,6 +3,7 @@
 
 #include "Partitioner.h"
 #include <array>
+#include <vector>
 
 namespace sensei
 {
@@ -39,6 +40,12 @@ public:
   int GetPartition(MPI_Comm comm, const sensei::MeshMetadataPtr &in,
     sensei::MeshMetadataPtr &out) override;
 
+  // get the indices, into the metadata's block arrays, of the blocks that
+  // intersect the plane. BlockBounds are required.
+  static int GetActiveBlocks(const sensei::MeshMetadataPtr &md,
+    const std::array<double,3> &point, const std::array<double,3> &normal,
+    std::vector<int> &activeBlocks);
+
 protected:
   PlanarSlicePartitioner() : Point{0.,0.,0.}, Normal{1.,0.,0.} {}
   PlanarSlicePartitioner(const PlanarSlicePartitioner &) = default;
@@ -1,5 +1,6 @@
 #include "Profiler.h"
 #include "MemoryProfiler.h"
+#include "HardwareCounters.h"
 #include "Error.h"
 
 #include <sys/time.h>
@@ -18,6 +19,8 @@
 #include <vector>
 #include <iomanip>
 #include <limits>
+#include <algorithm>
+#include <cmath>
 #include <unordered_map>
 #include <mutex>
 
@@ -33,6 +36,11 @@ struct Event
   // serializes the Event in CSV format into the stream.
   void ToStream(std::ostream &str) const;
 
+  // serializes the Event as a Chrome trace complete event into the stream.
+  // times are written in microseconds since origin.
+  void ToChromeTrace(std::ostream &str, int rank, int track,
+    double origin) const;
+
   enum { START=0, END=1, DELTA=2 }; // record fields
 
   // user provided identifier for the record
@@ -50,6 +58,15 @@ struct Event
   // how deep is the Event stack
   int Depth;
 
+  // resident set size in KiB at the start and end of the Event, and the
+  // largest seen during it. recorded only with memory attribution enabled
+  long long MemStart;
+  long long MemEnd;
+  long long MemPeak;
+
+  // hardware counter values. recorded only with hardware counters enabled
+  long long Counters[sensei::HardwareCounters::MaxCounters];
+
   // the thread id that generated the Event
   std::thread::id Tid;
 };
@@ -64,6 +81,15 @@ static int loggingEnabled = 0x00;
 
 static std::string timerLogFile = "timer.csv";
 
+// the format of the timer log. 0 CSV, 1 Chrome trace event JSON
+static int timerLogFormat = 0;
+
+// Chrome trace state. event times are relative to the origin, and each
+// thread is given a small integer track id
+static double traceOrigin = -1.0;
+static std::map<std::thread::id, int> traceTracks;
+static int traceProcessNamed = 0;
+
 using eventLogType = std::list<impl::Event>;
 using threadMapType = std::unordered_map<std::thread::id, eventLogType>;
 
@@ -85,8 +111,11 @@ static double getSystemTime()
 
 // --------------------------------------------------------------------------
 Event::Event() : Time{0,0,0}, NumBytes(-1ll), Depth(0),
+  MemStart(-1ll), MemEnd(-1ll), MemPeak(-1ll),
   Tid(std::this_thread::get_id())
 {
+  for (int i = 0; i < sensei::HardwareCounters::MaxCounters; ++i)
+    this->Counters[i] = -1ll;
 }
 
 //-----------------------------------------------------------------------------
@@ -104,11 +133,537 @@ void Event::ToStream(std::ostream &str) const
   str << rank << ", " << this->Tid << ", \"" << this->Name << "\", "
     << this->Time[START] << ", " << this->Time[END] << ", "
     << this->Time[DELTA] << ", " << this->NumBytes  << ", "
-    << this->Depth << std::endl;
+    << this->Depth;
+
+  if (loggingEnabled & 0x08)
+    str << ", " << this->MemStart << ", " << this->MemEnd << ", "
+      << this->MemEnd - this->MemStart << ", " << this->MemPeak;
+
+  if (loggingEnabled & 0x10)
+    {
+    int nCounters = sensei::HardwareCounters::GetNumberOfCounters();
+    for (int i = 0; i < nCounters; ++i)
+      str << ", " << this->Counters[i];
+    }
+
+  str << std::endl;
 #else
   (void)str;
 #endif
 }
+
+// --------------------------------------------------------------------------
+// write the string as a JSON string literal
+static void jsonString(std::ostream &str, const std::string &s)
+{
+  str << '"';
+  size_t n = s.size();
+  for (size_t i = 0; i < n; ++i)
+    {
+    char c = s[i];
+    if ((c == '"') || (c == '\\'))
+      {
+      str << '\\' << c;
+      }
+    else if ((unsigned char)c < 0x20)
+      {
+      char buf[8];
+      snprintf(buf, sizeof(buf), "\\u%04x", (unsigned int)c);
+      str << buf;
+      }
+    else
+      {
+      str << c;
+      }
+    }
+  str << '"';
+}
+
+//-----------------------------------------------------------------------------
+void Event::ToChromeTrace(std::ostream &str, int rank, int track,
+  double origin) const
+{
+  str << "{\"name\":";
+  jsonString(str, this->Name);
+  str << ",\"cat\":\"sensei\",\"ph\":\"X\",\"pid\":" << rank
+    << ",\"tid\":" << track << ",\"ts\":" << (this->Time[START] - origin)*1.0e6
+    << ",\"dur\":" << this->Time[DELTA]*1.0e6 << ",\"args\":{\"depth\":"
+    << this->Depth;
+
+  if (this->NumBytes >= 0)
+    str << ",\"bytes\":" << this->NumBytes;
+
+  if (loggingEnabled & 0x08)
+    str << ",\"rss start kiB\":" << this->MemStart << ",\"rss end kiB\":"
+      << this->MemEnd << ",\"rss peak kiB\":" << this->MemPeak;
+
+  if (loggingEnabled & 0x10)
+    {
+    int nCounters = sensei::HardwareCounters::GetNumberOfCounters();
+    for (int i = 0; i < nCounters; ++i)
+      str << ",\"" << sensei::HardwareCounters::GetCounterName(i) << "\":"
+        << this->Counters[i];
+    }
+
+  str << "}},\n";
+}
+
+// --------------------------------------------------------------------------
+// serialize the logged events in Chrome trace event format. each rank is a
+// process and each thread is a track within it. process and thread names
+// are written the first time a rank or thread is seen.
+static void chromeTraceToStream(std::ostream &str, int rank)
+{
+  str.setf(std::ios::fixed, std::ios::floatfield);
+  str.precision(3);
+
+  if (!traceProcessNamed)
+    {
+    str << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << rank
+      << ",\"args\":{\"name\":\"rank " << rank << "\"}},\n"
+      << "{\"name\":\"process_sort_index\",\"ph\":\"M\",\"pid\":" << rank
+      << ",\"args\":{\"sort_index\":" << rank << "}},\n";
+    traceProcessNamed = 1;
+    }
+
+  eventLogType::iterator iter = eventLog.begin();
+  eventLogType::iterator end = eventLog.end();
+
+  // events logged before a time origin is established are relative to
+  // the first of them
+  if (traceOrigin < 0.0)
+    {
+    traceOrigin = std::numeric_limits<double>::max();
+    for (; iter != end; ++iter)
+      traceOrigin = std::min(traceOrigin, iter->Time[Event::START]);
+    iter = eventLog.begin();
+    }
+
+  for (; iter != end; ++iter)
+    {
+    std::map<std::thread::id, int>::iterator tit = traceTracks.find(iter->Tid);
+    if (tit == traceTracks.end())
+      {
+      int track = traceTracks.size();
+      tit = traceTracks.insert(std::make_pair(iter->Tid, track)).first;
+
+      std::ostringstream tname;
+      tname << "thread " << track << " (" << iter->Tid << ")";
+
+      str << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << rank
+        << ",\"tid\":" << track << ",\"args\":{\"name\":";
+      jsonString(str, tname.str());
+      str << "}},\n";
+      }
+
+    iter->ToChromeTrace(str, rank, tit->second, traceOrigin);
+    }
+}
+
+// --------------------------------------------------------------------------
+// running statistics of the duration of a named event. see summary mode.
+struct EventSummary
+{
+  EventSummary();
+
+  // add an event's duration using Welford's algorithm
+  void Update(double dt, long long nBytes);
+
+  // add an event's change in memory use and peak memory use
+  void UpdateMemory(long long memDelta, long long memPeak);
+
+  // add an event's hardware counter values
+  void UpdateCounters(const long long *counters, int nCounters);
+
+  // combine with statistics from another rank
+  void Merge(const EventSummary &other);
+
+  // initialize the cross rank statistics from this rank's
+  void InitializeRankStatistics(int rank);
+
+  // serialize/deserialize the statistics for communication
+  void Pack(const std::string &name, std::vector<char> &buf) const;
+  static size_t Unpack(const char *buf, std::string &name, EventSummary &es);
+
+  // serializes the summary in CSV format into the stream.
+  void ToStream(std::ostream &str, const std::string &name,
+    int flush, long step) const;
+
+  long long Count;
+  double Total;
+  double Min;
+  double Max;
+  double Mean;
+  double M2;
+  long long NumBytes;
+
+  // cross rank statistics of the per rank total time
+  double RankMin;
+  double RankMax;
+  double RankSum;
+  int SlowestRank;
+  int NumRanks;
+
+  // largest change in and peak of memory use in KiB
+  long long MemDeltaMax;
+  long long MemPeakMax;
+
+  // hardware counter totals, -1 where not available
+  std::vector<long long> Counters;
+
+  // counts of durations in power of 2 microsecond bins
+  std::vector<long long> Histogram;
+};
+
+static const int summaryHistogramBins = 32;
+
+using summaryMapType = std::map<std::string, impl::EventSummary>;
+
+static summaryMapType eventSummary;
+static std::string summaryLogFile = "timer_summary.csv";
+static int summaryInterval = 0;
+static int summaryHistogram = 0;
+static long stepCount = 0;
+static int summaryFlushCount = 0;
+
+// comma separated list of hardware counters, empty for the default set
+static std::string counterNames;
+
+// --------------------------------------------------------------------------
+EventSummary::EventSummary() : Count(0), Total(0.0),
+  Min(std::numeric_limits<double>::max()), Max(0.0), Mean(0.0), M2(0.0),
+  NumBytes(-1ll), RankMin(0.0), RankMax(0.0), RankSum(0.0),
+  SlowestRank(-1), NumRanks(0),
+  MemDeltaMax(std::numeric_limits<long long>::min()), MemPeakMax(-1ll)
+{
+}
+
+// --------------------------------------------------------------------------
+void EventSummary::Update(double dt, long long nBytes)
+{
+  this->Count += 1;
+  this->Total += dt;
+  this->Min = std::min(this->Min, dt);
+  this->Max = std::max(this->Max, dt);
+
+  double delta = dt - this->Mean;
+  this->Mean += delta/this->Count;
+  this->M2 += delta*(dt - this->Mean);
+
+  if (nBytes >= 0)
+    this->NumBytes = (this->NumBytes < 0 ? 0 : this->NumBytes) + nBytes;
+
+  if (summaryHistogram)
+    {
+    if (this->Histogram.empty())
+      this->Histogram.resize(summaryHistogramBins, 0);
+
+    // bin i holds durations in [2^(i-1), 2^i) microseconds
+    int bin = 0;
+    frexp(dt*1.0e6, &bin);
+    bin = std::max(0, std::min(summaryHistogramBins - 1, bin));
+
+    this->Histogram[bin] += 1;
+    }
+}
+
+// --------------------------------------------------------------------------
+void EventSummary::UpdateMemory(long long memDelta, long long memPeak)
+{
+  this->MemDeltaMax = std::max(this->MemDeltaMax, memDelta);
+  this->MemPeakMax = std::max(this->MemPeakMax, memPeak);
+}
+
+// --------------------------------------------------------------------------
+void EventSummary::UpdateCounters(const long long *counters, int nCounters)
+{
+  if (this->Counters.empty())
+    this->Counters.resize(nCounters, -1ll);
+
+  for (int i = 0; i < nCounters; ++i)
+    {
+    if (counters[i] >= 0)
+      this->Counters[i] = (this->Counters[i] < 0 ? 0 : this->Counters[i])
+        + counters[i];
+    }
+}
+
+// --------------------------------------------------------------------------
+void EventSummary::Merge(const EventSummary &other)
+{
+  if (other.Count == 0)
+    return;
+
+  // combine the means and variances, Chan et al.
+  long long count = this->Count + other.Count;
+  double delta = other.Mean - this->Mean;
+
+  this->Mean += delta*other.Count/count;
+  this->M2 += other.M2 + delta*delta*this->Count*other.Count/count;
+
+  this->Count = count;
+  this->Total += other.Total;
+  this->Min = std::min(this->Min, other.Min);
+  this->Max = std::max(this->Max, other.Max);
+
+  if (other.NumBytes >= 0)
+    this->NumBytes = (this->NumBytes < 0 ? 0 : this->NumBytes) + other.NumBytes;
+
+  if (this->NumRanks == 0)
+    {
+    this->RankMin = other.RankMin;
+    this->RankMax = other.RankMax;
+    this->SlowestRank = other.SlowestRank;
+    }
+  else
+    {
+    this->RankMin = std::min(this->RankMin, other.RankMin);
+    if (other.RankMax > this->RankMax)
+      {
+      this->RankMax = other.RankMax;
+      this->SlowestRank = other.SlowestRank;
+      }
+    }
+  this->RankSum += other.RankSum;
+  this->NumRanks += other.NumRanks;
+
+  this->MemDeltaMax = std::max(this->MemDeltaMax, other.MemDeltaMax);
+  this->MemPeakMax = std::max(this->MemPeakMax, other.MemPeakMax);
+
+  if (!other.Counters.empty())
+    this->UpdateCounters(other.Counters.data(), other.Counters.size());
+
+  if (!other.Histogram.empty())
+    {
+    if (this->Histogram.empty())
+      this->Histogram.resize(other.Histogram.size(), 0);
+
+    size_t nBins = other.Histogram.size();
+    for (size_t i = 0; i < nBins; ++i)
+      this->Histogram[i] += other.Histogram[i];
+    }
+}
+
+// --------------------------------------------------------------------------
+void EventSummary::InitializeRankStatistics(int rank)
+{
+  this->RankMin = this->Total;
+  this->RankMax = this->Total;
+  this->RankSum = this->Total;
+  this->SlowestRank = rank;
+  this->NumRanks = 1;
+}
+
+// --------------------------------------------------------------------------
+template <typename T>
+void pack(std::vector<char> &buf, const T &val)
+{
+  const char *pval = reinterpret_cast<const char*>(&val);
+  buf.insert(buf.end(), pval, pval + sizeof(T));
+}
+
+// --------------------------------------------------------------------------
+template <typename T>
+size_t unpack(const char *buf, T &val)
+{
+  memcpy(&val, buf, sizeof(T));
+  return sizeof(T);
+}
+
+// --------------------------------------------------------------------------
+void EventSummary::Pack(const std::string &name, std::vector<char> &buf) const
+{
+  int nChars = name.size();
+  pack(buf, nChars);
+  buf.insert(buf.end(), name.begin(), name.end());
+
+  pack(buf, this->Count);
+  pack(buf, this->Total);
+  pack(buf, this->Min);
+  pack(buf, this->Max);
+  pack(buf, this->Mean);
+  pack(buf, this->M2);
+  pack(buf, this->NumBytes);
+  pack(buf, this->RankMin);
+  pack(buf, this->RankMax);
+  pack(buf, this->RankSum);
+  pack(buf, this->SlowestRank);
+  pack(buf, this->NumRanks);
+  pack(buf, this->MemDeltaMax);
+  pack(buf, this->MemPeakMax);
+
+  int nBins = this->Histogram.size();
+  pack(buf, nBins);
+  for (int i = 0; i < nBins; ++i)
+    pack(buf, this->Histogram[i]);
+
+  int nCounters = this->Counters.size();
+  pack(buf, nCounters);
+  for (int i = 0; i < nCounters; ++i)
+    pack(buf, this->Counters[i]);
+}
+
+// --------------------------------------------------------------------------
+size_t EventSummary::Unpack(const char *buf, std::string &name,
+  EventSummary &es)
+{
+  const char *p = buf;
+
+  int nChars = 0;
+  p += unpack(p, nChars);
+  name.assign(p, nChars);
+  p += nChars;
+
+  p += unpack(p, es.Count);
+  p += unpack(p, es.Total);
+  p += unpack(p, es.Min);
+  p += unpack(p, es.Max);
+  p += unpack(p, es.Mean);
+  p += unpack(p, es.M2);
+  p += unpack(p, es.NumBytes);
+  p += unpack(p, es.RankMin);
+  p += unpack(p, es.RankMax);
+  p += unpack(p, es.RankSum);
+  p += unpack(p, es.SlowestRank);
+  p += unpack(p, es.NumRanks);
+  p += unpack(p, es.MemDeltaMax);
+  p += unpack(p, es.MemPeakMax);
+
+  int nBins = 0;
+  p += unpack(p, nBins);
+  es.Histogram.resize(nBins);
+  for (int i = 0; i < nBins; ++i)
+    p += unpack(p, es.Histogram[i]);
+
+  int nCounters = 0;
+  p += unpack(p, nCounters);
+  es.Counters.resize(nCounters);
+  for (int i = 0; i < nCounters; ++i)
+    p += unpack(p, es.Counters[i]);
+
+  return p - buf;
+}
+
+// --------------------------------------------------------------------------
+void EventSummary::ToStream(std::ostream &str, const std::string &name,
+  int flush, long step) const
+{
+  double stdDev = this->Count ? sqrt(this->M2/this->Count) : 0.0;
+  double rankMean = this->NumRanks ? this->RankSum/this->NumRanks : 0.0;
+  double imbalance = rankMean > 0.0 ? this->RankMax/rankMean - 1.0 : 0.0;
+
+  str << flush << ", " << step << ", \"" << name << "\", "
+    << this->NumRanks << ", " << this->Count << ", " << this->Total << ", "
+    << this->Min << ", " << this->Max << ", " << this->Mean << ", "
+    << stdDev << ", " << this->RankMin << ", " << rankMean << ", "
+    << this->RankMax << ", " << imbalance << ", " << this->SlowestRank
+    << ", " << this->NumBytes;
+
+  if (loggingEnabled & 0x08)
+    str << ", " << this->MemDeltaMax << ", " << this->MemPeakMax;
+
+  if (loggingEnabled & 0x10)
+    {
+    int nCounters = sensei::HardwareCounters::GetNumberOfCounters();
+    int nVals = this->Counters.size();
+    for (int i = 0; i < nCounters; ++i)
+      str << ", " << (i < nVals ? this->Counters[i] : -1ll);
+    }
+
+  if (summaryHistogram)
+    {
+    size_t nBins = this->Histogram.size();
+    for (int i = 0; i < summaryHistogramBins; ++i)
+      str << ", " << (i < int(nBins) ? this->Histogram[i] : 0ll);
+    }
+
+  str << std::endl;
+}
+
+#if defined(SENSEI_HAS_MPI)
+// --------------------------------------------------------------------------
+// reduce the summaries to rank 0 of the communicator over a binomial tree.
+// the data sent at each level is proportional to the number of distinct
+// events, not the number of ranks.
+static int reduceSummary(MPI_Comm comm, summaryMapType &summary)
+{
+  int rank = 0;
+  int nRanks = 1;
+
+  MPI_Comm_rank(comm, &rank);
+  MPI_Comm_size(comm, &nRanks);
+
+  const int tag = 5101;
+
+  for (int level = 1; level < nRanks; level <<= 1)
+    {
+    if (rank & level)
+      {
+      // send to the parent and we're done
+      std::vector<char> buf;
+      summaryMapType::iterator it = summary.begin();
+      summaryMapType::iterator end = summary.end();
+      for (; it != end; ++it)
+        it->second.Pack(it->first, buf);
+
+      MPI_Send(buf.data(), buf.size(), MPI_BYTE, rank - level, tag, comm);
+      break;
+      }
+    else if (rank + level < nRanks)
+      {
+      // receive from the child and merge
+      MPI_Status stat;
+      MPI_Probe(rank + level, tag, comm, &stat);
+
+      int nBytes = 0;
+      MPI_Get_count(&stat, MPI_BYTE, &nBytes);
+
+      std::vector<char> buf(nBytes);
+      MPI_Recv(buf.data(), nBytes, MPI_BYTE, rank + level, tag, comm,
+        MPI_STATUS_IGNORE);
+
+      const char *p = buf.data();
+      const char *pEnd = p + nBytes;
+      while (p < pEnd)
+        {
+        std::string name;
+        EventSummary es;
+        p += EventSummary::Unpack(p, name, es);
+        summary[name].Merge(es);
+        }
+      }
+    }
+
+  return 0;
+}
+#endif
+
+// --------------------------------------------------------------------------
+// write the header describing the summary's columns
+static void summaryHeader(std::ostream &str)
+{
+  str << "# flush, step, name, num ranks, count, total, min, max, mean,"
+    " std dev, rank total min, rank total mean, rank total max, imbalance,"
+    " slowest rank, bytes";
+
+  if (loggingEnabled & 0x08)
+    str << ", max rss delta kiB, max rss peak kiB";
+
+  if (loggingEnabled & 0x10)
+    {
+    int nCounters = sensei::HardwareCounters::GetNumberOfCounters();
+    for (int i = 0; i < nCounters; ++i)
+      str << ", total " << sensei::HardwareCounters::GetCounterName(i);
+    }
+
+  if (summaryHistogram)
+    {
+    for (int i = 0; i < summaryHistogramBins; ++i)
+      str << ", < " << (1ull << i) << " us";
+    }
+
+  str << std::endl;
+}
 #endif
 }
 
@@ -145,6 +700,30 @@ void Profiler::SetTimerLogFile(const std::string &file)
 #endif
 }
 
+// ----------------------------------------------------------------------------
+int Profiler::SetTimerLogFormat(const std::string &format)
+{
+#if defined(ENABLE_PROFILER)
+  if (format == "csv")
+    {
+    impl::timerLogFormat = 0;
+    }
+  else if (format == "chrome")
+    {
+    impl::timerLogFormat = 1;
+    }
+  else
+    {
+    SENSEI_ERROR("Invalid timer log format \"" << format
+      << "\". Use one of: csv, chrome")
+    return -1;
+    }
+#else
+  (void)format;
+#endif
+  return 0;
+}
+
 // ----------------------------------------------------------------------------
 void Profiler::SetMemProfLogFile(const std::string &file)
 {
@@ -165,6 +744,123 @@ void Profiler::SetMemProfInterval(int interval)
 #endif
 }
 
+// ----------------------------------------------------------------------------
+void Profiler::SetHardwareCounters(const std::string &names)
+{
+#if defined(ENABLE_PROFILER)
+  impl::counterNames = names;
+#else
+  (void)names;
+#endif
+}
+
+// ----------------------------------------------------------------------------
+void Profiler::SetSummaryLogFile(const std::string &file)
+{
+#if defined(ENABLE_PROFILER)
+  impl::summaryLogFile = file;
+#else
+  (void)file;
+#endif
+}
+
+// ----------------------------------------------------------------------------
+void Profiler::SetSummaryInterval(int nSteps)
+{
+#if defined(ENABLE_PROFILER)
+  impl::summaryInterval = nSteps;
+#else
+  (void)nSteps;
+#endif
+}
+
+// ----------------------------------------------------------------------------
+void Profiler::SetSummaryHistogram(int val)
+{
+#if defined(ENABLE_PROFILER)
+  impl::summaryHistogram = val;
+#else
+  (void)val;
+#endif
+}
+
+// ----------------------------------------------------------------------------
+int Profiler::EndStep()
+{
+#if defined(ENABLE_PROFILER)
+  if ((impl::loggingEnabled & 0x05) == 0x05)
+    {
+    impl::stepCount += 1;
+
+    if ((impl::summaryInterval > 0) &&
+      ((impl::stepCount % impl::summaryInterval) == 0))
+      return Profiler::FlushSummary();
+    }
+#endif
+  return 0;
+}
+
+// ----------------------------------------------------------------------------
+int Profiler::FlushSummary()
+{
+#if defined(ENABLE_PROFILER)
+  if ((impl::loggingEnabled & 0x05) != 0x05)
+    return 0;
+
+  // take this interval's statistics, events ended from here on are
+  // counted in the next interval
+  impl::summaryMapType summary;
+  {
+  std::lock_guard<std::mutex> lock(impl::eventLogMutex);
+  summary.swap(impl::eventSummary);
+  }
+
+  int rank = 0;
+  int ok = 0;
+#if defined(SENSEI_HAS_MPI)
+  int fin = 0;
+  MPI_Initialized(&ok);
+  MPI_Finalized(&fin);
+  ok = ok && !fin && (impl::comm != MPI_COMM_NULL);
+  if (ok)
+    MPI_Comm_rank(impl::comm, &rank);
+#endif
+
+  impl::summaryMapType::iterator it = summary.begin();
+  impl::summaryMapType::iterator end = summary.end();
+  for (; it != end; ++it)
+    it->second.InitializeRankStatistics(rank);
+
+#if defined(SENSEI_HAS_MPI)
+  if (ok)
+    impl::reduceSummary(impl::comm, summary);
+#endif
+
+  if (rank == 0)
+    {
+    std::ostringstream oss;
+    oss.precision(std::numeric_limits<double>::digits10 + 2);
+    oss.setf(std::ios::scientific, std::ios::floatfield);
+
+    if (impl::summaryFlushCount == 0)
+      impl::summaryHeader(oss);
+
+    it = summary.begin();
+    end = summary.end();
+    for (; it != end; ++it)
+      it->second.ToStream(oss, it->first, impl::summaryFlushCount,
+        impl::stepCount);
+
+    if (Profiler::WriteCStdio(impl::summaryLogFile.c_str(),
+      impl::summaryFlushCount ? "a" : "w", oss.str()))
+      return -1;
+    }
+
+  impl::summaryFlushCount += 1;
+#endif
+  return 0;
+}
+
 // ----------------------------------------------------------------------------
 int Profiler::Validate()
 {
@@ -201,7 +897,19 @@ int Profiler::Validate()
 int Profiler::ToStream(std::ostream &os)
 {
 #if defined(ENABLE_PROFILER)
-  if (impl::loggingEnabled & 0x01)
+  if ((impl::loggingEnabled & 0x01) && (impl::timerLogFormat == 1))
+    {
+    int rank = 0;
+#if defined(SENSEI_HAS_MPI)
+    int ini = 0, fin = 0;
+    MPI_Initialized(&ini);
+    MPI_Finalized(&fin);
+    if (ini && !fin)
+      MPI_Comm_rank(impl::comm, &rank);
+#endif
+    impl::chromeTraceToStream(os, rank);
+    }
+  else if (impl::loggingEnabled & 0x01)
     {
     // serialize the logged events in CSV format
     os.precision(std::numeric_limits<double>::digits10 + 2);
@@ -247,8 +955,13 @@ int Profiler::Initialize()
   if ((tmp = getenv("PROFILER_ENABLE")))
     impl::loggingEnabled = atoi(tmp);
 
+  if ((tmp = getenv("PROFILER_LOG_FORMAT")))
+    Profiler::SetTimerLogFormat(tmp);
+
   if ((tmp = getenv("PROFILER_LOG_FILE")))
     impl::timerLogFile = tmp;
+  else if ((impl::timerLogFormat == 1) && (impl::timerLogFile == "timer.csv"))
+    impl::timerLogFile = "timer.json";
 
   if ((tmp = getenv("MEMPROF_LOG_FILE")))
     impl::memProf.SetFilename(tmp);
@@ -256,9 +969,38 @@ int Profiler::Initialize()
   if ((tmp = getenv("MEMPROF_INTERVAL")))
     impl::memProf.SetInterval(atof(tmp));
 
+  if ((tmp = getenv("MEMPROF_BUFFER_SIZE")))
+    impl::memProf.SetBufferSize(atol(tmp));
+
+  if ((tmp = getenv("PROFILER_COUNTERS")))
+    impl::counterNames = tmp;
+
+  if ((tmp = getenv("PROFILER_SUMMARY_FILE")))
+    impl::summaryLogFile = tmp;
+
+  if ((tmp = getenv("PROFILER_SUMMARY_INTERVAL")))
+    impl::summaryInterval = atoi(tmp);
+
+  if ((tmp = getenv("PROFILER_SUMMARY_HISTOGRAM")))
+    impl::summaryHistogram = atoi(tmp);
+
   if (impl::loggingEnabled & 0x02)
     impl::memProf.Initialize();
 
+  int nCountersAvailable = 0;
+  if ((impl::loggingEnabled & 0x10) && !impl::counterNames.empty() &&
+    sensei::HardwareCounters::SetCounters(impl::counterNames))
+    {
+    SENSEI_ERROR("Invalid hardware counter list \"" << impl::counterNames
+      << "\". Hardware counters are disabled")
+    impl::loggingEnabled &= ~0x10;
+    }
+  else if (impl::loggingEnabled & 0x10)
+    {
+    nCountersAvailable =
+      sensei::HardwareCounters::GetNumberOfAvailableCounters();
+    }
+
   // report what options are in use
   if ((rank == 0) && impl::loggingEnabled)
     std::cerr << "Profiler configured with Event logging "
@@ -268,6 +1010,31 @@ int Profiler::Initialize()
       << "\", memory profiler log file \"" << impl::memProf.GetFilename()
       << "\", sampling interval " << impl::memProf.GetInterval()
       << " seconds" << std::endl;
+
+  if ((rank == 0) && ((impl::loggingEnabled & 0x09) == 0x09))
+    std::cerr << "Profiler memory attribution enabled, peak memory use "
+      << (impl::loggingEnabled & 0x02 ? "from samples" : "from event end points")
+      << std::endl;
+
+  if ((rank == 0) && ((impl::loggingEnabled & 0x11) == 0x11))
+    {
+    std::cerr << "Profiler hardware counters enabled,";
+    int nCounters = sensei::HardwareCounters::GetNumberOfCounters();
+    for (int i = 0; i < nCounters; ++i)
+      std::cerr << (i ? ", " : " ") << sensei::HardwareCounters::GetCounterName(i);
+    std::cerr << ". " << nCountersAvailable << " of " << nCounters
+      << " are available";
+    if (nCountersAvailable < nCounters)
+      std::cerr << ", the others will be reported as -1. perf events may be"
+        " restricted by kernel.perf_event_paranoid or the container runtime";
+    std::cerr << std::endl;
+    }
+
+  if ((rank == 0) && ((impl::loggingEnabled & 0x05) == 0x05))
+    std::cerr << "Profiler summary mode enabled, summary file \""
+      << impl::summaryLogFile << "\", flush interval "
+      << impl::summaryInterval << " steps, histogram "
+      << (impl::summaryHistogram ? "enabled" : "disabled") << std::endl;
 #endif
   return 0;
 }
@@ -330,6 +1097,14 @@ int Profiler::WriteMpiIo(MPI_Comm comm, const char *fileName,
 int Profiler::Flush()
 {
 #if defined(ENABLE_PROFILER)
+  // in summary mode append the remaining statistics, un-reduced
+  if ((impl::loggingEnabled & 0x05) == 0x05)
+    {
+    Profiler::FlushSummary();
+    Profiler::Validate();
+    return 0;
+    }
+
   std::ostringstream oss;
   Profiler::ToStream(oss);
   Profiler::WriteCStdio(impl::timerLogFile.c_str(), "a", oss.str());
@@ -383,7 +1158,12 @@ int Profiler::Finalize()
   MPI_Initialized(&ok);
 #endif
 
-  if (impl::loggingEnabled & 0x01)
+  if ((impl::loggingEnabled & 0x05) == 0x05)
+    {
+    // write what remains of the summary. this replaces the event log
+    Profiler::FlushSummary();
+    }
+  else if (impl::loggingEnabled & 0x01)
     {
     int rank = 0;
 #if defined(SENSEI_HAS_MPI)
@@ -391,11 +1171,45 @@ int Profiler::Finalize()
       MPI_Comm_rank(impl::comm, &rank);
 #endif
 
-    // serialize the logged events in CSV format
     std::ostringstream oss;
 
-    if (rank == 0)
-      oss << "# rank, thread, Name, start Time, end Time, delta, Depth" << std::endl;
+    if (impl::timerLogFormat == 1)
+      {
+      // Chrome trace event JSON, array format. the array is left open so
+      // that events logged by Flush can be appended, trace viewers accept
+      // this
+      if (rank == 0)
+        oss << "[" << std::endl;
+
+      // use a common time origin across ranks
+      double origin = std::numeric_limits<double>::max();
+      impl::eventLogType::iterator iter = impl::eventLog.begin();
+      impl::eventLogType::iterator end = impl::eventLog.end();
+      for (; iter != end; ++iter)
+        origin = std::min(origin, iter->Time[impl::Event::START]);
+#if defined(SENSEI_HAS_MPI)
+      if (ok)
+        MPI_Allreduce(MPI_IN_PLACE, &origin, 1, MPI_DOUBLE, MPI_MIN, impl::comm);
+#endif
+      impl::traceOrigin = origin;
+      }
+    else if (rank == 0)
+      {
+      // serialize the logged events in CSV format
+      oss << "# rank, thread, Name, start Time, end Time, delta, bytes, Depth";
+
+      if (impl::loggingEnabled & 0x08)
+        oss << ", rss start kiB, rss end kiB, rss delta kiB, rss peak kiB";
+
+      if (impl::loggingEnabled & 0x10)
+        {
+        int nCounters = sensei::HardwareCounters::GetNumberOfCounters();
+        for (int i = 0; i < nCounters; ++i)
+          oss << ", " << sensei::HardwareCounters::GetCounterName(i);
+        }
+
+      oss << std::endl;
+      }
 
     Profiler::ToStream(oss);
 
@@ -463,6 +1277,13 @@ int Profiler::StartEvent(const char* eventname, long long nbytes)
     evt.Time[impl::Event::START] = impl::getSystemTime();
     evt.NumBytes = nbytes;
 
+    if (impl::loggingEnabled & 0x08)
+      evt.MemStart = sensei::MemoryProfiler::GetCurrentMemoryUsed();
+
+    // read the counters last so that the above is not counted
+    if (impl::loggingEnabled & 0x10)
+      sensei::HardwareCounters::Read(evt.Counters);
+
     std::lock_guard<std::mutex> lock(impl::eventLogMutex);
     impl::activeEvents[evt.Tid].push_back(evt);
     }
@@ -479,9 +1300,18 @@ int Profiler::EndEvent(const char* eventname, long long nbytes)
 #if defined(ENABLE_PROFILER)
   if (impl::loggingEnabled & 0x01)
     {
+    // read the counters first so that the below is not counted
+    long long counters[sensei::HardwareCounters::MaxCounters];
+    if (impl::loggingEnabled & 0x10)
+      sensei::HardwareCounters::Read(counters);
+
     // get end Time
     double endTime = impl::getSystemTime();
 
+    long long memEnd = -1ll;
+    if (impl::loggingEnabled & 0x08)
+      memEnd = sensei::MemoryProfiler::GetCurrentMemoryUsed();
+
     // get this thread's Event log
     std::thread::id tid = std::this_thread::get_id();
 
@@ -512,7 +1342,39 @@ int Profiler::EndEvent(const char* eventname, long long nbytes)
     evt.NumBytes = nbytes;
     evt.Depth = iter->second.size();
 
-    impl::eventLog.emplace_back(std::move(evt));
+    if (impl::loggingEnabled & 0x08)
+      {
+      // the peak is taken from the memory profiler's samples when it is
+      // running, this catches transient allocations made during the event
+      evt.MemEnd = memEnd;
+      evt.MemPeak = std::max(evt.MemStart, memEnd);
+      if (impl::loggingEnabled & 0x02)
+        evt.MemPeak = std::max(evt.MemPeak, impl::memProf.GetPeakMemoryUsed(
+          evt.Time[impl::Event::START], endTime));
+      }
+
+    int nCounters = 0;
+    if (impl::loggingEnabled & 0x10)
+      {
+      // the counts during the event
+      nCounters = sensei::HardwareCounters::GetNumberOfCounters();
+      for (int i = 0; i < nCounters; ++i)
+        evt.Counters[i] = ((evt.Counters[i] < 0) || (counters[i] < 0)) ?
+          -1ll : counters[i] - evt.Counters[i];
+      }
+
+    // in summary mode only the running statistics are kept
+    if (impl::loggingEnabled & 0x04)
+      {
+      impl::EventSummary &es = impl::eventSummary[evt.Name];
+      es.Update(evt.Time[impl::Event::DELTA], nbytes);
+      if (impl::loggingEnabled & 0x08)
+        es.UpdateMemory(evt.MemEnd - evt.MemStart, evt.MemPeak);
+      if (nCounters)
+        es.UpdateCounters(evt.Counters, nCounters);
+      }
+    else
+      impl::eventLog.emplace_back(std::move(evt));
     }
 #else
   (void)eventname;
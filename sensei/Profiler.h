@@ -28,9 +28,66 @@ public:
   //   PROFILER_ENABLE     : bit mask turns on or off logging,
   //               0x01 -- event profiling enabled
   //               0x02 -- memory profiling enabled
+  //               0x04 -- summarize events rather than logging each one.
+  //                       requires event profiling, see summary mode below
+  //               0x08 -- attribute memory use to events. requires event
+  //                       profiling, see memory attribution below
+  //               0x10 -- record hardware counters for events. requires
+  //                       event profiling, see hardware counters below
   //   PROFILER_LOG_FILE   : path to write timer log to
+  //   PROFILER_LOG_FORMAT : format of the timer log, csv or chrome
   //   MEMPROF_LOG_FILE    : path to write memory profiler log to
   //   MEMPROF_INTERVAL    : number of seconds between memory recordings
+  //   MEMPROF_BUFFER_SIZE : number of memory recordings kept
+  //   PROFILER_COUNTERS   : comma separated list of hardware counters
+  //   PROFILER_SUMMARY_FILE      : path to write the event summary to
+  //   PROFILER_SUMMARY_INTERVAL  : number of steps between summary flushes
+  //   PROFILER_SUMMARY_HISTOGRAM : non-zero to include duration histograms
+  //
+  // Summary mode
+  //
+  // In summary mode each rank keeps running statistics of the duration of
+  // each named event (count, total, min, max, mean, and variance) instead of
+  // a record per event, so memory use does not grow with the length of the
+  // run. Optionally a histogram of durations in power of 2 microsecond bins
+  // is kept. The statistics are reduced across ranks with a tree reduction
+  // and rank 0 appends one row per event to the summary file. In addition
+  // to the combined statistics each row reports the minimum, mean, and
+  // maximum over ranks of the per rank total time, the imbalance
+  // (max/mean - 1), and the slowest rank. This happens every
+  // SetSummaryInterval steps, as counted by EndStep, and at Finalize. The
+  // statistics are reset after each flush so that rows summarize the
+  // interval since the previous flush.
+  //
+  // Memory attribution
+  //
+  // With memory attribution each event records the resident set size at
+  // its start and end, their difference, and the peak during the event.
+  // These are appended to each event's row in the timer log, and in summary
+  // mode the largest delta and peak are reported for each event. The
+  // resident set size is read from /proc/self/statm which costs one system
+  // call per event end point. When memory profiling is also enabled the
+  // peak includes the samples taken during the event, set MEMPROF_INTERVAL
+  // small enough to resolve the events of interest. Otherwise the peak is
+  // the larger of the start and end values.
+  //
+  // Chrome trace format
+  //
+  // With PROFILER_LOG_FORMAT=chrome the timer log is written in the Chrome
+  // trace event JSON format, which can be loaded in chrome://tracing and
+  // the Perfetto UI. Each rank is a process and each thread a track. The
+  // bytes, depth, and when enabled memory use and hardware counters are
+  // written as event arguments. The default log file is then timer.json.
+  //
+  // Hardware counters
+  //
+  // With hardware counters each event records the counts of the configured
+  // CPU performance counters, for instance cycles, instructions and last
+  // level cache misses, made by the calling thread during the event. These
+  // are appended to each event's row in the timer log, and in summary mode
+  // the totals are reported for each event. See HardwareCounters for the
+  // available counters. Where perf events are not available the counts
+  // are reported as -1.
   //
   static int Initialize();
 
@@ -54,6 +111,11 @@ public:
   // default value; Timer.csv
   static void SetTimerLogFile(const std::string &fileName);
 
+  // Sets the format of the timer log, one of csv or chrome
+  // overriden by PROFILER_LOG_FORMAT environment variable
+  // default value: csv
+  static int SetTimerLogFormat(const std::string &format);
+
   // Sets the path to write the timer log to
   // overriden by MEMPROF_LOG_FILE environment variable
   // default value: MemProfLog.csv
@@ -63,6 +125,40 @@ public:
   // overriden by MEMPROF_INTERVAL environment variable.
   static void SetMemProfInterval(int interval);
 
+  // Sets the hardware counters to record, as a comma separated list.
+  // Must be called prior to initialization.
+  // overriden by PROFILER_COUNTERS environment variable
+  // default value: cycles,instructions,cache-references,cache-misses
+  static void SetHardwareCounters(const std::string &names);
+
+  // Sets the path to write the event summary to
+  // overriden by PROFILER_SUMMARY_FILE environment variable
+  // default value: timer_summary.csv
+  static void SetSummaryLogFile(const std::string &fileName);
+
+  // Sets the number of steps between summary flushes. When 0 the summary
+  // is written only at Finalize.
+  // overriden by PROFILER_SUMMARY_INTERVAL environment variable
+  // default value: 0
+  static void SetSummaryInterval(int nSteps);
+
+  // Enable/disable the per event duration histogram in summary mode
+  // overriden by PROFILER_SUMMARY_HISTOGRAM environment variable
+  // default value: disabled
+  static void SetSummaryHistogram(int val);
+
+  // Mark the end of a time step. In summary mode with a non-zero summary
+  // interval this periodically flushes the summary, in which case it is a
+  // collective call with respect to the profiler's communicator. It is
+  // not called by SENSEI, the simulation calls it outside of any open
+  // event, on all ranks of the communicator, once per step.
+  static int EndStep();
+
+  // Reduce the event summary across ranks and write it. Collective with
+  // respect to the profiler's communicator. Does nothing unless in summary
+  // mode.
+  static int FlushSummary();
+
   // Enable/Disable logging. Overriden by PROFILER_ENABLE environment
   // variable. In the default format a CSV file is generated capturing each
   // ranks timer events. default value: disabled
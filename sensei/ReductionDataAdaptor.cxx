@@ -0,0 +1,825 @@
+#include "ReductionDataAdaptor.h"
+#include "MeshMetadata.h"
+#include "MeshSelection.h"
+#include "ThreadPool.h"
+#include "VTKUtils.h"
+#include "Profiler.h"
+#include "Error.h"
+
+#include <vtkObjectFactory.h>
+#include <vtkSmartPointer.h>
+#include <vtkCompositeDataSet.h>
+#include <vtkCompositeDataIterator.h>
+#include <vtkMultiBlockDataSet.h>
+#include <vtkImageData.h>
+#include <vtkDataSetAttributes.h>
+#include <vtkFieldData.h>
+#include <vtkDataArray.h>
+#include <vtkDoubleArray.h>
+#include <vtkFloatArray.h>
+#include <vtkUnsignedCharArray.h>
+#include <vtkUnsignedShortArray.h>
+
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <vector>
+#include <cmath>
+
+using vtkDataArrayPtr = vtkSmartPointer<vtkDataArray>;
+using vtkImageDataPtr = vtkSmartPointer<vtkImageData>;
+using vtkCompositeDataSetPtr = vtkSmartPointer<vtkCompositeDataSet>;
+using vtkCompositeDataIteratorPtr = vtkSmartPointer<vtkCompositeDataIterator>;
+
+namespace
+{
+// a block of a mesh and its coarsened counterpart
+struct BlockPair
+{
+  vtkImageDataPtr Fine;
+  vtkImageDataPtr Coarse;
+  int FineExt[6];     // cell extent of the fine block
+  int CoarseExt[6];   // cell extent of the coarse block
+};
+
+// a mesh and its coarsened counterpart
+struct ReducedMesh
+{
+  vtkCompositeDataSetPtr Fine;
+  vtkCompositeDataSetPtr Coarse;
+  std::vector<BlockPair> Blocks;
+};
+
+// reduce the cells of one coarse k-plane. each coarse cell takes the
+// first fine cell it covers, or when box filtering the average of the fine
+// cells of the block that it covers. the rows of fine cells are summed
+// first, with contiguous loops that the compiler vectorizes.
+template <typename T>
+void reduceCells(const T *fine, T *coarse, int nComps, const int *fExt,
+  const int *cExt, int s, bool box, long K, std::vector<double> &acc)
+{
+  long fnx = fExt[1] - fExt[0] + 1;
+  long fnxy = fnx*(fExt[3] - fExt[2] + 1);
+  long cnx = cExt[1] - cExt[0] + 1;
+  long cnxy = cnx*(cExt[3] - cExt[2] + 1);
+
+  T *dest = coarse + (K - cExt[4])*cnxy*nComps;
+
+  if (!box)
+    {
+    long k = K*s - fExt[4];
+    for (long J = cExt[2]; J <= cExt[3]; ++J)
+      {
+      const T *src = fine + (k*fnxy + (J*s - fExt[2])*fnx)*nComps;
+      for (long I = cExt[0]; I <= cExt[1]; ++I)
+        {
+        const T *pSrc = src + (I*s - fExt[0])*nComps;
+        for (int c = 0; c < nComps; ++c)
+          *dest++ = pSrc[c];
+        }
+      }
+    return;
+    }
+
+  long rowLen = fnx*nComps;
+  acc.resize(rowLen);
+  double *pAcc = acc.data();
+
+  long k0 = K*s;
+  long k1 = std::min<long>(k0 + s - 1, fExt[5]);
+
+  for (long J = cExt[2]; J <= cExt[3]; ++J)
+    {
+    long j0 = J*s;
+    long j1 = std::min<long>(j0 + s - 1, fExt[3]);
+
+    // sum the rows of fine cells covered by this row of coarse cells
+    std::fill(acc.begin(), acc.end(), 0.0);
+    for (long k = k0; k <= k1; ++k)
+      {
+      for (long j = j0; j <= j1; ++j)
+        {
+        const T *src = fine + ((k - fExt[4])*fnxy + (j - fExt[2])*fnx)*nComps;
+        for (long q = 0; q < rowLen; ++q)
+          pAcc[q] += src[q];
+        }
+      }
+
+    // sum along the row and normalize
+    long nkj = (k1 - k0 + 1)*(j1 - j0 + 1);
+    for (long I = cExt[0]; I <= cExt[1]; ++I)
+      {
+      long i0 = I*s;
+      long i1 = std::min<long>(i0 + s - 1, fExt[1]);
+      double w = 1.0/(nkj*(i1 - i0 + 1));
+      const double *pRow = pAcc + (i0 - fExt[0])*nComps;
+      for (int c = 0; c < nComps; ++c)
+        {
+        double sum = 0.0;
+        for (long i = 0; i <= i1 - i0; ++i)
+          sum += pRow[i*nComps + c];
+        *dest++ = static_cast<T>(sum*w);
+        }
+      }
+    }
+}
+
+// reduce the points of one coarse k-plane by sampling. coarse points
+// beyond the last fine point of the block take its value.
+template <typename T>
+void reducePoints(const T *fine, T *coarse, int nComps, const int *fExt,
+  const int *cExt, int s, long K)
+{
+  long fnx = fExt[1] - fExt[0] + 2;
+  long fnxy = fnx*(fExt[3] - fExt[2] + 2);
+  long cnx = cExt[1] - cExt[0] + 2;
+  long cnxy = cnx*(cExt[3] - cExt[2] + 2);
+
+  T *dest = coarse + (K - cExt[4])*cnxy*nComps;
+
+  long k = std::min<long>(K*s, fExt[5] + 1) - fExt[4];
+  for (long J = cExt[2]; J <= cExt[3] + 1; ++J)
+    {
+    long j = std::min<long>(J*s, fExt[3] + 1) - fExt[2];
+    const T *src = fine + (k*fnxy + j*fnx)*nComps;
+    for (long I = cExt[0]; I <= cExt[1] + 1; ++I)
+      {
+      long i = std::min<long>(I*s, fExt[1] + 1) - fExt[0];
+      const T *pSrc = src + i*nComps;
+      for (int c = 0; c < nComps; ++c)
+        *dest++ = pSrc[c];
+      }
+    }
+}
+
+// map values onto [0, 2^n - 1]
+template <typename T, typename Q>
+void quantize(const T *in, Q *out, long n, double x0, double scale)
+{
+  for (long i = 0; i < n; ++i)
+    out[i] = static_cast<Q>((in[i] - x0)*scale + 0.5);
+}
+
+// convert to float
+template <typename T>
+void toFloat(const T *in, float *out, long n)
+{
+  for (long i = 0; i < n; ++i)
+    out[i] = static_cast<float>(in[i]);
+}
+
+// get the type of array delivered for an array of the given type
+int getDeliveredType(int type, int precision)
+{
+  if ((type != VTK_DOUBLE) && (type != VTK_FLOAT))
+    return type;
+
+  switch (precision)
+    {
+    case sensei::ReductionDataAdaptor::PRECISION_FLOAT:
+      return VTK_FLOAT;
+    case sensei::ReductionDataAdaptor::PRECISION_UINT16:
+      return VTK_UNSIGNED_SHORT;
+    case sensei::ReductionDataAdaptor::PRECISION_UINT8:
+      return VTK_UNSIGNED_CHAR;
+    }
+
+  return type;
+}
+
+// convert the array to the requested precision. the range needed to
+// recover quantized values is returned in a 2 component array
+int convertPrecision(vtkDataArray *in, int precision, vtkDataArray *&out,
+  vtkDoubleArray *&range)
+{
+  out = nullptr;
+  range = nullptr;
+
+  int type = getDeliveredType(in->GetDataType(), precision);
+  if (type == in->GetDataType())
+    return 0;
+
+  long n = in->GetNumberOfTuples()*in->GetNumberOfComponents();
+
+  if (type == VTK_FLOAT)
+    {
+    vtkFloatArray *fa = vtkFloatArray::New();
+    fa->SetName(in->GetName());
+    fa->SetNumberOfComponents(in->GetNumberOfComponents());
+    fa->SetNumberOfTuples(in->GetNumberOfTuples());
+    switch (in->GetDataType())
+      {
+      vtkTemplateMacro(
+        toFloat(static_cast<const VTK_TT*>(in->GetVoidPointer(0)),
+          fa->GetPointer(0), n);
+        );
+      default:
+        fa->Delete();
+        return -1;
+      }
+    out = fa;
+    return 0;
+    }
+
+  // find the range over all components
+  double x0 = std::numeric_limits<double>::max();
+  double x1 = std::numeric_limits<double>::lowest();
+  for (int c = 0; c < in->GetNumberOfComponents(); ++c)
+    {
+    double rng[2];
+    in->GetRange(rng, c);
+    x0 = std::min(x0, rng[0]);
+    x1 = std::max(x1, rng[1]);
+    }
+
+  if (n == 0)
+    {
+    x0 = 0.0;
+    x1 = 0.0;
+    }
+
+  double qMax = type == VTK_UNSIGNED_CHAR ? 255.0 : 65535.0;
+  double scale = x1 > x0 ? qMax/(x1 - x0) : 0.0;
+
+  vtkDataArray *qa = vtkDataArray::CreateDataArray(type);
+  qa->SetName(in->GetName());
+  qa->SetNumberOfComponents(in->GetNumberOfComponents());
+  qa->SetNumberOfTuples(in->GetNumberOfTuples());
+
+  switch (in->GetDataType())
+    {
+    vtkTemplateMacro(
+      const VTK_TT *pIn = static_cast<const VTK_TT*>(in->GetVoidPointer(0));
+      if (type == VTK_UNSIGNED_CHAR)
+        quantize(pIn, static_cast<unsigned char*>(qa->GetVoidPointer(0)),
+          n, x0, scale);
+      else
+        quantize(pIn, static_cast<unsigned short*>(qa->GetVoidPointer(0)),
+          n, x0, scale);
+      );
+    default:
+      qa->Delete();
+      return -1;
+    }
+
+  range = vtkDoubleArray::New();
+  range->SetName((std::string(in->GetName()) + "_range").c_str());
+  range->SetNumberOfComponents(2);
+  range->SetNumberOfTuples(1);
+  range->SetValue(0, x0);
+  range->SetValue(1, x1);
+
+  out = qa;
+  return 0;
+}
+}
+
+namespace sensei
+{
+
+struct ReductionDataAdaptor::InternalsType
+{
+  InternalsType() : Stride(1), Filter(FILTER_SAMPLE),
+    Precision(PRECISION_NATIVE) {}
+
+  // returns true if meshes are passed through unchanged
+  bool PassThrough() const
+  { return (this->Stride < 2) && (this->Precision == PRECISION_NATIVE); }
+
+  vtkSmartPointer<DataAdaptor> Source;
+  int Stride;
+  int Filter;
+  int Precision;
+
+  // the meshes handed out this step indexed by the coarse mesh
+  std::map<vtkDataObject*, ReducedMesh> Meshes;
+};
+
+//----------------------------------------------------------------------------
+senseiNewMacro(ReductionDataAdaptor);
+
+//----------------------------------------------------------------------------
+ReductionDataAdaptor::ReductionDataAdaptor() :
+  Internals(new ReductionDataAdaptor::InternalsType)
+{
+}
+
+//----------------------------------------------------------------------------
+ReductionDataAdaptor::~ReductionDataAdaptor()
+{
+  delete this->Internals;
+}
+
+//----------------------------------------------------------------------------
+void ReductionDataAdaptor::SetDataAdaptor(DataAdaptor *source)
+{
+  this->Internals->Meshes.clear();
+  this->Internals->Source = source;
+}
+
+//----------------------------------------------------------------------------
+void ReductionDataAdaptor::SetStride(int stride)
+{
+  this->Internals->Stride = std::max(1, stride);
+}
+
+//----------------------------------------------------------------------------
+void ReductionDataAdaptor::SetFilter(int filter)
+{
+  this->Internals->Filter = filter;
+}
+
+//----------------------------------------------------------------------------
+int ReductionDataAdaptor::SetFilter(const std::string &filter)
+{
+  if (filter == "sample")
+    this->Internals->Filter = FILTER_SAMPLE;
+  else if (filter == "box")
+    this->Internals->Filter = FILTER_BOX;
+  else
+    {
+    SENSEI_ERROR("Invalid filter \"" << filter << "\". The filter must be"
+      " one of \"sample\" or \"box\"")
+    return -1;
+    }
+  return 0;
+}
+
+//----------------------------------------------------------------------------
+void ReductionDataAdaptor::SetPrecision(int precision)
+{
+  this->Internals->Precision = precision;
+}
+
+//----------------------------------------------------------------------------
+int ReductionDataAdaptor::SetPrecision(const std::string &precision)
+{
+  if (precision == "native")
+    this->Internals->Precision = PRECISION_NATIVE;
+  else if (precision == "float")
+    this->Internals->Precision = PRECISION_FLOAT;
+  else if (precision == "uint16")
+    this->Internals->Precision = PRECISION_UINT16;
+  else if (precision == "uint8")
+    this->Internals->Precision = PRECISION_UINT8;
+  else
+    {
+    SENSEI_ERROR("Invalid precision \"" << precision << "\". The precision"
+      " must be one of \"native\", \"float\", \"uint16\", or \"uint8\"")
+    return -1;
+    }
+  return 0;
+}
+
+//----------------------------------------------------------------------------
+int ReductionDataAdaptor::Initialize(pugi::xml_node &node)
+{
+  this->SetStride(node.attribute("stride").as_int(1));
+
+  if (this->SetFilter(node.attribute("filter").as_string("sample")) ||
+    this->SetPrecision(node.attribute("precision").as_string("native")))
+    return -1;
+
+  return 0;
+}
+
+//----------------------------------------------------------------------------
+int ReductionDataAdaptor::GetNumberOfMeshes(unsigned int &numMeshes)
+{
+  numMeshes = 0;
+
+  if (!this->Internals->Source)
+    {
+    SENSEI_ERROR("No data adaptor was set")
+    return -1;
+    }
+
+  return this->Internals->Source->GetNumberOfMeshes(numMeshes);
+}
+
+//----------------------------------------------------------------------------
+int ReductionDataAdaptor::GetMeshMetadata(unsigned int id,
+  MeshMetadataPtr &md)
+{
+  if (!this->Internals->Source)
+    {
+    SENSEI_ERROR("No data adaptor was set")
+    return -1;
+    }
+
+  if (this->Internals->Source->GetMeshMetadata(id, md))
+    return -1;
+
+  // only blocks of multiblock Cartesian meshes are reduced
+  if (this->Internals->PassThrough() ||
+    (md->MeshType != VTK_MULTIBLOCK_DATA_SET) ||
+    (md->BlockType != VTK_IMAGE_DATA))
+    return 0;
+
+  // describe the coarse blocks
+  int s = this->Internals->Stride;
+
+  MeshSelection sel;
+  sel.SetStride({s, s, s});
+
+  auto coarsen = [&](std::array<int,6> &ext) -> bool
+    {
+    int cellExt[6];
+    if (!sel.GetCellExtent(ext.data(), cellExt))
+      {
+      ext = {0, -1, 0, -1, 0, -1};
+      return false;
+      }
+    sel.GetCoarseExtent(cellExt, ext.data());
+    return true;
+    };
+
+  if (coarsen(md->Extent))
+    {
+    long nx = md->Extent[1] - md->Extent[0] + 1;
+    long ny = md->Extent[3] - md->Extent[2] + 1;
+    long nz = md->Extent[5] - md->Extent[4] + 1;
+    md->NumCells = nx*ny*nz;
+    md->NumPoints = (nx + 1)*(ny + 1)*(nz + 1);
+    }
+
+  unsigned int nBlocks = md->BlockExtents.size();
+  for (unsigned int i = 0; i < nBlocks; ++i)
+    {
+    std::array<int,6> &ext = md->BlockExtents[i];
+
+    long nCells = 0;
+    long nPoints = 0;
+    if (coarsen(ext))
+      {
+      long nx = ext[1] - ext[0] + 1;
+      long ny = ext[3] - ext[2] + 1;
+      long nz = ext[5] - ext[4] + 1;
+      nCells = nx*ny*nz;
+      nPoints = (nx + 1)*(ny + 1)*(nz + 1);
+      }
+
+    if (md->BlockNumCells.size() == nBlocks)
+      md->BlockNumCells[i] = nCells;
+
+    if (md->BlockNumPoints.size() == nBlocks)
+      md->BlockNumPoints[i] = nPoints;
+    }
+
+  // the types of the delivered arrays
+  for (int i = 0; i < md->NumArrays; ++i)
+    md->ArrayType[i] = getDeliveredType(md->ArrayType[i],
+      this->Internals->Precision);
+
+  return 0;
+}
+
+//----------------------------------------------------------------------------
+int ReductionDataAdaptor::GetMesh(const std::string &meshName,
+  bool structureOnly, vtkDataObject *&mesh)
+{
+  TimeEvent<128> mark("ReductionDataAdaptor::GetMesh");
+
+  mesh = nullptr;
+
+  if (!this->Internals->Source)
+    {
+    SENSEI_ERROR("No data adaptor was set")
+    return -1;
+    }
+
+  vtkDataObject *dobj = nullptr;
+  if (this->Internals->Source->GetMesh(meshName, structureOnly, dobj))
+    {
+    SENSEI_ERROR("Failed to get mesh \"" << meshName << "\"")
+    return -1;
+    }
+
+  // only blocks of multiblock Cartesian meshes are reduced
+  vtkMultiBlockDataSet *fine = dynamic_cast<vtkMultiBlockDataSet*>(dobj);
+  if (this->Internals->PassThrough() || !fine)
+    {
+    mesh = dobj;
+    return 0;
+    }
+
+  int s = this->Internals->Stride;
+
+  MeshSelection sel;
+  sel.SetStride({s, s, s});
+
+  double x0[3] = {0.0};
+  double dx[3] = {0.0};
+
+  ReducedMesh rm;
+  rm.Fine.TakeReference(fine);
+
+  vtkMultiBlockDataSet *coarse = vtkMultiBlockDataSet::New();
+  coarse->CopyStructure(fine);
+  rm.Coarse = coarse;
+
+  vtkCompositeDataIteratorPtr it;
+  it.TakeReference(fine->NewIterator());
+  it->SetSkipEmptyNodes(1);
+  for (it->InitTraversal(); !it->IsDoneWithTraversal(); it->GoToNextItem())
+    {
+    vtkDataObject *leaf = it->GetCurrentDataObject();
+    vtkImageData *fineBlock = dynamic_cast<vtkImageData*>(leaf);
+
+    // other types of blocks, and 2D blocks, are passed through
+    int ptExt[6] = {0, -1, 0, -1, 0, -1};
+    if (fineBlock)
+      fineBlock->GetExtent(ptExt);
+
+    if (!fineBlock || (!structureOnly && ((ptExt[0] == ptExt[1]) ||
+      (ptExt[2] == ptExt[3]) || (ptExt[4] == ptExt[5]))))
+      {
+      coarse->SetDataSet(it, leaf);
+      continue;
+      }
+
+    BlockPair bp;
+    bp.Fine = fineBlock;
+    bp.Coarse.TakeReference(vtkImageData::New());
+
+    // get the coarse cell extent. blocks without any cells are left empty
+
+    for (int i = 0; i < 3; ++i)
+      {
+      bp.FineExt[2*i] = ptExt[2*i];
+      bp.FineExt[2*i+1] = ptExt[2*i+1] - 1;
+      }
+
+    int cellExt[6];
+    if (structureOnly || !sel.GetCellExtent(bp.FineExt, cellExt))
+      {
+      if (structureOnly)
+        coarse->SetDataSet(it, bp.Coarse);
+      continue;
+      }
+
+    sel.GetCoarseExtent(cellExt, bp.CoarseExt);
+
+    fineBlock->GetOrigin(x0);
+    fineBlock->GetSpacing(dx);
+
+    double cx0[3];
+    double cdx[3];
+    sel.GetCoarseGeometry(x0, dx, cx0, cdx);
+
+    bp.Coarse->SetOrigin(cx0);
+    bp.Coarse->SetSpacing(cdx);
+    bp.Coarse->SetExtent(bp.CoarseExt[0], bp.CoarseExt[1] + 1,
+      bp.CoarseExt[2], bp.CoarseExt[3] + 1, bp.CoarseExt[4],
+      bp.CoarseExt[5] + 1);
+
+    // pass field data through
+    bp.Coarse->GetFieldData()->ShallowCopy(fineBlock->GetFieldData());
+
+    coarse->SetDataSet(it, bp.Coarse);
+
+    rm.Blocks.push_back(bp);
+    }
+
+  this->Internals->Meshes[coarse] = rm;
+
+  // the caller takes a reference
+  mesh = coarse;
+
+  return 0;
+}
+
+//----------------------------------------------------------------------------
+int ReductionDataAdaptor::ReduceArray(vtkDataObject *mesh, int association,
+  const std::string &arrayName)
+{
+  TimeEvent<128> mark("ReductionDataAdaptor::ReduceArray");
+
+  std::map<vtkDataObject*, ReducedMesh>::iterator mit =
+    this->Internals->Meshes.find(mesh);
+
+  if (mit == this->Internals->Meshes.end())
+    {
+    SENSEI_ERROR("The mesh was not made by this adaptor")
+    return -1;
+    }
+
+  ReducedMesh &rm = mit->second;
+  std::vector<BlockPair> &blocks = rm.Blocks;
+
+  int s = this->Internals->Stride;
+  bool point = association == vtkDataObject::POINT;
+  bool ghosts = arrayName == "vtkGhostType";
+  bool box = !point && !ghosts && (this->Internals->Filter == FILTER_BOX);
+
+  // allocate the coarse arrays and make a work item per coarse k-plane
+  long nBlocks = blocks.size();
+  std::vector<vtkDataArrayPtr> fineArrays(nBlocks);
+  std::vector<vtkDataArrayPtr> coarseArrays(nBlocks);
+  std::vector<std::pair<long,long>> work;
+
+  for (long i = 0; i < nBlocks; ++i)
+    {
+    BlockPair &bp = blocks[i];
+
+    vtkDataArray *fa =
+      bp.Fine->GetAttributes(association)->GetArray(arrayName.c_str());
+
+    if (!fa)
+      {
+      SENSEI_ERROR("Block is missing "
+        << VTKUtils::GetAttributesName(association) << " data array \""
+        << arrayName << "\"")
+      return -1;
+      }
+
+    vtkDataArray *ca = fa->NewInstance();
+    ca->SetName(fa->GetName());
+    ca->SetNumberOfComponents(fa->GetNumberOfComponents());
+    ca->SetNumberOfTuples(point ? bp.Coarse->GetNumberOfPoints() :
+      bp.Coarse->GetNumberOfCells());
+
+    fineArrays[i] = fa;
+    coarseArrays[i].TakeReference(ca);
+
+    long nK = bp.CoarseExt[5] - bp.CoarseExt[4] + (point ? 2 : 1);
+    for (long k = 0; k < nK; ++k)
+      work.emplace_back(i, bp.CoarseExt[4] + k);
+    }
+
+  // reduce
+  ThreadPool &pool = ThreadPool::GetGlobalPool();
+  std::vector<std::vector<double>> acc(pool.GetNumberOfThreads());
+  std::vector<int> errors(nBlocks, 0);
+
+  pool.ParallelFor(work.size(),
+    [&](int thread, long w)
+    {
+    long i = work[w].first;
+    long K = work[w].second;
+
+    BlockPair &bp = blocks[i];
+    vtkDataArray *fa = fineArrays[i];
+    vtkDataArray *ca = coarseArrays[i];
+    int nComps = fa->GetNumberOfComponents();
+
+    switch (fa->GetDataType())
+      {
+      vtkTemplateMacro(
+        const VTK_TT *pFine = static_cast<const VTK_TT*>(fa->GetVoidPointer(0));
+        VTK_TT *pCoarse = static_cast<VTK_TT*>(ca->GetVoidPointer(0));
+        if (point)
+          reducePoints(pFine, pCoarse, nComps, bp.FineExt, bp.CoarseExt,
+            s, K);
+        else
+          reduceCells(pFine, pCoarse, nComps, bp.FineExt, bp.CoarseExt,
+            s, box, K, acc[thread]);
+        );
+      default:
+        errors[i] = 1;
+      }
+    });
+
+  // convert precision and pass to the coarse blocks
+  for (long i = 0; i < nBlocks; ++i)
+    {
+    if (errors[i])
+      {
+      SENSEI_ERROR("Failed to reduce " << fineArrays[i]->GetClassName()
+        << " \"" << arrayName << "\"")
+      return -1;
+      }
+
+    vtkDataArray *ca = coarseArrays[i];
+
+    vtkDataArray *pa = nullptr;
+    vtkDoubleArray *range = nullptr;
+    if (!ghosts && convertPrecision(ca, this->Internals->Precision, pa, range))
+      {
+      SENSEI_ERROR("Failed to convert the precision of \""
+        << arrayName << "\"")
+      return -1;
+      }
+
+    vtkImageData *cb = blocks[i].Coarse;
+    cb->GetAttributes(association)->AddArray(pa ? pa : ca);
+
+    if (pa)
+      pa->Delete();
+
+    if (range)
+      {
+      cb->GetFieldData()->AddArray(range);
+      range->Delete();
+      }
+    }
+
+  return 0;
+}
+
+//----------------------------------------------------------------------------
+int ReductionDataAdaptor::AddArray(vtkDataObject* mesh,
+  const std::string &meshName, int association, const std::string &arrayName)
+{
+  if (!this->Internals->Source)
+    {
+    SENSEI_ERROR("No data adaptor was set")
+    return -1;
+    }
+
+  // meshes that were passed through
+  std::map<vtkDataObject*, ReducedMesh>::iterator it =
+    this->Internals->Meshes.find(mesh);
+
+  if (it == this->Internals->Meshes.end())
+    return this->Internals->Source->AddArray(mesh, meshName,
+      association, arrayName);
+
+  // add the array to the fine blocks, then reduce
+  if (this->Internals->Source->AddArray(it->second.Fine, meshName,
+    association, arrayName))
+    return -1;
+
+  if ((association == vtkDataObject::FIELD) || it->second.Blocks.empty())
+    return 0;
+
+  return this->ReduceArray(mesh, association, arrayName);
+}
+
+//----------------------------------------------------------------------------
+int ReductionDataAdaptor::AddGhostNodesArray(vtkDataObject* mesh,
+  const std::string &meshName)
+{
+  if (!this->Internals->Source)
+    {
+    SENSEI_ERROR("No data adaptor was set")
+    return -1;
+    }
+
+  std::map<vtkDataObject*, ReducedMesh>::iterator it =
+    this->Internals->Meshes.find(mesh);
+
+  if (it == this->Internals->Meshes.end())
+    return this->Internals->Source->AddGhostNodesArray(mesh, meshName);
+
+  if (this->Internals->Source->AddGhostNodesArray(it->second.Fine, meshName))
+    return -1;
+
+  if (it->second.Blocks.empty())
+    return 0;
+
+  return this->ReduceArray(mesh, vtkDataObject::POINT, "vtkGhostType");
+}
+
+//----------------------------------------------------------------------------
+int ReductionDataAdaptor::AddGhostCellsArray(vtkDataObject* mesh,
+  const std::string &meshName)
+{
+  if (!this->Internals->Source)
+    {
+    SENSEI_ERROR("No data adaptor was set")
+    return -1;
+    }
+
+  std::map<vtkDataObject*, ReducedMesh>::iterator it =
+    this->Internals->Meshes.find(mesh);
+
+  if (it == this->Internals->Meshes.end())
+    return this->Internals->Source->AddGhostCellsArray(mesh, meshName);
+
+  if (this->Internals->Source->AddGhostCellsArray(it->second.Fine, meshName))
+    return -1;
+
+  if (it->second.Blocks.empty())
+    return 0;
+
+  return this->ReduceArray(mesh, vtkDataObject::CELL, "vtkGhostType");
+}
+
+//----------------------------------------------------------------------------
+int ReductionDataAdaptor::ReleaseData()
+{
+  this->Internals->Meshes.clear();
+
+  if (this->Internals->Source)
+    return this->Internals->Source->ReleaseData();
+
+  return 0;
+}
+
+//----------------------------------------------------------------------------
+double ReductionDataAdaptor::GetDataTime()
+{
+  return this->Internals->Source ?
+    this->Internals->Source->GetDataTime() : this->DataAdaptor::GetDataTime();
+}
+
+//----------------------------------------------------------------------------
+long ReductionDataAdaptor::GetDataTimeStep()
+{
+  return this->Internals->Source ?
+    this->Internals->Source->GetDataTimeStep() :
+    this->DataAdaptor::GetDataTimeStep();
+}
+
+}
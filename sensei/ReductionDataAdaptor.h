@@ -0,0 +1,111 @@
+#ifndef sensei_ReductionDataAdaptor_h
+#define sensei_ReductionDataAdaptor_h
+
+#include "DataAdaptor.h"
+
+#include <pugixml.hpp>
+#include <string>
+
+namespace sensei
+{
+/// @brief A DataAdaptor that delivers another adaptor's Cartesian meshes at
+///        reduced resolution and/or precision.
+///
+/// Placed in front of an analysis that does not need the full resolution
+/// data, for instance rendering or in transit movement, it cuts the data
+/// volume by the cube of the stride and the ratio of the value sizes. The
+/// vtkImageData blocks of multiblock meshes are coarsened by the stride.
+/// A coarse cell is owned by the block holding the first of the fine cells
+/// it covers, and coarse points sample the fine points, clamped to the
+/// block. Cell data is either sampled, taking the first fine cell, or box
+/// filtered, averaging the fine cells of the block the coarse cell covers.
+/// Point data and ghost arrays are always sampled. Results are exact when
+/// the block extents are multiples of the stride. Floating point arrays of
+/// the coarse blocks are optionally delivered as float, or quantized to 8
+/// or 16 bits, in which case the range needed to recover the values is
+/// passed in a field data array named <array name>_range. Other meshes and
+/// blocks are passed through unchanged. The work is done in parallel using
+/// the global ThreadPool.
+class ReductionDataAdaptor : public DataAdaptor
+{
+public:
+  static ReductionDataAdaptor *New();
+  senseiTypeMacro(ReductionDataAdaptor, DataAdaptor);
+
+  /// @brief Set the adaptor providing the full resolution data. This
+  /// releases the data cached from the previous adaptor.
+  void SetDataAdaptor(DataAdaptor *source);
+
+  /// @brief Set the number of fine cells in each direction that make up
+  /// a coarse cell. The default, 1, leaves the resolution unchanged.
+  void SetStride(int stride);
+
+  enum {FILTER_SAMPLE = 0, FILTER_BOX = 1};
+
+  /// @brief Set the filter used on cell data, FILTER_SAMPLE or
+  /// FILTER_BOX. May be given by name "sample" or "box".
+  void SetFilter(int filter);
+  int SetFilter(const std::string &filter);
+
+  enum {PRECISION_NATIVE = 0, PRECISION_FLOAT = 1, PRECISION_UINT16 = 2,
+    PRECISION_UINT8 = 3};
+
+  /// @brief Set the precision of floating point arrays. May be given by
+  /// name "native", "float", "uint16", or "uint8".
+  void SetPrecision(int precision);
+  int SetPrecision(const std::string &precision);
+
+  /// @brief Configure from the attributes stride, filter, and precision
+  /// of an XML element.
+  int Initialize(pugi::xml_node &node);
+
+  // SENSEI API
+  int GetNumberOfMeshes(unsigned int &numMeshes) override;
+
+  int GetMeshMetadata(unsigned int id, MeshMetadataPtr &metadata) override;
+
+  int GetMesh(const std::string &meshName, bool structureOnly,
+    vtkDataObject *&mesh) override;
+
+  using DataAdaptor::GetMesh;
+
+  int AddArray(vtkDataObject* mesh, const std::string &meshName,
+    int association, const std::string &arrayName) override;
+
+  using DataAdaptor::AddArray;
+
+  int AddGhostNodesArray(vtkDataObject* mesh,
+    const std::string &meshName) override;
+
+  using DataAdaptor::AddGhostNodesArray;
+
+  int AddGhostCellsArray(vtkDataObject* mesh,
+    const std::string &meshName) override;
+
+  using DataAdaptor::AddGhostCellsArray;
+
+  int ReleaseData() override;
+
+  double GetDataTime() override;
+
+  long GetDataTimeStep() override;
+
+protected:
+  ReductionDataAdaptor();
+  ~ReductionDataAdaptor();
+
+  ReductionDataAdaptor(const ReductionDataAdaptor&) = delete;
+  void operator=(const ReductionDataAdaptor&) = delete;
+
+  // reduce the named array from the fine blocks onto the coarse blocks
+  int ReduceArray(vtkDataObject *mesh, int association,
+    const std::string &arrayName);
+
+private:
+  struct InternalsType;
+  InternalsType *Internals;
+};
+
+}
+
+#endif
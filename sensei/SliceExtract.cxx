@@ -6,6 +6,8 @@
 #include "VTKPosthocIO.h"
 #include "VTKDataAdaptor.h"
 #include "VTKUtils.h"
+#include "CartesianExtract.h"
+#include "BlockParallel.h"
 #include "Profiler.h"
 #include "Error.h"
 
@@ -20,15 +22,57 @@
 #include <vtkCompositeDataSet.h>
 #include <vtkCompositeDataIterator.h>
 #include <vtkMultiBlockDataSet.h>
+#include <vtkPolyData.h>
 #include <vtkOverlappingAMR.h>
 #include <vtkUniformGridAMRDataIterator.h>
 
+#include <map>
+#include <mpi.h>
+
 
 using vtkDataObjectAlgorithmPtr = vtkSmartPointer<vtkDataObjectAlgorithm>;
 using vtkCellDataToPointDataPtr = vtkSmartPointer<vtkCellDataToPointData>;
 using vtkContourFilterPtr = vtkSmartPointer<vtkContourFilter>;
 using vtkCutterPtr = vtkSmartPointer<vtkCutter>;
 using vtkPlanePtr = vtkSmartPointer<vtkPlane>;
+using vtkDataObjectPtr = vtkSmartPointer<vtkDataObject>;
+
+namespace
+{
+// wrap a rank's extract in a multiblock with a block per rank
+vtkMultiBlockDataSet *NewRankMultiBlock(MPI_Comm comm, vtkPolyData *pd)
+{
+  int rank = 0;
+  int nRanks = 1;
+  MPI_Comm_rank(comm, &rank);
+  MPI_Comm_size(comm, &nRanks);
+
+  vtkMultiBlockDataSet *mbds = vtkMultiBlockDataSet::New();
+  mbds->SetNumberOfBlocks(nRanks);
+  mbds->SetBlock(rank, pd);
+
+  return mbds;
+}
+
+// convert indices into the metadata's per block arrays into block ids
+void getBlockIds(const sensei::MeshMetadataPtr &md,
+  const std::vector<int> &ids, std::vector<int> &blockIds)
+{
+  unsigned int n = ids.size();
+  blockIds.resize(n);
+  for (unsigned int i = 0; i < n; ++i)
+    blockIds[i] = md->BlockIds[ids[i]];
+}
+
+// --------------------------------------------------------------------------
+int numBlocksDescribed(const sensei::MeshMetadataPtr &md)
+{
+  // the metadata describes all blocks, or in a local view only this
+  // rank's blocks
+  return md->GlobalView ? md->NumBlocks :
+    (md->NumBlocksLocal.empty() ? -1 : md->NumBlocksLocal[0]);
+}
+}
 
 namespace sensei
 {
@@ -36,7 +80,7 @@ namespace sensei
 struct SliceExtract::InternalsType
 {
   InternalsType() : Operation(OP_PLANAR_SLICE), NumIsoValues(0),
-    EnablePartitioner(1)
+    EnablePartitioner(1), EnableCartesianExtract(1), NumberOfThreads(-1)
   {
     this->SlicePartitioner = PlanarSlicePartitioner::New();
     this->IsoValPartitioner = IsoSurfacePartitioner::New();
@@ -50,6 +94,8 @@ struct SliceExtract::InternalsType
   std::array<double,3> Normal;
   DataRequirements Requirements;
   int EnablePartitioner;
+  int EnableCartesianExtract;
+  int NumberOfThreads;
   IsoSurfacePartitionerPtr IsoValPartitioner;
   PlanarSlicePartitionerPtr SlicePartitioner;
   VTKPosthocIOPtr Writer;
@@ -78,6 +124,18 @@ void SliceExtract::EnablePartitioner(int val)
   this->Internals->EnablePartitioner = val;
 }
 
+// --------------------------------------------------------------------------
+void SliceExtract::EnableCartesianExtract(int val)
+{
+  this->Internals->EnableCartesianExtract = val;
+}
+
+// --------------------------------------------------------------------------
+void SliceExtract::SetNumberOfThreads(int val)
+{
+  this->Internals->NumberOfThreads = val;
+}
+
 // --------------------------------------------------------------------------
 int SliceExtract::SetOperation(int op)
 {
@@ -256,9 +314,24 @@ bool SliceExtract::ExecuteIsoSurface(DataAdaptor* dataAdaptor)
     return false;
     }
 
-  // get the mesh
+  // get the mesh. when running in situ and the block array ranges are
+  // available, only the blocks whose range includes one of the values are
+  // requested. in transit the partitioner has already done this.
   vtkCompositeDataSet *dobj = nullptr;
-  if (dataAdaptor->GetMesh(meshName, false, dobj))
+  std::vector<int> activeBlocks;
+  if (!itDataAdaptor &&
+    (int(md->BlockArrayRange.size()) == numBlocksDescribed(md)) &&
+    !IsoSurfacePartitioner::GetActiveBlocks(md, arrayName, isoVals, activeBlocks))
+    {
+    std::vector<int> blockIds;
+    getBlockIds(md, activeBlocks, blockIds);
+    if (dataAdaptor->GetMesh(meshName, false, blockIds, dobj))
+      {
+      SENSEI_ERROR("Failed to get mesh \"" << meshName << "\"")
+      return false;
+      }
+    }
+  else if (dataAdaptor->GetMesh(meshName, false, dobj))
     {
     SENSEI_ERROR("Failed to get mesh \"" << meshName << "\"")
     return false;
@@ -291,7 +364,7 @@ bool SliceExtract::ExecuteIsoSurface(DataAdaptor* dataAdaptor)
 
   // compute the iso-surfaces
   vtkCompositeDataSet *isoMesh = nullptr;
-  if (this->IsoSurface(dobj, arrayName, arrayCentering, isoVals, isoMesh))
+  if (this->IsoSurface(dobj, md, arrayName, arrayCentering, isoVals, isoMesh))
     {
     SENSEI_ERROR("Failed to extract slice")
     return false;
@@ -338,6 +411,7 @@ bool SliceExtract::ExecuteSlice(DataAdaptor* dataAdaptor)
   // figure out what the simulation can provide
   MeshMetadataFlags flags;
   flags.SetBlockDecomp();
+  flags.SetBlockBounds();
 
   MeshMetadataMap mdm;
   if (mdm.Initialize(dataAdaptor, flags))
@@ -362,9 +436,28 @@ bool SliceExtract::ExecuteSlice(DataAdaptor* dataAdaptor)
       return false;
       }
 
-    // get the mesh
+    // get the mesh. when running in situ and the block bounds are
+    // available, only the blocks that intersect the plane are requested.
+    // in transit the partitioner has already done this.
+    std::array<double,3> point, normal;
+    this->Internals->SlicePartitioner->GetPoint(point);
+    this->Internals->SlicePartitioner->GetNormal(normal);
+
     vtkCompositeDataSet *dobj = nullptr;
-    if (dataAdaptor->GetMesh(meshName, mit.StructureOnly(), dobj))
+    std::vector<int> activeBlocks;
+    if (!itDataAdaptor &&
+      (int(md->BlockBounds.size()) == numBlocksDescribed(md)) &&
+      !PlanarSlicePartitioner::GetActiveBlocks(md, point, normal, activeBlocks))
+      {
+      std::vector<int> blockIds;
+      getBlockIds(md, activeBlocks, blockIds);
+      if (dataAdaptor->GetMesh(meshName, mit.StructureOnly(), blockIds, dobj))
+        {
+        SENSEI_ERROR("Failed to get mesh \"" << meshName << "\"")
+        return false;
+        }
+      }
+    else if (dataAdaptor->GetMesh(meshName, mit.StructureOnly(), dobj))
       {
       SENSEI_ERROR("Failed to get mesh \"" << meshName << "\"")
       return false;
@@ -404,9 +497,6 @@ bool SliceExtract::ExecuteSlice(DataAdaptor* dataAdaptor)
 
     // compute the slice
     vtkCompositeDataSet *sliceMesh = nullptr;
-    std::array<double,3> point, normal;
-    this->Internals->SlicePartitioner->GetPoint(point);
-    this->Internals->SlicePartitioner->GetNormal(normal);
     if (this->Slice(dobj, point, normal, sliceMesh))
       {
       SENSEI_ERROR("Failed to extract slice")
@@ -436,35 +526,49 @@ bool SliceExtract::ExecuteSlice(DataAdaptor* dataAdaptor)
 
 // --------------------------------------------------------------------------
 int SliceExtract::IsoSurface(vtkCompositeDataSet *input,
-  const std::string &arrayName, int arrayCen, const std::vector<double> &vals,
-  vtkCompositeDataSet *&output)
+  const MeshMetadataPtr &md, const std::string &arrayName, int arrayCen,
+  const std::vector<double> &vals, vtkCompositeDataSet *&output)
 {
   TimeEvent<128> mark("SliceExtract::IsoSurface");
-  // build pipeline
-  vtkContourFilterPtr contour = vtkContourFilterPtr::New();
-  contour->SetComputeScalars(1);
 
-  contour->SetInputArrayToProcess(0, 0, 0,
-    vtkDataObject::FIELD_ASSOCIATION_POINTS, arrayName.c_str());
+  if (this->Internals->EnableCartesianExtract &&
+    CartesianExtract::Supported(input))
+    {
+    // the block array ranges let blocks that the surfaces do not pass
+    // through be skipped
+    std::map<long, std::array<double,2>> blockRanges;
 
-  unsigned int nVals = vals.size();
-  contour->SetNumberOfContours(nVals);
-  for (unsigned int i = 0; i < nVals; ++i)
-    contour->SetValue(i, vals[i]);
+    int arrayId = -1;
+    for (int i = 0; i < md->NumArrays; ++i)
+      {
+      if ((md->ArrayName[i] == arrayName) &&
+        (md->ArrayCentering[i] == arrayCen))
+        {
+        arrayId = i;
+        break;
+        }
+      }
 
-  // when processing cell data first convert to point data
-  vtkCellDataToPointDataPtr cdpd;
-  if (arrayCen == vtkDataObject::CELL)
-    {
-    cdpd = vtkCellDataToPointDataPtr::New();
-    cdpd->SetPassCellData(1);
-    /* in newer VTK one can select specific arrays to convert
-     * it is important not to convert vtkGhostType.
-    cdpd->SetProcessAllArrays(0);
-    cdpd->AddCellDataArray(arrayName.c_str());*/
-    contour->SetInputConnection(cdpd->GetOutputPort());
-    }
+    int nBlocks = md->BlockIds.size();
+    if ((arrayId >= 0) && (md->BlockArrayRange.size() == size_t(nBlocks)))
+      {
+      for (int i = 0; i < nBlocks; ++i)
+        blockRanges[md->BlockIds[i]] = md->BlockArrayRange[i][arrayId];
+      }
+
+    vtkPolyData *pd = nullptr;
+    if (CartesianExtract::IsoSurface(input, arrayName, arrayCen, vals,
+      blockRanges, pd, this->Internals->NumberOfThreads))
+      {
+      SENSEI_ERROR("Failed to compute iso-surfaces")
+      return -1;
+      }
 
+    output = NewRankMultiBlock(this->GetCommunicator(), pd);
+    pd->Delete();
+
+    return 0;
+    }
   // allocate output
   vtkCompositeDataIterator *it = input->NewIterator();
   it->SetSkipEmptyNodes(0);
@@ -482,7 +586,10 @@ int SliceExtract::IsoSurface(vtkCompositeDataSet *input,
   vtkUniformGridAMRDataIterator *amrIt = dynamic_cast<vtkUniformGridAMRDataIterator*>(it);
   vtkOverlappingAMR *amrMesh = dynamic_cast<vtkOverlappingAMR*>(input);
 
-  // process data
+  // gather the blocks
+  std::vector<vtkDataObject*> blocksIn;
+  std::vector<long> bids;
+
   it->SetSkipEmptyNodes(1);
   for (it->InitTraversal(); !it->IsDoneWithTraversal(); it->GoToNextItem())
     {
@@ -501,22 +608,71 @@ int SliceExtract::IsoSurface(vtkCompositeDataSet *input,
       bid = it->GetCurrentFlatIndex() - 1;
       }
 
-    vtkDataObject *dobjIn = it->GetCurrentDataObject();
+    blocksIn.push_back(it->GetCurrentDataObject());
+    bids.push_back(bid);
+    }
+
+  it->Delete();
+
+  // build a pipeline per thread
+  int nThreads = BlockParallel::GetNumberOfThreads(
+    this->Internals->NumberOfThreads);
+
+  std::vector<vtkContourFilterPtr> contours(nThreads);
+  std::vector<vtkCellDataToPointDataPtr> cdpds(nThreads);
+
+  unsigned int nVals = vals.size();
+  for (int i = 0; i < nThreads; ++i)
+    {
+    vtkContourFilterPtr contour = vtkContourFilterPtr::New();
+    contour->SetComputeScalars(1);
+
+    contour->SetInputArrayToProcess(0, 0, 0,
+      vtkDataObject::FIELD_ASSOCIATION_POINTS, arrayName.c_str());
+
+    contour->SetNumberOfContours(nVals);
+    for (unsigned int j = 0; j < nVals; ++j)
+      contour->SetValue(j, vals[j]);
+
+    // when processing cell data first convert to point data
+    if (arrayCen == vtkDataObject::CELL)
+      {
+      vtkCellDataToPointDataPtr cdpd = vtkCellDataToPointDataPtr::New();
+      cdpd->SetPassCellData(1);
+      /* in newer VTK one can select specific arrays to convert
+       * it is important not to convert vtkGhostType.
+      cdpd->SetProcessAllArrays(0);
+      cdpd->AddCellDataArray(arrayName.c_str());*/
+      contour->SetInputConnection(cdpd->GetOutputPort());
+      cdpds[i] = cdpd;
+      }
+
+    contours[i] = contour;
+    }
+
+  // process the blocks in parallel
+  long nIn = blocksIn.size();
+  std::vector<vtkDataObjectPtr> blocksOut(nIn);
+
+  BlockParallel::ForEach(nIn, nThreads,
+    [&](int thread, long i)
+    {
+    vtkContourFilter *contour = contours[thread];
 
     // run the pipeline on the block
     if (arrayCen == vtkDataObject::CELL)
-      cdpd->SetInputData(dobjIn);
+      cdpds[thread]->SetInputData(blocksIn[i]);
     else
-      contour->SetInputData(dobjIn);
+      contour->SetInputData(blocksIn[i]);
     contour->SetOutput(nullptr);
     contour->Update();
 
-    // save the extract
-    vtkDataObject *dobjOut = contour->GetOutput();
-    mbds->SetBlock(bid, dobjOut);
-    }
+    blocksOut[i] = contour->GetOutput();
+    });
 
-  it->Delete();
+  // save the extracts
+  for (long i = 0; i < nIn; ++i)
+    mbds->SetBlock(bids[i], blocksOut[i]);
 
   output = mbds;
 
@@ -530,14 +686,22 @@ int SliceExtract::Slice(vtkCompositeDataSet *input,
 {
   TimeEvent<128> mark("SliceExtract::Slice");
 
-  // build pipeline
-  vtkCutterPtr slice = vtkCutterPtr::New();
+  if (this->Internals->EnableCartesianExtract &&
+    CartesianExtract::Supported(input))
+    {
+    vtkPolyData *pd = nullptr;
+    if (CartesianExtract::Slice(input, point, normal, pd,
+      this->Internals->NumberOfThreads))
+      {
+      SENSEI_ERROR("Failed to compute the slice")
+      return -1;
+      }
 
-  vtkPlanePtr plane = vtkPlanePtr::New();
-  plane->SetOrigin(const_cast<double*>(point.data()));
-  plane->SetNormal(const_cast<double*>(normal.data()));
+    output = NewRankMultiBlock(this->GetCommunicator(), pd);
+    pd->Delete();
 
-  slice->SetCutFunction(plane.GetPointer());
+    return 0;
+    }
 
   // allocate output
   vtkCompositeDataIterator *it = input->NewIterator();
@@ -547,28 +711,53 @@ int SliceExtract::Slice(vtkCompositeDataSet *input,
   for (it->InitTraversal(); !it->IsDoneWithTraversal(); it->GoToNextItem())
     ++nBlocks;
 
+  it->Delete();
+
   vtkMultiBlockDataSet *mbds = vtkMultiBlockDataSet::New();
   mbds->SetNumberOfBlocks(nBlocks);
 
-  // process data
-  it->SetSkipEmptyNodes(1);
-  for (it->InitTraversal(); !it->IsDoneWithTraversal(); it->GoToNextItem())
+  // gather the blocks
+  std::vector<vtkDataObject*> blocksIn;
+  std::vector<long> bids;
+  BlockParallel::GetBlocks(input, blocksIn, &bids);
+
+  // build a pipeline per thread
+  int nThreads = BlockParallel::GetNumberOfThreads(
+    this->Internals->NumberOfThreads);
+
+  std::vector<vtkCutterPtr> slices(nThreads);
+  for (int i = 0; i < nThreads; ++i)
     {
-    // get the current block
-    unsigned int bid = it->GetCurrentFlatIndex() - 1;
-    vtkDataObject *dobjIn = it->GetCurrentDataObject();
+    vtkPlanePtr plane = vtkPlanePtr::New();
+    plane->SetOrigin(const_cast<double*>(point.data()));
+    plane->SetNormal(const_cast<double*>(normal.data()));
+
+    vtkCutterPtr slice = vtkCutterPtr::New();
+    slice->SetCutFunction(plane.GetPointer());
+
+    slices[i] = slice;
+    }
+
+  // process the blocks in parallel
+  long nIn = blocksIn.size();
+  std::vector<vtkDataObjectPtr> blocksOut(nIn);
+
+  BlockParallel::ForEach(nIn, nThreads,
+    [&](int thread, long i)
+    {
+    vtkCutter *slice = slices[thread];
 
     // set up and run the pipeline
-    slice->SetInputData(dobjIn);
+    slice->SetInputData(blocksIn[i]);
     slice->SetOutput(nullptr);
     slice->Update();
 
-    // save the extract
-    vtkDataObject *dobjOut = slice->GetOutput();
-    mbds->SetBlock(bid, dobjOut);
-    }
+    blocksOut[i] = slice->GetOutput();
+    });
 
-  it->Delete();
+  // save the extracts
+  for (long i = 0; i < nIn; ++i)
+    mbds->SetBlock(bids[i], blocksOut[i]);
 
   output = mbds;
 
@@ -2,6 +2,7 @@
 #define sensei_SliceExtract_h
 
 #include "AnalysisAdaptor.h"
+#include "MeshMetadata.h"
 
 #include <vector>
 #include <array>
@@ -27,6 +28,16 @@ public:
   // enable use of optimized partitioner
   void EnablePartitioner(int val);
 
+  // enable the native engine for meshes made of vtkImageData blocks. the
+  // blocks are processed in parallel and the result is a single polydata
+  // per rank. other meshes are processed by VTK filters, block by block.
+  void EnableCartesianExtract(int val);
+
+  // set the number of threads used to process the blocks. the default, -1,
+  // uses all of the global ThreadPool's threads. with the VTK filters each
+  // thread runs a pipeline of its own.
+  void SetNumberOfThreads(int val);
+
   // set which operation will be used. Valid values are OP_ISO_SURFACE=0,
   // OP_PLANAR_SLICE=1
   enum {OP_ISO_SURFACE=0, OP_PLANAR_SLICE=1};
@@ -78,7 +89,7 @@ private:
     int Slice(vtkCompositeDataSet *input, const std::array<double,3> &point,
       const std::array<double,3> &normal, vtkCompositeDataSet *&output);
 
-    int IsoSurface(vtkCompositeDataSet *input,
+    int IsoSurface(vtkCompositeDataSet *input, const MeshMetadataPtr &md,
       const std::string &arrayName, int arrayCen,
       const std::vector<double> &vals, vtkCompositeDataSet *&output);
 
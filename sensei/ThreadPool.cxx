@@ -0,0 +1,222 @@
+#include "ThreadPool.h"
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <algorithm>
+#include <cstdlib>
+
+namespace
+{
+// set on threads executing a loop body. loops started from a loop
+// body are run serially.
+thread_local int inParallelFor = 0;
+}
+
+namespace sensei
+{
+
+struct ThreadPool::InternalsType
+{
+  InternalsType() : Body(nullptr), N(0), Next(0), NumParticipants(0),
+    NumBusy(0), Generation(0), Quit(0)
+  {}
+
+  // the worker's main loop
+  void Run(int threadId);
+
+  // execute loop iterations until there are none left
+  void Work(int threadId);
+
+  std::vector<std::thread> Threads;
+  std::mutex LoopMutex;
+  std::mutex Mutex;
+  std::condition_variable WorkReady;
+  std::condition_variable WorkDone;
+  const ThreadPool::LoopBody *Body;
+  long N;
+  std::atomic<long> Next;
+  int NumParticipants;
+  int NumBusy;
+  unsigned long Generation;
+  int Quit;
+};
+
+// --------------------------------------------------------------------------
+void ThreadPool::InternalsType::Work(int threadId)
+{
+  long i = 0;
+  while ((i = this->Next.fetch_add(1, std::memory_order_relaxed)) < this->N)
+    (*this->Body)(threadId, i);
+}
+
+// --------------------------------------------------------------------------
+void ThreadPool::InternalsType::Run(int threadId)
+{
+  inParallelFor = 1;
+
+  unsigned long generation = 0;
+  while (1)
+    {
+    std::unique_lock<std::mutex> lock(this->Mutex);
+
+    this->WorkReady.wait(lock, [this,generation]() -> bool {
+      return this->Quit || (this->Generation != generation); });
+
+    if (this->Quit)
+      break;
+
+    generation = this->Generation;
+
+    // this thread is not needed for the current loop
+    if (threadId >= this->NumParticipants)
+      continue;
+
+    lock.unlock();
+
+    this->Work(threadId);
+
+    lock.lock();
+
+    this->NumBusy -= 1;
+    if (this->NumBusy == 0)
+      this->WorkDone.notify_all();
+    }
+}
+
+// --------------------------------------------------------------------------
+ThreadPool::ThreadPool(int nThreads)
+{
+  this->Internals = new InternalsType;
+
+  if (nThreads < 1)
+    nThreads = ThreadPool::GetDefaultNumberOfThreads();
+
+  // the calling thread is thread 0
+  for (int i = 1; i < nThreads; ++i)
+    this->Internals->Threads.emplace_back(
+      std::thread(&ThreadPool::InternalsType::Run, this->Internals, i));
+}
+
+// --------------------------------------------------------------------------
+ThreadPool::~ThreadPool()
+{
+  {
+  std::lock_guard<std::mutex> lock(this->Internals->Mutex);
+  this->Internals->Quit = 1;
+  }
+
+  this->Internals->WorkReady.notify_all();
+
+  unsigned int nThreads = this->Internals->Threads.size();
+  for (unsigned int i = 0; i < nThreads; ++i)
+    this->Internals->Threads[i].join();
+
+  delete this->Internals;
+}
+
+// --------------------------------------------------------------------------
+int ThreadPool::GetNumberOfThreads() const
+{
+  return this->Internals->Threads.size() + 1;
+}
+
+// --------------------------------------------------------------------------
+void ThreadPool::ParallelFor(long n, const LoopBody &body, int maxThreads)
+{
+  if (n < 1)
+    return;
+
+  int nThreads = this->GetNumberOfThreads();
+
+  if (maxThreads > 0)
+    nThreads = std::min(nThreads, maxThreads);
+
+  nThreads = std::min(long(nThreads), n);
+
+  // run in place when there is no parallelism to exploit or when called
+  // from a loop body
+  if ((nThreads < 2) || inParallelFor)
+    {
+    for (long i = 0; i < n; ++i)
+      body(0, i);
+    return;
+    }
+
+  InternalsType *internals = this->Internals;
+
+  // one loop at a time. when another thread's loop is in progress, for
+  // instance when the caller is itself one of several threads processing
+  // blocks, the loop runs in place rather than waiting for the pool
+  std::unique_lock<std::mutex> loopLock(internals->LoopMutex, std::try_to_lock);
+  if (!loopLock.owns_lock())
+    {
+    for (long i = 0; i < n; ++i)
+      body(0, i);
+    return;
+    }
+
+  {
+  std::lock_guard<std::mutex> lock(internals->Mutex);
+  internals->Body = &body;
+  internals->N = n;
+  internals->Next = 0;
+  internals->NumParticipants = nThreads;
+  internals->NumBusy = nThreads - 1;
+  internals->Generation += 1;
+  }
+
+  internals->WorkReady.notify_all();
+
+  // the calling thread participates
+  inParallelFor = 1;
+  internals->Work(0);
+  inParallelFor = 0;
+
+  std::unique_lock<std::mutex> lock(internals->Mutex);
+
+  internals->WorkDone.wait(lock,
+    [internals]() -> bool { return internals->NumBusy == 0; });
+
+  internals->Body = nullptr;
+}
+
+// --------------------------------------------------------------------------
+ThreadPool &ThreadPool::GetGlobalPool()
+{
+  static ThreadPool pool;
+  return pool;
+}
+
+// --------------------------------------------------------------------------
+int ThreadPool::GetDefaultNumberOfThreads()
+{
+  char *tmp = getenv("SENSEI_NUM_THREADS");
+  if (tmp)
+    return std::max(1, atoi(tmp));
+
+  int nCores = std::thread::hardware_concurrency();
+
+  // share the node's cores amongst the ranks running on it. the launchers
+  // report this in the environment which, unlike a communicator split, does
+  // not require a collective call.
+  const char *localSizeVars[] = {"OMPI_COMM_WORLD_LOCAL_SIZE",
+    "MPI_LOCALNRANKS", "MV2_COMM_WORLD_LOCAL_SIZE", "SLURM_TASKS_PER_NODE",
+    nullptr};
+
+  int nLocalRanks = 1;
+  for (int i = 0; localSizeVars[i]; ++i)
+    {
+    if ((tmp = getenv(localSizeVars[i])))
+      {
+      nLocalRanks = std::max(1, atoi(tmp));
+      break;
+      }
+    }
+
+  return std::max(1, nCores/nLocalRanks);
+}
+
+}
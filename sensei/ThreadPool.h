@@ -0,0 +1,63 @@
+#ifndef sensei_ThreadPool_h
+#define sensei_ThreadPool_h
+
+#include "senseiConfig.h"
+
+#include <functional>
+
+namespace sensei
+{
+
+// ThreadPool - a persistent pool of threads for data parallel loops
+/**
+The threads are created once and reused by every loop so that the cost of
+thread creation is not paid each time step. Loop iterations are handed out
+dynamically, one at a time, which balances loops over blocks of differing
+cost. The calling thread participates in the loop. A loop started from
+inside a loop body runs serially on the calling thread.
+
+The number of threads in the process wide pool returned by GetGlobalPool is
+taken from the SENSEI_NUM_THREADS environment variable when it is set.
+Otherwise the cores of the node are divided evenly amongst the MPI ranks
+running on it.
+*/
+class ThreadPool
+{
+public:
+  // the loop body is passed the id of the thread executing it, in
+  // [0, GetNumberOfThreads()), and the loop index. the thread id can
+  // be used to index thread local storage for reductions.
+  using LoopBody = std::function<void(int threadId, long i)>;
+
+  // create a pool with the given number of threads, including the
+  // caller. when nThreads < 1 the default number of threads is used.
+  ThreadPool(int nThreads = -1);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+  void operator=(const ThreadPool &) = delete;
+
+  // returns the number of threads, including the calling thread.
+  int GetNumberOfThreads() const;
+
+  // execute body(threadId, i) for i in [0, n) and wait for completion.
+  // at most maxThreads threads will be used, when maxThreads < 1 all of
+  // the pool's threads may be used. The pool executes one loop at a time,
+  // a loop started while the pool is busy runs serially on the caller.
+  void ParallelFor(long n, const LoopBody &body, int maxThreads = -1);
+
+  // get the process wide pool. it is created on first use.
+  static ThreadPool &GetGlobalPool();
+
+  // returns SENSEI_NUM_THREADS if set, else the number of cores divided
+  // by the number of MPI ranks on the node
+  static int GetDefaultNumberOfThreads();
+
+private:
+  struct InternalsType;
+  InternalsType *Internals;
+};
+
+}
+
+#endif
@@ -11,6 +11,8 @@
 #include <vtkObjectFactory.h>
 #include <vtkSmartPointer.h>
 #include <vtkOverlappingAMR.h>
+#include <vtkUniformGrid.h>
+#include <vtkUniformGridAMRDataIterator.h>
 #include <vtkCompositeDataPipeline.h>
 #include <vtkXMLPUniformGridAMRWriter.h>
 #include <vtkAlgorithm.h>
@@ -37,6 +39,58 @@ std::string getFileName(const std::string &outputDir,
   return fss.str();
 }
 
+//-----------------------------------------------------------------------------
+static
+vtkMPIController *newController(MPI_Comm comm)
+{
+  vtkMPICommunicatorOpaqueComm ocomm(&comm);
+
+  vtkMPICommunicator *vcomm = vtkMPICommunicator::New();
+  vcomm->InitializeExternal(&ocomm);
+
+  vtkMPIController *controller = vtkMPIController::New();
+  controller->Initialize(0,0,1);
+  controller->SetCommunicator(vcomm);
+  vcomm->Delete();
+
+  return controller;
+}
+
+//-----------------------------------------------------------------------------
+static
+vtkOverlappingAMR *copyHierarchy(vtkOverlappingAMR *amrIn, int deep)
+{
+  // the structure is copied and each block is replaced by a new
+  // object so that the caller is free to modify its blocks while the
+  // copy is in use. arrays are shared unless a deep copy is requested
+  vtkOverlappingAMR *amrOut = vtkOverlappingAMR::New();
+  amrOut->ShallowCopy(amrIn);
+
+  vtkUniformGridAMRDataIterator *it =
+    static_cast<vtkUniformGridAMRDataIterator*>(amrIn->NewIterator());
+
+  for (it->InitTraversal(); !it->IsDoneWithTraversal(); it->GoToNextItem())
+    {
+    vtkUniformGrid *gIn = dynamic_cast<vtkUniformGrid*>(it->GetCurrentDataObject());
+    if (!gIn)
+      continue;
+
+    vtkUniformGrid *gOut = vtkUniformGrid::New();
+
+    if (deep)
+      gOut->DeepCopy(gIn);
+    else
+      gOut->ShallowCopy(gIn);
+
+    amrOut->SetDataSet(it->GetCurrentLevel(), it->GetCurrentIndex(), gOut);
+    gOut->Delete();
+    }
+
+  it->Delete();
+
+  return amrOut;
+}
+
 
 namespace sensei
 {
@@ -44,8 +98,12 @@ namespace sensei
 senseiNewMacro(VTKAmrWriter);
 
 //-----------------------------------------------------------------------------
-VTKAmrWriter::VTKAmrWriter() : OutputDir("./"), Mode(MODE_PARAVIEW)
-{}
+VTKAmrWriter::VTKAmrWriter() : OutputDir("./"), Mode(MODE_PARAVIEW),
+  WriteBehind(0), WriteBehindDeepCopy(1), WriterComm(MPI_COMM_NULL),
+  WriterController(nullptr)
+{
+  this->WriteQueue.SetName("VTKAmrWriter");
+}
 
 //-----------------------------------------------------------------------------
 VTKAmrWriter::~VTKAmrWriter()
@@ -54,23 +112,40 @@ VTKAmrWriter::~VTKAmrWriter()
 //-----------------------------------------------------------------------------
 int VTKAmrWriter::Initialize()
 {
-  MPI_Comm comm = this->GetCommunicator();
-  vtkMPICommunicatorOpaqueComm ocomm(&comm);
-
-  vtkMPICommunicator *vcomm = vtkMPICommunicator::New();
-  vcomm->InitializeExternal(&ocomm);
-
-  vtkMPIController *controller = vtkMPIController::New();
-  controller->Initialize(0,0,1);
-  controller->SetCommunicator(vcomm);
-  vcomm->Delete();
-
+  vtkMPIController *controller = newController(this->GetCommunicator());
   vtkMultiProcessController::SetGlobalController(controller);
 
   vtkCompositeDataPipeline* cexec=vtkCompositeDataPipeline::New();
   vtkAlgorithm::SetDefaultExecutivePrototype(cexec);
   cexec->Delete();
 
+  if (this->WriteBehind)
+    {
+    // the parallel writer communicates, doing so from the I/O thread
+    // while the simulation communicates requires full thread support
+    int threadLevel = MPI_THREAD_SINGLE;
+    MPI_Query_thread(&threadLevel);
+
+    if (threadLevel < MPI_THREAD_MULTIPLE)
+      {
+      SENSEI_WARNING("Write behind requires MPI_THREAD_MULTIPLE. "
+        "Writes will be made in place.")
+      this->WriteBehind = 0;
+      return 0;
+      }
+
+    // the I/O thread communicates in its own space. the queue is FIFO
+    // so collective operations are issued in the same order on all ranks
+    MPI_Comm_dup(this->GetCommunicator(), &this->WriterComm);
+    this->WriterController = newController(this->WriterComm);
+
+    if (this->WriteQueue.Initialize())
+      {
+      SENSEI_ERROR("Failed to start the I/O thread")
+      return -1;
+      }
+    }
+
   return 0;
 }
 
@@ -121,6 +196,30 @@ int VTKAmrWriter::SetMode(std::string modeStr)
   return 0;
 }
 
+//-----------------------------------------------------------------------------
+void VTKAmrWriter::SetWriteBehind(int val)
+{
+  this->WriteBehind = val;
+}
+
+//-----------------------------------------------------------------------------
+int VTKAmrWriter::GetWriteBehind()
+{
+  return this->WriteBehind;
+}
+
+//-----------------------------------------------------------------------------
+void VTKAmrWriter::SetMaxBytesInFlight(long long nBytes)
+{
+  this->WriteQueue.SetMaxBytesInFlight(nBytes);
+}
+
+//-----------------------------------------------------------------------------
+void VTKAmrWriter::SetWriteBehindDeepCopy(int val)
+{
+  this->WriteBehindDeepCopy = val;
+}
+
 //-----------------------------------------------------------------------------
 int VTKAmrWriter::SetDataRequirements(const DataRequirements &reqs)
 {
@@ -225,22 +324,49 @@ bool VTKAmrWriter::Execute(DataAdaptor* dataAdaptor)
       ++ait;
       }
 
-    // initialize file id and time and step records
+    // initialize file id and time and step records, and the writer. the
+    // writer is kept for the run, in write behind mode it is used only
+    // from the I/O thread
     if (this->HaveBlockInfo.count(meshName) == 0)
       {
       this->HaveBlockInfo[meshName] = 1;
       this->FileId[meshName] = 0;
+
+      vtkXMLPUniformGridAMRWriter *w = vtkXMLPUniformGridAMRWriter::New();
+      if (this->WriteBehind)
+        w->SetController(this->WriterController);
+      this->Writers[meshName] = w;
       }
 
+    vtkXMLPUniformGridAMRWriter *writer = this->Writers[meshName];
+
     // write to disk
     std::string fileName =
       getFileName(this->OutputDir, meshName, this->FileId[meshName], ".vth");
 
-    vtkXMLPUniformGridAMRWriter *w = vtkXMLPUniformGridAMRWriter::New();
-    w->SetInputData(dobj);
-    w->SetFileName(fileName.c_str());
-    w->Write();
-    w->Delete();
+    if (this->WriteBehind)
+      {
+      vtkSmartPointer<vtkOverlappingAMR> amr;
+      amr.TakeReference(copyHierarchy(static_cast<vtkOverlappingAMR*>(dobj),
+        this->WriteBehindDeepCopy));
+
+      long long nBytes = 1024ll*amr->GetActualMemorySize();
+
+      this->WriteQueue.Push(nBytes, [amr, fileName, writer]() -> int {
+        writer->SetInputData(amr);
+        writer->SetFileName(fileName.c_str());
+        writer->Write();
+        writer->SetInputData(nullptr);
+        return 0;
+        });
+      }
+    else
+      {
+      writer->SetInputData(dobj);
+      writer->SetFileName(fileName.c_str());
+      writer->Write();
+      writer->SetInputData(nullptr);
+      }
 
     // update file id
     this->FileId[meshName] += 1;
@@ -269,6 +395,37 @@ int VTKAmrWriter::Finalize()
   int rank = 0;
   MPI_Comm_rank(this->GetCommunicator(), &rank);
 
+  // wait for the I/O thread to write the queued hierarchies
+  int nErrors = 0;
+  if (this->WriteBehind)
+    {
+    nErrors = this->WriteQueue.Finalize();
+
+    if (this->GetVerbose())
+      {
+      long nTasks = 0;
+      long maxDepth = 0;
+      long long maxBytes = 0;
+      double stallTime = 0.0;
+      this->WriteQueue.GetStatistics(nTasks, maxDepth, maxBytes, stallTime);
+
+      SENSEI_STATUS("VTKAmrWriter wrote " << nTasks << " steps from the"
+        " I/O thread. max queue depth " << maxDepth << ", max bytes in flight "
+        << maxBytes << ", stall time " << stallTime << " seconds")
+      }
+
+    this->WriterController->Finalize(1);
+    this->WriterController->Delete();
+    this->WriterController = nullptr;
+
+    MPI_Comm_free(&this->WriterComm);
+    }
+
+  NameMap<vtkXMLPUniformGridAMRWriter*>::iterator wit = this->Writers.begin();
+  for (; wit != this->Writers.end(); ++wit)
+    wit->second->Delete();
+  this->Writers.clear();
+
   // clean up VTK
   vtkMultiProcessController *controller =
     vtkMultiProcessController::GetGlobalController();
@@ -279,6 +436,12 @@ int VTKAmrWriter::Finalize()
   vtkMultiProcessController::SetGlobalController(nullptr);
   vtkAlgorithm::SetDefaultExecutivePrototype(nullptr);
 
+  if (nErrors)
+    {
+    SENSEI_ERROR(nErrors << " steps failed to write")
+    return -1;
+    }
+
   // rank 0 will write meta files
   if (rank != 0)
     return 0;
@@ -3,11 +3,14 @@
 
 #include "AnalysisAdaptor.h"
 #include "DataRequirements.h"
+#include "WriteBehindQueue.h"
 
 #include <mpi.h>
 #include <vector>
 #include <string>
 
+class vtkMPIController;
+class vtkXMLPUniformGridAMRWriter;
 
 namespace sensei
 {
@@ -21,6 +24,12 @@ namespace sensei
 /// consisting of a list of meshes and the arrays to write from
 /// each mesh. File names are derived using the output directory,
 /// the mesh name, and the mode.
+///
+/// In write behind mode the hierarchy is shallow copied, holding
+/// references to the arrays, and written from a per-rank I/O thread.
+/// Because VTK's parallel AMR writer communicates, the I/O thread uses
+/// its own communicator and write behind requires MPI_THREAD_MULTIPLE.
+/// When it is not available writes are made in place.
 class VTKAmrWriter : public AnalysisAdaptor
 {
 public:
@@ -42,6 +51,21 @@ public:
   int AddDataRequirement(const std::string &meshName,
     int association, const std::vector<std::string> &arrays);
 
+  // enable/disable writing from a background I/O thread. this must be
+  // set before calling Initialize. default value: disabled
+  void SetWriteBehind(int val);
+  int GetWriteBehind();
+
+  // sets the maximum number of bytes that hierarchies queued for
+  // writing may hold. default value: 1 GiB
+  void SetMaxBytesInFlight(long long nBytes);
+
+  // when set blocks are deep copied before being queued. when not set the
+  // queued blocks share their arrays with the simulation, which is only
+  // safe when the data adaptor hands out fresh buffers every step, rather
+  // than memory the simulation updates in place. default value: enabled
+  void SetWriteBehindDeepCopy(int val);
+
   int Initialize();
 
   // SENSEI API
@@ -60,6 +84,11 @@ private:
   std::string OutputDir;
   DataRequirements Requirements;
   int Mode;
+  int WriteBehind;
+  int WriteBehindDeepCopy;
+  WriteBehindQueue WriteQueue;
+  MPI_Comm WriterComm;
+  vtkMPIController *WriterController;
 
   template<typename T>
   using NameMap = std::map<std::string, T>;
@@ -68,6 +97,7 @@ private:
   NameMap<std::vector<long>> TimeStep;
   NameMap<long> FileId;
   NameMap<int> HaveBlockInfo;
+  NameMap<vtkXMLPUniformGridAMRWriter*> Writers;
 #endif
 };
 
@@ -21,6 +21,7 @@
 
 #include <functional>
 #include <map>
+#include <set>
 #include <utility>
 
 using vtkDataObjectPtr = vtkSmartPointer<vtkDataObject>;
@@ -36,6 +37,10 @@ namespace sensei
 struct VTKDataAdaptor::InternalsType
 {
   MeshMapType MeshMap;
+
+  // array ranges saved from the previous call to GetMeshMetadata. these
+  // persist across ReleaseData
+  std::map<std::string, VTKUtils::ArrayRangeCache> RangeCache;
 };
 
 //----------------------------------------------------------------------------
@@ -75,6 +80,29 @@ int VTKDataAdaptor::GetDataObject(const std::string &meshName,
   return 0;
 }
 
+//----------------------------------------------------------------------------
+void VTKDataAdaptor::SetUnchangedArrays(const std::string &meshName,
+  int association, const std::vector<std::string> &arrayNames)
+{
+  VTKUtils::ArrayRangeCache &cache = this->Internals->RangeCache[meshName];
+
+  std::set<VTKUtils::ArrayRangeCache::KeyType>::iterator it =
+    cache.Unchanged.begin();
+
+  while (it != cache.Unchanged.end())
+    {
+    if (it->first == association)
+      it = cache.Unchanged.erase(it);
+    else
+      ++it;
+    }
+
+  unsigned int n = arrayNames.size();
+  for (unsigned int i = 0; i < n; ++i)
+    cache.Unchanged.insert(VTKUtils::ArrayRangeCache::KeyType(association,
+      arrayNames[i]));
+}
+
 //----------------------------------------------------------------------------
 int VTKDataAdaptor::GetNumberOfMeshes(unsigned int &numMeshes)
 {
@@ -109,10 +137,12 @@ int VTKDataAdaptor::GetMeshMetadata(unsigned int id, MeshMetadataPtr &metadata)
   // fill in metadata
   metadata->MeshName = meshName;
 
+  VTKUtils::ArrayRangeCache *cache = &this->Internals->RangeCache[meshName];
+
   // multiblock and amr
   if (vtkCompositeDataSet *cd = dynamic_cast<vtkCompositeDataSet*>(dobj))
     {
-    if (VTKUtils::GetMetadata(this->GetCommunicator(), cd, metadata))
+    if (VTKUtils::GetMetadata(this->GetCommunicator(), cd, metadata, cache))
       {
       SENSEI_ERROR("Failed to get metadata for composite mesh \""
         << meshName << "\"")
@@ -124,7 +154,7 @@ int VTKDataAdaptor::GetMeshMetadata(unsigned int id, MeshMetadataPtr &metadata)
   // ParaView's legacy domain decomp
   if (vtkDataSet *ds = dynamic_cast<vtkDataSet*>(dobj))
     {
-    if (VTKUtils::GetMetadata(this->GetCommunicator(), ds, metadata))
+    if (VTKUtils::GetMetadata(this->GetCommunicator(), ds, metadata, cache))
       {
       SENSEI_ERROR("Failed to get metadata for dataset mesh \""
         << meshName << "\"")
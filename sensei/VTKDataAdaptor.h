@@ -4,6 +4,9 @@
 #include "DataAdaptor.h"
 #include <vtkSmartPointer.h>
 
+#include <string>
+#include <vector>
+
 class vtkDataObject;
 
 namespace sensei
@@ -45,6 +48,19 @@ public:
   /// @returns zero if the named mesh is present, non zero if it was not
   int GetDataObject(const std::string &meshName, vtkDataObject *&dobj);
 
+  /// @brief Declare arrays whose values do not change between time steps.
+  ///
+  /// Per block array ranges computed by GetMeshMetadata are saved, and
+  /// on subsequent time steps the saved ranges of the named arrays are
+  /// reported rather than recomputed. Passing an empty list clears the
+  /// declaration for the given mesh and association.
+  ///
+  /// @param[in] meshName the name of the mesh
+  /// @param[in] association vtkDataObject::POINT or vtkDataObject::CELL
+  /// @param[in] arrayNames the names of the unchanging arrays
+  void SetUnchangedArrays(const std::string &meshName, int association,
+    const std::vector<std::string> &arrayNames);
+
   /// @breif Gets the number of meshes a simulation can provide
   ///
   /// The caller passes a reference to an integer variable in the first
@@ -1,226 +1,133 @@
 #include "senseiConfig.h"
 #include "VTKHistogram.h"
+#include "BlockParallel.h"
 #include "Error.h"
 
 #include <algorithm>
+#include <array>
+#include <iomanip>
 #include <vector>
 #include <cstdio>
 #include <cstring>
 #include <errno.h>
 
-#include <vtkSmartPointer.h>
-#include <vtkUnsignedCharArray.h>
-#ifdef ENABLE_VTK_GENERIC_ARRAYS
-#include <vtkAOSDataArrayTemplate.h>
-#include <vtkArrayDispatch.h>
-#include <vtkCompositeDataIterator.h>
-#include <vtkCompositeDataSet.h>
 #include <vtkDataArray.h>
-#include <vtkDataObject.h>
-#include <vtkFieldData.h>
-#include <vtkObjectFactory.h>
-#else
-#include <vtkDataArrayDispatcher.h>
-#include <vtkDataArrayTemplate.h>
-#endif
+#include <vtkType.h>
+#include <vtkUnsignedCharArray.h>
 
-namespace sensei
+namespace
 {
-// Private worker for Histogram method. Computes the local Histogram on
-// array (passed to operator()). To be used with vtkArrayDispatch.
-//
-// Inputs:
-// range: Global range of data
-// bins: Number of Histogram bins
-// array: Local data.
-//
-// Outputs:
-// Histogram: The Histogram of the local data.
-#ifdef ENABLE_VTK_GENERIC_ARRAYS
-struct VTKHistogram::Internals
+// get the range of the first component of elements [first, last),
+// skipping ghosts
+template <typename T>
+void getRange(const T *data, int nComps, const unsigned char *ghosts,
+  long first, long last, double *range)
 {
-  const double *Range;
-  int Bins;
-  std::vector<unsigned int> Histogram;
-
-  Internals(const double *range, int bins) :
-    Range(range), Bins(bins), Histogram(bins,0.0) {}
-
-  template <typename ArrayT>
-  void operator()(ArrayT *array)
-  {
-    assert(array);
-    assert(array->GetNumberOfComponents() == 1);
-
-    typedef typename ArrayT::ValueType ValueType;
-
-    ValueType width = static_cast<ValueType>((this->Range[1]
-      - this->Range[0]) / this->Bins);
-
-    ValueType min = static_cast<ValueType>(this->Range[0]);
-    vtkIdType numTuples = array->GetNumberOfTuples();
+  for (long i = first; i < last; ++i)
+    {
+    if (ghosts && ghosts[i])
+      continue;
 
-    // + 1 to store val == max. These will be moved to this last bin before
-    // returning (Avoids having to branch in the loop below);
-    this->Histogram.resize(this->Bins + 1, 0);
-    for (vtkIdType tIdx = 0; tIdx < numTuples; ++tIdx)
-      {
-      int bin = static_cast<int>((array->GetComponent(tIdx, 0) - min) / width);
-      ++this->Histogram[bin];
-      }
+    double val = static_cast<double>(data[i*nComps]);
+    range[0] = std::min(range[0], val);
+    range[1] = std::max(range[1], val);
+    }
+}
 
-    // Merge the last two bins (the last is only when val == max)
-    this->Histogram[this->Bins-1] += this->Histogram[this->Bins];
-    this->Histogram.resize(this->Bins);
-  }
-};
-#else
-struct VTKHistogram::Internals
+// bin the first component of elements [first, last), skipping ghosts. the
+// value equal to the max lands in the last bin.
+template <typename T>
+void binValues(const T *data, int nComps, const unsigned char *ghosts,
+  long first, long last, double min, double width, int nBins,
+  unsigned int *hist)
 {
-  vtkUnsignedCharArray* GhostArray;
-  const double *Range;
-  int Bins;
-  std::vector<unsigned int> Histogram;
-
-  Internals(const double *range, int bins) :
-    GhostArray(NULL), Range(range), Bins(bins), Histogram(bins,0.0) {}
-
-  template <typename T>
-  void operator()(const vtkDataArrayDispatcherPointer<T>& array)
-  {
-    assert(array.NumberOfComponents == 1);
-
-    typedef T ValueType;
-    ValueType width = static_cast<ValueType>((this->Range[1] - this->Range[0]) / this->Bins);
-    ValueType min = static_cast<ValueType>(this->Range[0]);
-    vtkIdType numTuples = array.NumberOfTuples;
-
-    // + 1 to store val == max. These will be moved to this last bin before
-    // returning (Avoids having to branch in the loop below);
-    this->Histogram.resize(this->Bins + 1, 0);
-    if (this->GhostArray)
-      {
-      for (vtkIdType tIdx = 0; tIdx < numTuples; ++tIdx)
-        {
-        if (this->GhostArray->GetValue(tIdx) == 0)
-          {
-          int bin = static_cast<int>((array.RawPointer[tIdx] - min) / width);
-          ++this->Histogram[bin];
-          }
-        }
-      }
-    else
-      {
-      for (vtkIdType tIdx = 0; tIdx < numTuples; ++tIdx)
-        {
-        int bin = static_cast<int>((array.RawPointer[tIdx] - min) / width);
-        ++this->Histogram[bin];
-        }
-      }
+  for (long i = first; i < last; ++i)
+    {
+    if (ghosts && ghosts[i])
+      continue;
 
-    // Merge the last two bins (the last is only when val == max)
-    this->Histogram[this->Bins-1] += this->Histogram[this->Bins];
-    this->Histogram.resize(this->Bins);
-  }
-};
+    int bin = static_cast<int>((data[i*nComps] - min) / width);
+    bin = bin < 0 ? 0 : (bin >= nBins ? nBins - 1 : bin);
+    ++hist[bin];
+    }
+}
 
-// Compute array range by skipping ghost elements.
-class ComponentRangeWorker
+// get the sizes of the arrays, to split them between the threads, and
+// their pointers. the pointers are fetched here, before the threads start,
+// since VTK makes a copy of arrays that are not stored as contiguous tuples
+void getArrays(const std::vector<vtkDataArray*> &arrays,
+  std::vector<long> &sizes, std::vector<void*> &ptrs)
 {
-public:
-  ComponentRangeWorker(vtkUnsignedCharArray* ghostArray) :
-    GhostArray(ghostArray)
+  unsigned int nArrays = arrays.size();
+  sizes.resize(nArrays);
+  ptrs.resize(nArrays);
+  for (unsigned int i = 0; i < nArrays; ++i)
     {
-    this->Range[0] = vtkTypeTraits<double>::Max();
-    this->Range[1] = vtkTypeTraits<double>::Min();
+    sizes[i] = arrays[i] ? arrays[i]->GetNumberOfTuples() : 0;
+    ptrs[i] = sizes[i] ? arrays[i]->GetVoidPointer(0) : nullptr;
     }
+}
 
-  template <typename T>
-  void operator()(const vtkDataArrayDispatcherPointer<T>& array)
-    {
-    assert(array.NumberOfComponents == 1);
-    vtkIdType numTuples = array.NumberOfTuples;
-    for (vtkIdType cc=0; cc < numTuples; cc++)
-      {
-      if (this->GhostArray->GetValue(cc) == 0)
-        {
-        this->Range[0] = std::min(this->Range[0], static_cast<double>(array.RawPointer[cc]));
-        this->Range[1] = std::max(this->Range[1], static_cast<double>(array.RawPointer[cc]));
-        }
-      }
-    }
+// get the ghost array's pointer, if there is one for the block
+const unsigned char *getGhosts(
+  const std::vector<vtkUnsignedCharArray*> &ghostArrays, long i)
+{
+  return (i < long(ghostArrays.size())) && ghostArrays[i] ?
+    ghostArrays[i]->GetPointer(0) : nullptr;
+}
+}
 
-  void GetRange(double r[2])
-    {
-    std::copy(this->Range, this->Range+2, r);
-    }
-private:
-  double Range[2];
-  vtkUnsignedCharArray* GhostArray;
-};
-#endif
+namespace sensei
+{
 
 // --------------------------------------------------------------------------
 VTKHistogram::VTKHistogram()
 {
   this->Range[0] = VTK_DOUBLE_MAX;
   this->Range[1] = VTK_DOUBLE_MIN;
-  this->Worker = NULL;
 }
 
 // --------------------------------------------------------------------------
 VTKHistogram::~VTKHistogram()
 {
-  delete this->Worker;
 }
 
 // --------------------------------------------------------------------------
-void VTKHistogram::AddRange(vtkDataArray* da,
-  vtkUnsignedCharArray* ghostArray)
+void VTKHistogram::AddRange(const std::vector<vtkDataArray*> &arrays,
+  const std::vector<vtkUnsignedCharArray*> &ghostArrays, int nThreads)
 {
-#ifdef ENABLE_VTK_GENERIC_ARRAYS
-  (void)ghostArray;
-  if (da)
-    {
-    double crange[2];
-    da->GetRange(crange);
-    this->Range[0] = std::min(this->Range[0], crange[0]);
-    this->Range[1] = std::max(this->Range[1], crange[1]);
-    }
-#else
-  double crange[2] = { vtkTypeTraits<double>::Max(), vtkTypeTraits<double>::Min() };
-  if (da && ghostArray)
-    {
-    ComponentRangeWorker worker(ghostArray);
-    vtkDataArrayDispatcher<ComponentRangeWorker> dispatcher(worker);
-    dispatcher.Go(da);
-    worker.GetRange(crange);
-    }
-  else if (da)
+  std::vector<long> sizes;
+  std::vector<void*> ptrs;
+  getArrays(arrays, sizes, ptrs);
+
+  std::array<double,2> init{{VTK_DOUBLE_MAX, VTK_DOUBLE_MIN}};
+  BlockParallel::ThreadLocal<std::array<double,2>> ranges(nThreads, init);
+
+  BlockParallel::ForEachPiece(sizes, nThreads,
+    [&](int thread, long i, long first, long last)
     {
-    da->GetRange(crange);
-    }
-  this->Range[0] = std::min(this->Range[0], crange[0]);
-  this->Range[1] = std::max(this->Range[1], crange[1]);
-#endif
-}
+    vtkDataArray *da = arrays[i];
+    const unsigned char *ghosts = getGhosts(ghostArrays, i);
+    int nComps = da->GetNumberOfComponents();
+    double *range = ranges[thread].data();
+    switch (da->GetDataType())
+      {
+      vtkTemplateMacro(
+        getRange(static_cast<const VTK_TT*>(ptrs[i]),
+          nComps, ghosts, first, last, range);
+        );
+      }
+    });
 
-// --------------------------------------------------------------------------
-void VTKHistogram::Compute(vtkDataArray* da,
-  vtkUnsignedCharArray* ghostArray)
-{
-  if (da)
+  std::array<double,2> &range = ranges.Merge(
+    [](std::array<double,2> &a, const std::array<double,2> &b)
     {
-#ifdef ENABLE_VTK_GENERIC_ARRAYS
-    (void)ghostArray;
-    vtkArrayDispatch::Dispatch::Execute(da, *this->Worker);
-#else
-    this->Worker->GhostArray = ghostArray;
-    vtkDataArrayDispatcher<Internals> dispatcher(*this->Worker);
-    dispatcher.Go(da);
-    this->Worker->GhostArray = NULL;
-#endif
-    }
+    a[0] = std::min(a[0], b[0]);
+    a[1] = std::max(a[1], b[1]);
+    });
+
+  this->Range[0] = std::min(this->Range[0], range[0]);
+  this->Range[1] = std::max(this->Range[1], range[1]);
 }
 
 // --------------------------------------------------------------------------
@@ -232,7 +139,59 @@ void VTKHistogram::PreCompute(MPI_Comm comm, int bins)
   MPI_Allreduce(&this->Range[1], &g_range[1], 1, MPI_DOUBLE, MPI_MAX, comm);
   this->Range[0] = g_range[0];
   this->Range[1] = g_range[1];
-  this->Worker = new Internals(this->Range, bins);
+  this->Histogram.assign(bins, 0);
+}
+
+// --------------------------------------------------------------------------
+void VTKHistogram::Compute(const std::vector<vtkDataArray*> &arrays,
+  const std::vector<vtkUnsignedCharArray*> &ghostArrays, int nThreads)
+{
+  int nBins = this->Histogram.size();
+  if (nBins < 1)
+    return;
+
+  double min = this->Range[0];
+  double width = (this->Range[1] - this->Range[0]) / nBins;
+
+  // a degenerate range is reported by PostCompute, until then put
+  // everything in the first bin
+  if (!(width > 0.0))
+    width = 1.0;
+
+  std::vector<long> sizes;
+  std::vector<void*> ptrs;
+  getArrays(arrays, sizes, ptrs);
+
+  // each thread bins into its own histogram, these are summed before the
+  // MPI reduction
+  BlockParallel::ThreadLocal<std::vector<unsigned int>>
+    hists(nThreads, std::vector<unsigned int>(nBins, 0));
+
+  BlockParallel::ForEachPiece(sizes, nThreads,
+    [&](int thread, long i, long first, long last)
+    {
+    vtkDataArray *da = arrays[i];
+    const unsigned char *ghosts = getGhosts(ghostArrays, i);
+    int nComps = da->GetNumberOfComponents();
+    unsigned int *hist = hists[thread].data();
+    switch (da->GetDataType())
+      {
+      vtkTemplateMacro(
+        binValues(static_cast<const VTK_TT*>(ptrs[i]),
+          nComps, ghosts, first, last, min, width, nBins, hist);
+        );
+      }
+    });
+
+  std::vector<unsigned int> &hist = hists.Merge(
+    [nBins](std::vector<unsigned int> &a, const std::vector<unsigned int> &b)
+    {
+    for (int j = 0; j < nBins; ++j)
+      a[j] += b[j];
+    });
+
+  for (int j = 0; j < nBins; ++j)
+    this->Histogram[j] += hist[j];
 }
 
 // --------------------------------------------------------------------------
@@ -242,7 +201,9 @@ void VTKHistogram::PostCompute(MPI_Comm comm, int nBins, int step,
 {
   std::vector<unsigned int> gHist(nBins, 0);
 
-  MPI_Reduce(&this->Worker->Histogram[0], &gHist[0],
+  this->Histogram.resize(nBins, 0);
+
+  MPI_Reduce(this->Histogram.data(), gHist.data(),
     nBins, MPI_UNSIGNED, MPI_SUM, 0, comm);
 
   int rank = 0;
@@ -312,7 +273,7 @@ void VTKHistogram::PostCompute(MPI_Comm comm, int nBins, int step,
       }
 
     // cache the last result, the simulation can access it
-    this->Worker->Histogram = gHist;
+    this->Histogram = gHist;
     }
 }
 
@@ -320,7 +281,7 @@ void VTKHistogram::PostCompute(MPI_Comm comm, int nBins, int step,
 int VTKHistogram::GetHistogram(MPI_Comm comm, double &min, double &max,
   std::vector<unsigned int> &bins)
 {
-  if (!this->Worker)
+  if (this->Histogram.empty())
     return -1;
 
   int rank = 0;
@@ -330,7 +291,7 @@ int VTKHistogram::GetHistogram(MPI_Comm comm, double &min, double &max,
     {
     min = this->Range[0];
     max = this->Range[1];
-    bins = this->Worker->Histogram;
+    bins = this->Histogram;
     }
 
   return 0;
@@ -11,19 +11,29 @@ class vtkDataArray;
 namespace sensei
 {
 
+// Computes the histogram of the first component of a set of arrays, one
+// per local block, skipping the ghost elements flagged in the optional
+// ghost arrays. The blocks are processed on nThreads threads of the global
+// ThreadPool, each thread accumulating into its own range and bins which
+// are merged before the MPI reductions.
 class VTKHistogram
 {
 public:
     VTKHistogram();
     ~VTKHistogram();
 
-    void AddRange(vtkDataArray* da, vtkUnsignedCharArray* ghostArray);
+    // compute the local min and max
+    void AddRange(const std::vector<vtkDataArray*> &arrays,
+      const std::vector<vtkUnsignedCharArray*> &ghostArrays,
+      int nThreads = -1);
 
     // compute the global min and max
     void PreCompute(MPI_Comm comm, int bins);
 
     // do the local histgram calculation
-    void Compute(vtkDataArray* da, vtkUnsignedCharArray* ghostArray);
+    void Compute(const std::vector<vtkDataArray*> &arrays,
+      const std::vector<vtkUnsignedCharArray*> &ghostArrays,
+      int nThreads = -1);
 
     // do the reduction, write the result to a file, or cout.
     // the result is cached on rank 0.
@@ -37,8 +47,7 @@ public:
 
 private:
   double Range[2];
-  struct Internals;
-  Internals *Worker;
+  std::vector<unsigned int> Histogram;
 };
 
 }
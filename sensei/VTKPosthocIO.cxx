@@ -89,6 +89,62 @@ std::string getBlockFileName(const std::string &outputDir,
   return oss.str();
 }
 
+//-----------------------------------------------------------------------------
+static
+int writeBlock(vtkDataSet *ds, const std::string &fileName, int writerType,
+  int largeWrites)
+{
+  // when large writes are requested the file is serialized in memory and
+  // then written with a small number of large writes
+  if (writerType == sensei::VTKPosthocIO::WRITER_VTK_LEGACY)
+    {
+    vtkDataSetWriter *writer = vtkDataSetWriter::New();
+    writer->SetInputData(ds);
+    writer->SetFileTypeToBinary();
+
+    int ierr = 0;
+    if (largeWrites)
+      {
+      writer->WriteToOutputStringOn();
+      writer->Write();
+      ierr = sensei::WriteBehindQueue::WriteFile(fileName,
+        writer->GetOutputString(), writer->GetOutputStringLength());
+      }
+    else
+      {
+      writer->SetFileName(fileName.c_str());
+      writer->Write();
+      }
+
+    writer->Delete();
+    return ierr;
+    }
+
+  vtkXMLDataSetWriter *writer = vtkXMLDataSetWriter::New();
+  writer->SetInputData(ds);
+  writer->SetDataModeToAppended();
+  writer->EncodeAppendedDataOff();
+  writer->SetCompressorTypeToNone();
+
+  int ierr = 0;
+  if (largeWrites)
+    {
+    writer->WriteToOutputStringOn();
+    writer->Write();
+    std::string buf = writer->GetOutputString();
+    ierr = sensei::WriteBehindQueue::WriteFile(fileName,
+      buf.data(), buf.size());
+    }
+  else
+    {
+    writer->SetFileName(fileName.c_str());
+    writer->Write();
+    }
+
+  writer->Delete();
+  return ierr;
+}
+
 namespace sensei
 {
 //-----------------------------------------------------------------------------
@@ -96,8 +152,11 @@ senseiNewMacro(VTKPosthocIO);
 
 //-----------------------------------------------------------------------------
 VTKPosthocIO::VTKPosthocIO() :
-  OutputDir("./"), Mode(MODE_PARAVIEW), Writer(WRITER_VTK_XML)
-{}
+  OutputDir("./"), Mode(MODE_PARAVIEW), Writer(WRITER_VTK_XML),
+  WriteBehind(0), WriteBehindDeepCopy(1)
+{
+  this->WriteQueue.SetName("VTKPosthocIO");
+}
 
 //-----------------------------------------------------------------------------
 VTKPosthocIO::~VTKPosthocIO()
@@ -226,6 +285,30 @@ std::string VTKPosthocIO::GetGhostArrayName()
   return this->GhostArrayName;
 }
 
+//-----------------------------------------------------------------------------
+void VTKPosthocIO::SetWriteBehind(int val)
+{
+  this->WriteBehind = val;
+}
+
+//-----------------------------------------------------------------------------
+int VTKPosthocIO::GetWriteBehind()
+{
+  return this->WriteBehind;
+}
+
+//-----------------------------------------------------------------------------
+void VTKPosthocIO::SetMaxBytesInFlight(long long nBytes)
+{
+  this->WriteQueue.SetMaxBytesInFlight(nBytes);
+}
+
+//-----------------------------------------------------------------------------
+void VTKPosthocIO::SetWriteBehindDeepCopy(int val)
+{
+  this->WriteBehindDeepCopy = val;
+}
+
 //-----------------------------------------------------------------------------
 int VTKPosthocIO::SetDataRequirements(const DataRequirements &reqs)
 {
@@ -245,6 +328,13 @@ int VTKPosthocIO::AddDataRequirement(const std::string &meshName,
 //-----------------------------------------------------------------------------
 bool VTKPosthocIO::Execute(DataAdaptor* dataAdaptor)
 {
+  // start the I/O thread. this is a no-op if it is already running
+  if (this->WriteBehind && this->WriteQueue.Initialize())
+    {
+    SENSEI_ERROR("Failed to start the I/O thread")
+    return false;
+    }
+
   // see what the simulation is providing
   MeshMetadataFlags flags;
   flags.SetBlockDecomp();
@@ -392,25 +482,29 @@ bool VTKPosthocIO::Execute(DataAdaptor* dataAdaptor)
         ds->UpdateCellGhostArrayCache();
         }
 
-      if (this->Writer == VTKPosthocIO::WRITER_VTK_LEGACY)
+      if (this->WriteBehind)
         {
-        vtkDataSetWriter *writer = vtkDataSetWriter::New();
-        writer->SetInputData(ds);
-        writer->SetFileName(fileName.c_str());
-        writer->SetFileTypeToBinary();
-        writer->Write();
-        writer->Delete();
+        // hold references to the arrays, or copy them, until the I/O
+        // thread has written the block
+        vtkSmartPointer<vtkDataSet> block;
+        block.TakeReference(ds->NewInstance());
+
+        if (this->WriteBehindDeepCopy)
+          block->DeepCopy(ds);
+        else
+          block->ShallowCopy(ds);
+
+        long long nBytes = 1024ll*block->GetActualMemorySize();
+        int writerType = this->Writer;
+
+        this->WriteQueue.Push(nBytes, [block, fileName, writerType]() -> int {
+          return writeBlock(block.GetPointer(), fileName, writerType, 1); });
         }
-      else
+      else if (writeBlock(ds, fileName, this->Writer, 0))
         {
-        vtkXMLDataSetWriter *writer = vtkXMLDataSetWriter::New();
-        writer->SetInputData(ds);
-        writer->SetDataModeToAppended();
-        writer->EncodeAppendedDataOff();
-        writer->SetCompressorTypeToNone();
-        writer->SetFileName(fileName.c_str());
-        writer->Write();
-        writer->Delete();
+        SENSEI_ERROR("Failed to write block " << blockId
+          << " to \"" << fileName << "\"")
+        return false;
         }
       }
     it->Delete();
@@ -450,6 +544,31 @@ int VTKPosthocIO::Finalize()
   int rank = 0;
   MPI_Comm_rank(this->GetCommunicator(), &rank);
 
+  // wait for the I/O thread to write the queued blocks
+  if (this->WriteBehind)
+    {
+    int nErrors = this->WriteQueue.Finalize();
+
+    if (this->GetVerbose())
+      {
+      long nTasks = 0;
+      long maxDepth = 0;
+      long long maxBytes = 0;
+      double stallTime = 0.0;
+      this->WriteQueue.GetStatistics(nTasks, maxDepth, maxBytes, stallTime);
+
+      SENSEI_STATUS("VTKPosthocIO wrote " << nTasks << " blocks from the"
+        " I/O thread. max queue depth " << maxDepth << ", max bytes in flight "
+        << maxBytes << ", stall time " << stallTime << " seconds")
+      }
+
+    if (nErrors)
+      {
+      SENSEI_ERROR(nErrors << " blocks failed to write")
+      return -1;
+      }
+    }
+
   if (rank != 0)
     return 0;
 
@@ -4,6 +4,7 @@
 #include "AnalysisAdaptor.h"
 #include "DataRequirements.h"
 #include "MeshMetadata.h"
+#include "WriteBehindQueue.h"
 
 #include <vtkSmartPointer.h>
 
@@ -27,6 +28,11 @@ using VTKPosthocIOPtr = vtkSmartPointer<VTKPosthocIO>;
 /// consisting of a list of meshes and the arrays to write from
 /// each mesh. File names are derived using the output directory,
 /// the mesh name, and the mode.
+///
+/// In write behind mode blocks are shallow copied, holding references
+/// to the arrays, and queued to a per-rank I/O thread. The solver is
+/// blocked only when the bytes held by the queue exceed the budget.
+/// Finalize waits for all queued writes to complete.
 class VTKPosthocIO : public AnalysisAdaptor
 {
 public:
@@ -51,6 +57,21 @@ public:
   void SetGhostArrayName(const std::string &name);
   std::string GetGhostArrayName();
 
+  // enable/disable writing from a background I/O thread.
+  // default value: disabled
+  void SetWriteBehind(int val);
+  int GetWriteBehind();
+
+  // sets the maximum number of bytes that blocks queued for writing
+  // may hold. default value: 1 GiB
+  void SetMaxBytesInFlight(long long nBytes);
+
+  // when set blocks are deep copied before being queued. when not set the
+  // queued blocks share their arrays with the simulation, which is only
+  // safe when the data adaptor hands out fresh buffers every step, rather
+  // than memory the simulation updates in place. default value: enabled
+  void SetWriteBehindDeepCopy(int val);
+
   /// data requirements tell the adaptor what to push
   /// if none are given then all data is pushed.
   int SetDataRequirements(const DataRequirements &reqs);
@@ -76,6 +97,9 @@ private:
   int Mode;
   int Writer;
   std::string GhostArrayName;
+  int WriteBehind;
+  int WriteBehindDeepCopy;
+  WriteBehindQueue WriteQueue;
 
   template<typename T>
   using NameMap = std::map<std::string, T>;
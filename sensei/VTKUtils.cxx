@@ -1,6 +1,7 @@
 #include "VTKUtils.h"
 #include "MPIUtils.h"
 #include "MeshMetadata.h"
+#include "ThreadPool.h"
 #include "Error.h"
 
 
@@ -66,6 +67,8 @@
 
 #include <sstream>
 #include <functional>
+#include <limits>
+#include <algorithm>
 #include <mpi.h>
 
 using vtkDataObjectPtr = vtkSmartPointer<vtkDataObject>;
@@ -572,20 +575,204 @@ int GetArrayMetadata(vtkDataSetAttributes *dsa, int centering,
 }
 
 // --------------------------------------------------------------------------
-int GetArrayMetadata(vtkDataSetAttributes *dsa,
-  std::vector<std::array<double,2>> &arrayRange)
+template <typename T>
+void GetRange(const T *p, long nTups, int nComps, int comp,
+  const unsigned char *ghosts, double rng[2])
 {
+  // the range is accumulated in the native type in a number of independent
+  // lanes. without a loop carried dependence the compiler can vectorize the
+  // contiguous cases. the ghost mask is applied with a select rather than a
+  // branch for the same reason.
+  const int nLanes = 16;
+
+  T lmin[nLanes];
+  T lmax[nLanes];
+  for (int j = 0; j < nLanes; ++j)
+    {
+    lmin[j] = std::numeric_limits<T>::max();
+    lmax[j] = std::numeric_limits<T>::lowest();
+    }
+
+  p += comp;
+
+  long nBulk = (nTups / nLanes) * nLanes;
+
+  if (ghosts && (nComps == 1))
+    {
+    for (long i = 0; i < nBulk; i += nLanes)
+      {
+      for (int j = 0; j < nLanes; ++j)
+        {
+        T val = p[i + j];
+        bool real = ghosts[i + j] == 0;
+        lmin[j] = (real && (val < lmin[j])) ? val : lmin[j];
+        lmax[j] = (real && (val > lmax[j])) ? val : lmax[j];
+        }
+      }
+    }
+  else if (ghosts)
+    {
+    for (long i = 0; i < nBulk; i += nLanes)
+      {
+      for (int j = 0; j < nLanes; ++j)
+        {
+        T val = p[(i + j)*nComps];
+        bool real = ghosts[i + j] == 0;
+        lmin[j] = (real && (val < lmin[j])) ? val : lmin[j];
+        lmax[j] = (real && (val > lmax[j])) ? val : lmax[j];
+        }
+      }
+    }
+  else if (nComps == 1)
+    {
+    for (long i = 0; i < nBulk; i += nLanes)
+      {
+      for (int j = 0; j < nLanes; ++j)
+        {
+        T val = p[i + j];
+        lmin[j] = val < lmin[j] ? val : lmin[j];
+        lmax[j] = val > lmax[j] ? val : lmax[j];
+        }
+      }
+    }
+  else
+    {
+    for (long i = 0; i < nBulk; i += nLanes)
+      {
+      for (int j = 0; j < nLanes; ++j)
+        {
+        T val = p[(i + j)*nComps];
+        lmin[j] = val < lmin[j] ? val : lmin[j];
+        lmax[j] = val > lmax[j] ? val : lmax[j];
+        }
+      }
+    }
+
+  // remainder
+  for (long i = nBulk; i < nTups; ++i)
+    {
+    if (ghosts && ghosts[i])
+      continue;
+
+    T val = p[i*nComps];
+    lmin[0] = val < lmin[0] ? val : lmin[0];
+    lmax[0] = val > lmax[0] ? val : lmax[0];
+    }
+
+  // reduce the lanes. a lane that saw no values has min > max
+  for (int j = 0; j < nLanes; ++j)
+    {
+    if (lmin[j] <= lmax[j])
+      {
+      rng[0] = std::min(rng[0], double(lmin[j]));
+      rng[1] = std::max(rng[1], double(lmax[j]));
+      }
+    }
+}
+
+// --------------------------------------------------------------------------
+int GetArrayRange(vtkDataArray *da, vtkUnsignedCharArray *ghosts,
+  double rng[2], int comp)
+{
+  rng[0] = std::numeric_limits<double>::max();
+  rng[1] = std::numeric_limits<double>::lowest();
+
+  long nTups = da->GetNumberOfTuples();
+  int nComps = da->GetNumberOfComponents();
+
+  if ((comp < 0) || (comp >= nComps))
+    {
+    SENSEI_ERROR("Invalid component " << comp << " requested for "
+      << nComps << " component array \"" << da->GetName() << "\"")
+    return -1;
+    }
+
+  if (ghosts && (ghosts->GetNumberOfTuples() != nTups))
+    {
+    SENSEI_ERROR("The ghost array has " << ghosts->GetNumberOfTuples()
+      << " values but array \"" << da->GetName() << "\" has " << nTups)
+    return -1;
+    }
+
+  const unsigned char *pGhosts = ghosts ? ghosts->GetPointer(0) : nullptr;
+
+#if (VTK_MAJOR_VERSION > 7) || ((VTK_MAJOR_VERSION == 7) && (VTK_MINOR_VERSION >= 1))
+  // arrays with a non-contiguous layout go through the virtual API
+  if (!da->HasStandardMemoryLayout())
+    {
+    for (long i = 0; i < nTups; ++i)
+      {
+      if (pGhosts && pGhosts[i])
+        continue;
+
+      double val = da->GetComponent(i, comp);
+      rng[0] = std::min(rng[0], val);
+      rng[1] = std::max(rng[1], val);
+      }
+    return 0;
+    }
+#endif
+
+  switch (da->GetDataType())
+    {
+    vtkTemplateMacro(
+      const VTK_TT *pDa = static_cast<const VTK_TT*>(da->GetVoidPointer(0));
+      GetRange(pDa, nTups, nComps, comp, pGhosts, rng);
+      );
+    default:
+      SENSEI_ERROR("Unsupported array type " << da->GetClassName())
+      return -1;
+    }
+
+  return 0;
+}
+
+// --------------------------------------------------------------------------
+void GetArrayMetadata(vtkDataSetAttributes *dsa, int centering, int bid,
+  const ArrayRangeCache *cache, std::vector<std::array<double,2>> &arrayRange)
+{
+  vtkUnsignedCharArray *ghosts =
+    dynamic_cast<vtkUnsignedCharArray*>(dsa->GetArray("vtkGhostType"));
+
+  // ranges that the caller says are unchanged since the last step
+  const std::map<ArrayRangeCache::KeyType, std::array<double,2>> *cachedRanges = nullptr;
+  if (cache && !cache->Unchanged.empty())
+    {
+    std::map<int, std::map<ArrayRangeCache::KeyType,
+      std::array<double,2>>>::const_iterator it = cache->Ranges.find(bid);
+
+    if (it != cache->Ranges.end())
+      cachedRanges = &it->second;
+    }
+
   int na = dsa->GetNumberOfArrays();
   for (int i = 0; i < na; ++i)
     {
     vtkDataArray *da = dsa->GetArray(i);
+    const char *name = da->GetName();
 
+    if (cachedRanges && name)
+      {
+      ArrayRangeCache::KeyType key(centering, name);
+      if (cache->Unchanged.count(key))
+        {
+        std::map<ArrayRangeCache::KeyType, std::array<double,2>>::const_iterator
+          it = cachedRanges->find(key);
+
+        if (it != cachedRanges->end())
+          {
+          arrayRange.push_back(it->second);
+          continue;
+          }
+        }
+      }
+
+    // the ghost array itself is not masked
     double rng[2];
-    da->GetRange(rng);
+    GetArrayRange(da, (da == ghosts ? nullptr : ghosts), rng, 0);
 
     arrayRange.emplace_back(std::array<double,2>({rng[0], rng[1]}));
     }
-  return 0;
 }
 
 // --------------------------------------------------------------------------
@@ -606,29 +793,25 @@ int GetArrayMetadata(vtkDataSet *ds, MeshMetadataPtr &metadata)
 
 // --------------------------------------------------------------------------
 int GetBlockMetadata(int rank, int id, vtkDataSet *ds,
-  const MeshMetadataFlags &flags, std::vector<int> &blockOwner,
-  std::vector<int> &blockIds, std::vector<long> &blockPoints,
-  std::vector<long> &blockCells, std::vector<long> &blockCellArraySize,
-  std::vector<std::array<int,6>> &blockExtents,
-  std::vector<std::array<double,6>> &blockBounds,
-  std::vector<std::vector<std::array<double,2>>> &blockArrayRange)
+  const MeshMetadataFlags &flags, const ArrayRangeCache *cache,
+  int &blockOwner, int &blockId, long &blockPoints, long &blockCells,
+  long &blockCellArraySize, std::array<int,6> &blockExtents,
+  std::array<double,6> &blockBounds,
+  std::vector<std::array<double,2>> &blockArrayRange)
 {
   if (!ds)
     return -1;
 
   if (flags.BlockDecompSet())
     {
-    blockOwner.emplace_back(rank);
-    blockIds.emplace_back(id);
+    blockOwner = rank;
+    blockId = id;
     }
 
   if (flags.BlockSizeSet())
     {
-    long nPts = ds->GetNumberOfPoints();
-    blockPoints.emplace_back(nPts);
-
-    long nCells = ds->GetNumberOfCells();
-    blockCells.emplace_back(nCells);
+    blockPoints = ds->GetNumberOfPoints();
+    blockCells = ds->GetNumberOfCells();
 
     long cellArraySize = 0;
 
@@ -638,58 +821,145 @@ int GetBlockMetadata(int rank, int id, vtkDataSet *ds,
       cellArraySize = pd->GetVerts()->GetSize() + pd->GetLines()->GetSize()
         + pd->GetPolys()->GetSize() + pd->GetStrips()->GetSize();
 
-    blockCellArraySize.emplace_back(cellArraySize);
+    blockCellArraySize = cellArraySize;
     }
 
   if (flags.BlockExtentsSet())
     {
-    std::array<int,6> ext;
     if (vtkImageData *im = dynamic_cast<vtkImageData*>(ds))
       {
-      im->GetExtent(ext.data());
+      im->GetExtent(blockExtents.data());
       }
     else if (vtkRectilinearGrid *rg = dynamic_cast<vtkRectilinearGrid*>(ds))
       {
-      rg->GetExtent(ext.data());
+      rg->GetExtent(blockExtents.data());
       }
     else if (vtkStructuredGrid *sg = dynamic_cast<vtkStructuredGrid*>(ds))
       {
-      sg->GetExtent(ext.data());
+      sg->GetExtent(blockExtents.data());
       }
-    blockExtents.emplace_back(std::move(ext));
 
     // TODO -- for AMR meshes extract blocvk level
     }
 
   if (flags.BlockBoundsSet())
     {
-    std::array<double,6> bounds;
-    ds->GetBounds(bounds.data());
-    blockBounds.emplace_back(std::move(bounds));
+    ds->GetBounds(blockBounds.data());
     }
 
   if (flags.BlockArrayRangeSet())
     {
-    std::vector<std::array<double,2>> arrayRange;
-    GetArrayMetadata(ds->GetPointData(), arrayRange);
-    GetArrayMetadata(ds->GetCellData(), arrayRange);
-    blockArrayRange.emplace_back(std::move(arrayRange));
+    GetArrayMetadata(ds->GetPointData(), vtkDataObject::POINT, id, cache, blockArrayRange);
+    GetArrayMetadata(ds->GetCellData(), vtkDataObject::CELL, id, cache, blockArrayRange);
     }
 
   return 0;
 }
 
 // --------------------------------------------------------------------------
-int GetBlockMetadata(int rank, int id, vtkDataSet *ds, MeshMetadataPtr metadata)
+int GetBlockMetadata(int rank, const std::vector<int> &ids,
+  const std::vector<vtkDataSet*> &blocks, MeshMetadataPtr metadata,
+  ArrayRangeCache *cache)
 {
-    return GetBlockMetadata(rank, id, ds, metadata->Flags,
-      metadata->BlockOwner, metadata->BlockIds, metadata->BlockNumPoints,
-      metadata->BlockNumCells, metadata->BlockCellArraySize,
-      metadata->BlockExtents, metadata->BlockBounds, metadata->BlockArrayRange);
+  long nBlocks = blocks.size();
+
+  // blocks are processed in parallel, each thread writes the results
+  // for its block into its own slot. the results are then appended to
+  // the metadata in block order.
+  std::vector<int> blockOwner(nBlocks);
+  std::vector<int> blockIds(nBlocks);
+  std::vector<long> blockPoints(nBlocks);
+  std::vector<long> blockCells(nBlocks);
+  std::vector<long> blockCellArraySize(nBlocks);
+  std::vector<std::array<int,6>> blockExtents(nBlocks);
+  std::vector<std::array<double,6>> blockBounds(nBlocks);
+  std::vector<std::vector<std::array<double,2>>> blockArrayRange(nBlocks);
+  std::vector<int> blockErrors(nBlocks, 0);
+
+  const MeshMetadataFlags &flags = metadata->Flags;
+
+  ThreadPool::GetGlobalPool().ParallelFor(nBlocks,
+    [&](int, long i)
+    {
+    blockErrors[i] = GetBlockMetadata(rank, ids[i], blocks[i], flags,
+      cache, blockOwner[i], blockIds[i], blockPoints[i], blockCells[i],
+      blockCellArraySize[i], blockExtents[i], blockBounds[i],
+      blockArrayRange[i]);
+    });
+
+  for (long i = 0; i < nBlocks; ++i)
+    {
+    if (blockErrors[i])
+      {
+      SENSEI_ERROR("Failed to get block metadata for block " << ids[i])
+      return -1;
+      }
+    }
+
+  if (flags.BlockDecompSet())
+    {
+    metadata->BlockOwner.insert(metadata->BlockOwner.end(),
+      blockOwner.begin(), blockOwner.end());
+
+    metadata->BlockIds.insert(metadata->BlockIds.end(),
+      blockIds.begin(), blockIds.end());
+    }
+
+  if (flags.BlockSizeSet())
+    {
+    metadata->BlockNumPoints.insert(metadata->BlockNumPoints.end(),
+      blockPoints.begin(), blockPoints.end());
+
+    metadata->BlockNumCells.insert(metadata->BlockNumCells.end(),
+      blockCells.begin(), blockCells.end());
+
+    metadata->BlockCellArraySize.insert(metadata->BlockCellArraySize.end(),
+      blockCellArraySize.begin(), blockCellArraySize.end());
+    }
+
+  if (flags.BlockExtentsSet())
+    metadata->BlockExtents.insert(metadata->BlockExtents.end(),
+      blockExtents.begin(), blockExtents.end());
+
+  if (flags.BlockBoundsSet())
+    metadata->BlockBounds.insert(metadata->BlockBounds.end(),
+      blockBounds.begin(), blockBounds.end());
+
+  if (flags.BlockArrayRangeSet())
+    {
+    // save the ranges for use in the next step. this is only needed
+    // when some arrays are declared unchanging
+    if (cache && !cache->Unchanged.empty())
+      {
+      unsigned int nArrays = metadata->ArrayName.size();
+      for (long i = 0; i < nBlocks; ++i)
+        {
+        std::map<ArrayRangeCache::KeyType, std::array<double,2>> &ranges =
+          cache->Ranges[ids[i]];
+
+        ranges.clear();
+
+        unsigned int nRanges = blockArrayRange[i].size();
+        for (unsigned int j = 0; (j < nRanges) && (j < nArrays); ++j)
+          {
+          ArrayRangeCache::KeyType key(metadata->ArrayCentering[j],
+            metadata->ArrayName[j]);
+
+          ranges[key] = blockArrayRange[i][j];
+          }
+        }
+      }
+
+    for (long i = 0; i < nBlocks; ++i)
+      metadata->BlockArrayRange.emplace_back(std::move(blockArrayRange[i]));
+    }
+
+  return 0;
 }
 
 // --------------------------------------------------------------------------
-int GetMetadata(MPI_Comm comm, vtkCompositeDataSet *cd, MeshMetadataPtr metadata)
+int GetMetadata(MPI_Comm comm, vtkCompositeDataSet *cd,
+  MeshMetadataPtr metadata, ArrayRangeCache *cache)
 {
   int rank = 0;
   MPI_Comm_rank(comm, &rank);
@@ -713,9 +983,11 @@ int GetMetadata(MPI_Comm comm, vtkCompositeDataSet *cd, MeshMetadataPtr metadata
       metadata->CoordinateType = ps->GetPoints()->GetData()->GetDataType();
     }
 
-  // get block metadata
+  // gather the local blocks. the iterator is not thread safe so this is
+  // done serially
   int numBlocks = 0;
-  int numBlocksLocal = 0;
+  std::vector<int> blockIds;
+  std::vector<vtkDataSet*> blocks;
   cdit->SetSkipEmptyNodes(0);
 
   for (cdit->InitTraversal(); !cdit->IsDoneWithTraversal(); cdit->GoToNextItem())
@@ -727,22 +999,20 @@ int GetMetadata(MPI_Comm comm, vtkCompositeDataSet *cd, MeshMetadataPtr metadata
 
     if (vtkDataSet *ds = dynamic_cast<vtkDataSet*>(dobj))
       {
-      numBlocksLocal += 1;
-
-      if (VTKUtils::GetBlockMetadata(rank, bid, ds, metadata))
-        {
-        SENSEI_ERROR("Failed to get block metadata for block "
-         << cdit->GetCurrentFlatIndex())
-        cdit->Delete();
-        return -1;
-        }
+      blockIds.push_back(bid);
+      blocks.push_back(ds);
       }
     }
 
+  cdit->Delete();
+
+  // get block metadata
+  if (VTKUtils::GetBlockMetadata(rank, blockIds, blocks, metadata, cache))
+    return -1;
+
   // set block counts
   metadata->NumBlocks = numBlocks;
-  metadata->NumBlocksLocal = {numBlocksLocal};
-  cdit->Delete();
+  metadata->NumBlocksLocal = {int(blocks.size())};
 
   // get global bounds and extents
   if (metadata->Flags.BlockBoundsSet())
@@ -791,7 +1061,8 @@ int GetMetadata(MPI_Comm comm, vtkCompositeDataSet *cd, MeshMetadataPtr metadata
 
 // --------------------------------------------------------------------------
 // note: not intended for use on the blocks of a multiblock
-int GetMetadata(MPI_Comm comm, vtkDataSet *ds, MeshMetadataPtr metadata)
+int GetMetadata(MPI_Comm comm, vtkDataSet *ds, MeshMetadataPtr metadata,
+  ArrayRangeCache *cache)
 {
   int rank = 0;
   int nRanks = 1;
@@ -804,11 +1075,11 @@ int GetMetadata(MPI_Comm comm, vtkDataSet *ds, MeshMetadataPtr metadata)
 
   VTKUtils::GetArrayMetadata(ds, metadata);
 
-  if (VTKUtils::GetBlockMetadata(rank, 0, ds, metadata))
-    {
-    SENSEI_ERROR("Failed to get block metadata for block " << rank)
+  std::vector<int> blockIds(1, 0);
+  std::vector<vtkDataSet*> blocks(1, ds);
+
+  if (VTKUtils::GetBlockMetadata(rank, blockIds, blocks, metadata, cache))
     return -1;
-    }
 
   metadata->NumBlocks = nRanks;
   metadata->NumBlocksLocal = {1};
@@ -8,10 +8,17 @@ class vtkDataObject;
 class vtkFieldData;
 class vtkDataSetAttributes;
 class vtkCompositeDataSet;
+class vtkDataArray;
+class vtkUnsignedCharArray;
 
 #include <vtkSmartPointer.h>
 #include <functional>
 #include <vector>
+#include <array>
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
 #include <mpi.h>
 
 using vtkCompositeDataSetPtr = vtkSmartPointer<vtkCompositeDataSet>;
@@ -70,10 +77,31 @@ int SetGhostLayerMetadata(vtkDataObject *mesh,
 int GetGhostLayerMetadata(vtkDataObject *mesh,
   int &nGhostCellLayers, int &nGhostNodeLayers);
 
+/// Per block array ranges saved by GetMetadata. Ranges of the arrays
+/// listed in Unchanged are copied from Ranges rather than recomputed.
+/// Blocks are identified by the block ids reported in the metadata.
+struct ArrayRangeCache
+{
+  using KeyType = std::pair<int, std::string>; // centering, array name
+  std::set<KeyType> Unchanged;
+  std::map<int, std::map<KeyType, std::array<double,2>>> Ranges;
+};
+
+/// Compute the range of the given component of the array. Values flagged
+/// by the ghost array, if one is passed, are skipped. If all values are
+/// skipped the range is [DBL_MAX, -DBL_MAX].
+int GetArrayRange(vtkDataArray *da, vtkUnsignedCharArray *ghosts,
+  double rng[2], int comp = 0);
+
 /// Get  metadata, note that data set variant is not meant to
-/// be used on blocks of a multi-block
-int GetMetadata(MPI_Comm comm, vtkDataSet *ds, MeshMetadataPtr);
-int GetMetadata(MPI_Comm comm, vtkCompositeDataSet *cd, MeshMetadataPtr);
+/// be used on blocks of a multi-block. Blocks are processed in parallel
+/// using the global ThreadPool. When a cache is passed block array ranges
+/// are saved in it and unchanged array ranges are reused from it.
+int GetMetadata(MPI_Comm comm, vtkDataSet *ds, MeshMetadataPtr,
+  ArrayRangeCache *cache = nullptr);
+
+int GetMetadata(MPI_Comm comm, vtkCompositeDataSet *cd, MeshMetadataPtr,
+  ArrayRangeCache *cache = nullptr);
 
 /// Given a data object ensure that it is a composite data set
 /// If it already is, then the call is a no-op, if it is not
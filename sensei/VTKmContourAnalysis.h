@@ -2,6 +2,8 @@
 #define sensei_VTKmContourAnalysis_h
 
 #include "AnalysisAdaptor.h"
+#include "VTKmUtils.h"
+#include <vtkSmartPointer.h>
 #include <mpi.h>
 
 class vtkDataObject;
@@ -10,6 +12,8 @@ class vtkDataArray;
 namespace sensei
 {
 
+class GhostDataAdaptor;
+
 /// @class VTKmContourAnalysis
 /// @brief sensei::VTKmContourAnalysis is a AnalysisAdaptor specialization for contouring.
 ///
@@ -19,8 +23,10 @@ public:
   static VTKmContourAnalysis* New();
   vtkTypeMacro(VTKmContourAnalysis, AnalysisAdaptor);
 
+  /// @param device the VTK-m device to run on, one of the
+  ///        VTKmUtils::DEVICE_* values
   void Initialize(const std::string& meshName, const std::string& arrayname,
-    double value, bool writeOutput);
+    double value, bool writeOutput, int device = VTKmUtils::DEVICE_ANY);
 
   bool Execute(sensei::DataAdaptor* data) override;
 
@@ -34,6 +40,11 @@ protected:
   std::string ArrayName;
   double Value;
   bool WriteOutput;
+  int Device;
+
+  // adds the ghost cells. kept across steps so that the exchange with the
+  // neighbors of a static mesh is set up only once
+  vtkSmartPointer<GhostDataAdaptor> Ghosts;
 
 private:
   VTKmContourAnalysis(const VTKmContourAnalysis&);
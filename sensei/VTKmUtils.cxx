@@ -0,0 +1,128 @@
+#include "VTKmUtils.h"
+#include "Error.h"
+
+#include <vtkm/cont/DeviceAdapter.h>
+#include <vtkm/cont/RuntimeDeviceTracker.h>
+#include <vtkm/cont/cuda/DeviceAdapterCuda.h>
+#include <vtkm/cont/openmp/DeviceAdapterOpenMP.h>
+#include <vtkm/cont/serial/DeviceAdapterSerial.h>
+#include <vtkm/cont/tbb/DeviceAdapterTBB.h>
+
+#include <cctype>
+
+namespace
+{
+// --------------------------------------------------------------------------
+template <typename DeviceTag>
+int forceDevice(DeviceTag tag)
+{
+  using Traits = vtkm::cont::DeviceAdapterTraits<DeviceTag>;
+
+  if (!Traits::Valid)
+    {
+    SENSEI_ERROR("VTK-m was built without the " << Traits::GetName()
+      << " device")
+    return -1;
+    }
+
+  vtkm::cont::RuntimeDeviceTracker tracker =
+    vtkm::cont::GetGlobalRuntimeDeviceTracker();
+
+  if (!tracker.CanRunOn(tag))
+    {
+    SENSEI_ERROR("The VTK-m " << Traits::GetName()
+      << " device can not run here")
+    return -1;
+    }
+
+  tracker.ForceDevice(tag);
+  return 0;
+}
+}
+
+namespace sensei
+{
+namespace VTKmUtils
+{
+
+// --------------------------------------------------------------------------
+int GetDevice(std::string deviceStr, int &device)
+{
+  unsigned int n = deviceStr.size();
+  for (unsigned int i = 0; i < n; ++i)
+    deviceStr[i] = tolower(deviceStr[i]);
+
+  if (deviceStr == "any")
+    {
+    device = DEVICE_ANY;
+    return 0;
+    }
+  else if (deviceStr == "serial")
+    {
+    device = DEVICE_SERIAL;
+    return 0;
+    }
+  else if (deviceStr == "tbb")
+    {
+    device = DEVICE_TBB;
+    return 0;
+    }
+  else if (deviceStr == "openmp")
+    {
+    device = DEVICE_OPENMP;
+    return 0;
+    }
+  else if (deviceStr == "cuda")
+    {
+    device = DEVICE_CUDA;
+    return 0;
+    }
+
+  SENSEI_ERROR("Invalid VTK-m device \"" << deviceStr << "\"")
+  return -1;
+}
+
+// --------------------------------------------------------------------------
+const char *GetDeviceName(int device)
+{
+  switch (device)
+    {
+    case DEVICE_ANY: return "any";
+    case DEVICE_SERIAL: return "serial";
+    case DEVICE_TBB: return "tbb";
+    case DEVICE_OPENMP: return "openmp";
+    case DEVICE_CUDA: return "cuda";
+    }
+  return "unknown";
+}
+
+// --------------------------------------------------------------------------
+int SetDevice(int device)
+{
+  switch (device)
+    {
+    case DEVICE_ANY:
+      return 0;
+    case DEVICE_SERIAL:
+      return forceDevice(vtkm::cont::DeviceAdapterTagSerial());
+    case DEVICE_TBB:
+      return forceDevice(vtkm::cont::DeviceAdapterTagTBB());
+    case DEVICE_OPENMP:
+      return forceDevice(vtkm::cont::DeviceAdapterTagOpenMP());
+    case DEVICE_CUDA:
+      return forceDevice(vtkm::cont::DeviceAdapterTagCuda());
+    }
+
+  SENSEI_ERROR("Invalid VTK-m device " << device)
+  return -1;
+}
+
+// --------------------------------------------------------------------------
+void ResetDevice(int device)
+{
+  if (device != DEVICE_ANY)
+    vtkm::cont::GetGlobalRuntimeDeviceTracker().Reset();
+}
+
+}
+}
@@ -0,0 +1,38 @@
+#ifndef VTKmUtils_h
+#define VTKmUtils_h
+
+#include <string>
+
+namespace sensei
+{
+
+/// Selection of the device that VTK-m based analyses run on
+namespace VTKmUtils
+{
+
+/// the devices. DEVICE_ANY leaves the choice to VTK-m, which takes the
+/// first of the enabled devices that can run.
+enum {DEVICE_ANY = 0, DEVICE_SERIAL = 1, DEVICE_TBB = 2, DEVICE_OPENMP = 3,
+  DEVICE_CUDA = 4};
+
+/// returns the enum value given a device name. where name can be one
+/// of: any, serial, tbb, openmp or, cuda
+int GetDevice(std::string deviceStr, int &device);
+
+/// returns the name of the device
+const char *GetDeviceName(int device);
+
+/// Restrict VTK-m's global runtime device tracker to the given device, so
+/// that VTK-m filters, including the ones VTK runs, execute on it. An error
+/// is reported if VTK-m was built without the device or if it can not run
+/// here. Has no effect for DEVICE_ANY.
+int SetDevice(int device);
+
+/// Restore the global runtime device tracker after SetDevice. Has no effect
+/// for DEVICE_ANY.
+void ResetDevice(int device);
+
+}
+}
+
+#endif
@@ -2,6 +2,7 @@
 
 #include "CinemaHelper.h"
 #include "DataAdaptor.h"
+#include "VTKmUtils.h"
 #include <Profiler.h>
 
 #include <vtkCellData.h>
@@ -18,6 +19,7 @@
 #include <vtkSmartPointer.h>
 
 #include <algorithm>
+#include <array>
 #include <vector>
 
 // --- vtkm ---
@@ -33,6 +35,7 @@
 
 #include <vtkm/cont/TryExecute.h>
 #include <vtkm/cont/cuda/DeviceAdapterCuda.h>
+#include <vtkm/cont/openmp/DeviceAdapterOpenMP.h>
 #include <vtkm/cont/serial/DeviceAdapterSerial.h>
 #include <vtkm/cont/tbb/DeviceAdapterTBB.h>
 
@@ -43,9 +46,11 @@ namespace sensei
 //-----------------------------------------------------------------------------
 
 //This is the list of devices to compile in support for. The order of the
-//devices determines the runtime preference.
+//devices determines the runtime preference. The device selected in the
+//XML restricts it to one through the global runtime device tracker.
 struct DevicesToTry : vtkm::ListTagBase<vtkm::cont::DeviceAdapterTagCuda,
                                         vtkm::cont::DeviceAdapterTagTBB,
+                                        vtkm::cont::DeviceAdapterTagOpenMP,
                                         vtkm::cont::DeviceAdapterTagSerial>
 {
 };
@@ -92,30 +97,28 @@ private:
 
 class ImageReduction : public vtkm::filter::FilterDataSet<ImageReduction>
 {
-  vtkm::Vec<vtkm::Int32, 3> InputDimensions;
   vtkm::cont::Field::Association FieldAssoc;
   std::string FieldName;
+  vtkm::cont::ArrayHandle<vtkm::Id> Permutation;
 
 public:
 
   ImageReduction()
-    : InputDimensions(1, 1, 1)
-    , FieldAssoc(vtkm::cont::Field::Association::POINTS)
+    : FieldAssoc(vtkm::cont::Field::Association::POINTS)
   { }
 
-  void SetInputDimensions(vtkm::Int32 i, vtkm::Int32 j, vtkm::Int32 k)
-  {
-    this->InputDimensions[0] = i;
-    this->InputDimensions[1] = j;
-    this->InputDimensions[2] = k;
-  }
-
   void SetField(vtkm::cont::Field::Association assoc, const std::string& name)
   {
     this->FieldName = name;
     this->FieldAssoc = assoc;
   }
 
+  // the ids of the first point of each 2x2x2 group of points to average
+  void SetPermutation(const vtkm::cont::ArrayHandle<vtkm::Id>& ids)
+  {
+    this->Permutation = ids;
+  }
+
   template <typename Policy, typename Device>
   VTKM_CONT vtkm::cont::DataSet DoExecute(const vtkm::cont::DataSet& input,
                                                   vtkm::filter::PolicyBase<Policy> policy,
@@ -133,26 +136,8 @@ public:
     //get the previous state of the game
     input.GetField(this->FieldName, this->FieldAssoc).GetData().CopyTo(in);
 
-    // Create scatter array
-    std::vector<vtkm::Id> ids;
-    int kSize = this->InputDimensions[2] - 1;
-    int jSize = this->InputDimensions[1] - 1;
-    int iSize = this->InputDimensions[0] - 1;
-    for (int k = 0; k < kSize; k += 2)
-    {
-      for (int j = 0; j < jSize; j += 2)
-      {
-        for (int i = 0; i < iSize; i += 2)
-        {
-          ids.push_back(i + (j * this->InputDimensions[0]) + (k * this->InputDimensions[0] * this->InputDimensions[1]));
-        }
-      }
-    }
-
-    auto counting = vtkm::cont::make_ArrayHandle(ids);
-
     //Update the game state
-    VoxelMean worklet(counting);
+    VoxelMean worklet(this->Permutation);
     DispatcherType(worklet, worklet.GetScatter()).Invoke(vtkm::filter::ApplyPolicy(cells, policy), in, out);
 
     //save the results
@@ -185,11 +170,76 @@ public:
 
 
 //-----------------------------------------------------------------------------
+// the uniform dataset, coordinates and cell set, and the permutation of each
+// level of the reduction. these depend only on the dimensions and are reused
+// for as long as the mesh does not change.
+struct VTKmVolumeReductionAnalysis::CacheType
+{
+  CacheType() : Dimensions{{-1, -1, -1}} {}
+
+  void Update(const int dimensions[3], int nLevels);
+
+  std::array<int,3> Dimensions;
+  std::vector<vtkm::cont::DataSet> Levels;
+  std::vector<vtkm::cont::ArrayHandle<vtkm::Id>> Permutations;
+};
+
+//-----------------------------------------------------------------------------
+void VTKmVolumeReductionAnalysis::CacheType::Update(const int dimensions[3],
+  int nLevels)
+{
+  std::array<int,3> dims{{dimensions[0], dimensions[1], dimensions[2]}};
+
+  if ((dims == this->Dimensions) && (this->Levels.size() == size_t(nLevels)))
+    return;
+
+  TimeEvent<128> mark("VTKmVolumeReductionAnalysis::UpdateCache");
+
+  this->Dimensions = dims;
+  this->Levels.clear();
+  this->Permutations.clear();
+
+  vtkm::cont::DataSetBuilderUniform builder;
+
+  for (int level = 0; level < nLevels; ++level)
+    {
+    this->Levels.push_back(builder.Create(vtkm::Id3(dims[0], dims[1], dims[2])));
+
+    // the first point of each 2x2x2 group of points
+    int kSize = dims[2] - 1;
+    int jSize = dims[1] - 1;
+    int iSize = dims[0] - 1;
+    vtkm::Id nx = dims[0];
+    vtkm::Id nxy = nx * dims[1];
+
+    vtkm::cont::ArrayHandle<vtkm::Id> ids;
+    ids.Allocate(vtkm::Id((iSize + 1) / 2) * ((jSize + 1) / 2) * ((kSize + 1) / 2));
+    auto portal = ids.GetPortalControl();
+
+    vtkm::Id q = 0;
+    for (int k = 0; k < kSize; k += 2)
+      {
+      for (int j = 0; j < jSize; j += 2)
+        {
+        vtkm::Id row = j * nx + k * nxy;
+        for (int i = 0; i < iSize; i += 2)
+          portal.Set(q++, row + i);
+        }
+      }
+
+    this->Permutations.push_back(ids);
+
+    for (int d = 0; d < 3; ++d)
+      dims[d] /= 2;
+    }
+}
+
 //-----------------------------------------------------------------------------
 senseiNewMacro(VTKmVolumeReductionAnalysis);
 
 //-----------------------------------------------------------------------------
-VTKmVolumeReductionAnalysis::VTKmVolumeReductionAnalysis() : Communicator(MPI_COMM_WORLD), Helper(NULL)
+VTKmVolumeReductionAnalysis::VTKmVolumeReductionAnalysis() : Communicator(MPI_COMM_WORLD), Helper(NULL),
+  Device(VTKmUtils::DEVICE_ANY), Cache(new CacheType)
 {
 }
 
@@ -197,6 +247,7 @@ VTKmVolumeReductionAnalysis::VTKmVolumeReductionAnalysis() : Communicator(MPI_CO
 VTKmVolumeReductionAnalysis::~VTKmVolumeReductionAnalysis()
 {
     delete this->Helper;
+    delete this->Cache;
 }
 
 //-----------------------------------------------------------------------------
@@ -206,7 +257,8 @@ void VTKmVolumeReductionAnalysis::Initialize(
   const std::string& fieldAssoc,
   const std::string& workingDirectory,
   int reductionFactor,
-  MPI_Comm comm
+  MPI_Comm comm,
+  int device
   )
 {
   this->MeshName = meshName;
@@ -216,6 +268,7 @@ void VTKmVolumeReductionAnalysis::Initialize(
     vtkm::cont::Field::Association::POINTS;
   this->Communicator = comm;
   this->Reduction = reductionFactor;
+  this->Device = device;
 
 #ifdef ENABLE_VTK_MPI
   vtkNew<vtkMPIController> con;
@@ -257,20 +310,31 @@ bool VTKmVolumeReductionAnalysis::Execute(DataAdaptor* data)
     return true;
   }
 
+  // the output of the last level points into this buffer, it must be kept
+  // until the output has been written
+  vtkm::cont::ArrayHandle<vtkm::Float32> vtkmArray;
+
   vtkNew<vtkImageData> outputDataSet;
   if (this->Reduction > 0)
     {
     Profiler::StartEvent("VTKm reduction");
 
+    if (VTKmUtils::SetDevice(this->Device))
+      {
+      Profiler::EndEvent("VTKm reduction");
+      return false;
+      }
+
     int dimensions[3];
     originalImageData->GetDimensions(dimensions);
     dimensions[0]--; // cell data to point data
     dimensions[1]--; // cell data to point data
     dimensions[2]--; // cell data to point data
 
+    this->Cache->Update(dimensions, this->Reduction);
+
     vtkNew<vtkFloatArray> dataArray;
     dataArray->ShallowCopy(vtkFloatArray::SafeDownCast(originalImageData->GetCellData()->GetScalars()));
-    vtkm::cont::ArrayHandle<vtkm::Float32> vtkmArray;
     for (int step = 0 ; step < this->Reduction; step++)
       {
       // Data preparation
@@ -278,17 +342,17 @@ bool VTKmVolumeReductionAnalysis::Execute(DataAdaptor* data)
       int size = dimensions[0] * dimensions[1] * dimensions[2];
 
       // --- vtk-m filtering ---
-      // - create vtkm dataset
+      // - create vtkm dataset. the array is used in place, and the
+      //   coordinates and cells come from the cache
       vtkm::cont::ArrayHandle<vtkm::Float32> handle = vtkm::cont::make_ArrayHandle(inFloat, size);
-      vtkm::cont::DataSetBuilderUniform builder;
-      vtkm::cont::DataSet dataset = builder.Create(vtkm::Id3(dimensions[0], dimensions[1], dimensions[2]));
+      vtkm::cont::DataSet dataset = this->Cache->Levels[step];
       vtkm::cont::Field scalarField(this->FieldName, this->FieldAssoc, handle);
       dataset.AddField(scalarField);
 
       // - create and execute filter
       ImageReduction filter;
-      filter.SetInputDimensions(dimensions[0], dimensions[1], dimensions[2]);
       filter.SetField(this->FieldAssoc, this->FieldName);
+      filter.SetPermutation(this->Cache->Permutations[step]);
       auto rdata = filter.Execute(dataset, ImageReductionPolicy());
 
       // - recover data from vtkm
@@ -307,6 +371,8 @@ bool VTKmVolumeReductionAnalysis::Execute(DataAdaptor* data)
       }
     outputDataSet->SetDimensions(dimensions[0], dimensions[1], dimensions[2]);
     outputDataSet->GetPointData()->SetScalars(dataArray);
+
+    VTKmUtils::ResetDevice(this->Device);
     Profiler::EndEvent("VTKm reduction");
     }
   else
@@ -2,6 +2,7 @@
 #define sensei_VTKmVolumeReductionAnalysis_h
 
 #include "AnalysisAdaptor.h"
+#include "VTKmUtils.h"
 #include <vtkm/cont/Field.h>
 #include <mpi.h>
 
@@ -21,7 +22,8 @@ public:
     const std::string& fieldAssoc,
     const std::string& workingDirectory,
     int reductionFactor,
-    MPI_Comm comm);
+    MPI_Comm comm,
+    int device = VTKmUtils::DEVICE_ANY);
 
   bool Execute(DataAdaptor* data) override;
 
@@ -37,8 +39,12 @@ protected:
   MPI_Comm Communicator;
   CinemaHelper* Helper;
   int Reduction;
+  int Device;
 
 private:
+  struct CacheType;
+  CacheType *Cache;
+
   VTKmVolumeReductionAnalysis(const VTKmVolumeReductionAnalysis&);
   void operator=(const VTKmVolumeReductionAnalysis&);
 };
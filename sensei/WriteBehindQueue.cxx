@@ -0,0 +1,325 @@
+#include "WriteBehindQueue.h"
+#include "Profiler.h"
+#include "Error.h"
+
+#include <algorithm>
+#include <deque>
+#include <utility>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <sstream>
+#include <cstring>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+
+// writes are issued in chunks of this size, starting at offsets that are
+// a multiple of it. this is large enough to amortize per call overheads
+// on parallel file systems and a multiple of typical stripe sizes.
+#define WRITE_BEHIND_CHUNK_SIZE (8ul*1024ul*1024ul)
+
+namespace sensei
+{
+
+struct WriteBehindQueue::InternalsType
+{
+  InternalsType() : MaxBytesInFlight(1ll << 30), BytesInFlight(0),
+    NumActive(0), NumErrors(0), Running(0), Quit(0), NumTasks(0),
+    MaxDepth(0), MaxBytesSeen(0), StallTime(0.0)
+  {}
+
+  // the I/O thread's main loop
+  void Run();
+
+  using QueueEntry = std::pair<long long, WriteBehindQueue::WriteTask>;
+
+  std::string WriteEvent;
+  std::string StallEvent;
+  std::string EnqueueEvent;
+  long long MaxBytesInFlight;
+  long long BytesInFlight;
+  int NumActive;
+  int NumErrors;
+  int Running;
+  int Quit;
+  long NumTasks;
+  long MaxDepth;
+  long long MaxBytesSeen;
+  double StallTime;
+  std::deque<QueueEntry> Queue;
+  std::thread Thread;
+  mutable std::mutex Mutex;
+  std::condition_variable WorkReady;
+  std::condition_variable SpaceReady;
+};
+
+// --------------------------------------------------------------------------
+void WriteBehindQueue::InternalsType::Run()
+{
+  while (1)
+    {
+    std::unique_lock<std::mutex> lock(this->Mutex);
+
+    this->WorkReady.wait(lock,
+      [this]() -> bool { return this->Quit || !this->Queue.empty(); });
+
+    // quit only once all the queued work is done
+    if (this->Queue.empty())
+      break;
+
+    QueueEntry entry(std::move(this->Queue.front()));
+    this->Queue.pop_front();
+    this->NumActive = 1;
+
+    lock.unlock();
+
+    long long nBytes = entry.first;
+
+    Profiler::StartEvent(this->WriteEvent.c_str(), nBytes);
+    int ierr = entry.second();
+    Profiler::EndEvent(this->WriteEvent.c_str(), nBytes);
+
+    // release the references the task holds before crediting the budget
+    entry.second = nullptr;
+
+    lock.lock();
+
+    this->BytesInFlight -= nBytes;
+    this->NumActive = 0;
+
+    if (ierr)
+      this->NumErrors += 1;
+
+    lock.unlock();
+
+    this->SpaceReady.notify_all();
+    }
+}
+
+// --------------------------------------------------------------------------
+WriteBehindQueue::WriteBehindQueue()
+{
+  this->Internals = new InternalsType;
+  this->SetName("WriteBehindQueue");
+}
+
+// --------------------------------------------------------------------------
+WriteBehindQueue::~WriteBehindQueue()
+{
+  this->Finalize();
+  delete this->Internals;
+}
+
+// --------------------------------------------------------------------------
+void WriteBehindQueue::SetName(const std::string &name)
+{
+  std::lock_guard<std::mutex> lock(this->Internals->Mutex);
+  this->Internals->WriteEvent = name + "::WriteBehind";
+  this->Internals->StallEvent = name + "::WriteBehindStall";
+  this->Internals->EnqueueEvent = name + "::WriteBehindEnqueue";
+}
+
+// --------------------------------------------------------------------------
+void WriteBehindQueue::SetMaxBytesInFlight(long long nBytes)
+{
+  std::lock_guard<std::mutex> lock(this->Internals->Mutex);
+  this->Internals->MaxBytesInFlight = nBytes;
+}
+
+// --------------------------------------------------------------------------
+long long WriteBehindQueue::GetMaxBytesInFlight() const
+{
+  std::lock_guard<std::mutex> lock(this->Internals->Mutex);
+  return this->Internals->MaxBytesInFlight;
+}
+
+// --------------------------------------------------------------------------
+int WriteBehindQueue::Initialize()
+{
+  std::lock_guard<std::mutex> lock(this->Internals->Mutex);
+
+  if (this->Internals->Running)
+    return 0;
+
+  this->Internals->Quit = 0;
+  this->Internals->NumErrors = 0;
+  this->Internals->NumTasks = 0;
+  this->Internals->MaxDepth = 0;
+  this->Internals->MaxBytesSeen = 0;
+  this->Internals->StallTime = 0.0;
+
+  this->Internals->Thread =
+    std::thread(&WriteBehindQueue::InternalsType::Run, this->Internals);
+
+  this->Internals->Running = 1;
+
+  return 0;
+}
+
+// --------------------------------------------------------------------------
+int WriteBehindQueue::Push(long long nBytes, const WriteTask &task)
+{
+  InternalsType *internals = this->Internals;
+
+  std::unique_lock<std::mutex> lock(internals->Mutex);
+
+  // when the I/O thread is not running the write happens in place
+  if (!internals->Running)
+    {
+    lock.unlock();
+    return task();
+    }
+
+  // block while the budget is exceeded. a task larger than the budget
+  // is accepted once the queue is empty
+  if (internals->BytesInFlight &&
+    (internals->BytesInFlight + nBytes > internals->MaxBytesInFlight))
+    {
+    long long bytesInFlight = internals->BytesInFlight;
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+
+    Profiler::StartEvent(internals->StallEvent.c_str(), bytesInFlight);
+
+    internals->SpaceReady.wait(lock, [internals,nBytes]() -> bool {
+      return (internals->BytesInFlight == 0) ||
+        (internals->BytesInFlight + nBytes <= internals->MaxBytesInFlight); });
+
+    Profiler::EndEvent(internals->StallEvent.c_str(), bytesInFlight);
+
+    internals->StallTime += std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - t0).count();
+    }
+
+  internals->Queue.emplace_back(nBytes, task);
+  internals->BytesInFlight += nBytes;
+  internals->NumTasks += 1;
+
+  long depth = internals->Queue.size() + internals->NumActive;
+  long long bytesInFlight = internals->BytesInFlight;
+
+  internals->MaxDepth = std::max(internals->MaxDepth, depth);
+  internals->MaxBytesSeen = std::max(internals->MaxBytesSeen, bytesInFlight);
+
+  std::ostringstream oss;
+  oss << internals->EnqueueEvent << " depth=" << depth;
+
+  lock.unlock();
+
+  internals->WorkReady.notify_one();
+
+  std::string evtName = oss.str();
+  Profiler::StartEvent(evtName.c_str(), bytesInFlight);
+  Profiler::EndEvent(evtName.c_str(), bytesInFlight);
+
+  return 0;
+}
+
+// --------------------------------------------------------------------------
+int WriteBehindQueue::Drain()
+{
+  InternalsType *internals = this->Internals;
+
+  std::unique_lock<std::mutex> lock(internals->Mutex);
+
+  internals->SpaceReady.wait(lock, [internals]() -> bool {
+    return internals->Queue.empty() && !internals->NumActive; });
+
+  int nErrors = internals->NumErrors;
+  internals->NumErrors = 0;
+
+  return nErrors;
+}
+
+// --------------------------------------------------------------------------
+int WriteBehindQueue::Finalize()
+{
+  {
+  std::lock_guard<std::mutex> lock(this->Internals->Mutex);
+  if (!this->Internals->Running)
+    return 0;
+  }
+
+  int nErrors = this->Drain();
+
+  {
+  std::lock_guard<std::mutex> lock(this->Internals->Mutex);
+  this->Internals->Quit = 1;
+  }
+
+  this->Internals->WorkReady.notify_all();
+  this->Internals->Thread.join();
+
+  std::lock_guard<std::mutex> lock(this->Internals->Mutex);
+  this->Internals->Running = 0;
+
+  return nErrors;
+}
+
+// --------------------------------------------------------------------------
+void WriteBehindQueue::GetStatistics(long &numTasks, long &maxDepth,
+  long long &maxBytesInFlight, double &stallTime) const
+{
+  std::lock_guard<std::mutex> lock(this->Internals->Mutex);
+  numTasks = this->Internals->NumTasks;
+  maxDepth = this->Internals->MaxDepth;
+  maxBytesInFlight = this->Internals->MaxBytesSeen;
+  stallTime = this->Internals->StallTime;
+}
+
+// --------------------------------------------------------------------------
+int WriteBehindQueue::WriteFile(const std::string &fileName,
+  const char *buf, size_t nBytes)
+{
+  int fd = open(fileName.c_str(), O_WRONLY|O_CREAT|O_TRUNC,
+    S_IRUSR|S_IWUSR|S_IRGRP|S_IROTH);
+  if (fd < 0)
+    {
+    const char *estr = strerror(errno);
+    SENSEI_ERROR("Failed to open \"" << fileName << "\" " << estr)
+    return -1;
+    }
+
+#if defined(__linux)
+  // reserve the space up front so the file system can allocate
+  // contiguous extents. failure here is not an error.
+  if (nBytes > WRITE_BEHIND_CHUNK_SIZE)
+    posix_fallocate(fd, 0, nBytes);
+#endif
+
+  size_t offset = 0;
+  while (offset < nBytes)
+    {
+    size_t nReq = std::min(WRITE_BEHIND_CHUNK_SIZE, nBytes - offset);
+
+    ssize_t nWritten = write(fd, buf + offset, nReq);
+    if (nWritten < 0)
+      {
+      if (errno == EINTR)
+        continue;
+
+      const char *estr = strerror(errno);
+      SENSEI_ERROR("Failed to write " << nBytes << " bytes to \""
+        << fileName << "\" " << estr)
+      close(fd);
+      return -1;
+      }
+
+    offset += nWritten;
+    }
+
+  if (close(fd))
+    {
+    const char *estr = strerror(errno);
+    SENSEI_ERROR("Failed to close \"" << fileName << "\" " << estr)
+    return -1;
+    }
+
+  return 0;
+}
+
+}
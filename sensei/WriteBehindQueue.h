@@ -0,0 +1,84 @@
+#ifndef sensei_WriteBehindQueue_h
+#define sensei_WriteBehindQueue_h
+
+#include "senseiConfig.h"
+
+#include <functional>
+#include <string>
+#include <cstddef>
+
+namespace sensei
+{
+
+// WriteBehindQueue - a per-rank background I/O thread
+/**
+Writes are queued as tasks and executed in FIFO order by a single
+I/O thread so that the caller, usually the simulation, does not wait
+on the file system. Each task declares the number of bytes it keeps
+alive while queued. When accepting a new task would push the bytes in
+flight past the budget, Push blocks until enough queued writes have
+completed. A single task larger than the budget is accepted when the
+queue is empty.
+
+When profiling is enabled the following events are logged using the
+name passed to SetName as a prefix:
+
+  <name>::WriteBehind           -- a task executing on the I/O thread,
+                                   bytes are the task's size
+  <name>::WriteBehindStall      -- time the caller was blocked on the
+                                   budget, bytes are the bytes in flight
+  <name>::WriteBehindEnqueue depth=<n>
+                                -- the queue depth after a push, bytes
+                                   are the bytes in flight
+*/
+class WriteBehindQueue
+{
+public:
+  // a write task returns 0 on success
+  using WriteTask = std::function<int()>;
+
+  WriteBehindQueue();
+  ~WriteBehindQueue();
+
+  WriteBehindQueue(const WriteBehindQueue &) = delete;
+  void operator=(const WriteBehindQueue &) = delete;
+
+  // Set the prefix used when naming profiler events
+  void SetName(const std::string &name);
+
+  // Set/get the maximum number of bytes that may be held by queued
+  // tasks. default value: 1 GiB
+  void SetMaxBytesInFlight(long long nBytes);
+  long long GetMaxBytesInFlight() const;
+
+  // start the I/O thread. this is a no-op if the thread is running.
+  int Initialize();
+
+  // queue a task. nBytes is the amount of memory the task keeps alive
+  // until it has been executed. blocks while the budget is exceeded.
+  int Push(long long nBytes, const WriteTask &task);
+
+  // wait for all queued tasks to complete. returns the number of tasks
+  // that reported an error since the last call.
+  int Drain();
+
+  // drain the queue and stop the I/O thread
+  int Finalize();
+
+  // report statistics gathered since Initialize
+  void GetStatistics(long &numTasks, long &maxDepth,
+    long long &maxBytesInFlight, double &stallTime) const;
+
+  // write the buffer to a file using large writes issued at offsets
+  // aligned to the chunk size. the file is truncated first or created.
+  static int WriteFile(const std::string &fileName, const char *buf,
+    size_t nBytes);
+
+private:
+  struct InternalsType;
+  InternalsType *Internals;
+};
+
+}
+
+#endif
@@ -0,0 +1,149 @@
+#include "CartesianTestDataAdaptor.h"
+
+#include "ProgrammableDataAdaptor.h"
+#include "MeshMetadata.h"
+
+#include <vtkDataObject.h>
+#include <vtkImageData.h>
+#include <vtkMultiBlockDataSet.h>
+#include <vtkDataSetAttributes.h>
+#include <vtkDoubleArray.h>
+
+#include <algorithm>
+
+namespace testing
+{
+
+// --------------------------------------------------------------------------
+double f(int i, int j, int k)
+{
+  return i + 1000.0*j + 1000000.0*k;
+}
+
+// --------------------------------------------------------------------------
+sensei::ProgrammableDataAdaptor *NewCartesianDataAdaptor(
+  const CartesianMesh &mesh)
+{
+  int nBlocks = mesh.BlockExtents.size();
+  int b0 = mesh.FirstLocalBlock;
+  int b1 = b0 + mesh.NumBlocksLocal;
+
+  auto getNumberOfMeshes = [](unsigned int &nMeshes) -> int
+    {
+    nMeshes = 1;
+    return 0;
+    };
+
+  auto getMeshMetadata = [=](unsigned int, sensei::MeshMetadataPtr &md) -> int
+    {
+    md->MeshName = "mesh";
+    md->MeshType = VTK_MULTIBLOCK_DATA_SET;
+    md->BlockType = VTK_IMAGE_DATA;
+    md->CoordinateType = VTK_DOUBLE;
+    md->NumBlocks = nBlocks;
+    md->NumBlocksLocal = {mesh.NumBlocksLocal};
+    md->NumArrays = 1;
+    md->ArrayName = {"data"};
+    md->ArrayCentering = {mesh.ArrayCentering};
+    md->ArrayComponents = {2};
+    md->ArrayType = {VTK_DOUBLE};
+
+    if (md->Flags.BlockExtentsSet())
+      {
+      md->Extent = mesh.WholeExtent;
+      for (int b = b0; b < b1; ++b)
+        md->BlockExtents.push_back(mesh.BlockExtents[b]);
+      }
+
+    if (md->Flags.BlockDecompSet())
+      {
+      for (int b = b0; b < b1; ++b)
+        {
+        md->BlockOwner.push_back(mesh.Rank);
+        md->BlockIds.push_back(b);
+        }
+      }
+
+    if (md->Flags.BlockSizeSet())
+      {
+      for (int b = b0; b < b1; ++b)
+        {
+        const Extent &ce = mesh.BlockExtents[b];
+        long nx = ce[1] - ce[0] + 1;
+        long ny = ce[3] - ce[2] + 1;
+        long nz = ce[5] - ce[4] + 1;
+        md->BlockNumCells.push_back(nx*ny*nz);
+        md->BlockNumPoints.push_back((nx + 1)*(ny + 1)*(nz + 1));
+        }
+      }
+
+    return 0;
+    };
+
+  auto getMesh = [=](const std::string &, bool, vtkDataObject *&dobj) -> int
+    {
+    vtkMultiBlockDataSet *mb = vtkMultiBlockDataSet::New();
+    mb->SetNumberOfBlocks(nBlocks);
+    for (int b = b0; b < b1; ++b)
+      {
+      const Extent &ce = mesh.BlockExtents[b];
+      vtkImageData *im = vtkImageData::New();
+      im->SetExtent(ce[0], ce[1] + 1, ce[2], ce[3] + 1, ce[4], ce[5] + 1);
+      mb->SetBlock(b, im);
+      im->Delete();
+      }
+    dobj = mb;
+    return 0;
+    };
+
+  auto addArray = [=](vtkDataObject *dobj, const std::string &,
+    int association, const std::string &name) -> int
+    {
+    if (std::find(mesh.MissingArrays.begin(), mesh.MissingArrays.end(),
+      name) != mesh.MissingArrays.end())
+      return -1;
+
+    bool point = association == vtkDataObject::POINT;
+    int d = point ? 1 : 0;
+
+    vtkMultiBlockDataSet *mb = static_cast<vtkMultiBlockDataSet*>(dobj);
+    for (int b = b0; b < b1; ++b)
+      {
+      const Extent &ce = mesh.BlockExtents[b];
+      vtkImageData *im = static_cast<vtkImageData*>(mb->GetBlock(b));
+
+      vtkDoubleArray *da = vtkDoubleArray::New();
+      da->SetName(name.c_str());
+      da->SetNumberOfComponents(2);
+      da->SetNumberOfTuples(point ? im->GetNumberOfPoints() :
+        im->GetNumberOfCells());
+
+      long q = 0;
+      for (int k = ce[4]; k <= ce[5] + d; ++k)
+        for (int j = ce[2]; j <= ce[3] + d; ++j)
+          for (int i = ce[0]; i <= ce[1] + d; ++i, ++q)
+            {
+            da->SetComponent(q, 0, f(i, j, k));
+            da->SetComponent(q, 1, -f(i, j, k));
+            }
+
+      im->GetAttributes(association)->AddArray(da);
+      da->Delete();
+      }
+
+    return 0;
+    };
+
+  auto releaseData = []() -> int { return 0; };
+
+  sensei::ProgrammableDataAdaptor *pda = sensei::ProgrammableDataAdaptor::New();
+  pda->SetGetNumberOfMeshesCallback(getNumberOfMeshes);
+  pda->SetGetMeshMetadataCallback(getMeshMetadata);
+  pda->SetGetMeshCallback(getMesh);
+  pda->SetAddArrayCallback(addArray);
+  pda->SetReleaseDataCallback(releaseData);
+
+  return pda;
+}
+
+}
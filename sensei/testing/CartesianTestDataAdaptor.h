@@ -0,0 +1,40 @@
+#ifndef CartesianTestDataAdaptor_h
+#define CartesianTestDataAdaptor_h
+
+#include <array>
+#include <vector>
+#include <string>
+
+namespace sensei { class ProgrammableDataAdaptor; }
+
+namespace testing
+{
+
+using Extent = std::array<int,6>;
+
+/// the value served at a global point or cell index. the component 0 of
+/// the arrays holds f, component 1 holds -f
+double f(int i, int j, int k);
+
+/// describes the Cartesian multiblock served by NewCartesianDataAdaptor
+struct CartesianMesh
+{
+  Extent WholeExtent;                 // the cell extent of the domain
+  std::vector<Extent> BlockExtents;   // the cell extent of every block
+  int FirstLocalBlock;                // local blocks are contiguous
+  int NumBlocksLocal;
+  int Rank;                           // reported as the owner of local blocks
+  int ArrayCentering;                 // reported in the metadata
+  std::vector<std::string> MissingArrays; // arrays that can not be added
+};
+
+/// makes an adaptor serving the mesh "mesh", a vtkMultiBlockDataSet of
+/// vtkImageData, with a 2 component double array of any name requested
+/// at points or cells. the metadata reports the local blocks' extents,
+/// ids, owners, and sizes when asked. the caller deletes the adaptor
+sensei::ProgrammableDataAdaptor *NewCartesianDataAdaptor(
+  const CartesianMesh &mesh);
+
+}
+
+#endif
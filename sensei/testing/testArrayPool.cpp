@@ -0,0 +1,252 @@
+// checks the buffer recycling of ArrayPool. a buffer returned to the pool,
+// directly or by deleting an array made by NewArray, must be handed back
+// for a later request of the same type and length, and not for another.
+// idle buffers must be released once they have been idle for the
+// configured number of steps, and the statistics must count the buffers
+// reused and allocated. when the pool is disabled every request must be
+// served by the system.
+//
+// usage: testArrayPool
+//
+// with SENSEI_ARRAY_POOL=0 in the environment only the disabled pool is
+// checked, and ArrayPool::Enable must not override the environment.
+
+#include "ArrayPool.h"
+
+#include <vtkDataArray.h>
+#include <vtkVersionMacros.h>
+
+#include <mpi.h>
+
+#include <iostream>
+#include <string>
+#include <cstdlib>
+
+using std::cerr;
+using std::endl;
+
+using sensei::ArrayPool;
+
+// --------------------------------------------------------------------------
+int check(bool ok, const char *what)
+{
+  if (!ok)
+    cerr << "ERROR: " << what << endl;
+  return ok ? 0 : 1;
+}
+
+// --------------------------------------------------------------------------
+int testReuse()
+{
+  int nFailed = 0;
+
+  ArrayPool::Statistics s0, s1;
+  ArrayPool::GetStatistics(s0);
+
+  void *a = ArrayPool::Allocate(VTK_DOUBLE, 100);
+  ArrayPool::Free(a);
+
+  void *b = ArrayPool::Allocate(VTK_DOUBLE, 100);
+  nFailed += check(b == a, "a freed buffer was not reused");
+  ArrayPool::Free(b);
+
+  // the same number of bytes, but another length or type
+  void *c = ArrayPool::Allocate(VTK_DOUBLE, 101);
+  nFailed += check(c != b, "a buffer was reused for another length");
+
+  void *d = ArrayPool::Allocate(VTK_FLOAT, 200);
+  nFailed += check(d != b, "a buffer was reused for another type");
+
+  ArrayPool::GetStatistics(s1);
+
+  nFailed += check(s1.NumAllocated - s0.NumAllocated == 3,
+    "the allocated buffers were miscounted");
+
+  nFailed += check(s1.NumReused - s0.NumReused == 1,
+    "the reused buffers were miscounted");
+
+  nFailed += check((s1.BytesAllocated - s0.BytesAllocated == 2408) &&
+    (s1.BytesReused - s0.BytesReused == 800),
+    "the allocated or reused bytes were miscounted");
+
+  nFailed += check(s1.IdleBytes - s0.IdleBytes == 800,
+    "the idle bytes were miscounted");
+
+  ArrayPool::Free(c);
+  ArrayPool::Free(d);
+  ArrayPool::Clear();
+
+  ArrayPool::GetStatistics(s1);
+
+  nFailed += check((s1.IdleBytes == 0) &&
+    (s1.NumReleased - s0.NumReleased == 3),
+    "Clear did not release the idle buffers");
+
+  return nFailed;
+}
+
+// --------------------------------------------------------------------------
+int testNewArray()
+{
+  int nFailed = 0;
+
+#if (VTK_MAJOR_VERSION > 8) || ((VTK_MAJOR_VERSION == 8) && (VTK_MINOR_VERSION >= 2))
+  ArrayPool::Statistics s0, s1;
+  ArrayPool::GetStatistics(s0);
+
+  vtkDataArray *a = ArrayPool::NewArray(VTK_FLOAT, 50, 2, "a");
+  if (!a)
+    {
+    cerr << "ERROR: NewArray failed" << endl;
+    return 1;
+    }
+
+  nFailed += check((a->GetNumberOfTuples() == 50) &&
+    (a->GetNumberOfComponents() == 2) && (std::string("a") == a->GetName()),
+    "NewArray made an array of the wrong shape");
+
+  // the array's free function returns the buffer to the pool
+  void *buf = a->GetVoidPointer(0);
+  a->Delete();
+
+  vtkDataArray *b = ArrayPool::NewArray(VTK_FLOAT, 50, 2);
+  nFailed += check(b->GetVoidPointer(0) == buf,
+    "the buffer of a deleted array was not reused");
+
+  b->Delete();
+
+  vtkDataArray *c = ArrayPool::NewArray(VTK_FLOAT, 51, 2);
+  nFailed += check(c->GetVoidPointer(0) != buf,
+    "the buffer of a deleted array was reused for another length");
+
+  c->Delete();
+
+  ArrayPool::GetStatistics(s1);
+
+  nFailed += check((s1.NumAllocated - s0.NumAllocated == 2) &&
+    (s1.NumReused - s0.NumReused == 1),
+    "the arrays' buffers were miscounted");
+
+  ArrayPool::Clear();
+#endif
+
+  return nFailed;
+}
+
+// --------------------------------------------------------------------------
+int testAging()
+{
+  int nFailed = 0;
+
+  ArrayPool::SetMaxIdleSteps(2);
+
+  void *a = ArrayPool::Allocate(VTK_INT, 64);
+  ArrayPool::Free(a);
+
+  ArrayPool::Statistics s0, s1;
+  ArrayPool::GetStatistics(s0);
+
+  // kept while idle for up to the max idle steps
+  for (int i = 0; i < 2; ++i)
+    {
+    ArrayPool::EndStep();
+    ArrayPool::GetStatistics(s1);
+    nFailed += check((s1.IdleBytes == s0.IdleBytes) &&
+      (s1.NumReleased == s0.NumReleased),
+      "an idle buffer was released early");
+    }
+
+  ArrayPool::EndStep();
+  ArrayPool::GetStatistics(s1);
+  nFailed += check((s0.IdleBytes - s1.IdleBytes == 256) &&
+    (s1.NumReleased - s0.NumReleased == 1),
+    "an idle buffer was not released");
+
+  // the next request is served by the system
+  void *b = ArrayPool::Allocate(VTK_INT, 64);
+  ArrayPool::GetStatistics(s0);
+  nFailed += check((s0.NumAllocated - s1.NumAllocated == 1) &&
+    (s0.NumReused == s1.NumReused),
+    "a released buffer was reused");
+
+  ArrayPool::Free(b);
+  ArrayPool::Clear();
+
+  return nFailed;
+}
+
+// --------------------------------------------------------------------------
+int testDisabled()
+{
+  int nFailed = 0;
+
+  nFailed += check(!ArrayPool::Enabled(), "the pool is not disabled");
+
+  ArrayPool::Statistics s0, s1;
+  ArrayPool::GetStatistics(s0);
+
+  void *a = ArrayPool::Allocate(VTK_DOUBLE, 100);
+  ArrayPool::Free(a);
+
+  void *b = ArrayPool::Allocate(VTK_DOUBLE, 100);
+  ArrayPool::Free(b);
+
+  ArrayPool::GetStatistics(s1);
+
+  nFailed += check((s1.NumAllocated - s0.NumAllocated == 2) &&
+    (s1.NumReused == s0.NumReused) && (s1.IdleBytes == s0.IdleBytes) &&
+    (s1.NumReleased - s0.NumReleased == 2),
+    "the disabled pool kept or reused a buffer");
+
+  // a plain array
+  vtkDataArray *da = ArrayPool::NewArray(VTK_DOUBLE, 10, 3);
+  if (!da)
+    {
+    cerr << "ERROR: NewArray failed" << endl;
+    return nFailed + 1;
+    }
+
+  da->SetComponent(9, 2, 1.0);
+  nFailed += check((da->GetNumberOfTuples() == 10) &&
+    (da->GetComponent(9, 2) == 1.0),
+    "the disabled pool made an unusable array");
+
+  da->Delete();
+
+  return nFailed;
+}
+
+// --------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+  MPI_Init(&argc, &argv);
+
+  int nFailed = 0;
+
+  char *env = getenv("SENSEI_ARRAY_POOL");
+  if (env && !atoi(env))
+    {
+    // the environment takes precedence
+    ArrayPool::Enable(true);
+    nFailed += testDisabled();
+    }
+  else
+    {
+    ArrayPool::Enable(true);
+    nFailed += testReuse();
+    nFailed += testNewArray();
+    nFailed += testAging();
+
+    if (!env)
+      {
+      ArrayPool::Enable(false);
+      nFailed += testDisabled();
+      }
+    }
+
+  cerr << nFailed << " failed checks" << endl;
+
+  MPI_Finalize();
+
+  return nFailed ? -1 : 0;
+}
@@ -0,0 +1,382 @@
+// benchmarks and validates the distributed sample sort, quantiles, and
+// kd-tree particle redistribution in DIYUtils on an oscillator style
+// particle mesh. in strong scaling runs the total number of particles is
+// fixed, in weak scaling runs the number per rank is. the particles are
+// clustered toward one corner of each rank's domain so that the kd-tree
+// has work to do.
+//
+// usage: testDIYUtils [strong|weak] [num particles] [num repetitions]
+
+#include "DIYUtils.h"
+#include "Error.h"
+
+#include <vtkPolyData.h>
+#include <vtkPoints.h>
+#include <vtkFloatArray.h>
+#include <vtkLongLongArray.h>
+#include <vtkPointData.h>
+#include <vtkMultiBlockDataSet.h>
+#include <vtkDataObject.h>
+
+#include <mpi.h>
+
+#include <vector>
+#include <string>
+#include <random>
+#include <chrono>
+#include <iostream>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+
+// --------------------------------------------------------------------------
+vtkPolyData *newParticles(int rank, int nRanks, long long nLocal,
+  long long firstId)
+{
+  std::mt19937 gen(rank + 1);
+  std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+
+  vtkFloatArray *x = vtkFloatArray::New();
+  x->SetNumberOfComponents(3);
+  x->SetNumberOfTuples(nLocal);
+  float *px = x->GetPointer(0);
+
+  vtkFloatArray *v = vtkFloatArray::New();
+  v->SetName("velocity");
+  v->SetNumberOfComponents(3);
+  v->SetNumberOfTuples(nLocal);
+  float *pv = v->GetPointer(0);
+
+  vtkLongLongArray *ids = vtkLongLongArray::New();
+  ids->SetName("id");
+  ids->SetNumberOfTuples(nLocal);
+  long long *pids = ids->GetPointer(0);
+
+  // a slab per rank, with the particles clustered toward its low corner.
+  // the velocity is a function of the position so that it can be checked
+  // after redistribution
+  float x0 = float(rank)/nRanks;
+  float dx = 1.0f/nRanks;
+  for (long long i = 0; i < nLocal; ++i)
+    {
+    float r0 = dist(gen);
+    float r1 = dist(gen);
+    float r2 = dist(gen);
+
+    float *pxi = px + 3*i;
+    pxi[0] = x0 + dx*r0*r0;
+    pxi[1] = r1*r1;
+    pxi[2] = r2;
+
+    float *pvi = pv + 3*i;
+    pvi[0] = pxi[1];
+    pvi[1] = -pxi[0];
+    pvi[2] = pxi[0]*pxi[2];
+
+    pids[i] = firstId + i;
+    }
+
+  vtkPoints *points = vtkPoints::New();
+  points->SetData(x);
+  x->Delete();
+
+  vtkPolyData *pd = vtkPolyData::New();
+  pd->SetPoints(points);
+  points->Delete();
+
+  pd->GetPointData()->AddArray(v);
+  v->Delete();
+
+  pd->GetPointData()->AddArray(ids);
+  ids->Delete();
+
+  return pd;
+}
+
+// --------------------------------------------------------------------------
+double elapsed(const std::chrono::steady_clock::time_point &t0)
+{
+  return std::chrono::duration<double>(
+    std::chrono::steady_clock::now() - t0).count();
+}
+
+// --------------------------------------------------------------------------
+int validateSort(MPI_Comm comm, const std::vector<double> &sorted,
+  long long offset, long long total, long long nExpected)
+{
+  int rank = 0;
+  int nRanks = 1;
+  MPI_Comm_rank(comm, &rank);
+  MPI_Comm_size(comm, &nRanks);
+
+  int nErrors = 0;
+
+  if (total != nExpected)
+    {
+    SENSEI_ERROR("Sorted " << total << " values, expected " << nExpected)
+    nErrors += 1;
+    }
+
+  if (!std::is_sorted(sorted.begin(), sorted.end()))
+    {
+    SENSEI_ERROR("The values on rank " << rank << " are not sorted")
+    nErrors += 1;
+    }
+
+  // the slices must be ordered by rank
+  double ends[2] = {sorted.empty() ? -HUGE_VAL : sorted.front(),
+    sorted.empty() ? -HUGE_VAL : sorted.back()};
+
+  std::vector<double> allEnds(2*nRanks);
+  MPI_Allgather(ends, 2, MPI_DOUBLE, allEnds.data(), 2, MPI_DOUBLE, comm);
+
+  double prev = -HUGE_VAL;
+  for (int i = 0; i < nRanks; ++i)
+    {
+    if (allEnds[2*i+1] == -HUGE_VAL)
+      continue;
+
+    if (allEnds[2*i] < prev)
+      {
+      SENSEI_ERROR("The values on rank " << i << " start before the end of"
+        " the previous slice")
+      nErrors += 1;
+      }
+
+    prev = allEnds[2*i+1];
+    }
+
+  long long nLocal = sorted.size();
+  long long nPrev = 0;
+  MPI_Exscan(&nLocal, &nPrev, 1, MPI_LONG_LONG, MPI_SUM, comm);
+  if (rank == 0)
+    nPrev = 0;
+
+  if (offset != nPrev)
+    {
+    SENSEI_ERROR("Wrong offset " << offset << " on rank " << rank)
+    nErrors += 1;
+    }
+
+  return nErrors;
+}
+
+// --------------------------------------------------------------------------
+int validateQuantiles(MPI_Comm comm, vtkPolyData *pd,
+  const std::vector<double> &quantiles)
+{
+  // the extremes are the range of the first velocity component
+  float *pv = static_cast<vtkFloatArray*>(
+    pd->GetPointData()->GetArray("velocity"))->GetPointer(0);
+
+  vtkIdType nPts = pd->GetNumberOfPoints();
+
+  double rng[2] = {HUGE_VAL, -HUGE_VAL};
+  for (vtkIdType i = 0; i < nPts; ++i)
+    {
+    rng[0] = std::min(rng[0], double(pv[3*i]));
+    rng[1] = std::max(rng[1], double(pv[3*i]));
+    }
+
+  MPI_Allreduce(MPI_IN_PLACE, &rng[0], 1, MPI_DOUBLE, MPI_MIN, comm);
+  MPI_Allreduce(MPI_IN_PLACE, &rng[1], 1, MPI_DOUBLE, MPI_MAX, comm);
+
+  int nErrors = 0;
+
+  if ((quantiles.front() != rng[0]) || (quantiles.back() != rng[1]))
+    {
+    SENSEI_ERROR("The extreme quantiles [" << quantiles.front() << ", "
+      << quantiles.back() << "] are not the range [" << rng[0] << ", "
+      << rng[1] << "]")
+    nErrors += 1;
+    }
+
+  if (!std::is_sorted(quantiles.begin(), quantiles.end()))
+    {
+    SENSEI_ERROR("The quantiles are not sorted")
+    nErrors += 1;
+    }
+
+  return nErrors;
+}
+
+// --------------------------------------------------------------------------
+int validateKDTree(MPI_Comm comm, vtkMultiBlockDataSet *mb,
+  long long nExpected, double &imbalance)
+{
+  int nErrors = 0;
+
+  long long nPts = 0;
+  long long idSum = 0;
+  long long maxPts = 0;
+
+  unsigned int nBlocks = mb->GetNumberOfBlocks();
+  for (unsigned int i = 0; i < nBlocks; ++i)
+    {
+    vtkPolyData *pd = dynamic_cast<vtkPolyData*>(mb->GetBlock(i));
+    if (!pd)
+      continue;
+
+    vtkFloatArray *x = dynamic_cast<vtkFloatArray*>(pd->GetPoints()->GetData());
+    vtkFloatArray *v = dynamic_cast<vtkFloatArray*>(
+      pd->GetPointData()->GetArray("velocity"));
+    vtkLongLongArray *ids = dynamic_cast<vtkLongLongArray*>(
+      pd->GetPointData()->GetArray("id"));
+
+    if (!x || !v || !ids || (v->GetNumberOfComponents() != 3))
+      {
+      SENSEI_ERROR("Block " << i << " has the wrong arrays")
+      nErrors += 1;
+      continue;
+      }
+
+    long long n = pd->GetNumberOfPoints();
+    if (pd->GetNumberOfVerts() != n)
+      {
+      SENSEI_ERROR("Block " << i << " has " << pd->GetNumberOfVerts()
+        << " vertices for " << n << " points")
+      nErrors += 1;
+      }
+
+    const float *px = x->GetPointer(0);
+    const float *pv = v->GetPointer(0);
+    const long long *pids = ids->GetPointer(0);
+    for (long long j = 0; j < n; ++j)
+      {
+      const float *pxj = px + 3*j;
+      const float *pvj = pv + 3*j;
+      if ((pvj[0] != pxj[1]) || (pvj[1] != -pxj[0]) ||
+        (pvj[2] != pxj[0]*pxj[2]))
+        {
+        SENSEI_ERROR("Particle " << pids[j] << " in block " << i
+          << " was not moved with its velocity")
+        nErrors += 1;
+        break;
+        }
+      idSum += pids[j];
+      }
+
+    nPts += n;
+    maxPts = std::max(maxPts, n);
+    }
+
+  MPI_Allreduce(MPI_IN_PLACE, &nPts, 1, MPI_LONG_LONG, MPI_SUM, comm);
+  MPI_Allreduce(MPI_IN_PLACE, &idSum, 1, MPI_LONG_LONG, MPI_SUM, comm);
+  MPI_Allreduce(MPI_IN_PLACE, &maxPts, 1, MPI_LONG_LONG, MPI_MAX, comm);
+
+  if ((nPts != nExpected) || (idSum != nExpected*(nExpected - 1)/2))
+    {
+    SENSEI_ERROR("Redistributed " << nPts << " particles, expected "
+      << nExpected)
+    nErrors += 1;
+    }
+
+  // the largest block relative to a perfect split
+  imbalance = nPts ? double(maxPts)*nBlocks/nPts : 0.0;
+
+  return nErrors;
+}
+
+// --------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+  MPI_Init(&argc, &argv);
+
+  MPI_Comm comm = MPI_COMM_WORLD;
+
+  int rank = 0;
+  int nRanks = 1;
+  MPI_Comm_rank(comm, &rank);
+  MPI_Comm_size(comm, &nRanks);
+
+  bool weak = (argc > 1) && (strcmp(argv[1], "weak") == 0);
+  long long nParticles = argc > 2 ? atoll(argv[2]) : 100000;
+  int nReps = argc > 3 ? atoi(argv[3]) : 3;
+
+  // in strong scaling runs the total is split over the ranks
+  long long nTotal = weak ? nParticles*nRanks : nParticles;
+  long long nLocal = nTotal/nRanks + (rank < nTotal%nRanks ? 1 : 0);
+
+  long long firstId = 0;
+  MPI_Exscan(&nLocal, &firstId, 1, MPI_LONG_LONG, MPI_SUM, comm);
+  if (rank == 0)
+    firstId = 0;
+
+  vtkPolyData *pd = newParticles(rank, nRanks, nLocal, firstId);
+
+  std::vector<std::string> arrays({"velocity", "id"});
+
+  double tSort = 0.0;
+  double tQuant = 0.0;
+  double tKD = 0.0;
+  double imbalance = 0.0;
+  int nErrors = 0;
+
+  for (int i = 0; i < nReps; ++i)
+    {
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+
+    std::vector<double> sorted;
+    long long offset = 0;
+    long long total = 0;
+    if (sensei::DIYUtils::Sort(comm, pd, vtkDataObject::POINT, "velocity",
+      0, sorted, offset, total))
+      {
+      SENSEI_ERROR("Sort failed")
+      nErrors += 1;
+      break;
+      }
+
+    tSort += elapsed(t0);
+    t0 = std::chrono::steady_clock::now();
+
+    std::vector<double> quantiles;
+    if (sensei::DIYUtils::Quantiles(comm, sorted, offset, total, 11, quantiles))
+      {
+      SENSEI_ERROR("Quantiles failed")
+      nErrors += 1;
+      break;
+      }
+
+    tQuant += elapsed(t0);
+    t0 = std::chrono::steady_clock::now();
+
+    vtkMultiBlockDataSet *mb = nullptr;
+    if (sensei::DIYUtils::KDTreeRedistribute(comm, pd, arrays, 0, mb))
+      {
+      SENSEI_ERROR("KDTreeRedistribute failed")
+      nErrors += 1;
+      break;
+      }
+
+    tKD += elapsed(t0);
+
+    nErrors += validateSort(comm, sorted, offset, total, nTotal);
+    nErrors += validateQuantiles(comm, pd, quantiles);
+    nErrors += validateKDTree(comm, mb, nTotal, imbalance);
+
+    mb->Delete();
+    }
+
+  pd->Delete();
+
+  MPI_Allreduce(MPI_IN_PLACE, &tSort, 1, MPI_DOUBLE, MPI_MAX, comm);
+  MPI_Allreduce(MPI_IN_PLACE, &tQuant, 1, MPI_DOUBLE, MPI_MAX, comm);
+  MPI_Allreduce(MPI_IN_PLACE, &tKD, 1, MPI_DOUBLE, MPI_MAX, comm);
+  MPI_Allreduce(MPI_IN_PLACE, &nErrors, 1, MPI_INT, MPI_SUM, comm);
+
+  if (rank == 0)
+    {
+    std::cerr << (weak ? "weak" : "strong") << " scaling, " << nRanks
+      << " ranks, " << nTotal << " particles" << std::endl
+      << "sort: " << tSort/nReps << " s" << std::endl
+      << "quantiles: " << tQuant/nReps << " s" << std::endl
+      << "kd-tree: " << tKD/nReps << " s, largest block "
+      << imbalance << " times the mean" << std::endl;
+    }
+
+  MPI_Finalize();
+
+  return nErrors ? -1 : 0;
+}
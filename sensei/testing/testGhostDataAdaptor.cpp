@@ -0,0 +1,266 @@
+// checks the ghost zones added by GhostDataAdaptor. the blocks of a
+// Cartesian mesh are spread over the ranks and carry point and cell arrays
+// whose values are a function of the global index. after the exchange
+// every ghost value must equal the value its owner holds, which is the
+// function at the same index. an array missing on one rank must make all
+// ranks fail rather than hang.
+//
+// usage: testGhostDataAdaptor [blocks per rank] [layers] [cells per block]
+
+#include "CartesianTestDataAdaptor.h"
+#include "ProgrammableDataAdaptor.h"
+#include "GhostDataAdaptor.h"
+
+#include <vtkDataObject.h>
+#include <vtkImageData.h>
+#include <vtkMultiBlockDataSet.h>
+#include <vtkCompositeDataIterator.h>
+#include <vtkDataSetAttributes.h>
+#include <vtkDoubleArray.h>
+#include <vtkUnsignedCharArray.h>
+#include <vtkSmartPointer.h>
+
+#include <mpi.h>
+
+#include <algorithm>
+#include <array>
+#include <vector>
+#include <iostream>
+#include <sstream>
+#include <cstdlib>
+
+using std::cerr;
+using std::endl;
+
+using testing::f;
+
+// --------------------------------------------------------------------------
+int checkBlock(vtkImageData *block, int bid, int association,
+  const int *ownExt, const int *wholeExt, int layers)
+{
+  bool point = association == vtkDataObject::POINT;
+  int d = point ? 1 : 0;
+
+  // the block is grown by the layers and clamped to the whole extent
+  int ghostExt[6];
+  for (int q = 0; q < 3; ++q)
+    {
+    ghostExt[2*q] = std::max(ownExt[2*q] - layers, wholeExt[2*q]);
+    ghostExt[2*q+1] = std::min(ownExt[2*q+1] + layers, wholeExt[2*q+1]) + d;
+    }
+
+  int nErrors = 0;
+
+  int *ext = block->GetExtent();
+  for (int q = 0; q < 3; ++q)
+    {
+    if ((ext[2*q] != ghostExt[2*q]) || (ext[2*q+1] != ghostExt[2*q+1] + 1 - d))
+      {
+      cerr << "ERROR: block " << bid << " has the wrong extent" << endl;
+      return 1;
+      }
+    }
+
+  vtkDataSetAttributes *atts = block->GetAttributes(association);
+
+  vtkDoubleArray *da = dynamic_cast<vtkDoubleArray*>(atts->GetArray("data"));
+
+  vtkUnsignedCharArray *ga = dynamic_cast<vtkUnsignedCharArray*>(
+    atts->GetArray(vtkDataSetAttributes::GhostArrayName()));
+
+  if (!da || !ga || (da->GetNumberOfComponents() != 2))
+    {
+    cerr << "ERROR: block " << bid << " is missing arrays" << endl;
+    return 1;
+    }
+
+  long q = 0;
+  for (int k = ghostExt[4]; k <= ghostExt[5]; ++k)
+    {
+    for (int j = ghostExt[2]; j <= ghostExt[3]; ++j)
+      {
+      for (int i = ghostExt[0]; i <= ghostExt[1]; ++i, ++q)
+        {
+        double val = f(i, j, k);
+        if ((da->GetComponent(q, 0) != val) || (da->GetComponent(q, 1) != -val))
+          {
+          if (nErrors < 10)
+            cerr << "ERROR: block " << bid << " has "
+              << da->GetComponent(q, 0) << ", " << da->GetComponent(q, 1)
+              << " at " << i << ", " << j << ", " << k << " expected "
+              << val << ", " << -val << endl;
+          ++nErrors;
+          }
+
+        bool own = (i >= ownExt[0]) && (i <= ownExt[1] + d) &&
+          (j >= ownExt[2]) && (j <= ownExt[3] + d) &&
+          (k >= ownExt[4]) && (k <= ownExt[5] + d);
+
+        if ((ga->GetValue(q) == 0) != own)
+          {
+          if (nErrors < 10)
+            cerr << "ERROR: block " << bid << " has the wrong ghost flag at "
+              << i << ", " << j << ", " << k << endl;
+          ++nErrors;
+          }
+        }
+      }
+    }
+
+  return nErrors;
+}
+
+// --------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+  MPI_Init(&argc, &argv);
+
+  int rank = 0;
+  int nRanks = 1;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &nRanks);
+
+  int nLocal = argc > 1 ? atoi(argv[1]) : 2;
+  int layers = argc > 2 ? atoi(argv[2]) : 2;
+  int n = argc > 3 ? atoi(argv[3]) : 6;
+
+  // the blocks are arranged in 2 columns in x, and rows in y and z, so
+  // that they have face, edge, and corner neighbors
+  int nBlocks = nLocal*nRanks;
+  int bx = nBlocks > 1 ? 2 : 1;
+  int nRows = (nBlocks + bx - 1)/bx;
+  int by = nRows > 1 ? 2 : 1;
+  int bz = (nRows + by - 1)/by;
+
+  // every cell of the whole extent must be covered by a block
+  if (bx*by*bz != nBlocks)
+    {
+    by = 1;
+    bz = nRows;
+    if (bx*bz != nBlocks)
+      {
+      bx = 1;
+      bz = nBlocks;
+      }
+    }
+
+  std::array<int,6> wholeExt = {0, bx*n - 1, 0, by*n - 1, 0, bz*n - 1};
+
+  std::vector<std::array<int,6>> blockExts(nBlocks);
+  for (int b = 0; b < nBlocks; ++b)
+    {
+    int ix = b % bx;
+    int iy = (b / bx) % by;
+    int iz = b / (bx*by);
+    blockExts[b] = {ix*n, (ix + 1)*n - 1, iy*n, (iy + 1)*n - 1,
+      iz*n, (iz + 1)*n - 1};
+    }
+
+  int b0 = rank*nLocal;
+
+  testing::CartesianMesh cm;
+  cm.WholeExtent = wholeExt;
+  cm.BlockExtents = blockExts;
+  cm.FirstLocalBlock = b0;
+  cm.NumBlocksLocal = nLocal;
+  cm.Rank = rank;
+  cm.ArrayCentering = vtkDataObject::POINT;
+
+  // the "partial" array is missing on rank 0
+  if (rank == 0)
+    cm.MissingArrays = {"partial"};
+
+  sensei::ProgrammableDataAdaptor *pda = testing::NewCartesianDataAdaptor(cm);
+
+  sensei::GhostDataAdaptor *gda = sensei::GhostDataAdaptor::New();
+  gda->SetDataAdaptor(pda);
+  gda->SetNumberOfGhostLayers(layers);
+
+  int nErrors = 0;
+
+  // the second step reuses the cached exchange
+  for (int step = 0; step < 2; ++step)
+    {
+    vtkDataObject *mesh = nullptr;
+    if (gda->GetMesh("mesh", false, mesh) ||
+      gda->AddArray(mesh, "mesh", vtkDataObject::POINT, "data") ||
+      gda->AddArray(mesh, "mesh", vtkDataObject::CELL, "data") ||
+      gda->AddGhostNodesArray(mesh, "mesh") ||
+      gda->AddGhostCellsArray(mesh, "mesh"))
+      {
+      cerr << "ERROR: failed to get the ghosted mesh" << endl;
+      MPI_Abort(MPI_COMM_WORLD, -1);
+      }
+
+    vtkMultiBlockDataSet *mb = dynamic_cast<vtkMultiBlockDataSet*>(mesh);
+    if (!mb)
+      {
+      cerr << "ERROR: the ghosted mesh is not a multiblock" << endl;
+      MPI_Abort(MPI_COMM_WORLD, -1);
+      }
+
+    int nFound = 0;
+    vtkSmartPointer<vtkCompositeDataIterator> it;
+    it.TakeReference(mb->NewIterator());
+    it->SetSkipEmptyNodes(1);
+    for (it->InitTraversal(); !it->IsDoneWithTraversal(); it->GoToNextItem())
+      {
+      int bid = it->GetCurrentFlatIndex() - 1;
+      vtkImageData *block = dynamic_cast<vtkImageData*>(it->GetCurrentDataObject());
+      if (!block || (bid < b0) || (bid >= b0 + nLocal))
+        {
+        cerr << "ERROR: unexpected block " << bid << endl;
+        ++nErrors;
+        continue;
+        }
+
+      nErrors += checkBlock(block, bid, vtkDataObject::POINT,
+        blockExts[bid].data(), wholeExt.data(), layers);
+
+      nErrors += checkBlock(block, bid, vtkDataObject::CELL,
+        blockExts[bid].data(), wholeExt.data(), layers);
+
+      ++nFound;
+      }
+
+    if (nFound != nLocal)
+      {
+      cerr << "ERROR: found " << nFound << " blocks, expected "
+        << nLocal << endl;
+      ++nErrors;
+      }
+
+    // all ranks fail, and none hangs, when one can not provide the array.
+    // the expected error messages are captured so that they are not taken
+    // for a failure of the test
+    std::ostringstream captured;
+    std::streambuf *cerrBuf = cerr.rdbuf(captured.rdbuf());
+
+    int partialFailed = gda->AddArray(mesh, "mesh",
+      vtkDataObject::CELL, "partial");
+
+    cerr.rdbuf(cerrBuf);
+
+    if (!partialFailed)
+      {
+      cerr << "ERROR: adding an array missing on rank 0 succeeded" << endl;
+      ++nErrors;
+      }
+
+    mesh->Delete();
+    gda->ReleaseData();
+    }
+
+  MPI_Allreduce(MPI_IN_PLACE, &nErrors, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+
+  if (rank == 0)
+    cerr << nBlocks << " blocks, " << layers << " layers, "
+      << nErrors << " failed checks" << endl;
+
+  gda->Delete();
+  pda->Delete();
+
+  MPI_Finalize();
+
+  return nErrors ? -1 : 0;
+}
@@ -0,0 +1,311 @@
+// checks the coarse meshes made by ReductionDataAdaptor. the blocks of a
+// Cartesian mesh carry point and cell arrays whose values are a function
+// of the index. the coarse arrays are compared against values computed
+// here by sampling and box filtering the function, for each filter and
+// precision, quantized values being recovered with the <name>_range array.
+// the coarse extents reported in the metadata and the extents of the
+// coarse blocks are checked as well. one of the blocks is not a multiple
+// of the stride so that the clamping at the block boundary is exercised.
+//
+// usage: testReductionDataAdaptor [stride]
+
+#include "CartesianTestDataAdaptor.h"
+#include "ProgrammableDataAdaptor.h"
+#include "ReductionDataAdaptor.h"
+#include "MeshMetadata.h"
+
+#include <vtkDataObject.h>
+#include <vtkImageData.h>
+#include <vtkMultiBlockDataSet.h>
+#include <vtkDataSetAttributes.h>
+#include <vtkFieldData.h>
+#include <vtkDataArray.h>
+
+#include <mpi.h>
+
+#include <algorithm>
+#include <array>
+#include <vector>
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+
+using std::cerr;
+using std::endl;
+
+using testing::Extent;
+using testing::f;
+
+// the cell extent of the coarse block, the first selected fine cell is
+// snapped up onto the lattice of strided cells
+Extent coarsen(const Extent &ext, int s)
+{
+  Extent cext;
+  for (int q = 0; q < 3; ++q)
+    {
+    cext[2*q] = (ext[2*q] + s - 1)/s;
+    cext[2*q+1] = ext[2*q+1]/s;
+    }
+  return cext;
+}
+
+// the expected value of a coarse cell or point
+double expected(const Extent &fext, int s, bool point, bool box,
+  int I, int J, int K)
+{
+  if (point)
+    return f(std::min(I*s, fext[1] + 1), std::min(J*s, fext[3] + 1),
+      std::min(K*s, fext[5] + 1));
+
+  if (!box)
+    return f(I*s, J*s, K*s);
+
+  double sum = 0.0;
+  long n = 0;
+  for (int k = K*s; k <= std::min(K*s + s - 1, fext[5]); ++k)
+    for (int j = J*s; j <= std::min(J*s + s - 1, fext[3]); ++j)
+      for (int i = I*s; i <= std::min(I*s + s - 1, fext[1]); ++i, ++n)
+        sum += f(i, j, k);
+
+  return sum/n;
+}
+
+// --------------------------------------------------------------------------
+int checkArray(vtkImageData *block, int bid, const Extent &fext, int s,
+  int association, int filter, int precision)
+{
+  bool point = association == vtkDataObject::POINT;
+  bool box = filter == sensei::ReductionDataAdaptor::FILTER_BOX;
+  int d = point ? 1 : 0;
+
+  vtkDataArray *da = block->GetAttributes(association)->GetArray("data");
+  if (!da || (da->GetNumberOfComponents() != 2))
+    {
+    cerr << "ERROR: block " << bid << " is missing the "
+      << (point ? "point" : "cell") << " data array" << endl;
+    return 1;
+    }
+
+  int type = VTK_DOUBLE;
+  double qMax = 0.0;
+  switch (precision)
+    {
+    case sensei::ReductionDataAdaptor::PRECISION_FLOAT:
+      type = VTK_FLOAT;
+      break;
+    case sensei::ReductionDataAdaptor::PRECISION_UINT16:
+      type = VTK_UNSIGNED_SHORT;
+      qMax = 65535.0;
+      break;
+    case sensei::ReductionDataAdaptor::PRECISION_UINT8:
+      type = VTK_UNSIGNED_CHAR;
+      qMax = 255.0;
+      break;
+    }
+
+  if (da->GetDataType() != type)
+    {
+    cerr << "ERROR: block " << bid << " has a " << da->GetClassName()
+      << " expected type " << type << endl;
+    return 1;
+    }
+
+  // the range over both components, needed to recover quantized values
+  double x0 = 0.0;
+  double x1 = 0.0;
+  if (qMax > 0.0)
+    {
+    vtkDataArray *ra = block->GetFieldData()->GetArray("data_range");
+    if (!ra || (ra->GetNumberOfComponents() != 2) ||
+      (ra->GetNumberOfTuples() != 1))
+      {
+      cerr << "ERROR: block " << bid << " is missing data_range" << endl;
+      return 1;
+      }
+    x0 = ra->GetComponent(0, 0);
+    x1 = ra->GetComponent(0, 1);
+    }
+
+  // quantized values are within half a step, others within the precision
+  // of float
+  double qTol = qMax > 0.0 ? 0.5*(x1 - x0)/qMax + 1e-6 : 0.0;
+
+  Extent cext = coarsen(fext, s);
+
+  int nErrors = 0;
+  long q = 0;
+  for (int K = cext[4]; K <= cext[5] + d; ++K)
+    {
+    for (int J = cext[2]; J <= cext[3] + d; ++J)
+      {
+      for (int I = cext[0]; I <= cext[1] + d; ++I, ++q)
+        {
+        double val = expected(fext, s, point, box, I, J, K);
+        for (int c = 0; c < 2; ++c)
+          {
+          double v = da->GetComponent(q, c);
+          if (qMax > 0.0)
+            v = x0 + v*(x1 - x0)/qMax;
+
+          double ev = c ? -val : val;
+          double tol = qMax > 0.0 ? qTol : 1e-6*std::max(1.0, std::abs(ev));
+          if (std::abs(v - ev) > tol)
+            {
+            if (nErrors < 10)
+              cerr << "ERROR: block " << bid << " has " << v << " at "
+                << I << ", " << J << ", " << K << " component " << c
+                << " expected " << ev << endl;
+            ++nErrors;
+            }
+          }
+        }
+      }
+    }
+
+  if (q != da->GetNumberOfTuples())
+    {
+    cerr << "ERROR: block " << bid << " has " << da->GetNumberOfTuples()
+      << " values expected " << q << endl;
+    ++nErrors;
+    }
+
+  return nErrors;
+}
+
+// --------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+  MPI_Init(&argc, &argv);
+
+  int s = argc > 1 ? atoi(argv[1]) : 2;
+
+  // the second block's extent in x is not a multiple of the stride
+  std::vector<Extent> blockExts = {{0, 4*s - 1, 0, 3*s - 1, 0, 2*s - 1},
+    {4*s, 6*s, 0, 3*s - 1, 0, 2*s - 1}};
+
+  Extent wholeExt = {0, 6*s, 0, 3*s - 1, 0, 2*s - 1};
+
+  int nBlocks = blockExts.size();
+
+  testing::CartesianMesh cm;
+  cm.WholeExtent = wholeExt;
+  cm.BlockExtents = blockExts;
+  cm.FirstLocalBlock = 0;
+  cm.NumBlocksLocal = nBlocks;
+  cm.Rank = 0;
+  cm.ArrayCentering = vtkDataObject::CELL;
+
+  sensei::ProgrammableDataAdaptor *pda = testing::NewCartesianDataAdaptor(cm);
+
+  sensei::ReductionDataAdaptor *rda = sensei::ReductionDataAdaptor::New();
+  rda->SetDataAdaptor(pda);
+  rda->SetStride(s);
+
+  int nErrors = 0;
+
+  // the coarse extents and sizes reported in the metadata
+  sensei::MeshMetadataPtr md = sensei::MeshMetadata::New();
+  md->Flags.SetBlockExtents();
+  md->Flags.SetBlockSize();
+
+  if (rda->GetMeshMetadata(0, md))
+    {
+    cerr << "ERROR: failed to get the metadata" << endl;
+    MPI_Abort(MPI_COMM_WORLD, -1);
+    }
+
+  if (md->Extent != coarsen(wholeExt, s))
+    {
+    cerr << "ERROR: the metadata has the wrong extent" << endl;
+    ++nErrors;
+    }
+
+  for (int b = 0; b < nBlocks; ++b)
+    {
+    Extent cext = coarsen(blockExts[b], s);
+    long nx = cext[1] - cext[0] + 1;
+    long ny = cext[3] - cext[2] + 1;
+    long nz = cext[5] - cext[4] + 1;
+
+    if ((md->BlockExtents[b] != cext) ||
+      (md->BlockNumCells[b] != nx*ny*nz) ||
+      (md->BlockNumPoints[b] != (nx + 1)*(ny + 1)*(nz + 1)))
+      {
+      cerr << "ERROR: the metadata of block " << b << " is wrong" << endl;
+      ++nErrors;
+      }
+    }
+
+  // the coarse arrays for each filter and precision
+  for (int filter = 0; filter < 2; ++filter)
+    {
+    for (int precision = 0; precision < 4; ++precision)
+      {
+      rda->SetFilter(filter);
+      rda->SetPrecision(precision);
+
+      vtkDataObject *mesh = nullptr;
+      if (rda->GetMesh("mesh", false, mesh))
+        {
+        cerr << "ERROR: failed to get the coarse mesh" << endl;
+        MPI_Abort(MPI_COMM_WORLD, -1);
+        }
+
+      vtkMultiBlockDataSet *mb = dynamic_cast<vtkMultiBlockDataSet*>(mesh);
+      if (!mb)
+        {
+        cerr << "ERROR: the coarse mesh is not a multiblock" << endl;
+        MPI_Abort(MPI_COMM_WORLD, -1);
+        }
+
+      // each array is checked as it is added since point and cell data
+      // share the name, and thus the field data range array
+      int associations[2] = {vtkDataObject::CELL, vtkDataObject::POINT};
+      for (int a = 0; a < 2; ++a)
+        {
+        if (rda->AddArray(mesh, "mesh", associations[a], "data"))
+          {
+          cerr << "ERROR: failed to add the array" << endl;
+          MPI_Abort(MPI_COMM_WORLD, -1);
+          }
+
+        for (int b = 0; b < nBlocks; ++b)
+          {
+          vtkImageData *block = dynamic_cast<vtkImageData*>(mb->GetBlock(b));
+          if (!block)
+            {
+            cerr << "ERROR: block " << b << " is missing" << endl;
+            ++nErrors;
+            continue;
+            }
+
+          Extent cext = coarsen(blockExts[b], s);
+          int *ext = block->GetExtent();
+          if ((ext[0] != cext[0]) || (ext[1] != cext[1] + 1) ||
+            (ext[2] != cext[2]) || (ext[3] != cext[3] + 1) ||
+            (ext[4] != cext[4]) || (ext[5] != cext[5] + 1))
+            {
+            cerr << "ERROR: block " << b << " has the wrong extent" << endl;
+            ++nErrors;
+            continue;
+            }
+
+          nErrors += checkArray(block, b, blockExts[b], s, associations[a],
+            filter, precision);
+          }
+        }
+
+      mesh->Delete();
+      rda->ReleaseData();
+      }
+    }
+
+  cerr << "stride " << s << ", " << nErrors << " failed checks" << endl;
+
+  rda->Delete();
+  pda->Delete();
+
+  MPI_Finalize();
+
+  return nErrors ? -1 : 0;
+}
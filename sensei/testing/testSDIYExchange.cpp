@@ -0,0 +1,182 @@
+// checks the split-phase exchange in sdiy::Master against the blocking
+// one. each block of a periodic 3D decomposition sends its gid and the
+// step to each of its neighbors, the received values are checked after
+// start_exchange/foreach_exchange, start_exchange/wait and exchange.
+//
+// usage: testSDIYExchange [blocks per rank] [num steps] [num threads]
+
+#include <sdiy/master.hpp>
+#include <sdiy/decomposition.hpp>
+#include <sdiy/assigner.hpp>
+#include <sdiy/mpi.hpp>
+
+#include <mpi.h>
+
+#include <vector>
+#include <iostream>
+#include <cstdlib>
+
+using Bounds = sdiy::DiscreteBounds;
+using Link = sdiy::RegularGridLink;
+using Proxy = sdiy::Master::ProxyWithLink;
+
+struct Block
+{
+  int Gid;
+  int Received;
+};
+
+// --------------------------------------------------------------------------
+void enqueueAll(Block *b, const Proxy &p, int step)
+{
+  Link *link = static_cast<Link*>(p.link());
+  int n = link->size();
+  for (int i = 0; i < n; ++i)
+    {
+    int msg[2] = {b->Gid, step};
+    p.enqueue(link->target(i), msg, 2);
+    }
+}
+
+// --------------------------------------------------------------------------
+void dequeueAll(Block *b, const Proxy &p, int step, int &nErrors)
+{
+  Link *link = static_cast<Link*>(p.link());
+  int n = link->size();
+  for (int i = 0; i < n; ++i)
+    {
+    int from = link->target(i).gid;
+
+    // with periodic boundaries a neighbor may appear more than once, the
+    // messages are all in the same queue
+    if (!p.incoming(from))
+      continue;
+
+    while (p.incoming(from))
+      {
+      int msg[2] = {-1, -1};
+      p.dequeue(from, msg, 2);
+      if ((msg[0] != from) || (msg[1] != step))
+        {
+        std::cerr << "ERROR: block " << b->Gid << " received " << msg[0]
+          << ", " << msg[1] << " from " << from << " in step " << step
+          << std::endl;
+        nErrors += 1;
+        }
+      b->Received += 1;
+      }
+    }
+}
+
+// --------------------------------------------------------------------------
+int runSteps(MPI_Comm mpiComm, int nLocal, int nSteps, int nThreads)
+{
+  int rank = 0;
+  int nRanks = 1;
+  MPI_Comm_rank(mpiComm, &rank);
+  MPI_Comm_size(mpiComm, &nRanks);
+
+  sdiy::mpi::communicator comm(mpiComm);
+
+  int nBlocks = nLocal*nRanks;
+
+  sdiy::Master master(comm, nThreads, -1,
+    []() -> void* { return new Block{-1, 0}; },
+    [](void *b) { delete static_cast<Block*>(b); });
+
+  sdiy::ContiguousAssigner assigner(nRanks, nBlocks);
+
+  Bounds domain;
+  for (int i = 0; i < 3; ++i)
+    {
+    domain.min[i] = 0;
+    domain.max[i] = 63;
+    }
+
+  sdiy::RegularDecomposer<Bounds> decomposer(3, domain, nBlocks,
+    sdiy::RegularDecomposer<Bounds>::BoolVector(3, false),
+    sdiy::RegularDecomposer<Bounds>::BoolVector(3, true));
+
+  decomposer.decompose(rank, assigner,
+    [&](int gid, const Bounds &, const Bounds &, const Bounds &,
+      const Link &link)
+    {
+    master.add(gid, new Block{gid, 0}, new Link(link));
+    });
+
+  int nErrors = 0;
+
+  for (int i = 0; i < 3*nSteps; ++i)
+    {
+    master.foreach([i](Block *b, const Proxy &p) { enqueueAll(b, p, i); });
+
+    switch (i % 3)
+      {
+      case 0:
+        {
+        auto h = master.start_exchange();
+        master.foreach_exchange(h, [i, &nErrors](Block *b, const Proxy &p)
+          { dequeueAll(b, p, i, nErrors); });
+        }
+        break;
+      case 1:
+        {
+        auto h = master.start_exchange();
+        h.wait();
+        master.foreach([i, &nErrors](Block *b, const Proxy &p)
+          { dequeueAll(b, p, i, nErrors); });
+        }
+        break;
+      case 2:
+        master.exchange();
+        master.foreach([i, &nErrors](Block *b, const Proxy &p)
+          { dequeueAll(b, p, i, nErrors); });
+        break;
+      }
+    }
+
+  // each block hears from each of its neighbors every step
+  long nReceived = 0;
+  long nExpected = 0;
+  for (unsigned i = 0; i < master.size(); ++i)
+    {
+    nReceived += master.block<Block>(i)->Received;
+    nExpected += 3*nSteps*master.link(i)->size();
+    }
+
+  if (nReceived != nExpected)
+    {
+    std::cerr << "ERROR: rank " << rank << " received " << nReceived
+      << " messages, expected " << nExpected << std::endl;
+    nErrors += 1;
+    }
+
+  return nErrors;
+}
+
+// --------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+  MPI_Init(&argc, &argv);
+
+  int rank = 0;
+  int nRanks = 1;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &nRanks);
+
+  int nLocal = argc > 1 ? atoi(argv[1]) : 4;
+  int nSteps = argc > 2 ? atoi(argv[2]) : 10;
+  int nThreads = argc > 3 ? atoi(argv[3]) : 1;
+
+  int nErrors = runSteps(MPI_COMM_WORLD, nLocal, nSteps, nThreads);
+
+  MPI_Allreduce(MPI_IN_PLACE, &nErrors, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+
+  if (rank == 0)
+    std::cerr << nLocal*nRanks << " blocks, " << nSteps << " steps, "
+      << nErrors << " failed checks" << std::endl;
+
+  MPI_Finalize();
+
+  return nErrors ? -1 : 0;
+}
@@ -0,0 +1,107 @@
+// compares block execution in sdiy::Master by the persistent work-stealing
+// thread pool against creating threads on every execute. this is the case
+// of over-decomposed runs with many cheap blocks.
+//
+// usage: testSDIYThreadPool [num blocks] [num steps] [num threads] [work]
+
+#include <sdiy/master.hpp>
+#include <sdiy/mpi.hpp>
+
+#include <mpi.h>
+
+#include <vector>
+#include <chrono>
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+
+struct Block
+{
+  double Value;
+  long Count;
+};
+
+// --------------------------------------------------------------------------
+double runSteps(MPI_Comm comm, bool usePool, int nBlocks, int nSteps,
+  int nThreads, int work, int &nErrors)
+{
+  std::vector<Block> blocks(nBlocks, Block{0.0, 0});
+
+  sdiy::Master master(comm, nThreads);
+  master.set_thread_pool(usePool);
+
+  for (int i = 0; i < nBlocks; ++i)
+    master.add(i, &blocks[i], new sdiy::Link);
+
+  auto processBlock = [work](Block *b, const sdiy::Master::ProxyWithLink &)
+  {
+    double v = b->Value;
+    for (int i = 0; i < work; ++i)
+      v = std::sqrt(v + i);
+    b->Value = v;
+    b->Count += 1;
+  };
+
+  // the first step includes thread creation for the pool
+  master.foreach(processBlock);
+
+  std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+
+  for (int i = 0; i < nSteps; ++i)
+    master.foreach(processBlock);
+
+  double dt = std::chrono::duration<double>(
+    std::chrono::steady_clock::now() - t0).count();
+
+  // each block should be processed exactly once per step
+  for (int i = 0; i < nBlocks; ++i)
+    {
+    if (blocks[i].Count != nSteps + 1)
+      {
+      std::cerr << "ERROR: block " << i << " was processed "
+        << blocks[i].Count << " times, expected " << nSteps + 1
+        << std::endl;
+      nErrors += 1;
+      }
+    }
+
+  return dt;
+}
+
+// --------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+  MPI_Init(&argc, &argv);
+
+  int rank = 0;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+  int nBlocks = argc > 1 ? atoi(argv[1]) : 1024;
+  int nSteps = argc > 2 ? atoi(argv[2]) : 100;
+  int nThreads = argc > 3 ? atoi(argv[3]) : 4;
+  int work = argc > 4 ? atoi(argv[4]) : 100;
+
+  int nErrors = 0;
+
+  double tSpawn = runSteps(MPI_COMM_WORLD, false,
+    nBlocks, nSteps, nThreads, work, nErrors);
+
+  double tPool = runSteps(MPI_COMM_WORLD, true,
+    nBlocks, nSteps, nThreads, work, nErrors);
+
+  MPI_Allreduce(MPI_IN_PLACE, &tSpawn, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+  MPI_Allreduce(MPI_IN_PLACE, &tPool, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+
+  if (rank == 0)
+    {
+    std::cerr << nBlocks << " blocks, " << nSteps << " steps, "
+      << nThreads << " threads, " << work << " work per block" << std::endl
+      << "thread per execute: " << tSpawn/nSteps << " s per step" << std::endl
+      << "work-stealing pool: " << tPool/nSteps << " s per step" << std::endl
+      << "speedup: " << tSpawn/tPool << std::endl;
+    }
+
+  MPI_Finalize();
+
+  return nErrors ? -1 : 0;
+}
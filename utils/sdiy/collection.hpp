@@ -49,6 +49,7 @@ namespace sdiy
 
       inline void   load(int i);
       inline void   unload(int i);
+      inline void   prefetch(int i);            // hint that element i is about to be loaded
 
       Create        creator() const                 { return create_; }
       Destroy       destroyer() const               { return destroy_; }
@@ -95,12 +96,15 @@ unload(int i)
   void* e = find(i);
   //save_(e, bb);
   //external_[i] = storage_->put(bb);
-  external_[static_cast<size_t>(i)] = storage_->put(e, save_);
+  int external = storage_->put(e, save_);
 
   destroy_(e);
   elements_[static_cast<size_t>(i)] = 0;
 
-  --(*in_memory_.access());
+  // external_ is updated under the lock, since prefetch() may read it from another thread
+  CInt::accessor in_memory = in_memory_.access();
+  external_[static_cast<size_t>(i)] = external;
+  --(*in_memory);
 }
 
 void
@@ -113,9 +117,24 @@ load(int i)
   //load_(e, bb);
   storage_->get(external_[static_cast<size_t>(i)], e, load_);
   elements_[static_cast<size_t>(i)] = e;
+
+  CInt::accessor in_memory = in_memory_.access();
   external_[static_cast<size_t>(i)] = -1;
+  ++(*in_memory);
+}
+
+void
+sdiy::Collection::
+prefetch(int i)
+{
+  int external;
+  {
+    CInt::accessor in_memory = in_memory_.access();
+    external = external_[static_cast<size_t>(i)];
+  }
 
-  ++(*in_memory_.access());
+  if (external != -1)
+    storage_->prefetch(external);
 }
 
 #endif
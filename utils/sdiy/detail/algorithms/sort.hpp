@@ -95,8 +95,9 @@ struct SampleSort<Block,T,Cmp>::Sampler
         if (k_in == 0)
         {
             // draw random samples
-            for (size_t i = 0; i < num_samples; ++i)
-                samples.push_back((b->*values)[std::rand() % (b->*values).size()]);
+            if (!(b->*values).empty())
+                for (size_t i = 0; i < num_samples; ++i)
+                    samples.push_back((b->*values)[std::rand() % (b->*values).size()]);
         } else
             dequeue_values(samples, srp, false);
 
@@ -106,8 +107,9 @@ struct SampleSort<Block,T,Cmp>::Sampler
             std::sort(samples.begin(), samples.end(), cmp);
             std::vector<T>  subsamples(srp.nblocks() - 1);
             int step = samples.size() / srp.nblocks();       // NB: subsamples.size() + 1
-            for (size_t i = 0; i < subsamples.size(); ++i)
-                subsamples[i] = samples[(i+1)*step];
+            if (!samples.empty())
+                for (size_t i = 0; i < subsamples.size(); ++i)
+                    subsamples[i] = samples[(i+1)*step];
             (b->*dividers).swap(subsamples);
         }
         else
@@ -134,19 +136,80 @@ struct SampleSort<Block,T,Cmp>::Exchanger
 
     void            operator()(Block* b, const ReduceProxy& rp) const
     {
+        std::vector<T>& v = b->*values;
+
+        if (detail::is_default< Serialization<T> >::value)
+        {
+            // fast path for values that are copied as bytes: sorting locally
+            // first makes the values going to each block a contiguous run, sent
+            // with a single copy, and the runs received are merged rather than
+            // sorted
+            if (rp.round() == 0)
+            {
+                std::sort(v.begin(), v.end(), cmp);
+
+                const std::vector<T>& s = b->*samples;
+                typename std::vector<T>::const_iterator first = v.begin();
+                for (int i = 0; i < rp.out_link().size(); ++i)
+                {
+                    // same destination as lower_bound(samples, x) for each x
+                    typename std::vector<T>::const_iterator last =
+                        (size_t) i < s.size() ? std::upper_bound(first, v.cend(), s[i], cmp) : v.cend();
+                    if (last != first)
+                        save(rp.outgoing(rp.out_link().target(i)), &*first, static_cast<size_t>(last - first));
+                    first = last;
+                }
+                v.clear();
+            } else
+            {
+                std::vector<size_t> runs(1, 0);
+                for (int i = 0; i < rp.in_link().size(); ++i)
+                {
+                    MemoryBuffer& in = rp.incoming(rp.in_link().target(i).gid);
+                    size_t n = in.size() / sizeof(T);
+                    if (!n)
+                        continue;
+                    v.resize(runs.back() + n);
+                    std::copy_n((const T*) &in.buffer[0], n, &v[runs.back()]);
+                    runs.push_back(v.size());
+                }
+                merge_runs(v, runs);
+            }
+            return;
+        }
+
         if (rp.round() == 0)
         {
             // enqueue values to the correct locations
-            for (size_t i = 0; i < (b->*values).size(); ++i)
+            for (size_t i = 0; i < v.size(); ++i)
             {
-                int to = std::lower_bound((b->*samples).begin(), (b->*samples).end(), (b->*values)[i], cmp) - (b->*samples).begin();
-                rp.enqueue(rp.out_link().target(to), (b->*values)[i]);
+                int to = std::lower_bound((b->*samples).begin(), (b->*samples).end(), v[i], cmp) - (b->*samples).begin();
+                rp.enqueue(rp.out_link().target(to), v[i]);
             }
-            (b->*values).clear();
+            v.clear();
         } else
         {
-            dequeue_values((b->*values), rp, false);
-            std::sort((b->*values).begin(), (b->*values).end(), cmp);
+            dequeue_values(v, rp, false);
+            std::sort(v.begin(), v.end(), cmp);
+        }
+    }
+
+    // merge the sorted runs [runs[i], runs[i+1]) of v pairwise, until v is sorted
+    void            merge_runs(std::vector<T>& v, std::vector<size_t>& runs) const
+    {
+        while (runs.size() > 2)
+        {
+            std::vector<size_t> merged(1, 0);
+            for (size_t i = 0; i + 1 < runs.size(); i += 2)
+            {
+                if (i + 2 < runs.size())
+                {
+                    std::inplace_merge(v.begin() + runs[i], v.begin() + runs[i+1], v.begin() + runs[i+2], cmp);
+                    merged.push_back(runs[i+2]);
+                } else
+                    merged.push_back(runs[i+1]);
+            }
+            runs.swap(merged);
         }
     }
 
@@ -7,7 +7,22 @@ struct sdiy::Master::ProcessBlock
               master(master_),
               blocks(blocks__),
               local_limit(local_limit_),
-              idx(idx_)
+              idx(&idx_),
+              queues(nullptr),
+              thread_id(0)
+          {}
+
+          ProcessBlock(Master&                    master_,
+                       const std::deque<int>&     blocks__,
+                       int                        local_limit_,
+                       WorkStealingQueues&        queues_,
+                       int                        thread_id_):
+              master(master_),
+              blocks(blocks__),
+              local_limit(local_limit_),
+              idx(nullptr),
+              queues(&queues_),
+              thread_id(thread_id_)
           {}
 
           ProcessBlock(const ProcessBlock&)     = delete;
@@ -20,12 +35,17 @@ struct sdiy::Master::ProcessBlock
     std::vector<int>      local;
     do
     {
-      int cur = (*idx.access())++;
+      int cur = next();
 
-      if ((size_t)cur >= blocks.size())
+      if (cur < 0 || (size_t)cur >= blocks.size())
           return;
 
       int i = blocks[cur];
+
+      // start reading in the block that is likely to come next, while this one is processed
+      if (master.limit_ != -1 && (size_t)cur + 1 < blocks.size())
+          master.prefetch(blocks[cur + 1]);
+
       if (master.block(i))
       {
           if (local.size() == (size_t)local_limit)
@@ -57,9 +77,13 @@ struct sdiy::Master::ProcessBlock
       {
           cmd->execute(skip ? 0 : master.block(i), master.proxy(i));
 
-          // no longer need them, so get rid of them
-          current_incoming[master.gid(i)].queues.clear();
-          current_incoming[master.gid(i)].records.clear();
+          // no longer need them, so get rid of them, unless they belong to
+          // a split-phase exchange that is still arriving
+          if (!master.exchange_pending_)
+          {
+              current_incoming[master.gid(i)].queues.clear();
+              current_incoming[master.gid(i)].records.clear();
+          }
       }
 
       if (skip && master.block(i) == 0)
@@ -67,6 +91,19 @@ struct sdiy::Master::ProcessBlock
     } while(true);
   }
 
+  // position in blocks of the next block to process, or -1 when done
+  int   next()
+  {
+      if (!queues)
+          return (*idx->access())++;
+
+      size_t item;
+      if (!queues->pop(thread_id, item))
+          return -1;
+
+      return static_cast<int>(item);
+  }
+
   bool  all_skip(int i) const
   {
       bool skip = true;
@@ -84,7 +121,9 @@ struct sdiy::Master::ProcessBlock
   Master&                 master;
   const std::deque<int>&  blocks;
   int                     local_limit;
-  critical_resource<int>& idx;
+  critical_resource<int>* idx;
+  WorkStealingQueues*     queues;
+  int                     thread_id;
 };
 
 void
@@ -129,11 +168,24 @@ execute()
     blocks_per_thread = limit_/num_threads;
   }
 
-  // idx is shared
-  critical_resource<int> idx(0);
+  if (num_threads > 1 && thread_pool_)
+  {
+    // persistent threads; each thread starts with the same share of the
+    // blocks on every call, and steals from the others when it runs out
+    if (!pool_ || pool_->size() != num_threads)
+        pool_.reset(new ThreadPool(num_threads, pin_threads_));
+
+    WorkStealingQueues queues(num_threads, blocks.size());
 
-  if (num_threads > 1)
+    pool_->run(num_threads, [&](int thread_id)
+    {
+        ProcessBlock(*this, blocks, blocks_per_thread, queues, thread_id)();
+    });
+  } else if (num_threads > 1)
   {
+    // idx is shared
+    critical_resource<int> idx(0);
+
     // launch the threads
     std::list<thread>   threads;
     for (unsigned i = 0; i < (unsigned)num_threads; ++i)
@@ -143,11 +195,13 @@ execute()
         t.join();
   } else
   {
+      critical_resource<int> idx(0);
       ProcessBlock(*this, blocks, blocks_per_thread, idx)();
   }
 
   // clear incoming queues
-  incoming_[exchange_round_].map.clear();
+  if (!exchange_pending_)
+      incoming_[exchange_round_].map.clear();
 
   if (limit() != -1 && in_memory() > limit())
       throw std::runtime_error(fmt::format("Fatal: {} blocks in memory, with limit {}", in_memory(), limit()));
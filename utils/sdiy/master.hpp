@@ -10,6 +10,8 @@
 #include <numeric>
 #include <memory>
 #include <climits>
+#include <limits>
+#include <cstdlib>
 
 #include "link.hpp"
 #include "collection.hpp"
@@ -20,6 +22,7 @@
 #include "time.hpp"
 
 #include "thread.hpp"
+#include "thread-pool.hpp"
 
 #include "detail/block_traits.hpp"
 
@@ -182,6 +185,7 @@ namespace sdiy
       inline int    loaded_block() const                { return blocks_.available(); }
 
       inline void   unload(int i);
+      void          prefetch(int i)                     { blocks_.prefetch(i); }    //!< hint that block i is about to be loaded
       inline void   load(int i);
       void          unload(std::vector<int>& loaded)    { for(unsigned i = 0; i < loaded.size(); ++i) unload(loaded[i]); loaded.clear(); }
       void          unload_all()                        { for(unsigned i = 0; i < size(); ++i) if (block(i) != 0) unload(i); }
@@ -209,6 +213,23 @@ namespace sdiy
       //! exchange the queues between all the blocks (collective operation)
       inline void   exchange(bool remote = false);
 
+      //! handle to an exchange in progress, see start_exchange()
+      struct ExchangeHandle;
+
+      //! start exchanging the queues between all the blocks and return without
+      //! waiting for them to arrive (collective operation). until the exchange
+      //! is completed, with ExchangeHandle::wait() or foreach_exchange(), blocks
+      //! may be processed with foreach and enqueue for the next exchange, but
+      //! must not dequeue. with out-of-core blocks the exchange completes
+      //! before returning.
+      inline ExchangeHandle start_exchange();
+
+      //! complete the exchange, calling `f` with each block as soon as all of its
+      //! incoming queues have arrived, so that processing the first blocks
+      //! overlaps communication for the rest
+      template<class F>
+      void          foreach_exchange(ExchangeHandle& h, const F& f);
+
       //! nonblocking exchange of the queues between all the blocks
       template<class Block>
       void          iexchange_(const ICallback<Block>&   f);
@@ -237,7 +258,15 @@ namespace sdiy
       int           threads() const                     { return threads_; }
       int           in_memory() const                   { return *blocks_.in_memory().const_access(); }
 
-      void          set_threads(int threads__)          { threads_ = threads__; }
+      void          set_threads(int threads__)          { threads_ = threads__; pool_.reset(); }
+
+      //! whether blocks are executed by the persistent work-stealing pool (the default), or by threads created on each execute
+      bool          thread_pool() const                 { return thread_pool_; }
+      void          set_thread_pool(bool p)             { thread_pool_ = p; }
+
+      //! whether the pool's threads are pinned to cores; defaults to the DIY_PIN_THREADS environment variable
+      bool          pin_threads() const                 { return pin_threads_; }
+      void          set_pin_threads(bool p)             { if (p != pin_threads_) pool_.reset(); pin_threads_ = p; }
 
       CreateBlock   creator() const                     { return blocks_.creator(); }
       DestroyBlock  destroyer() const                   { return blocks_.destroyer(); }
@@ -280,6 +309,7 @@ namespace sdiy
     private:
       // Communicator functionality
       inline void       comm_exchange(GidSendOrder& gid_order, IExchangeInfo*    iexchange = 0);
+      inline bool       progress_exchange(GidSendOrder& gid_order);
       inline void       rcomm_exchange();    // possibly called in between block computations
       inline bool       nudge();
       inline void       send_outgoing_queues(GidSendOrder&   gid_order,
@@ -314,6 +344,10 @@ namespace sdiy
       int                   threads_;
       ExternalStorage*      storage_;
 
+      std::unique_ptr<ThreadPool>   pool_;
+      bool                  thread_pool_        = true;
+      bool                  pin_threads_        = false;
+
     private:
       // Communicator
       mpi::communicator     comm_;
@@ -325,6 +359,7 @@ namespace sdiy
       std::unique_ptr<CollectivesMap>    collectives_;
 
       int                   expected_           = 0;
+      bool                  exchange_pending_   = false;    // a split-phase exchange is in progress
       int                   exchange_round_     = -1;
       bool                  immediate_          = true;
       Commands              commands_;
@@ -347,6 +382,30 @@ namespace sdiy
 #include "proxy.hpp"
 #include "detail/master/execution.hpp"
 
+namespace sdiy
+{
+  struct Master::ExchangeHandle
+  {
+                    ExchangeHandle(Master* master_ = nullptr):
+                        master(master_)                 {}
+
+    //! make progress on the exchange, returns true once it is complete
+    bool            test()                              { if (!done && master) done = master->progress_exchange(gid_order); return done || !master; }
+
+    //! wait for the exchange to complete, after which the incoming queues are
+    //! handled as after exchange()
+    void            wait()                              { while (!test()); if (master) master->exchange_pending_ = false; }
+
+    //! whether all of the incoming queues of the `i`-th local block have arrived
+    inline bool     ready(int i) const;
+
+    Master*             master;
+    bool                done = false;
+    std::vector<int>    expected;           // number of queues expected by each local block
+    GidSendOrder        gid_order;          // outgoing queues that have not been posted yet
+  };
+}
+
 sdiy::Master::
 Master(mpi::communicator    comm,
        int                  threads__,
@@ -368,6 +427,9 @@ Master(mpi::communicator    comm,
   collectives_(new CollectivesMap)
 {
     comm_.duplicate(comm);
+
+    const char* pin = std::getenv("DIY_PIN_THREADS");
+    pin_threads_ = pin && std::atoi(pin);
 }
 
 sdiy::Master::
@@ -615,6 +677,136 @@ foreach_(const Callback<Block>& f, const Skip& skip)
         execute();
 }
 
+sdiy::Master::ExchangeHandle
+sdiy::Master::
+start_exchange()
+{
+  auto scoped = prof.scoped("start_exchange");
+  DIY_UNUSED(scoped);
+
+  ExchangeHandle h(this);
+
+  // out-of-core queues are sent a few at a time, there is nothing to overlap
+  if (limit_ != -1)
+  {
+      exchange();
+      h.done = true;
+      return h;
+  }
+
+  execute();
+
+  log->debug("Starting split-phase exchange");
+
+  // make sure there is a queue for each neighbor
+  touch_queues();
+
+  // prepare for next round
+  incoming_.erase(exchange_round_);
+  ++exchange_round_;
+
+  // a queue arrives from each neighbor
+  h.expected.resize(size());
+  for (unsigned i = 0; i < size(); ++i)
+      h.expected[i] = link(i)->size_unique();
+
+  // with all blocks in memory every queue is posted at once, rather than
+  // a limited number at a time, so that the blocks may enqueue for the next
+  // exchange as soon as this returns
+  h.gid_order = order_gids();
+  h.gid_order.limit = std::numeric_limits<size_t>::max();
+
+  exchange_pending_ = true;
+
+  h.test();
+
+  return h;
+}
+
+bool
+sdiy::Master::
+progress_exchange(GidSendOrder& gid_order)
+{
+  // the outgoing queues are cleared only once all of them have been posted
+  if (!gid_order.empty())
+  {
+      comm_exchange(gid_order);
+      if (gid_order.empty())
+          outgoing_.clear();
+  }
+  else
+  {
+      nudge();
+      check_incoming_queues();
+  }
+
+  if (!gid_order.empty() || !inflight_sends().empty() ||
+      incoming_[exchange_round_].received < expected_)
+      return false;
+
+  log->debug("Done in split-phase exchange");
+
+  process_collectives();
+
+  return true;
+}
+
+bool
+sdiy::Master::ExchangeHandle::
+ready(int i) const
+{
+  if (done)
+      return true;
+
+  const IncomingQueuesMap& in = master->incoming_[master->exchange_round_].map;
+  IncomingQueuesMap::const_iterator it = in.find(master->gid(i));
+
+  return it != in.end() && static_cast<int>(it->second.records.size()) >= expected[i];
+}
+
+template<class F>
+void
+sdiy::Master::
+foreach_exchange(ExchangeHandle& h, const F& f)
+{
+  auto scoped = prof.scoped("foreach_exchange");
+  DIY_UNUSED(scoped);
+
+  using Block = typename detail::block_traits<F>::type;
+
+  if (h.done || limit_ != -1)
+  {
+      h.wait();
+      foreach(f);
+      return;
+  }
+
+  std::vector<char> processed(size(), 0);
+  unsigned n_left = size();
+  while (n_left)
+  {
+      bool done = h.test();
+
+      for (unsigned i = 0; i < size(); ++i)
+      {
+          if (processed[i] || !(done || h.ready(i)))
+              continue;
+
+          f(block<Block>(i), proxy(i));
+
+          // no longer need them, so get rid of them
+          IncomingQueuesRecords& in = incoming_[exchange_round_].map[gid(i)];
+          in.queues.clear();
+          in.records.clear();
+
+          processed[i] = 1;
+          --n_left;
+      }
+  }
+
+  h.wait();
+}
+
 void
 sdiy::Master::
 exchange(bool remote)
@@ -0,0 +1,274 @@
+#ifndef DIY_MMAP_STORAGE_HPP
+#define DIY_MMAP_STORAGE_HPP
+
+#include <string>
+#include <vector>
+#include <map>
+#include <cstring>
+#include <cstdlib>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "storage.hpp"
+
+namespace sdiy
+{
+  namespace detail
+  {
+    // counts the bytes a save function writes
+    struct CountingBuffer: public BinaryBuffer
+    {
+      virtual inline void save_binary(const char*, size_t count) override    { size += count; }
+      virtual inline void append_binary(const char*, size_t count) override  { size += count; }
+      virtual inline void load_binary(char*, size_t) override                 {}
+      virtual inline void load_binary_back(char*, size_t) override            {}
+
+      size_t              size = 0;
+    };
+
+    // reads and writes a mapped record in place
+    struct MappedBuffer: public BinaryBuffer
+    {
+                          MappedBuffer(char* data_, size_t size_): data(data_), head(0), tail(size_)  {}
+
+      virtual inline void save_binary(const char* x, size_t count) override   { std::memcpy(data + head, x, count); head += count; }
+      virtual inline void append_binary(const char* x, size_t count) override { save_binary(x, count); }
+      virtual inline void load_binary(char* x, size_t count) override         { std::memcpy(x, data + head, count); head += count; }
+      virtual inline void load_binary_back(char* x, size_t count) override    { tail -= count; std::memcpy(x, data + tail, count); }
+
+      char*   data;
+      size_t  head, tail;
+    };
+  }
+
+  // Stores records in a single memory-mapped file. Records are written and
+  // read through a mapping of their region, so a block's save and load
+  // functions copy their (large, contiguous) arrays straight to and from
+  // the page cache, without an intermediate buffer or a system call per
+  // array, and without creating and removing a file per record as
+  // FileStorage does. The regions of records that are read back are reused
+  // by later records of the same or smaller size, which is the common
+  // case of blocks cycling in and out of memory. prefetch() asks the kernel
+  // to start reading a record's pages in ahead of its load. POSIX only.
+  class MmapStorage: public ExternalStorage
+  {
+    private:
+      struct Record
+      {
+        size_t          offset;
+        size_t          size;
+        size_t          capacity;
+      };
+
+    public:
+                    MmapStorage(const std::string& filename_template = "/tmp/DIY.XXXXXX"):
+                      filename_(filename_template),
+                      page_size_(static_cast<size_t>(sysconf(_SC_PAGESIZE)))
+      {
+        // io::utils::mkstemp() opens write-only, a shared mapping needs read-write
+        std::vector<char> name(filename_.begin(), filename_.end());
+        name.push_back(0);
+        fd_ = ::mkstemp(&name[0]);
+        filename_ = &name[0];
+        if (fd_ < 0)
+          throw std::runtime_error(fmt::format("MmapStorage: could not create {}", filename_));
+
+        // the file is only ever accessed through the descriptor; removing
+        // it now means it is cleaned up however the process exits
+        io::utils::remove(filename_);
+      }
+
+                    ~MmapStorage()                              { close(fd_); }
+
+                    MmapStorage(const MmapStorage&)             = delete;
+      MmapStorage&  operator=(const MmapStorage&)               = delete;
+
+      virtual int   put(MemoryBuffer& bb) override
+      {
+        size_t sz = bb.buffer.size();
+        Record r = allocate(sz);
+
+        get_logger()->debug("MmapStorage::put(): offset {}; buffer size: {}", r.offset, sz);
+
+        char* data = map(r);
+        if (sz)
+          std::memcpy(data, &bb.buffer[0], sz);
+        unmap(data, r, true);
+        bb.wipe();
+
+        return make_record(r);
+      }
+
+      virtual int   put(const void* x, detail::Save save) override
+      {
+        // size the record first; this pass only adds up the sizes
+        detail::CountingBuffer cb;
+        save(x, cb);
+
+        Record r = allocate(cb.size);
+
+        get_logger()->debug("MmapStorage::put(): offset {}; block size: {}", r.offset, cb.size);
+
+        char* data = map(r);
+        detail::MappedBuffer mb(data, r.size);
+        save(x, mb);
+        unmap(data, r, true);
+
+        return make_record(r);
+      }
+
+      virtual void  get(int i, MemoryBuffer& bb, size_t extra) override
+      {
+        Record r = extract_record(i);
+
+        get_logger()->debug("MmapStorage::get(): offset {}; buffer size: {}", r.offset, r.size);
+
+        bb.buffer.reserve(r.size + extra);
+        bb.buffer.resize(r.size);
+
+        char* data = map(r);
+        if (r.size)
+          std::memcpy(&bb.buffer[0], data, r.size);
+        unmap(data, r, false);
+
+        release(r);
+      }
+
+      virtual void  get(int i, void* x, detail::Load load) override
+      {
+        Record r = extract_record(i);
+
+        char* data = map(r);
+        detail::MappedBuffer mb(data, r.size);
+        load(x, mb);
+        unmap(data, r, false);
+
+        release(r);
+      }
+
+      virtual void  destroy(int i) override                     { release(extract_record(i)); }
+
+      virtual void  prefetch(int i) override
+      {
+        Record r;
+        {
+          lock_guard<mutex> lock(mutex_);
+          std::map<int, Record>::const_iterator it = records_.find(i);
+          if (it == records_.end())
+            return;
+          r = it->second;
+        }
+#if defined(POSIX_FADV_WILLNEED)
+        posix_fadvise(fd_, static_cast<off_t>(r.offset), static_cast<off_t>(r.size), POSIX_FADV_WILLNEED);
+#endif
+      }
+
+      int           count() const                               { lock_guard<mutex> lock(mutex_); return count_; }
+      size_t        current_size() const                        { lock_guard<mutex> lock(mutex_); return current_size_; }
+      size_t        max_size() const                            { lock_guard<mutex> lock(mutex_); return max_size_; }
+      size_t        file_size() const                           { lock_guard<mutex> lock(mutex_); return file_size_; }
+
+    private:
+      // find a region for a record of the given size, reusing a free one if possible
+      Record        allocate(size_t sz)
+      {
+        // whole pages, so that the region can be mapped on its own
+        size_t capacity = (sz / page_size_ + 1) * page_size_;
+
+        lock_guard<mutex> lock(mutex_);
+
+        Record r = { 0, sz, capacity };
+
+        std::multimap<size_t, size_t>::iterator it = free_.lower_bound(capacity);
+        if (it != free_.end())
+        {
+          r.capacity = it->first;
+          r.offset   = it->second;
+          free_.erase(it);
+          return r;
+        }
+
+        r.offset = file_size_;
+        if (ftruncate(fd_, static_cast<off_t>(file_size_ + capacity)))
+          throw std::runtime_error(fmt::format("MmapStorage: could not grow {} to {} bytes", filename_, file_size_ + capacity));
+        file_size_ += capacity;
+
+        return r;
+      }
+
+      void          release(const Record& r)
+      {
+#if defined(POSIX_FADV_DONTNEED)
+        // the contents are no longer needed; drop them from the page cache
+        posix_fadvise(fd_, static_cast<off_t>(r.offset), static_cast<off_t>(r.capacity), POSIX_FADV_DONTNEED);
+#endif
+        lock_guard<mutex> lock(mutex_);
+        free_.emplace(r.capacity, r.offset);
+      }
+
+      char*         map(const Record& r) const
+      {
+        void* data = mmap(0, r.capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, static_cast<off_t>(r.offset));
+        if (data == MAP_FAILED)
+          throw std::runtime_error(fmt::format("MmapStorage: could not map {} bytes of {} at {}", r.capacity, filename_, r.offset));
+        return static_cast<char*>(data);
+      }
+
+      void          unmap(char* data, const Record& r, bool written) const
+      {
+#if defined(__linux__)
+        // start writing the record back now, so that its pages are clean
+        // and can be reclaimed as soon as memory is needed
+        if (written)
+          sync_file_range(fd_, static_cast<off_t>(r.offset), static_cast<off_t>(r.size), SYNC_FILE_RANGE_WRITE);
+#else
+        DIY_UNUSED(written);
+#endif
+        munmap(data, r.capacity);
+      }
+
+      int           make_record(const Record& r)
+      {
+        lock_guard<mutex> lock(mutex_);
+
+        int res = count_++;
+        records_[res] = r;
+
+        // keep track of sizes
+        current_size_ += r.size;
+        if (current_size_ > max_size_)
+            max_size_ = current_size_;
+
+        return res;
+      }
+
+      Record        extract_record(int i)
+      {
+        lock_guard<mutex> lock(mutex_);
+
+        Record r = records_[i];
+        records_.erase(i);
+        current_size_ -= r.size;
+
+        return r;
+      }
+
+    private:
+      std::string                       filename_;
+      int                               fd_;
+      size_t                            page_size_;
+      size_t                            file_size_      = 0;
+
+      mutable mutex                     mutex_;
+      std::map<int, Record>             records_;
+      std::multimap<size_t, size_t>     free_;          // capacity -> offset
+      int                               count_          = 0;
+      size_t                            current_size_   = 0;
+      size_t                            max_size_       = 0;
+  };
+}
+
+#endif
@@ -51,6 +51,11 @@ namespace sdiy
       virtual void  get(int i, MemoryBuffer& bb, size_t extra = 0)      =0;
       virtual void  get(int i, void* x, detail::Load load)              =0;
       virtual void  destroy(int i)                                      =0;
+
+      //! hint that record `i` is about to be read
+      virtual void  prefetch(int)                                       {}
+
+      virtual       ~ExternalStorage()                                  {}
   };
 
   class FileStorage: public ExternalStorage
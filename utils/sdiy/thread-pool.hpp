@@ -0,0 +1,300 @@
+#ifndef DIY_THREAD_POOL_HPP
+#define DIY_THREAD_POOL_HPP
+
+#include <vector>
+#include <atomic>
+#include <memory>
+#include <functional>
+#include <cstdint>
+#include <cstddef>
+
+#include "thread.hpp"
+
+#ifndef DIY_NO_THREADS
+#include <condition_variable>
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+#endif
+
+namespace sdiy
+{
+  // A fixed set of work items, [0, n), split into one contiguous range per
+  // thread. A thread takes items from the front of its own range and, when
+  // that is empty, steals the back half of another thread's range. Each range
+  // is a single atomic word, so taking and stealing are lock-free. Since the
+  // split depends only on the number of items and threads, a thread works on
+  // the same items from one call to the next, unless they are stolen.
+  class WorkStealingQueues
+  {
+    public:
+                    WorkStealingQueues(int n_threads, size_t n_items):
+                        n_threads_(n_threads),
+                        ranges_(new Range[n_threads])
+      {
+        for (int t = 0; t < n_threads; ++t)
+        {
+          uint32_t b = static_cast<uint32_t>(n_items * t / n_threads);
+          uint32_t e = static_cast<uint32_t>(n_items * (t + 1) / n_threads);
+          ranges_[t].be.store(pack(b, e));
+        }
+      }
+
+      // get the next item for thread t. returns false once there is no work
+      // left to take or steal.
+      inline bool   pop(int t, size_t& item);
+
+    private:
+      static uint64_t pack(uint32_t b, uint32_t e)  { return (static_cast<uint64_t>(b) << 32) | e; }
+      static uint32_t begin(uint64_t be)            { return static_cast<uint32_t>(be >> 32); }
+      static uint32_t end(uint64_t be)              { return static_cast<uint32_t>(be); }
+
+      // padded to a cache line so that threads don't contend on neighbors
+      struct Range
+      {
+        std::atomic<uint64_t>   be;
+        char                    pad[64 - sizeof(std::atomic<uint64_t>)];
+      };
+
+      int                       n_threads_;
+      std::unique_ptr<Range[]>  ranges_;
+  };
+
+  // A persistent pool of threads. run() executes a function on a number of
+  // threads, the calling thread being thread 0, and waits for them all to
+  // finish. The threads are created once and reused by every call. When
+  // pinning is requested worker i is bound to the i-th core of the process'
+  // CPU set (Linux only), so threads, and the blocks they favor, stay on the
+  // same cores and NUMA domains from one call to the next.
+  class ThreadPool
+  {
+    public:
+      using Task = std::function<void(int)>;
+
+      inline        ThreadPool(int n_threads, bool pin = false);
+      inline        ~ThreadPool();
+
+                    ThreadPool(const ThreadPool&)   = delete;
+      ThreadPool&   operator=(const ThreadPool&)    = delete;
+
+      //! the number of threads, including the caller
+      int           size() const                    { return n_threads_; }
+
+      //! call f(i) for i in [0, n) on n of the pool's threads and wait
+      inline void   run(int n, const Task& f);
+
+    private:
+      inline void   worker(int id);
+      inline void   pin(int id);
+
+      int                       n_threads_;
+#ifndef DIY_NO_THREADS
+      std::vector<std::thread>  threads_;
+      std::mutex                mutex_;
+      std::condition_variable   work_ready_;
+      std::condition_variable   work_done_;
+      const Task*               task_       = nullptr;
+      int                       n_active_   = 0;
+      int                       n_busy_     = 0;
+      unsigned long             generation_ = 0;
+      bool                      quit_       = false;
+#endif
+  };
+}
+
+bool
+sdiy::WorkStealingQueues::
+pop(int t, size_t& item)
+{
+  // own range, from the front
+  Range& own = ranges_[t];
+  uint64_t be = own.be.load();
+  while (begin(be) < end(be))
+  {
+    if (own.be.compare_exchange_weak(be, pack(begin(be) + 1, end(be))))
+    {
+      item = begin(be);
+      return true;
+    }
+  }
+
+  // steal the back half of another thread's range, starting with the
+  // neighbor so that thieves spread out
+  for (int i = 1; i < n_threads_; ++i)
+  {
+    Range& victim = ranges_[(t + i) % n_threads_];
+    uint64_t vbe = victim.be.load();
+    while (begin(vbe) < end(vbe))
+    {
+      uint32_t b = begin(vbe);
+      uint32_t e = end(vbe);
+      uint32_t mid = e - (e - b + 1)/2;
+      if (victim.be.compare_exchange_weak(vbe, pack(b, mid)))
+      {
+        // the first stolen item is returned and the rest become our range.
+        // our range is empty, so no one else modifies it meanwhile
+        item = mid;
+        own.be.store(pack(mid + 1, e));
+        return true;
+      }
+    }
+  }
+
+  return false;
+}
+
+#ifndef DIY_NO_THREADS
+
+sdiy::ThreadPool::
+ThreadPool(int n_threads, bool pin_):
+    n_threads_(n_threads < 1 ? 1 : n_threads)
+{
+  for (int i = 1; i < n_threads_; ++i)
+  {
+    threads_.emplace_back(&ThreadPool::worker, this, i);
+    if (pin_)
+      pin(i);
+  }
+}
+
+sdiy::ThreadPool::
+~ThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    quit_ = true;
+  }
+  work_ready_.notify_all();
+
+  for (auto& t : threads_)
+    t.join();
+}
+
+void
+sdiy::ThreadPool::
+pin(int id)
+{
+#if defined(__linux__)
+  cpu_set_t allowed;
+  CPU_ZERO(&allowed);
+  if (sched_getaffinity(0, sizeof(allowed), &allowed))
+    return;
+
+  int n_cpus = CPU_COUNT(&allowed);
+  if (n_cpus < 1)
+    return;
+
+  // the id-th allowed cpu, wrapping around when oversubscribed
+  int target = id % n_cpus;
+  for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+  {
+    if (!CPU_ISSET(cpu, &allowed))
+      continue;
+
+    if (target-- == 0)
+    {
+      cpu_set_t mask;
+      CPU_ZERO(&mask);
+      CPU_SET(cpu, &mask);
+      pthread_setaffinity_np(threads_[id - 1].native_handle(), sizeof(mask), &mask);
+      return;
+    }
+  }
+#else
+  (void) id;
+#endif
+}
+
+void
+sdiy::ThreadPool::
+worker(int id)
+{
+  unsigned long generation = 0;
+  while (true)
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    work_ready_.wait(lock, [this,generation]() { return quit_ || generation_ != generation; });
+
+    if (quit_)
+      return;
+
+    generation = generation_;
+
+    // not needed for this task
+    if (id >= n_active_)
+      continue;
+
+    const Task* task = task_;
+    lock.unlock();
+
+    (*task)(id);
+
+    lock.lock();
+    if (--n_busy_ == 0)
+      work_done_.notify_all();
+  }
+}
+
+void
+sdiy::ThreadPool::
+run(int n, const Task& f)
+{
+  if (n > n_threads_)
+    n = n_threads_;
+
+  if (n <= 1)
+  {
+    f(0);
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    task_       = &f;
+    n_active_   = n;
+    n_busy_     = n - 1;
+    ++generation_;
+  }
+  work_ready_.notify_all();
+
+  f(0);
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  work_done_.wait(lock, [this]() { return n_busy_ == 0; });
+  task_ = nullptr;
+}
+
+#else
+
+sdiy::ThreadPool::
+ThreadPool(int n_threads, bool):
+    n_threads_(n_threads < 1 ? 1 : n_threads)
+{}
+
+sdiy::ThreadPool::
+~ThreadPool()
+{}
+
+void
+sdiy::ThreadPool::
+pin(int)
+{}
+
+void
+sdiy::ThreadPool::
+worker(int)
+{}
+
+void
+sdiy::ThreadPool::
+run(int n, const Task& f)
+{
+  // no threads, run each share in turn
+  for (int i = 0; i < n; ++i)
+    f(i);
+}
+
+#endif
+
+#endif